@@ -22,6 +22,7 @@
 
 #include "audio/fmopl.h"
 
+#include "audio/fmopl_capture.h"
 #include "audio/mixer.h"
 #include "audio/softsynth/opl/dosbox.h"
 #include "audio/softsynth/opl/mame.h"
@@ -67,6 +68,10 @@ OPL::OPL() {
 	_hasInstance = true;
 }
 
+OPL::OPL(OPL *forwardTo) {
+	assert(forwardTo && _hasInstance);
+}
+
 const Config::EmulatorDescription Config::_drivers[] = {
 	{ "auto", "<default>", kAuto, kFlagOpl2 | kFlagDualOpl2 | kFlagOpl3 },
 	{ "mame", _s("MAME OPL emulator"), kMame, kFlagOpl2 },
@@ -166,6 +171,16 @@ OPL *Config::create(OplType type) {
 }
 
 OPL *Config::create(DriverId driver, OplType type) {
+	OPL *opl = createDriver(driver, type);
+
+	// Log all writes, to replay them with devtools/opl_replay
+	if (opl && ConfMan.hasKey("opl_capture"))
+		opl = createCapture(opl, type, ConfMan.get("opl_capture"));
+
+	return opl;
+}
+
+OPL *Config::createDriver(DriverId driver, OplType type) {
 	// On invalid driver selection, we try to do some fallback detection
 	if (driver == -1) {
 		warning("Invalid OPL driver selected, trying to detect a fallback emulator");
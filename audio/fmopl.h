@@ -103,6 +103,8 @@ public:
 	static OPL *create(OplType type = kOpl2);
 
 private:
+	static OPL *createDriver(DriverId driver, OplType type);
+
 	static const EmulatorDescription _drivers[];
 };
 
@@ -194,6 +196,12 @@ protected:
 	 */
 	virtual void stopCallbacks() = 0;
 
+	/**
+	 * Creates an OPL which passes everything on to another, already
+	 * existing, OPL. It does not count as an output instance of its own.
+	 */
+	explicit OPL(OPL *forwardTo);
+
 	/**
 	 * The functor for callbacks.
 	 */
@@ -247,6 +255,7 @@ public:
 
 	// AudioStream API
 	int readBuffer(int16 *buffer, const int numSamples);
+	virtual bool isStereo() const = 0;
 	int getRate() const;
 	bool endOfData() const { return false; }
 
@@ -0,0 +1,194 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "audio/fmopl_capture.h"
+
+#include "common/file.h"
+#include "common/stream.h"
+#include "common/textconsole.h"
+
+namespace OPL {
+
+CaptureOPL::CaptureOPL(OPL *opl, Config::OplType type, Common::WriteStream *stream) :
+	OPL(opl), _opl(opl), _stream(stream), _ticks(0), _lastTicks(0) {
+	_stream->writeUint32BE(MKTAG('O', 'P', 'L', 'C'));
+	_stream->writeByte(kCaptureVersion);
+	_stream->writeByte(type);
+}
+
+CaptureOPL::~CaptureOPL() {
+	stop();
+
+	// Keep the time after the last write, so the notes can fade out
+	writeDelay();
+	_stream->finalize();
+	delete _stream;
+	delete _opl;
+}
+
+bool CaptureOPL::init() {
+	return _opl->init();
+}
+
+void CaptureOPL::reset() {
+	writeCommand(kCaptureReset);
+	_opl->reset();
+}
+
+void CaptureOPL::write(int a, int v) {
+	writeCommand(kCaptureWrite);
+	_stream->writeUint16LE(a);
+	_stream->writeByte(v);
+	_opl->write(a, v);
+}
+
+byte CaptureOPL::read(int a) {
+	return _opl->read(a);
+}
+
+void CaptureOPL::writeReg(int r, int v) {
+	writeCommand(kCaptureWriteReg);
+	_stream->writeUint16LE(r);
+	_stream->writeByte(v);
+	_opl->writeReg(r, v);
+}
+
+void CaptureOPL::setCallbackFrequency(int timerFrequency) {
+	writeCommand(kCaptureFrequency);
+	_stream->writeUint32LE(timerFrequency);
+	_opl->setCallbackFrequency(timerFrequency);
+}
+
+void CaptureOPL::startCallbacks(int timerFrequency) {
+	writeCommand(kCaptureFrequency);
+	_stream->writeUint32LE(timerFrequency);
+	_opl->start(new Common::Functor0Mem<void, CaptureOPL>(this, &CaptureOPL::onTimer), timerFrequency);
+}
+
+void CaptureOPL::stopCallbacks() {
+	_opl->stop();
+}
+
+void CaptureOPL::onTimer() {
+	if (_callback && _callback->isValid())
+		(*_callback)();
+
+	// Writes done in the n-th callback are at tick n - 1, so that a tick
+	// starts with the callback, as in EmulatedOPL
+	++_ticks;
+}
+
+void CaptureOPL::writeDelay() {
+	const uint32 delay = _ticks - _lastTicks;
+	if (!delay)
+		return;
+
+	if (delay < 256) {
+		_stream->writeByte(kCaptureDelay);
+		_stream->writeByte(delay);
+	} else {
+		_stream->writeByte(kCaptureLongDelay);
+		_stream->writeUint32LE(delay);
+	}
+	_lastTicks += delay;
+}
+
+void CaptureOPL::writeCommand(CaptureCommand command) {
+	writeDelay();
+	_stream->writeByte(command);
+}
+
+OPL *createCapture(OPL *opl, Config::OplType type, const Common::String &filename) {
+	Common::DumpFile *file = new Common::DumpFile();
+	if (!file->open(filename)) {
+		warning("Could not create the OPL capture '%s'", filename.c_str());
+		delete file;
+		return opl;
+	}
+
+	return new CaptureOPL(opl, type, file);
+}
+
+CaptureReader::CaptureReader(Common::ReadStream *stream) : _stream(stream), _valid(false), _type(Config::kOpl2) {
+	const uint32 tag = _stream->readUint32BE();
+	const byte version = _stream->readByte();
+	const byte type = _stream->readByte();
+	if (_stream->err() || _stream->eos() || tag != MKTAG('O', 'P', 'L', 'C'))
+		return;
+
+	if (version != kCaptureVersion || type > Config::kOpl3) {
+		warning("Unsupported OPL capture version %d or type %d", version, type);
+		return;
+	}
+
+	_type = (Config::OplType)type;
+	_valid = true;
+}
+
+bool CaptureReader::readEvent(CaptureEvent &event) {
+	if (!_valid)
+		return false;
+
+	const byte command = _stream->readByte();
+	if (_stream->eos())
+		return false;
+
+	event.command = (CaptureCommand)command;
+	event.param = 0;
+	event.value = 0;
+
+	switch (command) {
+	case kCaptureDelay:
+		event.param = _stream->readByte();
+		break;
+
+	case kCaptureLongDelay:
+	case kCaptureFrequency:
+		event.param = _stream->readUint32LE();
+		break;
+
+	case kCaptureWrite:
+	case kCaptureWriteReg:
+		event.param = _stream->readUint16LE();
+		event.value = _stream->readByte();
+		break;
+
+	case kCaptureReset:
+		break;
+
+	default:
+		warning("Unknown OPL capture command %d", command);
+		_valid = false;
+		return false;
+	}
+
+	if (_stream->err() || _stream->eos()) {
+		warning("Truncated OPL capture");
+		_valid = false;
+		return false;
+	}
+
+	return true;
+}
+
+} // End of namespace OPL
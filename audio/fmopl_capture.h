@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_FMOPL_CAPTURE_H
+#define AUDIO_FMOPL_CAPTURE_H
+
+#include "audio/fmopl.h"
+
+#include "common/types.h"
+
+namespace Common {
+class ReadStream;
+class WriteStream;
+}
+
+namespace OPL {
+
+/**
+ * The commands of an OPL capture.
+ *
+ * A capture starts with the tag 'OPLC', a version byte and the OPL type,
+ * followed by the commands, each one a command byte and its arguments. All
+ * values are little endian. Time is counted in ticks of the timer callback,
+ * so a capture replays the same no matter what the output rate is.
+ */
+enum CaptureCommand {
+	kCaptureDelay = 0,			///< uint8 ticks
+	kCaptureLongDelay = 1,		///< uint32 ticks
+	kCaptureWrite = 2,			///< uint16 port, uint8 value
+	kCaptureWriteReg = 3,		///< uint16 register, uint8 value
+	kCaptureFrequency = 4,		///< uint32 timer callback frequency
+	kCaptureReset = 5
+};
+
+enum {
+	kCaptureVersion = 1
+};
+
+/**
+ * An OPL which passes everything on to another OPL, and logs all writes,
+ * together with their time, to a stream.
+ */
+class CaptureOPL : public OPL {
+public:
+	/**
+	 * Creates the capture. It takes ownership of both the OPL and the
+	 * stream.
+	 */
+	CaptureOPL(OPL *opl, Config::OplType type, Common::WriteStream *stream);
+	~CaptureOPL();
+
+	// OPL API
+	bool init();
+	void reset();
+	void write(int a, int v);
+	byte read(int a);
+	void writeReg(int r, int v);
+	void setCallbackFrequency(int timerFrequency);
+
+protected:
+	// OPL API
+	void startCallbacks(int timerFrequency);
+	void stopCallbacks();
+
+private:
+	void onTimer();
+
+	/** Write a delay for all ticks since the last command. */
+	void writeDelay();
+	void writeCommand(CaptureCommand command);
+
+	OPL *_opl;
+	Common::WriteStream *_stream;
+
+	uint32 _ticks;
+	uint32 _lastTicks;
+};
+
+/**
+ * Wrap an OPL with a capture to the given file. If the file can not be
+ * created, the OPL is returned as it is.
+ */
+OPL *createCapture(OPL *opl, Config::OplType type, const Common::String &filename);
+
+/**
+ * A single command of an OPL capture.
+ */
+struct CaptureEvent {
+	CaptureCommand command;
+
+	/**
+	 * The number of ticks for delays, the port or register for writes, the
+	 * frequency for frequency changes.
+	 */
+	uint32 param;
+
+	/** The value for writes. */
+	uint8 value;
+};
+
+/**
+ * Reads the commands of an OPL capture.
+ */
+class CaptureReader {
+public:
+	/**
+	 * Reads the header of the capture. The stream is not deleted by the
+	 * reader.
+	 */
+	CaptureReader(Common::ReadStream *stream);
+
+	/**
+	 * @return Whether the stream holds a capture this reader understands.
+	 */
+	bool isValid() const { return _valid; }
+
+	/**
+	 * @return The OPL type the capture was made for.
+	 */
+	Config::OplType getType() const { return _type; }
+
+	/**
+	 * Reads the next command.
+	 *
+	 * @return false at the end of the capture or if it is damaged.
+	 */
+	bool readEvent(CaptureEvent &event);
+
+private:
+	Common::ReadStream *_stream;
+	bool _valid;
+	Config::OplType _type;
+};
+
+} // End of namespace OPL
+
+#endif
@@ -4,6 +4,7 @@ MODULE_OBJS := \
 	adlib.o \
 	audiostream.o \
 	fmopl.o \
+	fmopl_capture.o \
 	mididrv.o \
 	midiparser_qt.o \
 	midiparser_smf.o \
@@ -65,6 +66,13 @@ MODULE_OBJS += \
 	softsynth/opl/nuked.o
 endif
 
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	softsynth/opl/dbopl_sse2.o
+
+$(MODULE)/softsynth/opl/dbopl_sse2.o: CXXFLAGS += -msse2
+endif
+
 ifdef USE_A52
 MODULE_OBJS += \
 	decoders/ac3.o
@@ -82,7 +90,16 @@ endif
 
 ifndef USE_ARM_SOUND_ASM
 MODULE_OBJS += \
-	rate.o
+	rate.o \
+	rate_kernels.o
+
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	rate_kernels_sse2.o
+
+$(MODULE)/rate_kernels_sse2.o: CXXFLAGS += -msse2
+endif
+
 else
 MODULE_OBJS += \
 	rate_arm.o \
@@ -30,8 +30,11 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_kernels.h"
 #include "audio/mixer.h"
-#include "common/frac.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/config-manager.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
@@ -47,15 +50,18 @@ namespace Audio {
 #define INTERMEDIATE_BUFFER_SIZE 512
 
 /**
- * The default fractional type in frac.h (with 16 fractional bits) limits
- * the rate conversion code to 65536Hz audio: we need to able to handle
- * 96kHz audio, so we use fewer fractional bits in this code.
+ * Mix a block of converted frames into the output buffer using the
+ * matching kernel.
  */
-enum {
-	FRAC_BITS_LOW = 15,
-	FRAC_ONE_LOW = (1L << FRAC_BITS_LOW),
-	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
-};
+template<bool stereo, bool reverseStereo>
+static inline void mixFrames(const RateKernels &kernels, st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!stereo)
+		kernels.mixMono(obuf, ibuf, numFrames, vol_l, vol_r);
+	else if (reverseStereo)
+		kernels.mixStereoReverse(obuf, ibuf, numFrames, vol_l, vol_r);
+	else
+		kernels.mixStereo(obuf, ibuf, numFrames, vol_l, vol_r);
+}
 
 /**
  * Audio rate converter based on simple resampling. Used when no
@@ -77,8 +83,10 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	const RateKernels &kernels;
+
 public:
-	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
+	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate, const RateKernels &k);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
 	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return ST_SUCCESS;
@@ -90,7 +98,7 @@ public:
  * Prepare processing.
  */
 template<bool stereo, bool reverseStereo>
-SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate, st_rate_t outrate) {
+SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate, st_rate_t outrate, const RateKernels &k) : kernels(k) {
 	if ((inrate % outrate) != 0) {
 		error("Input rate must be a multiple of output rate to use rate effect");
 	}
@@ -113,45 +121,53 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
  */
 template<bool stereo, bool reverseStereo>
 int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
-
-	while (obuf < oend) {
-
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		// Collect a block of output frames and mix them in one go
+		const st_size_t blockLen = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		st_sample_t *outPtr = outBuf;
+		bool eof = false;
+
+		for (st_size_t i = 0; i < blockLen; ++i) {
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						eof = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
+
+			if (eof)
+				break;
+
+			*outPtr++ = *inPtr++;
+			if (stereo)
+				*outPtr++ = *inPtr++;
 
-		// Increment output position
-		opos += opos_inc;
-
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
+		}
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		const st_size_t frames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixFrames<stereo, reverseStereo>(kernels, obuf + done * 2, outBuf, frames, vol_l, vol_r);
+		done += frames;
 
-		obuf += 2;
+		if (eof)
+			break;
 	}
-	return (obuf - ostart) / 2;
+	return done;
 }
 
 /**
@@ -168,23 +184,27 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 template<bool stereo, bool reverseStereo>
 class LinearRateConverter : public RateConverter {
 protected:
-	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
-	const st_sample_t *inPtr;
-	int inLen;
-
-	/** fractional position of the output stream in input stream unit */
-	frac_t opos;
+	/**
+	 * Input frames. The first two frames hold the last and current frame
+	 * of the previous buffer, followed by the frames read from the stream.
+	 */
+	st_sample_t inBuf[2 * 2 + INTERMEDIATE_BUFFER_SIZE];
+	uint32 inFrames;
+
+	/**
+	 * fractional position of the output stream in input stream unit,
+	 * relative to the start of inBuf. Each output frame is interpolated
+	 * between the frames (opos >> FRAC_BITS_LOW) - 1 and (opos >> FRAC_BITS_LOW).
+	 */
+	uint32 opos;
 
 	/** fractional position increment in the output stream */
-	frac_t opos_inc;
+	uint32 opos_inc;
 
-	/** last sample(s) in the input stream (left/right channel) */
-	st_sample_t ilast0, ilast1;
-	/** current sample(s) in the input stream (left/right channel) */
-	st_sample_t icur0, icur1;
+	const RateKernels &kernels;
 
 public:
-	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
+	LinearRateConverter(st_rate_t inrate, st_rate_t outrate, const RateKernels &k);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
 	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return ST_SUCCESS;
@@ -196,12 +216,16 @@ public:
  * Prepare processing.
  */
 template<bool stereo, bool reverseStereo>
-LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate, st_rate_t outrate) {
+LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate, st_rate_t outrate, const RateKernels &k) : kernels(k) {
 	if (inrate >= 131072 || outrate >= 131072) {
 		error("rate effect can only handle rates < 131072");
 	}
 
-	opos = FRAC_ONE_LOW;
+	// Start with two silent frames, the first output frame is then
+	// interpolated between silence and the first input frame.
+	memset(inBuf, 0, 2 * (stereo ? 2 : 1) * sizeof(st_sample_t));
+	inFrames = 2;
+	opos = 2 * FRAC_ONE_LOW;
 
 	// Compute the linear interpolation increment.
 	// This will overflow if inrate >= 2^17, and underflow if outrate >= 2^17.
@@ -209,11 +233,6 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 	// would cause problems, but since we rarely scale from 1 to 65536 Hz or vice
 	// versa, I think we can live with that limitation ;-).
 	opos_inc = (inrate << FRAC_BITS_LOW) / outrate;
-
-	ilast0 = ilast1 = 0;
-	icur0 = icur1 = 0;
-
-	inLen = 0;
 }
 
 /*
@@ -222,55 +241,297 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
  */
 template<bool stereo, bool reverseStereo>
 int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
-
-	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE_LOW <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
-			}
-			opos -= FRAC_ONE_LOW;
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
+
+	while (done < osamp) {
+
+		// read enough input samples so that the current frame is available
+		while ((opos >> FRAC_BITS_LOW) >= inFrames) {
+			// Keep the last two frames as history for the interpolation
+			const int numChannels = (stereo ? 2 : 1);
+			memmove(inBuf, inBuf + (inFrames - 2) * numChannels, 2 * numChannels * sizeof(st_sample_t));
+			opos -= (inFrames - 2) * FRAC_ONE_LOW;
+			inFrames = 2;
+
+			const int inLen = input.readBuffer(inBuf + 2 * numChannels, INTERMEDIATE_BUFFER_SIZE);
+			if (inLen <= 0)
+				return done;
+			inFrames += inLen / numChannels;
 		}
 
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE_LOW && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
-						  out0);
+		// Compute as many output frames as the buffered input allows
+		const uint32 available = (inFrames * FRAC_ONE_LOW - opos + opos_inc - 1) / opos_inc;
+		st_size_t frames = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		frames = MIN<st_size_t>(frames, available);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		if (stereo)
+			kernels.interpolateStereo(outBuf, inBuf, opos, opos_inc, frames);
+		else
+			kernels.interpolateMono(outBuf, inBuf, opos, opos_inc, frames);
+		mixFrames<stereo, reverseStereo>(kernels, obuf + done * 2, outBuf, frames, vol_l, vol_r);
+
+		// Increment output position
+		opos += frames * opos_inc;
+		done += frames;
+	}
+	return done;
+}
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
 
-			obuf += 2;
+#pragma mark -
 
-			// Increment output position
-			opos += opos_inc;
+
+/**
+ * Parameters of the band-limited resampling quality tiers.
+ */
+struct SincQuality {
+	/** Number of filter taps when upsampling, a multiple of 8. */
+	uint taps;
+	/** log2 of the number of filter phases. */
+	uint phaseBits;
+	/** Kaiser window parameter, trading stopband attenuation for transition width. */
+	double beta;
+	/** Cutoff frequency relative to the Nyquist frequency. */
+	double rolloff;
+};
+
+/** Upper limit of the filter length, to bound the cost of extreme downsampling. */
+enum { kMaxSincTaps = 256 };
+
+static const SincQuality sincQualities[] = {
+	{  8, 6, 5.0, 0.85 }, // kResamplingSincFast
+	{ 16, 8, 7.0, 0.90 }, // kResamplingSincMedium
+	{ 32, 9, 9.0, 0.94 }  // kResamplingSincBest
+};
+
+/**
+ * Modified Bessel function of the first kind, needed for the Kaiser window.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+/**
+ * Compute a Kaiser-windowed sinc filter with the given length and cutoff
+ * (relative to the Nyquist frequency of the input) for all phases.
+ */
+static SincFilter *createSincFilter(const SincQuality &quality, uint taps, double cutoff) {
+	const uint phases = 1 << quality.phaseBits;
+
+	SincFilter *filter = new SincFilter;
+	filter->taps = taps;
+	filter->phaseBits = quality.phaseBits;
+	filter->coefs = new int16[phases * taps];
+	filter->stereoCoefs = new int16[phases * taps * 2];
+
+	double *window = new double[taps];
+	for (uint phase = 0; phase < phases; ++phase) {
+		int16 *coefs = filter->coefs + phase * taps;
+
+		// Tap i is applied to the input frame at offset x from the
+		// output position
+		double sum = 0;
+		for (uint i = 0; i < taps; ++i) {
+			const double x = (double)i + 1 - taps / 2 - (double)phase / phases;
+			const double t = x / (taps / 2);
+			const double sinc = (x == 0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			window[i] = cutoff * sinc * besselI0(quality.beta * sqrt(MAX(0.0, 1 - t * t))) / besselI0(quality.beta);
+			sum += window[i];
+		}
+
+		// Normalize to unity gain. The rounding error is added to the
+		// central tap, so every phase passes DC unchanged.
+		int total = 0;
+		for (uint i = 0; i < taps; ++i) {
+			coefs[i] = (int16)floor(window[i] / sum * (1 << 14) + 0.5);
+			total += coefs[i];
+		}
+		coefs[taps / 2 - 1 + (phase >= phases / 2 ? 1 : 0)] += (1 << 14) - total;
+
+		int16 *stereoCoefs = filter->stereoCoefs + phase * taps * 2;
+		for (uint i = 0; i < taps; i += 2) {
+			stereoCoefs[i * 2 + 0] = stereoCoefs[i * 2 + 2] = coefs[i];
+			stereoCoefs[i * 2 + 1] = stereoCoefs[i * 2 + 3] = coefs[i + 1];
+		}
+	}
+	delete[] window;
+
+	return filter;
+}
+
+/**
+ * Filters created so far. Upsampling filters only depend on the quality,
+ * downsampling filters also on the ratio of the rates, so there are only
+ * a few of them in practice.
+ */
+class SincFilterCache {
+public:
+	~SincFilterCache() {
+		for (uint i = 0; i < _entries.size(); ++i) {
+			delete[] _entries[i].filter->coefs;
+			delete[] _entries[i].filter->stereoCoefs;
+			delete _entries[i].filter;
+		}
+	}
+
+	const SincFilter &get(ResamplingQuality quality, st_rate_t inrate, st_rate_t outrate) {
+		// Reduce the ratio, so equivalent rate pairs share their filter
+		if (outrate >= inrate) {
+			inrate = outrate = 1;
+		} else {
+			const st_rate_t gcd = Common::gcd(inrate, outrate);
+			inrate /= gcd;
+			outrate /= gcd;
+		}
+
+		for (uint i = 0; i < _entries.size(); ++i) {
+			const Entry &entry = _entries[i];
+			if (entry.quality == quality && entry.inrate == inrate && entry.outrate == outrate)
+				return *entry.filter;
+		}
+
+		const SincQuality &params = sincQualities[quality - kResamplingSincFast];
+		Entry entry;
+		entry.quality = quality;
+		entry.inrate = inrate;
+		entry.outrate = outrate;
+		// When downsampling, the filter has to span proportionally more
+		// input frames to keep the transition band equally narrow.
+		uint taps = params.taps * inrate / outrate;
+		taps = MIN<uint>((taps + 7) & ~7, kMaxSincTaps);
+		entry.filter = createSincFilter(params, taps, params.rolloff * outrate / inrate);
+		_entries.push_back(entry);
+		return *entry.filter;
+	}
+
+private:
+	struct Entry {
+		ResamplingQuality quality;
+		st_rate_t inrate, outrate;
+		SincFilter *filter;
+	};
+
+	Common::Array<Entry> _entries;
+};
+
+static const SincFilter &getSincFilter(ResamplingQuality quality, st_rate_t inrate, st_rate_t outrate) {
+	static SincFilterCache cache;
+	return cache.get(quality, inrate, outrate);
+}
+
+/**
+ * Audio rate converter based on band-limited interpolation with a
+ * polyphase windowed-sinc filter. Compared to linear interpolation this
+ * avoids most of the aliasing, at the cost of more CPU time.
+ *
+ * The output is aligned with the input, so the filter has to look
+ * filter.taps / 2 frames ahead in the input stream.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	const SincFilter &filter;
+
+	/** Input frames, starting with the history the filter still needs. */
+	st_sample_t *inBuf;
+	uint32 inFrames;
+	uint32 inCapacity;
+
+	/**
+	 * fractional position of the output stream in input stream unit,
+	 * relative to the start of inBuf.
+	 */
+	uint32 opos;
+
+	/** fractional position increment in the output stream */
+	uint32 opos_inc;
+
+	const RateKernels &kernels;
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality, const RateKernels &k);
+	~SincRateConverter() {
+		delete[] inBuf;
+	}
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality, const RateKernels &k)
+	: filter(getSincFilter(quality, inrate, outrate)), kernels(k) {
+	if (inrate >= 131072 || outrate >= 131072) {
+		error("rate effect can only handle rates < 131072");
+	}
+
+	opos_inc = (inrate << FRAC_BITS_LOW) / outrate;
+
+	// All buffers are allocated here, so flow() does not have to.
+	inCapacity = filter.taps + INTERMEDIATE_BUFFER_SIZE / (stereo ? 2 : 1);
+	inBuf = new st_sample_t[inCapacity * (stereo ? 2 : 1)];
+
+	// The filter for the first output frame reaches back before the
+	// start of the input, which is treated as silence.
+	inFrames = filter.taps / 2 - 1;
+	memset(inBuf, 0, inFrames * (stereo ? 2 : 1) * sizeof(st_sample_t));
+	opos = inFrames * FRAC_ONE_LOW;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	const int numChannels = (stereo ? 2 : 1);
+	const uint32 halfTaps = filter.taps / 2;
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+	st_size_t done = 0;
+
+	while (done < osamp) {
+
+		// read enough input samples so that the filter covers the current position
+		while ((opos >> FRAC_BITS_LOW) + halfTaps >= inFrames) {
+			// Drop the frames the filter does not need anymore. When
+			// downsampling, this can include frames not read yet.
+			const uint32 drop = MIN<uint32>((opos >> FRAC_BITS_LOW) + 1 - halfTaps, inFrames);
+			memmove(inBuf, inBuf + drop * numChannels, (inFrames - drop) * numChannels * sizeof(st_sample_t));
+			opos -= drop * FRAC_ONE_LOW;
+			inFrames -= drop;
+
+			const int inLen = input.readBuffer(inBuf + inFrames * numChannels, (inCapacity - inFrames) * numChannels);
+			if (inLen <= 0)
+				return done;
+			inFrames += inLen / numChannels;
 		}
+
+		// Compute as many output frames as the buffered input allows
+		const uint32 available = ((inFrames - halfTaps) * FRAC_ONE_LOW - opos + opos_inc - 1) / opos_inc;
+		st_size_t frames = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / numChannels);
+		frames = MIN<st_size_t>(frames, available);
+
+		if (stereo)
+			kernels.filterStereo(outBuf, inBuf, opos, opos_inc, frames, filter);
+		else
+			kernels.filterMono(outBuf, inBuf, opos, opos_inc, frames, filter);
+		mixFrames<stereo, reverseStereo>(kernels, obuf + done * 2, outBuf, frames, vol_l, vol_r);
+
+		// Increment output position
+		opos += frames * opos_inc;
+		done += frames;
 	}
-	return (obuf - ostart) / 2;
+	return done;
 }
 
 
@@ -284,8 +545,9 @@ template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
+	const RateKernels &_kernels;
 public:
-	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
+	CopyRateConverter(const RateKernels &kernels) : _buffer(0), _bufferSize(0), _kernels(kernels) {}
 	~CopyRateConverter() {
 		free(_buffer);
 	}
@@ -293,11 +555,6 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
-		st_size_t len;
-
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -312,24 +569,14 @@ public:
 			error("[CopyRateConverter::flow] Cannot allocate memory for temp buffer");
 
 		// Read up to 'osamp' samples into our temporary buffer
-		len = input.readBuffer(_buffer, osamp);
+		const int len = input.readBuffer(_buffer, osamp);
+		if (len <= 0)
+			return 0;
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t frames = len / (stereo ? 2 : 1);
+		mixFrames<stereo, reverseStereo>(_kernels, obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -341,29 +588,51 @@ public:
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, ResamplingQuality quality, const RateKernels &kernels) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0 && (inrate < 65536)) {
-			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
+		if (quality != kResamplingLinear) {
+			return new SincRateConverter<stereo, reverseStereo>(inrate, outrate, quality, kernels);
+		} else if ((inrate % outrate) == 0 && (inrate < 65536)) {
+			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate, kernels);
 		} else {
-			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
+			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate, kernels);
 		}
 	} else {
-		return new CopyRateConverter<stereo, reverseStereo>();
+		return new CopyRateConverter<stereo, reverseStereo>(kernels);
 	}
 }
 
-/**
- * Create and return a RateConverter object for the specified input and output rates.
- */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality, const RateKernels &kernels) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality, kernels);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality, kernels);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality, kernels);
+}
+
+ResamplingQuality getConfiguredResamplingQuality() {
+	const Common::String &quality = ConfMan.get("resampling_quality");
+	if (quality.equalsIgnoreCase("fast"))
+		return kResamplingSincFast;
+	else if (quality.equalsIgnoreCase("medium"))
+		return kResamplingSincMedium;
+	else if (quality.equalsIgnoreCase("best"))
+		return kResamplingSincBest;
+	else
+		return kResamplingLinear;
+}
+
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality) {
+	return makeRateConverter(inrate, outrate, stereo, reverseStereo, quality, getRateKernels());
+}
+
+/**
+ * Create and return a RateConverter object for the specified input and output rates.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	return makeRateConverter(inrate, outrate, stereo, reverseStereo, getConfiguredResamplingQuality());
 }
 
 } // End of namespace Audio
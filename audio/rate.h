@@ -78,8 +78,41 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
+/**
+ * Quality of the rate conversion.
+ */
+enum ResamplingQuality {
+	/** Linear interpolation, or dropping samples for integer ratios. */
+	kResamplingLinear,
+	/** Band-limited resampling with short polyphase filters. */
+	kResamplingSincFast,
+	kResamplingSincMedium,
+	/** Band-limited resampling with long polyphase filters. */
+	kResamplingSincBest
+};
+
+/**
+ * Return the resampling quality selected by the "resampling_quality"
+ * config key ("linear", "fast", "medium" or "best").
+ */
+ResamplingQuality getConfiguredResamplingQuality();
+
+/**
+ * Create and return a RateConverter object for the specified input and
+ * output rates, using the configured resampling quality.
+ */
 RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
 
+/**
+ * Create and return a RateConverter object for the specified input and
+ * output rates, using the given resampling quality.
+ *
+ * The filters used by the band-limited qualities are shared between all
+ * converters with the same parameters and kept around once created. Like
+ * the rest of the converter setup, this function is not thread-safe.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality);
+
 } // End of namespace Audio
 
 #endif
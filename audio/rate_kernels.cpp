@@ -0,0 +1,132 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/rate_kernels.h"
+#include "audio/mixer.h"
+#include "common/system.h"
+#include "common/util.h"
+
+namespace Audio {
+
+static void mixMonoScalar(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR) {
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t out = *ibuf++;
+
+		// output left channel
+		clampedAdd(obuf[0], (out * volL) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[1], (out * volR) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+template<bool reverseStereo>
+static void mixStereoScalar(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR) {
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t out0 = *ibuf++;
+		const st_sample_t out1 = *ibuf++;
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * volL) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * volR) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+template<bool stereo>
+static void interpolateScalar(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames) {
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t *icur = ibuf + (pos >> FRAC_BITS_LOW) * (stereo ? 2 : 1);
+		const st_sample_t *ilast = icur - (stereo ? 2 : 1);
+		const int frac = pos & (FRAC_ONE_LOW - 1);
+
+		*obuf++ = (st_sample_t)(ilast[0] + (((icur[0] - ilast[0]) * frac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+		if (stereo)
+			*obuf++ = (st_sample_t)(ilast[1] + (((icur[1] - ilast[1]) * frac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+
+		pos += inc;
+	}
+}
+
+template<bool stereo>
+static void filterScalar(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames, const SincFilter &filter) {
+	const uint taps = filter.taps;
+	const uint phaseShift = FRAC_BITS_LOW - filter.phaseBits;
+
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t *in = ibuf + ((pos >> FRAC_BITS_LOW) + 1 - taps / 2) * (stereo ? 2 : 1);
+		const int16 *coefs = filter.coefs + ((pos & (FRAC_ONE_LOW - 1)) >> phaseShift) * taps;
+
+		int32 acc0 = 0, acc1 = 0;
+		for (uint i = 0; i < taps; ++i) {
+			acc0 += in[0] * coefs[i];
+			if (stereo)
+				acc1 += in[1] * coefs[i];
+			in += (stereo ? 2 : 1);
+		}
+
+		*obuf++ = CLIP<int32>((acc0 + (1 << 13)) >> 14, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		if (stereo)
+			*obuf++ = CLIP<int32>((acc1 + (1 << 13)) >> 14, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+		pos += inc;
+	}
+}
+
+const RateKernels &getScalarRateKernels() {
+	static const RateKernels kernels = {
+		mixMonoScalar,
+		mixStereoScalar<false>,
+		mixStereoScalar<true>,
+		interpolateScalar<false>,
+		interpolateScalar<true>,
+		filterScalar<false>,
+		filterScalar<true>
+	};
+	return kernels;
+}
+
+static const RateKernels *detectRateKernels() {
+	// The vectorized kernels rely on saturating signed arithmetic and do not
+	// handle unsigned output.
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#ifdef SCUMMVM_SSE2
+	if (g_system && g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		return &getSSE2RateKernels();
+#endif
+#endif
+	return &getScalarRateKernels();
+}
+
+const RateKernels &getRateKernels() {
+	static const RateKernels *kernels = 0;
+	if (!kernels)
+		kernels = detectRateKernels();
+	return *kernels;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,136 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_KERNELS_H
+#define AUDIO_RATE_KERNELS_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * The default fractional type in frac.h (with 16 fractional bits) limits
+ * the rate conversion code to 65536Hz audio: we need to able to handle
+ * 96kHz audio, so we use fewer fractional bits in this code.
+ */
+enum {
+	FRAC_BITS_LOW = 15,
+	FRAC_ONE_LOW = (1L << FRAC_BITS_LOW),
+	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
+};
+
+/**
+ * A windowed-sinc lowpass filter, sampled at 1 << phaseBits fractional
+ * offsets (phases) for use by the polyphase resampler. The coefficients
+ * have 14 fractional bits and the coefficients of each phase sum up to
+ * exactly 1 << 14.
+ */
+struct SincFilter {
+	/** Number of coefficients per phase, a multiple of 8. */
+	uint taps;
+
+	/** Number of bits of the fractional position used to select the phase. */
+	uint phaseBits;
+
+	/** taps coefficients for each phase. */
+	int16 *coefs;
+
+	/**
+	 * The same coefficients, rearranged for filtering interleaved stereo
+	 * frames: each pair of taps c0, c1 is stored as c0, c1, c0, c1.
+	 */
+	int16 *stereoCoefs;
+};
+
+/**
+ * Batch processing kernels used by the rate converters. The converters
+ * first produce a block of resampled frames and then hand it over to
+ * these functions, which allows vectorized implementations to work on
+ * several samples at once. All implementations produce bit-identical
+ * output.
+ */
+struct RateKernels {
+	/**
+	 * Scale numFrames mono samples by volL/volR and add them to the
+	 * interleaved stereo buffer obuf, clamping the result.
+	 */
+	void (*mixMono)(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR);
+
+	/**
+	 * Scale numFrames interleaved stereo frames by volL/volR and add
+	 * them to obuf, clamping the result.
+	 */
+	void (*mixStereo)(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR);
+
+	/**
+	 * Same as mixStereo, but the left input channel is added to the right
+	 * output channel and vice versa.
+	 */
+	void (*mixStereoReverse)(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR);
+
+	/**
+	 * Linearly interpolate numFrames mono frames from ibuf. The position of
+	 * output frame k is p = pos + k * inc (with FRAC_BITS_LOW fractional
+	 * bits), and the frame is interpolated between the input frames
+	 * (p >> FRAC_BITS_LOW) - 1 and (p >> FRAC_BITS_LOW).
+	 */
+	void (*interpolateMono)(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames);
+
+	/** Same as interpolateMono for interleaved stereo frames. */
+	void (*interpolateStereo)(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames);
+
+	/**
+	 * Resample numFrames mono frames from ibuf with a polyphase filter. The
+	 * position of output frame k is p = pos + k * inc (with FRAC_BITS_LOW
+	 * fractional bits). The filter is applied to the filter.taps input
+	 * frames starting at frame (p >> FRAC_BITS_LOW) + 1 - filter.taps / 2,
+	 * using the phase selected by the fractional part of p.
+	 */
+	void (*filterMono)(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames, const SincFilter &filter);
+
+	/** Same as filterMono for interleaved stereo frames. */
+	void (*filterStereo)(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames, const SincFilter &filter);
+};
+
+/** Plain C++ kernels, available on all platforms. */
+const RateKernels &getScalarRateKernels();
+
+#ifdef SCUMMVM_SSE2
+/** Kernels using SSE2. Only use them if OSystem::kFeatureCpuSSE2 is set. */
+const RateKernels &getSSE2RateKernels();
+#endif
+
+/**
+ * Return the fastest kernels supported by the CPU. The choice is made
+ * once, on the first call.
+ */
+const RateKernels &getRateKernels();
+
+/**
+ * Create a RateConverter which uses the given kernels instead of the ones
+ * returned by getRateKernels(). Mostly useful for testing.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, ResamplingQuality quality, const RateKernels &kernels);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,252 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/rate_kernels.h"
+#include "audio/mixer.h"
+#include "common/endian.h"
+
+#ifdef SCUMMVM_SSE2
+
+#include <emmintrin.h>
+
+namespace Audio {
+
+/**
+ * Multiply eight samples by the volume and divide the 32 bit products by
+ * kMaxMixerVolume, rounding towards zero like the scalar code does.
+ */
+static inline __m128i scaleSSE2(__m128i samples, __m128i vol) {
+	const __m128i bias = _mm_set1_epi32(Mixer::kMaxMixerVolume - 1);
+	const __m128i lo = _mm_mullo_epi16(samples, vol);
+	const __m128i hi = _mm_mulhi_epi16(samples, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), 8);
+	return _mm_packs_epi32(p0, p1);
+}
+
+static void mixMonoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR) {
+	// Larger volumes could overflow the 16 bit intermediate results
+	if (volL > Mixer::kMaxMixerVolume || volR > Mixer::kMaxMixerVolume) {
+		getScalarRateKernels().mixMono(obuf, ibuf, numFrames, volL, volR);
+		return;
+	}
+
+	const __m128i vl = _mm_set1_epi16(volL);
+	const __m128i vr = _mm_set1_epi16(volR);
+	for (; numFrames >= 8; numFrames -= 8) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+		const __m128i l = scaleSSE2(in, vl);
+		const __m128i r = scaleSSE2(in, vr);
+		const __m128i o0 = _mm_loadu_si128((const __m128i *)obuf);
+		const __m128i o1 = _mm_loadu_si128((const __m128i *)(obuf + 8));
+		_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(o0, _mm_unpacklo_epi16(l, r)));
+		_mm_storeu_si128((__m128i *)(obuf + 8), _mm_adds_epi16(o1, _mm_unpackhi_epi16(l, r)));
+		ibuf += 8;
+		obuf += 16;
+	}
+
+	getScalarRateKernels().mixMono(obuf, ibuf, numFrames, volL, volR);
+}
+
+template<bool reverseStereo>
+static void mixStereoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint numFrames, int volL, int volR) {
+	if (volL > Mixer::kMaxMixerVolume || volR > Mixer::kMaxMixerVolume) {
+		if (reverseStereo)
+			getScalarRateKernels().mixStereoReverse(obuf, ibuf, numFrames, volL, volR);
+		else
+			getScalarRateKernels().mixStereo(obuf, ibuf, numFrames, volL, volR);
+		return;
+	}
+
+	// With reversed stereo the channels of each frame are swapped first, so
+	// the output lanes need the volumes in swapped order as well.
+	const __m128i vol = reverseStereo ?
+		_mm_set_epi16(volL, volR, volL, volR, volL, volR, volL, volR) :
+		_mm_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+	for (; numFrames >= 4; numFrames -= 4) {
+		__m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+		if (reverseStereo) {
+			in = _mm_shufflelo_epi16(in, _MM_SHUFFLE(2, 3, 0, 1));
+			in = _mm_shufflehi_epi16(in, _MM_SHUFFLE(2, 3, 0, 1));
+		}
+		const __m128i out = _mm_loadu_si128((const __m128i *)obuf);
+		_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(out, scaleSSE2(in, vol)));
+		ibuf += 8;
+		obuf += 8;
+	}
+
+	if (reverseStereo)
+		getScalarRateKernels().mixStereoReverse(obuf, ibuf, numFrames, volL, volR);
+	else
+		getScalarRateKernels().mixStereo(obuf, ibuf, numFrames, volL, volR);
+}
+
+/**
+ * Interpolate between the 16 bit sample pairs (last in the low half, current
+ * in the high half) of each 32 bit lane. The weights hold
+ * FRAC_ONE_LOW - 1 - frac in the low half and frac in the high half, so the
+ * sum of the products plus the last sample equals
+ * (last << FRAC_BITS_LOW) + (cur - last) * frac.
+ */
+static inline __m128i interpolatePairsSSE2(__m128i pairs, __m128i weights) {
+	const __m128i last = _mm_srai_epi32(_mm_slli_epi32(pairs, 16), 16);
+	const __m128i sum = _mm_add_epi32(_mm_madd_epi16(pairs, weights), last);
+	return _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(FRAC_HALF_LOW)), FRAC_BITS_LOW);
+}
+
+static inline int interpolationWeights(uint32 pos) {
+	const int frac = pos & (FRAC_ONE_LOW - 1);
+	return (frac << 16) | (FRAC_ONE_LOW - 1 - frac);
+}
+
+static void interpolateMonoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames) {
+	for (; numFrames >= 4; numFrames -= 4) {
+		const uint32 p0 = pos;
+		const uint32 p1 = p0 + inc;
+		const uint32 p2 = p1 + inc;
+		const uint32 p3 = p2 + inc;
+		pos = p3 + inc;
+
+		const __m128i pairs = _mm_set_epi32(
+			READ_UINT32(ibuf + (p3 >> FRAC_BITS_LOW) - 1),
+			READ_UINT32(ibuf + (p2 >> FRAC_BITS_LOW) - 1),
+			READ_UINT32(ibuf + (p1 >> FRAC_BITS_LOW) - 1),
+			READ_UINT32(ibuf + (p0 >> FRAC_BITS_LOW) - 1));
+		const __m128i weights = _mm_set_epi32(
+			interpolationWeights(p3), interpolationWeights(p2),
+			interpolationWeights(p1), interpolationWeights(p0));
+		const __m128i out = interpolatePairsSSE2(pairs, weights);
+		_mm_storel_epi64((__m128i *)obuf, _mm_packs_epi32(out, out));
+		obuf += 4;
+	}
+
+	getScalarRateKernels().interpolateMono(obuf, ibuf, pos, inc, numFrames);
+}
+
+/**
+ * Load the two stereo frames preceding and at the given position and
+ * arrange them as (lastL, curL, lastR, curR) sample pairs.
+ */
+static inline __m128i loadStereoPairsSSE2(const st_sample_t *ibuf, uint32 p0, uint32 p1) {
+	const __m128i f0 = _mm_loadl_epi64((const __m128i *)(ibuf + ((p0 >> FRAC_BITS_LOW) - 1) * 2));
+	const __m128i f1 = _mm_loadl_epi64((const __m128i *)(ibuf + ((p1 >> FRAC_BITS_LOW) - 1) * 2));
+	const __m128i frames = _mm_unpacklo_epi64(f0, f1);
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(frames, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static void interpolateStereoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames) {
+	for (; numFrames >= 4; numFrames -= 4) {
+		const uint32 p0 = pos;
+		const uint32 p1 = p0 + inc;
+		const uint32 p2 = p1 + inc;
+		const uint32 p3 = p2 + inc;
+		pos = p3 + inc;
+
+		const int w0 = interpolationWeights(p0);
+		const int w1 = interpolationWeights(p1);
+		const int w2 = interpolationWeights(p2);
+		const int w3 = interpolationWeights(p3);
+		const __m128i out0 = interpolatePairsSSE2(loadStereoPairsSSE2(ibuf, p0, p1), _mm_set_epi32(w1, w1, w0, w0));
+		const __m128i out1 = interpolatePairsSSE2(loadStereoPairsSSE2(ibuf, p2, p3), _mm_set_epi32(w3, w3, w2, w2));
+		_mm_storeu_si128((__m128i *)obuf, _mm_packs_epi32(out0, out1));
+		obuf += 8;
+	}
+
+	getScalarRateKernels().interpolateStereo(obuf, ibuf, pos, inc, numFrames);
+}
+
+/**
+ * Round the filter sums, which have 14 fractional bits, and saturate them
+ * to 16 bits.
+ */
+static inline __m128i roundFilterSSE2(__m128i acc) {
+	return _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 13)), 14);
+}
+
+static void filterMonoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames, const SincFilter &filter) {
+	const uint taps = filter.taps;
+	const uint phaseShift = FRAC_BITS_LOW - filter.phaseBits;
+
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t *in = ibuf + (pos >> FRAC_BITS_LOW) + 1 - taps / 2;
+		const int16 *coefs = filter.coefs + ((pos & (FRAC_ONE_LOW - 1)) >> phaseShift) * taps;
+
+		__m128i acc = _mm_setzero_si128();
+		for (uint i = 0; i < taps; i += 8) {
+			const __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+			const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(x, c));
+		}
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+		acc = roundFilterSSE2(acc);
+		*obuf++ = (st_sample_t)_mm_cvtsi128_si32(_mm_packs_epi32(acc, acc));
+
+		pos += inc;
+	}
+}
+
+static void filterStereoSSE2(st_sample_t *obuf, const st_sample_t *ibuf, uint32 pos, uint32 inc, uint numFrames, const SincFilter &filter) {
+	const uint taps = filter.taps;
+	const uint phaseShift = FRAC_BITS_LOW - filter.phaseBits;
+
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t *in = ibuf + ((pos >> FRAC_BITS_LOW) + 1 - taps / 2) * 2;
+		const int16 *coefs = filter.stereoCoefs + ((pos & (FRAC_ONE_LOW - 1)) >> phaseShift) * taps * 2;
+
+		// Rearrange each group of two frames to L0 L1 R0 R1, so that
+		// multiplying with c0 c1 c0 c1 sums up each channel separately.
+		__m128i acc = _mm_setzero_si128();
+		for (uint i = 0; i < taps * 2; i += 8) {
+			__m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+			x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0));
+			x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 1, 2, 0));
+			const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(x, c));
+		}
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc = roundFilterSSE2(acc);
+		WRITE_UINT32(obuf, _mm_cvtsi128_si32(_mm_packs_epi32(acc, acc)));
+		obuf += 2;
+
+		pos += inc;
+	}
+}
+
+const RateKernels &getSSE2RateKernels() {
+	static const RateKernels kernels = {
+		mixMonoSSE2,
+		mixStereoSSE2<false>,
+		mixStereoSSE2<true>,
+		interpolateMonoSSE2,
+		interpolateStereoSSE2,
+		filterMonoSSE2,
+		filterStereoSSE2
+	};
+	return kernels;
+}
+
+} // End of namespace Audio
+
+#endif // SCUMMVM_SSE2
@@ -35,6 +35,7 @@
 // Last synch with DOSBox SVN trunk r3752
 
 #include "dbopl.h"
+#include "common/system.h"
 
 #ifndef DISABLE_DOSBOX_OPL
 
@@ -46,22 +47,6 @@ namespace DBOPL {
 #define OPLRATE		((double)(14318180.0 / 288.0))
 #define TREMOLO_TABLE 52
 
-//Try to use most precision for frequencies
-//Else try to keep different waves in synch
-//#define WAVE_PRECISION	1
-#ifndef WAVE_PRECISION
-//Wave bits available in the top of the 32bit range
-//Original adlib uses 10.10, we use 10.22
-#define WAVE_BITS	10
-#else
-//Need some extra bits at the top to have room for octaves and frequency multiplier
-//We support to 8 times lower rate
-//128 * 15 * 8 = 15350, 2^13.9, so need 14 bits
-#define WAVE_BITS	14
-#endif
-#define WAVE_SH		( 32 - WAVE_BITS )
-#define WAVE_MASK	( ( 1 << WAVE_SH ) - 1 )
-
 //Use the same accuracy as the waves
 #define LFO_SH ( WAVE_SH - 10 )
 //LFO is controlled by our tremolo 256 sample limit
@@ -87,8 +72,6 @@ namespace DBOPL {
 //Attack/decay/release rate counter shift
 #define RATE_SH		24
 #define RATE_MASK	( ( 1 << RATE_SH ) - 1 )
-//Has to fit within 16bit lookuptable
-#define MUL_SH		16
 
 //Check some ranges
 #if ENV_EXTRA > 3
@@ -598,6 +581,101 @@ INLINE Bits Operator::GetSample( Bits modulation ) {
 	}
 }
 
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+static INLINE Bit16u VolumeMul( Bitu vol ) {
+	//Silent operators get multiplied by 0
+	return ENV_SILENT( vol ) ? 0 : MulTable[ vol >> ENV_EXTRA ];
+}
+
+//Run the envelope of a state till the state changes
+//The volume can only change when the rate counter overflows, so the samples
+//in between get the same volume without running the volume handler
+template< Operator::State yes>
+Bitu Operator::TemplateVolumeBatch( Bitu i, Bitu samples, Bit16u* mul ) {
+	Bit32u add;
+	//Volume at which the state ends even without a change
+	Bit32s limit;
+	switch ( yes ) {
+	case ATTACK:
+		add = attackAdd;
+		limit = ENV_MAX + 1;
+		break;
+	case DECAY:
+		add = decayAdd;
+		limit = sustainLevel;
+		break;
+	default:
+		add = releaseAdd;
+		limit = ENV_MAX;
+		break;
+	}
+	while ( i < samples ) {
+		if ( volume < limit ) {
+			Bitu steady = samples - i;
+			if ( add && ( RATE_MASK - rateIndex ) / add < steady )
+				steady = ( RATE_MASK - rateIndex ) / add;
+			rateIndex += steady * add;
+			Bit16u m = VolumeMul( currentLevel + volume );
+			for ( ; steady > 0; steady-- )
+				mul[i++] = m;
+			if ( i == samples )
+				break;
+		}
+		mul[i++] = VolumeMul( currentLevel + TemplateVolume<yes>() );
+		if ( GCC_UNLIKELY( state != yes ) )
+			break;
+	}
+	return i;
+}
+
+void Operator::ForwardVolumeBatch( Bitu samples, Bit16u* mul ) {
+	Bitu i = 0;
+	while ( i < samples ) {
+		switch ( state ) {
+		case OFF:
+		default:
+			//Can only change with a key on
+			for ( ; i < samples; i++ )
+				mul[i] = 0;
+			break;
+		case RELEASE:
+			i = TemplateVolumeBatch<RELEASE>( i, samples, mul );
+			break;
+		case SUSTAIN:
+			if ( reg20 & MASK_SUSTAIN ) {
+				//Stays at the same volume till a key off
+				Bit16u m = VolumeMul( currentLevel + volume );
+				for ( ; i < samples; i++ )
+					mul[i] = m;
+			} else {
+				i = TemplateVolumeBatch<SUSTAIN>( i, samples, mul );
+			}
+			break;
+		case DECAY:
+			i = TemplateVolumeBatch<DECAY>( i, samples, mul );
+			break;
+		case ATTACK:
+			i = TemplateVolumeBatch<ATTACK>( i, samples, mul );
+			break;
+		}
+	}
+}
+
+//The volume and wave position don't depend on the modulation, so they
+//can be calculated for the whole batch first
+INLINE void Operator::ForwardBatch( const Kernels* kernels, Bitu samples, Bit32u* index, Bit16u* mul ) {
+	ForwardVolumeBatch( samples, mul );
+	kernels->forwardWave( index, waveIndex, waveCurrent, samples );
+}
+
+INLINE void Operator::GetSamples( const Kernels* kernels, Bitu samples, const Bit32s* modulation, Bit32s* output ) {
+	Bit32u index[ BATCH_SAMPLES ];
+	Bit16u mul[ BATCH_SAMPLES ];
+	ForwardBatch( kernels, samples, index, mul );
+	kernels->getWave( output, waveBase, waveMask, index, modulation, mul, samples );
+}
+#endif
+
 Operator::Operator() {
 	chanData = 0;
 	freqMul = 0;
@@ -843,6 +921,57 @@ INLINE void Channel::GeneratePercussion( Chip* chip, Bit32s* output ) {
 	}
 }
 
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+//The first operator of the channel is generated by the chip
+template<SynthMode mode>
+void Channel::BatchTemplate( const Kernels* kernels, Bitu samples, const Bit32s* out0, Bit32s* output ) {
+	Bit32s sample[ BATCH_SAMPLES ];
+	Bit32s next[ BATCH_SAMPLES ];
+	//The other operators only depend on the output of the previous ones
+	if ( mode == sm2AM || mode == sm3AM ) {
+		Op(1)->GetSamples( kernels, samples, 0, sample );
+		for ( Bitu i = 0; i < samples; i++ )
+			sample[i] += out0[i];
+	} else if ( mode == sm2FM || mode == sm3FM ) {
+		Op(1)->GetSamples( kernels, samples, out0, sample );
+	} else if ( mode == sm3FMFM ) {
+		Op(1)->GetSamples( kernels, samples, out0, next );
+		Op(2)->GetSamples( kernels, samples, next, next );
+		Op(3)->GetSamples( kernels, samples, next, sample );
+	} else if ( mode == sm3AMFM ) {
+		Op(1)->GetSamples( kernels, samples, 0, next );
+		Op(2)->GetSamples( kernels, samples, next, next );
+		Op(3)->GetSamples( kernels, samples, next, sample );
+		for ( Bitu i = 0; i < samples; i++ )
+			sample[i] += out0[i];
+	} else if ( mode == sm3FMAM ) {
+		Op(1)->GetSamples( kernels, samples, out0, sample );
+		Op(2)->GetSamples( kernels, samples, 0, next );
+		Op(3)->GetSamples( kernels, samples, next, next );
+		for ( Bitu i = 0; i < samples; i++ )
+			sample[i] += next[i];
+	} else if ( mode == sm3AMAM ) {
+		Op(1)->GetSamples( kernels, samples, 0, next );
+		Op(2)->GetSamples( kernels, samples, next, next );
+		for ( Bitu i = 0; i < samples; i++ )
+			sample[i] = out0[i] + next[i];
+		Op(3)->GetSamples( kernels, samples, 0, next );
+		for ( Bitu i = 0; i < samples; i++ )
+			sample[i] += next[i];
+	}
+
+	if ( mode == sm2AM || mode == sm2FM ) {
+		for ( Bitu i = 0; i < samples; i++ )
+			output[ i ] += sample[i];
+	} else {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			output[ i * 2 + 0 ] += sample[i] & maskLeft;
+			output[ i * 2 + 1 ] += sample[i] & maskRight;
+		}
+	}
+}
+#endif
+
 template<SynthMode mode>
 Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 	switch( mode ) {
@@ -918,6 +1047,16 @@ Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 		Op( 4 )->Prepare( chip );
 		Op( 5 )->Prepare( chip );
 	}
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+	//Only the percussion is generated sample by sample, the other modes
+	//are generated in batches by the chip once all channels are prepared
+	if ( mode != sm2Percussion && mode != sm3Percussion ) {
+		chip->batchChannel[ chip->batchCount ] = this;
+		chip->batchHandler[ chip->batchCount ] = &Channel::BatchTemplate< mode >;
+		chip->batchCount++;
+		return ( mode > sm4Start ) ? ( this + 2 ) : ( this + 1 );
+	}
+#endif
 	for ( Bitu i = 0; i < samples; i++ ) {
 		//Early out for percussion handlers
 		if ( mode == sm2Percussion ) {
@@ -1035,6 +1174,8 @@ Chip::Chip() {
 	regBD = 0;
 	reg104 = 0;
 	opl3Active = 0;
+	kernels = &GetKernels();
+	batchCount = 0;
 }
 
 INLINE Bit32u Chip::ForwardNoise() {
@@ -1235,6 +1376,57 @@ Bit32u Chip::WriteAddr( Bit32u port, Bit8u val ) {
 	return 0;
 }
 
+void Chip::GenerateBatches( Bitu total, Bit32s* output, Bitu stride ) {
+#if ( DBOPL_WAVE == WAVE_TABLEMUL )
+	Bit32u index[ 18 ][ BATCH_SAMPLES ];
+	Bit16u mul[ 18 ][ BATCH_SAMPLES ];
+	Bit32s out0[ 18 ][ BATCH_SAMPLES ];
+	//Copies of the feedback state of the channels
+	Bit32s old[ 18 ][ 2 ];
+	Bit32u feedback[ 18 ];
+	const Bit16s* waveBase[ 18 ];
+	Bit32u waveMask[ 18 ];
+	if ( !batchCount )
+		return;
+	for ( Bitu c = 0; c < batchCount; c++ ) {
+		const Channel* ch = batchChannel[c];
+		old[c][0] = ch->old[0];
+		old[c][1] = ch->old[1];
+		feedback[c] = ch->feedback;
+		waveBase[c] = ch->op[0].waveBase;
+		waveMask[c] = ch->op[0].waveMask;
+	}
+	for ( Bitu done = 0; done < total; done += BATCH_SAMPLES ) {
+		Bitu samples = total - done;
+		if ( samples > BATCH_SAMPLES )
+			samples = BATCH_SAMPLES;
+		for ( Bitu c = 0; c < batchCount; c++ )
+			batchChannel[c]->op[0].ForwardBatch( kernels, samples, index[c], mul[c] );
+		//The feedback of the first operator needs to be done sample by sample,
+		//doing all channels at once lets the cpu work on them in parallel
+		for ( Bitu i = 0; i < samples; i++ ) {
+			for ( Bitu c = 0; c < batchCount; c++ ) {
+				//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
+				Bit32s mod = (Bit32u)((old[c][0] + old[c][1])) >> feedback[c];
+				Bit32s out = old[c][1];
+				out0[c][i] = out;
+				old[c][0] = out;
+				old[c][1] = (waveBase[c][ ( index[c][i] + mod ) & waveMask[c] ] * mul[c][i]) >> MUL_SH;
+			}
+		}
+		for ( Bitu c = 0; c < batchCount; c++ ) {
+			Channel* ch = batchChannel[c];
+			(ch->*batchHandler[c])( kernels, samples, out0[c], output + done * stride );
+		}
+	}
+	for ( Bitu c = 0; c < batchCount; c++ ) {
+		batchChannel[c]->old[0] = old[c][0];
+		batchChannel[c]->old[1] = old[c][1];
+	}
+#endif
+	batchCount = 0;
+}
+
 void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 	while ( total > 0 ) {
 		Bit32u samples = ForwardLFO( total );
@@ -1244,6 +1436,7 @@ void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 			count++;
 			ch = (ch->*(ch->synthHandler))( this, samples, output );
 		}
+		GenerateBatches( samples, output, 1 );
 		total -= samples;
 		output += samples;
 	}
@@ -1258,6 +1451,7 @@ void Chip::GenerateBlock3( Bitu total, Bit32s* output  ) {
 			count++;
 			ch = (ch->*(ch->synthHandler))( this, samples, output );
 		}
+		GenerateBatches( samples, output, 2 );
 		total -= samples;
 		output += samples * 2;
 	}
@@ -1385,6 +1579,52 @@ void Chip::Setup( Bit32u rate ) {
 	}
 }
 
+/*
+	Kernels
+*/
+
+static void ForwardWaveScalar( Bit32u* index, Bit32u& counter, Bit32u add, Bitu samples ) {
+	Bit32u c = counter;
+	for ( Bitu i = 0; i < samples; i++ ) {
+		c += add;
+		index[i] = c >> WAVE_SH;
+	}
+	counter = c;
+}
+
+static void GetWaveScalar( Bit32s* output, const Bit16s* waveBase, Bit32u waveMask, const Bit32u* index, const Bit32s* modulation, const Bit16u* mul, Bitu samples ) {
+	if ( modulation ) {
+		for ( Bitu i = 0; i < samples; i++ )
+			output[i] = (waveBase[ ( index[i] + modulation[i] ) & waveMask ] * mul[i]) >> MUL_SH;
+	} else {
+		for ( Bitu i = 0; i < samples; i++ )
+			output[i] = (waveBase[ index[i] & waveMask ] * mul[i]) >> MUL_SH;
+	}
+}
+
+const Kernels& GetScalarKernels() {
+	static const Kernels kernels = {
+		ForwardWaveScalar,
+		GetWaveScalar
+	};
+	return kernels;
+}
+
+static const Kernels* DetectKernels() {
+#ifdef SCUMMVM_SSE2
+	if ( g_system && g_system->hasFeature( OSystem::kFeatureCpuSSE2 ) )
+		return &GetSSE2Kernels();
+#endif
+	return &GetScalarKernels();
+}
+
+const Kernels& GetKernels() {
+	static const Kernels* kernels = 0;
+	if ( !kernels )
+		kernels = DetectKernels();
+	return *kernels;
+}
+
 static bool doneTables = false;
 void InitTables( void ) {
 	if ( doneTables )
@@ -38,6 +38,28 @@ namespace DOSBox {
 //Select the type of wave generator routine
 #define DBOPL_WAVE WAVE_TABLEMUL
 
+//Try to use most precision for frequencies
+//Else try to keep different waves in synch
+//#define WAVE_PRECISION	1
+#ifndef WAVE_PRECISION
+//Wave bits available in the top of the 32bit range
+//Original adlib uses 10.10, we use 10.22
+#define WAVE_BITS	10
+#else
+//Need some extra bits at the top to have room for octaves and frequency multiplier
+//We support to 8 times lower rate
+//128 * 15 * 8 = 15350, 2^13.9, so need 14 bits
+#define WAVE_BITS	14
+#endif
+#define WAVE_SH		( 32 - WAVE_BITS )
+#define WAVE_MASK	( ( 1 << WAVE_SH ) - 1 )
+
+//Has to fit within 16bit lookuptable
+#define MUL_SH		16
+
+//Maximum amount of samples the operators generate in one batch
+#define BATCH_SAMPLES	64
+
 namespace DBOPL {
 
 // Type aliases for the DBOPL code
@@ -66,8 +88,11 @@ struct Channel;
 typedef Bits ( DB_FASTCALL *WaveHandler) ( Bitu i, Bitu volume );
 #endif
 
+struct Kernels;
+
 typedef Bits ( DBOPL::Operator::*VolumeHandler) ( );
 typedef Channel* ( DBOPL::Channel::*SynthHandler) ( Chip* chip, Bit32u samples, Bit32s* output );
+typedef void ( DBOPL::Channel::*BatchHandler) ( const Kernels* kernels, Bitu samples, const Bit32s* out0, Bit32s* output );
 
 //Different synth modes that can generate blocks of data
 typedef enum {
@@ -178,6 +203,14 @@ public:
 
 	Bits GetSample( Bits modulation );
 	Bits GetWave( Bitu index, Bitu vol );
+
+	//Batch versions of the above, for at most BATCH_SAMPLES samples
+	template< State state>
+	Bitu TemplateVolumeBatch( Bitu i, Bitu samples, Bit16u* mul );
+	void ForwardVolumeBatch( Bitu samples, Bit16u* mul );
+	void ForwardBatch( const Kernels* kernels, Bitu samples, Bit32u* index, Bit16u* mul );
+	//Modulation can be 0 for none, output can be the same buffer as modulation
+	void GetSamples( const Kernels* kernels, Bitu samples, const Bit32s* modulation, Bit32s* output );
 public:
 	Operator();
 };
@@ -212,6 +245,10 @@ struct Channel {
 	template< bool opl3Mode >
 	void GeneratePercussion( Chip* chip, Bit32s* output );
 
+	//Generate at most BATCH_SAMPLES samples from the output of the first operator
+	template<SynthMode mode>
+	void BatchTemplate( const Kernels* kernels, Bitu samples, const Bit32s* out0, Bit32s* output );
+
 	//Generate blocks of data in specific modes
 	template<SynthMode mode>
 	Channel* BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output );
@@ -254,6 +291,13 @@ struct Chip {
 	//0 or -1 when enabled
 	Bit8s opl3Active;
 
+	//Routines used for generating batches of samples
+	const Kernels* kernels;
+	//Channels which are generated in batches for the current block
+	Channel* batchChannel[18];
+	BatchHandler batchHandler[18];
+	Bitu batchCount;
+
 	//Return the maximum amount of samples before and LFO change
 	Bit32u ForwardLFO( Bit32u samples );
 	Bit32u ForwardNoise();
@@ -263,6 +307,7 @@ struct Chip {
 
 	Bit32u WriteAddr( Bit32u port, Bit8u val );
 
+	void GenerateBatches( Bitu samples, Bit32s* output, Bitu stride );
 	void GenerateBlock2( Bitu samples, Bit32s* output );
 	void GenerateBlock3( Bitu samples, Bit32s* output );
 
@@ -274,6 +319,25 @@ struct Chip {
 
 void InitTables();
 
+//Routines working on a batch of samples of an operator. There are plain and
+//vectorized versions, which all give the same results.
+struct Kernels {
+	//Advance the wave counter by add for every sample and store the
+	//counter >> WAVE_SH after each step in index
+	void ( *forwardWave )( Bit32u* index, Bit32u& counter, Bit32u add, Bitu samples );
+	//Set output to ( waveBase[ ( index + modulation ) & waveMask ] * mul ) >> MUL_SH
+	//for every sample, modulation can be 0 for none
+	void ( *getWave )( Bit32s* output, const Bit16s* waveBase, Bit32u waveMask, const Bit32u* index, const Bit32s* modulation, const Bit16u* mul, Bitu samples );
+};
+
+const Kernels& GetScalarKernels();
+#ifdef SCUMMVM_SSE2
+//Only use them if OSystem::kFeatureCpuSSE2 is set
+const Kernels& GetSSE2Kernels();
+#endif
+//The fastest routines supported by the cpu
+const Kernels& GetKernels();
+
 }		//Namespace
 } // End of namespace DOSBox
 } // End of namespace OPL
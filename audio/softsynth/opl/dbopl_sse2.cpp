@@ -0,0 +1,110 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "audio/softsynth/opl/dbopl.h"
+
+#if defined(SCUMMVM_SSE2) && !defined(DISABLE_DOSBOX_OPL)
+
+#include <emmintrin.h>
+
+namespace OPL {
+namespace DOSBox {
+namespace DBOPL {
+
+static void forwardWaveSSE2(Bit32u *index, Bit32u &counter, Bit32u add, Bitu samples) {
+	Bit32u c = counter;
+	__m128i pos = _mm_set_epi32(c + 4 * add, c + 3 * add, c + 2 * add, c + add);
+	const __m128i step = _mm_set1_epi32(4 * add);
+	Bitu i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		_mm_storeu_si128((__m128i *)(index + i), _mm_srli_epi32(pos, WAVE_SH));
+		pos = _mm_add_epi32(pos, step);
+	}
+	c += i * add;
+	for (; i < samples; i++) {
+		c += add;
+		index[i] = c >> WAVE_SH;
+	}
+	counter = c;
+}
+
+/**
+ * Multiply eight signed wave samples by eight unsigned volume factors and
+ * return bits 16 to 31 of the 32 bit products, sign extended to 32 bits.
+ */
+static inline void scaleSSE2(__m128i wave, __m128i mul, Bit32s *output) {
+	// mulhi_epi16 treats factors >= 0x8000 as negative, which is off by
+	// wave << 16
+	__m128i hi = _mm_mulhi_epi16(wave, mul);
+	hi = _mm_add_epi16(hi, _mm_and_si128(wave, _mm_srai_epi16(mul, 15)));
+	_mm_storeu_si128((__m128i *)output, _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+	_mm_storeu_si128((__m128i *)(output + 4), _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+}
+
+template<bool modulated>
+static void lookupWaveSSE2(Bit32s *output, const Bit16s *waveBase, Bit32u waveMask, const Bit32u *index, const Bit32s *modulation, const Bit16u *mul, Bitu samples) {
+	const __m128i mask = _mm_set1_epi32(waveMask);
+	Bitu i = 0;
+	for (; i + 8 <= samples; i += 8) {
+		__m128i i0 = _mm_loadu_si128((const __m128i *)(index + i));
+		__m128i i1 = _mm_loadu_si128((const __m128i *)(index + i + 4));
+		if (modulated) {
+			i0 = _mm_add_epi32(i0, _mm_loadu_si128((const __m128i *)(modulation + i)));
+			i1 = _mm_add_epi32(i1, _mm_loadu_si128((const __m128i *)(modulation + i + 4)));
+		}
+		i0 = _mm_and_si128(i0, mask);
+		i1 = _mm_and_si128(i1, mask);
+
+		// There is no gather in SSE2, the masked positions all fit in 16 bits
+		const __m128i pos = _mm_packs_epi32(i0, i1);
+		const __m128i wave = _mm_set_epi16(
+			waveBase[_mm_extract_epi16(pos, 7)], waveBase[_mm_extract_epi16(pos, 6)],
+			waveBase[_mm_extract_epi16(pos, 5)], waveBase[_mm_extract_epi16(pos, 4)],
+			waveBase[_mm_extract_epi16(pos, 3)], waveBase[_mm_extract_epi16(pos, 2)],
+			waveBase[_mm_extract_epi16(pos, 1)], waveBase[_mm_extract_epi16(pos, 0)]);
+		scaleSSE2(wave, _mm_loadu_si128((const __m128i *)(mul + i)), output + i);
+	}
+
+	GetScalarKernels().getWave(output + i, waveBase, waveMask, index + i, modulated ? modulation + i : 0, mul + i, samples - i);
+}
+
+static void getWaveSSE2(Bit32s *output, const Bit16s *waveBase, Bit32u waveMask, const Bit32u *index, const Bit32s *modulation, const Bit16u *mul, Bitu samples) {
+	if (modulation)
+		lookupWaveSSE2<true>(output, waveBase, waveMask, index, modulation, mul, samples);
+	else
+		lookupWaveSSE2<false>(output, waveBase, waveMask, index, modulation, mul, samples);
+}
+
+const Kernels &GetSSE2Kernels() {
+	static const Kernels kernels = {
+		forwardWaveSSE2,
+		getWaveSSE2
+	};
+	return kernels;
+}
+
+} // End of namespace DBOPL
+} // End of namespace DOSBox
+} // End of namespace OPL
+
+#endif // SCUMMVM_SSE2 && !DISABLE_DOSBOX_OPL
@@ -173,6 +173,16 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this path, in seconds. The epoch depends on the backend, so the value
+	 * is only suitable to detect changes.
+	 *
+	 * @note The default implementation returns 0, which means that the time
+	 *       is not known.
+	 */
+	virtual uint32 getModificationTime() const { return 0; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
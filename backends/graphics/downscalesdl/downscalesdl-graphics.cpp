@@ -279,11 +279,7 @@ void DownscaleSdlGraphicsManager::internUpdateScreen() {
 
 	// Force a full redraw if requested
 	if (_forceRedraw) {
-		_numDirtyRects = 1;
-		_dirtyRectList[0].x = 0;
-		_dirtyRectList[0].y = 0;
-		_dirtyRectList[0].w = width;
-		_dirtyRectList[0].h = height;
+		_dirtyRegion.setRect(Common::Rect(width, height));
 
 #ifdef GPH_DEVICE
 		// HACK: Make sure the full hardware screen is wiped clean.
@@ -291,6 +287,9 @@ void DownscaleSdlGraphicsManager::internUpdateScreen() {
 #endif
 	}
 
+	appendDirtyRects();
+	_dirtyRegion.flush();
+
 	// Only draw anything if necessary
 	if (_numDirtyRects > 0 || _cursorNeedsRedraw) {
 		SDL_Rect *r;
@@ -396,11 +395,16 @@ void DownscaleSdlGraphicsManager::internUpdateScreen() {
 		drawOSD();
 #endif
 
+		// Add the rects drawn on top of the scaled screen
+		appendDirtyRects();
+		_dirtyRegion.clear();
+
 		// Finally, blit all our changes to the screen
 		SDL_UpdateRects(_hwScreen, _numDirtyRects, _dirtyRectList);
 	}
 
 	_numDirtyRects = 0;
+	_dirtyRegion.endFrame();
 	_forceRedraw = false;
 	_cursorNeedsRedraw = false;
 }
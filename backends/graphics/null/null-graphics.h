@@ -24,37 +24,65 @@
 #define BACKENDS_GRAPHICS_NULL_H
 
 #include "backends/graphics/graphics.h"
+#include "graphics/surface.h"
 
+/**
+ * A graphics manager which keeps the screen in memory, without ever
+ * displaying it. Engines can draw to it and screenshots can be taken of
+ * it, e.g. to compare them with the ones of a recording. The overlay is
+ * kept in memory the same way, so that the GUI can run, e.g. to measure
+ * how long the launcher takes to start.
+ */
 class NullGraphicsManager : public GraphicsManager {
 public:
-	virtual ~NullGraphicsManager() {}
+	NullGraphicsManager() : _format(Graphics::PixelFormat::createFormatCLUT8()) {
+		memset(_palette, 0, sizeof(_palette));
+		_overlay.create(kOverlayWidth, kOverlayHeight, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	}
+	virtual ~NullGraphicsManager() {
+		_screen.free();
+		_overlay.free();
+	}
 
 	bool hasFeature(OSystem::Feature f) const override { return false; }
 	void setFeatureState(OSystem::Feature f, bool enable) override {}
 	bool getFeatureState(OSystem::Feature f) const override { return false; }
 
 	inline Graphics::PixelFormat getScreenFormat() const override {
-		return Graphics::PixelFormat::createFormatCLUT8();
+		return _format;
 	}
 	inline Common::List<Graphics::PixelFormat> getSupportedFormats() const override {
 		Common::List<Graphics::PixelFormat> list;
 		list.push_back(Graphics::PixelFormat::createFormatCLUT8());
 		return list;
 	}
-	void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) override {}
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) override {
+		// Any format is fine, since nothing is displayed
+		_format = format ? *format : Graphics::PixelFormat::createFormatCLUT8();
+		_screen.free();
+		_screen.create(width, height, _format);
+	}
 	virtual int getScreenChangeID() const override { return 0; }
 
 	void beginGFXTransaction() override {}
 	OSystem::TransactionError endGFXTransaction() override { return OSystem::kTransactionSuccess; }
 
-	int16 getHeight() const override { return 0; }
-	int16 getWidth() const override { return 0; }
-	void setPalette(const byte *colors, uint start, uint num) override {}
-	void grabPalette(byte *colors, uint start, uint num) const override {}
-	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) override {}
-	Graphics::Surface *lockScreen() override { return NULL; }
+	int16 getHeight() const override { return _screen.h; }
+	int16 getWidth() const override { return _screen.w; }
+	void setPalette(const byte *colors, uint start, uint num) override {
+		memcpy(_palette + start * 3, colors, num * 3);
+	}
+	void grabPalette(byte *colors, uint start, uint num) const override {
+		memcpy(colors, _palette + start * 3, num * 3);
+	}
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) override {
+		_screen.copyRectToSurface(buf, pitch, x, y, w, h);
+	}
+	Graphics::Surface *lockScreen() override { return &_screen; }
 	void unlockScreen() override {}
-	void fillScreen(uint32 col) override {}
+	void fillScreen(uint32 col) override {
+		_screen.fillRect(Common::Rect(_screen.w, _screen.h), col);
+	}
 	void updateScreen() override {}
 	void setShakePos(int shakeXOffset, int shakeYOffset) override {}
 	void setFocusRectangle(const Common::Rect& rect) override {}
@@ -62,17 +90,37 @@ public:
 
 	void showOverlay() override {}
 	void hideOverlay() override {}
-	Graphics::PixelFormat getOverlayFormat() const override { return Graphics::PixelFormat(); }
-	void clearOverlay() override {}
-	void grabOverlay(void *buf, int pitch) const override {}
-	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) override {}
-	int16 getOverlayHeight() const override { return 0; }
-	int16 getOverlayWidth() const override { return 0; }
+	Graphics::PixelFormat getOverlayFormat() const override { return _overlay.format; }
+	void clearOverlay() override {
+		_overlay.fillRect(Common::Rect(_overlay.w, _overlay.h), 0);
+	}
+	void grabOverlay(void *buf, int pitch) const override {
+		const byte *src = (const byte *)_overlay.getPixels();
+		byte *dst = (byte *)buf;
+		for (int y = 0; y < _overlay.h; ++y, src += _overlay.pitch, dst += pitch)
+			memcpy(dst, src, _overlay.w * _overlay.format.bytesPerPixel);
+	}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) override {
+		_overlay.copyRectToSurface(buf, pitch, x, y, w, h);
+	}
+	int16 getOverlayHeight() const override { return _overlay.h; }
+	int16 getOverlayWidth() const override { return _overlay.w; }
 
 	bool showMouse(bool visible) override { return !visible; }
 	void warpMouse(int x, int y) override {}
 	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) override {}
 	void setCursorPalette(const byte *colors, uint start, uint num) override {}
+
+private:
+	enum {
+		kOverlayWidth = 640,
+		kOverlayHeight = 480
+	};
+
+	Graphics::PixelFormat _format;
+	Graphics::Surface _screen;
+	Graphics::Surface _overlay;
+	byte _palette[3 * 256];
 };
 
 #endif
@@ -154,7 +154,8 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_screenFormat(Graphics::PixelFormat::createFormatCLUT8()),
 	_cursorFormat(Graphics::PixelFormat::createFormatCLUT8()),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _scalerThreads(0), _screenChangeCount(0),
+	_dirtyRegion(NUM_DIRTY_RECT), _numDirtyRects(0),
 	_mouseData(nullptr), _mouseSurface(nullptr),
 	_mouseOrigSurface(nullptr), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakeXOffset(0), _currentShakeYOffset(0),
@@ -199,6 +200,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	_videoMode.stretchMode = STRETCH_FIT;
 #endif
+
+	// A non-positive number of threads uses all threads of the backend
+	_scalerThreads = MAX(ConfMan.getInt("scaler_threads"), 0);
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -1155,6 +1159,91 @@ void SurfaceSdlGraphicsManager::updateScreen() {
 	internUpdateScreen();
 }
 
+namespace {
+
+enum {
+	/**
+	 * Bands are not made smaller than this, so the synchronization does
+	 * not cost more than it saves. It is even, since DotMatrix depends on
+	 * the parity of the row.
+	 */
+	kMinScalerBandHeight = 16
+};
+
+/**
+ * A rectangle scaled in horizontal bands by OSystem::runParallel().
+ *
+ * The scalers only read the source surface, which is padded so pixels
+ * outside the rectangle can be read, and every output row only depends on
+ * the source rows around it. Hence the bands can be scaled independently,
+ * and the result is identical to scaling the whole rectangle at once.
+ */
+struct ScalerBands {
+	ScalerProc *scalerProc;
+	const uint8 *srcPtr;
+	uint32 srcPitch;
+	uint8 *dstPtr;
+	uint32 dstPitch;
+	int width, height;
+	int bandHeight;
+	int scaleFactor;
+};
+
+void scaleBand(void *param, uint index) {
+	const ScalerBands &bands = *(const ScalerBands *)param;
+	const int y = index * bands.bandHeight;
+	bands.scalerProc(bands.srcPtr + y * bands.srcPitch, bands.srcPitch,
+	                 bands.dstPtr + y * bands.scaleFactor * bands.dstPitch, bands.dstPitch,
+	                 bands.width, MIN(bands.bandHeight, bands.height - y));
+}
+
+/**
+ * Whether the given scaler can be called from several threads at once.
+ * This is not the case for the assembler versions of the HQ scalers, which
+ * keep their state in static variables.
+ */
+bool isScalerReentrant(ScalerProc *scalerProc) {
+#if defined(USE_SCALERS) && defined(USE_HQ_SCALERS) && defined(USE_NASM)
+	return scalerProc != HQ2x && scalerProc != HQ3x;
+#else
+	(void)scalerProc;
+	return true;
+#endif
+}
+
+/**
+ * Run a scaler with the parameters of ScalerProc, splitting the rectangle
+ * into bands for up to maxThreads threads (0 for no limit) if it is large
+ * enough.
+ */
+void scaleParallel(ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+                   uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor, uint maxThreads) {
+	uint threads = g_system->getParallelJobThreads();
+	if (maxThreads)
+		threads = MIN(threads, maxThreads);
+
+	// Two bands per thread, so threads finishing early can help out
+	const int numBands = MIN<int>(threads * 2, height / kMinScalerBandHeight);
+	if (threads < 2 || numBands < 2 || !isScalerReentrant(scalerProc)) {
+		scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
+	ScalerBands bands;
+	bands.scalerProc = scalerProc;
+	bands.srcPtr = srcPtr;
+	bands.srcPitch = srcPitch;
+	bands.dstPtr = dstPtr;
+	bands.dstPitch = dstPitch;
+	bands.width = width;
+	bands.height = height;
+	bands.bandHeight = ((height + numBands - 1) / numBands + 1) & ~1;
+	bands.scaleFactor = scaleFactor;
+	g_system->runParallel(scaleBand, &bands, (height + bands.bandHeight - 1) / bands.bandHeight);
+}
+
+} // End of anonymous namespace
+
 void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	SDL_Surface *srcSurf, *origSurf;
 	int height, width;
@@ -1239,13 +1328,11 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 #endif
 
 	// Force a full redraw if requested
-	if (_forceRedraw) {
-		_numDirtyRects = 1;
-		_dirtyRectList[0].x = 0;
-		_dirtyRectList[0].y = 0;
-		_dirtyRectList[0].w = width;
-		_dirtyRectList[0].h = height;
-	}
+	if (_forceRedraw)
+		_dirtyRegion.setRect(Common::Rect(width, height));
+
+	appendDirtyRects();
+	_dirtyRegion.flush();
 
 	// Only draw anything if necessary
 	if (_numDirtyRects > 0 || _cursorNeedsRedraw) {
@@ -1297,8 +1384,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwScreen->pixels + dst_x * 2 + dst_y * dstPitch, dstPitch, dst_w, dst_h);
+				scaleParallel(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwScreen->pixels + dst_x * 2 + dst_y * dstPitch, dstPitch, dst_w, dst_h, scale1, _scalerThreads);
 			}
 
 			r->x = dst_x;
@@ -1406,6 +1493,10 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		}
 #endif
 
+		// Add the rects drawn on top of the scaled screen
+		appendDirtyRects();
+		_dirtyRegion.clear();
+
 		// Finally, blit all our changes to the screen
 		if (!_displayDisabled) {
 			SDL_UpdateRects(_hwScreen, _numDirtyRects, _dirtyRectList);
@@ -1413,6 +1504,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	}
 
 	_numDirtyRects = 0;
+	_dirtyRegion.endFrame();
 	_forceRedraw = false;
 	_cursorNeedsRedraw = false;
 }
@@ -1612,11 +1704,6 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceRedraw)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceRedraw = true;
-		return;
-	}
-
 	int height, width;
 
 	if (!_overlayVisible && !realCoordinates) {
@@ -1665,13 +1752,20 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		return;
 	}
 
-	if (w > 0 && h > 0) {
+	if (w > 0 && h > 0)
+		_dirtyRegion.addRect(Common::Rect(x, y, x + w, y + h));
+}
+
+void SurfaceSdlGraphicsManager::appendDirtyRects() {
+	const Common::Array<Common::Rect> &rects = _dirtyRegion.getRects();
+	for (uint i = 0; i < rects.size(); ++i) {
+		assert((uint)_numDirtyRects < ARRAYSIZE(_dirtyRectList));
 		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 
-		r->x = x;
-		r->y = y;
-		r->w = w;
-		r->h = h;
+		r->x = rects[i].left;
+		r->y = rects[i].top;
+		r->w = rects[i].width();
+		r->h = rects[i].height();
 	}
 }
 
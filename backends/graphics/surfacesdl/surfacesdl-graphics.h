@@ -25,6 +25,7 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyregion.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "common/events.h"
@@ -328,6 +329,11 @@ protected:
 
 	ScalerProc *_scalerProc;
 	int _scalerType;
+	/**
+	 * The maximum number of threads scaling a dirty rect in parallel, or 0
+	 * to use as many as OSystem::runParallel() offers.
+	 */
+	uint _scalerThreads;
 	int _transactionMode;
 
 	// Indicates whether it is needed to free _hwSurface in destructor
@@ -344,9 +350,17 @@ protected:
 	};
 
 	// Dirty rect management
-	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
+	Graphics::DirtyRegion _dirtyRegion;
+	/**
+	 * The rects updated in the current frame. The first rects are scaled,
+	 * the remaining ones are drawn directly in real coordinates.
+	 */
+	SDL_Rect _dirtyRectList[2 * NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/** Move the rects of _dirtyRegion to the end of _dirtyRectList. */
+	void appendDirtyRects();
+
 	struct MousePos {
 		// The size and hotspot of the original cursor image.
 		int16 w, h;
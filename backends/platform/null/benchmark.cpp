@@ -0,0 +1,220 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/platform/null/benchmark.h"
+#include "backends/timer/default/default-timer.h"
+#include "audio/mixer_intern.h"
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/json.h"
+#include "common/system.h"
+
+#include <stdio.h>
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(POSIX)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+BenchmarkPlayback::BenchmarkPlayback(DefaultTimerManager *timerManager, Audio::MixerImpl *mixer)
+	: _timerManager(timerManager), _mixer(mixer), _finished(false), _quitSent(false), _reported(false),
+	  _time(0), _pendingSampleMillis(0), _missingTimerEvents(0),
+	  _startMicros(0), _frameStartMicros(0), _flushStartMicros(0), _frameMixMicros(0) {
+}
+
+bool BenchmarkPlayback::open(const Common::String &fileName) {
+	_fileName = fileName;
+	if (!_playbackFile.openRead(fileName))
+		return false;
+
+	// The paths of the recording machine are most likely wrong here
+	const Common::StringMap &settings = _playbackFile.getHeader().settingsRecords;
+	for (Common::StringMap::const_iterator i = settings.begin(); i != settings.end(); ++i) {
+		if (!i->_key.hasSuffix("path"))
+			ConfMan.set(i->_key, i->_value, Common::ConfigManager::kTransientDomain);
+	}
+
+	_nextEvent = _playbackFile.getNextEvent();
+	start();
+	return true;
+}
+
+void BenchmarkPlayback::start() {
+	_startMicros = _frameStartMicros = getMicros();
+	_frameMixMicros = 0;
+}
+
+uint32 BenchmarkPlayback::getMillis(bool skipRecord) {
+	if (skipRecord || _finished)
+		return _time;
+
+	if (_nextEvent.recordedtype == Common::kRecorderEventTypeTimer) {
+		advanceTo(_nextEvent.time);
+		_nextEvent = _playbackFile.getNextEvent();
+	} else if (_nextEvent.type == Common::EVENT_INVALID) {
+		_finished = true;
+	} else {
+		++_missingTimerEvents;
+	}
+	return _time;
+}
+
+void BenchmarkPlayback::delayMillis(uint msecs) {
+	// While replaying, time only advances with the recording, but after
+	// the end, the engine might wait for something before quitting
+	if (_finished)
+		advanceTo(_time + msecs);
+}
+
+bool BenchmarkPlayback::pollEvent(Common::Event &event) {
+	if (!_finished && _nextEvent.recordedtype == Common::kRecorderEventTypeNormal && _nextEvent.type == Common::EVENT_INVALID)
+		_finished = true;
+
+	if (_finished) {
+		if (_quitSent)
+			return false;
+		event = Common::Event();
+		event.type = Common::EVENT_QUIT;
+		_quitSent = true;
+		return true;
+	}
+
+	if (_nextEvent.recordedtype == Common::kRecorderEventTypeTimer)
+		return false;
+
+	event = _nextEvent;
+	_nextEvent = _playbackFile.getNextEvent();
+	return true;
+}
+
+void BenchmarkPlayback::advanceTo(uint32 time) {
+	if (time < _time)
+		return;
+
+	const uint32 elapsed = time - _time;
+	_time = time;
+	_timerManager->handler();
+
+	if (!_mixer)
+		return;
+
+	// In 64 bit, since a jump of the recording by a minute and a half
+	// would already overflow at 44.1 kHz
+	const uint64 sampleMillis = (uint64)elapsed * _mixer->getOutputRate() + _pendingSampleMillis;
+	uint64 samples = sampleMillis / 1000;
+	_pendingSampleMillis = (uint32)(sampleMillis % 1000);
+
+	const uint64 start = getMicros();
+	while (samples > 0) {
+		const uint32 count = (uint32)MIN<uint64>(samples, 4096);
+		// Stereo 16 bit samples
+		_mixBuffer.resize(count * 2);
+		_mixer->mixCallback((byte *)&_mixBuffer[0], count * 4);
+		samples -= count;
+	}
+	_frameMixMicros += (uint32)(getMicros() - start);
+}
+
+void BenchmarkPlayback::beginFlush() {
+	_flushStartMicros = getMicros();
+}
+
+void BenchmarkPlayback::endFlush() {
+	const uint64 now = getMicros();
+	const uint32 frameMicros = (uint32)(_flushStartMicros - _frameStartMicros);
+
+	FrameTimes frame;
+	frame.engineUpdate = frameMicros > _frameMixMicros ? frameMicros - _frameMixMicros : 0;
+	frame.graphicsFlush = (uint32)(now - _flushStartMicros);
+	frame.audioMix = _frameMixMicros;
+	_frames.push_back(frame);
+
+	_frameMixMicros = 0;
+	_frameStartMicros = now;
+}
+
+static Common::JSONValue *makePercentiles(Common::Array<uint32> &values) {
+	Common::JSONObject result;
+	uint64 sum = 0;
+	for (uint i = 0; i < values.size(); ++i)
+		sum += values[i];
+	Common::sort(values.begin(), values.end());
+
+	const uint n = values.size();
+	result["mean"] = new Common::JSONValue((long long int)(n ? sum / n : 0));
+	result["p50"] = new Common::JSONValue((long long int)(n ? values[(n - 1) * 50 / 100] : 0));
+	result["p90"] = new Common::JSONValue((long long int)(n ? values[(n - 1) * 90 / 100] : 0));
+	result["p99"] = new Common::JSONValue((long long int)(n ? values[(n - 1) * 99 / 100] : 0));
+	result["max"] = new Common::JSONValue((long long int)(n ? values[n - 1] : 0));
+	return new Common::JSONValue(result);
+}
+
+void BenchmarkPlayback::writeReport() {
+	if (_reported)
+		return;
+	_reported = true;
+
+	Common::Array<uint32> engineUpdate, graphicsFlush, audioMix;
+	for (uint i = 0; i < _frames.size(); ++i) {
+		engineUpdate.push_back(_frames[i].engineUpdate);
+		graphicsFlush.push_back(_frames[i].graphicsFlush);
+		audioMix.push_back(_frames[i].audioMix);
+	}
+
+	Common::JSONObject report;
+	report["recording"] = new Common::JSONValue(_fileName);
+	report["target"] = new Common::JSONValue(ConfMan.getActiveDomainName());
+	report["complete"] = new Common::JSONValue(_finished);
+	report["wall_time_ms"] = new Common::JSONValue((long long int)((getMicros() - _startMicros) / 1000));
+	report["replayed_time_ms"] = new Common::JSONValue((long long int)_time);
+	report["missing_timer_events"] = new Common::JSONValue((long long int)_missingTimerEvents);
+	report["frames"] = new Common::JSONValue((long long int)_frames.size());
+	report["engine_update_us"] = makePercentiles(engineUpdate);
+	report["graphics_flush_us"] = makePercentiles(graphicsFlush);
+	report["audio_mix_us"] = makePercentiles(audioMix);
+
+	const Common::JSONValue value(report);
+	printf("%s\n", value.stringify().c_str());
+	fflush(stdout);
+}
+
+uint64 BenchmarkPlayback::getMicros() {
+#if defined(WIN32)
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
+#elif defined(POSIX)
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+	return (uint64)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
@@ -0,0 +1,130 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef BACKENDS_PLATFORM_NULL_BENCHMARK_H
+#define BACKENDS_PLATFORM_NULL_BENCHMARK_H
+
+#include "common/array.h"
+#include "common/events.h"
+#include "common/recorderfile.h"
+#include "common/str.h"
+
+class DefaultTimerManager;
+
+namespace Audio {
+class MixerImpl;
+}
+
+/**
+ * Replays a recording of the event recorder as fast as possible, and
+ * measures how long the engine takes for each frame.
+ *
+ * The time seen by the engine is taken from the recording: every call of
+ * getMillis() advances it to the next recorded timer event, which also
+ * runs the timers and mixes the audio for the elapsed time. The recorded
+ * events are returned by pollEvent() until the next timer event. Hence
+ * the replay only depends on the recording, and runs the same way every
+ * time. A recording made with another backend may however not replay
+ * exactly like the recorded session, if that backend asked for the time
+ * more or less often.
+ *
+ * A frame ends with each call of updateScreen(). For each frame, the
+ * time spent in the engine, in flushing the screen and in mixing audio
+ * is recorded, and written as JSON at the end of the replay.
+ */
+class BenchmarkPlayback {
+public:
+	BenchmarkPlayback(DefaultTimerManager *timerManager, Audio::MixerImpl *mixer);
+
+	/**
+	 * Open the recording and apply the settings stored in it to the
+	 * transient config domain. Returns false if it could not be read.
+	 */
+	bool open(const Common::String &fileName);
+
+	/**
+	 * Start measuring, e.g. once the engine is created, so the time
+	 * needed to get there is not counted.
+	 */
+	void start();
+
+	/** Return the replayed time, see OSystem::getMillis(). */
+	uint32 getMillis(bool skipRecord);
+
+	/** Advance the time after the end of the recording. */
+	void delayMillis(uint msecs);
+
+	/** Return the real time in microseconds, from an arbitrary start. */
+	static uint64 getMicros();
+
+	/**
+	 * Return the next recorded event, or a quit event once the recording
+	 * is over.
+	 */
+	bool pollEvent(Common::Event &event);
+
+	/** Call before and after flushing the screen, to end a frame. */
+	void beginFlush();
+	void endFlush();
+
+	/**
+	 * Write the measurements as JSON to stdout. This only happens once,
+	 * further calls do nothing.
+	 */
+	void writeReport();
+
+private:
+	struct FrameTimes {
+		uint32 engineUpdate;
+		uint32 graphicsFlush;
+		uint32 audioMix;
+	};
+
+	/** Run the timers and the mixer up to the given time. */
+	void advanceTo(uint32 time);
+
+	DefaultTimerManager *_timerManager;
+	Audio::MixerImpl *_mixer;
+
+	Common::String _fileName;
+	Common::PlaybackFile _playbackFile;
+	Common::RecorderEvent _nextEvent;
+	bool _finished;
+	bool _quitSent;
+	bool _reported;
+
+	uint32 _time;
+	/** Fraction of the audio samples which could not be mixed yet, in sample milliseconds. */
+	uint32 _pendingSampleMillis;
+	Common::Array<int16> _mixBuffer;
+	/** Number of getMillis() calls for which the recording had no timer event. */
+	uint32 _missingTimerEvents;
+
+	uint64 _startMicros;
+	uint64 _frameStartMicros;
+	uint64 _flushStartMicros;
+	uint32 _frameMixMicros;
+	Common::Array<FrameTimes> _frames;
+};
+
+#endif
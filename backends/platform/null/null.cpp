@@ -38,8 +38,11 @@
 #include "backends/events/default/default-events.h"
 #include "backends/mutex/null/null-mutex.h"
 #include "backends/graphics/null/null-graphics.h"
+#include "backends/platform/null/benchmark.h"
 #include "audio/mixer_intern.h"
+#include "common/config-manager.h"
 #include "common/scummsys.h"
+#include "common/textconsole.h"
 
 /*
  * Include header files needed for the getFilesystemFactory() method.
@@ -61,6 +64,8 @@ public:
 
 	virtual void initBackend();
 
+	virtual bool hasFeature(Feature f);
+
 	virtual Common::EventSource *getDefaultEventSource() { return this; }
 	virtual bool pollEvent(Common::Event &event);
 
@@ -68,12 +73,22 @@ public:
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
+	virtual void updateScreen();
+
+	virtual void engineInit();
+	virtual void engineDone();
+
 	virtual void quit();
 
 	virtual void logMessage(LogMessageType::Type type, const char *message);
+
+private:
+	/** Replays a recording given with --benchmark, if any. */
+	BenchmarkPlayback *_benchmark;
+	uint64 _startMicros;
 };
 
-OSystem_NULL::OSystem_NULL() {
+OSystem_NULL::OSystem_NULL() : _benchmark(nullptr), _startMicros(BenchmarkPlayback::getMicros()) {
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
 	#elif defined(POSIX)
@@ -88,6 +103,12 @@ OSystem_NULL::OSystem_NULL() {
 }
 
 OSystem_NULL::~OSystem_NULL() {
+	delete _benchmark;
+
+	// The timer manager locks its mutex when it is deleted, which would
+	// call into an already destroyed OSystem if ~OSystem() deleted it
+	delete _timerManager;
+	_timerManager = 0;
 }
 
 void OSystem_NULL::initBackend() {
@@ -103,22 +124,71 @@ void OSystem_NULL::initBackend() {
 	// Note that both the mixer and the timer manager are useless
 	// this way; they need to be hooked into the system somehow to
 	// be functional. Of course, can't do that in a NULL backend :).
+	// Except when replaying a recording, which drives both.
+	if (ConfMan.hasKey("benchmark")) {
+		if (!ConfMan.getActiveDomain())
+			error("--benchmark needs a game target");
+
+		_benchmark = new BenchmarkPlayback((DefaultTimerManager *)_timerManager, (Audio::MixerImpl *)_mixer);
+		if (!_benchmark->open(ConfMan.get("benchmark"))) {
+			delete _benchmark;
+			_benchmark = nullptr;
+			error("Could not read the recording '%s'", ConfMan.get("benchmark").c_str());
+		}
+		((Audio::MixerImpl *)_mixer)->setReady(true);
+	}
 
 	ModularBackend::initBackend();
 }
 
+bool OSystem_NULL::hasFeature(Feature f) {
+	// There is no portable way to query the CPU here, so only report the
+	// instruction sets which are guaranteed by the target architecture.
+#if defined(__x86_64__) || defined(_M_X64)
+	if (f == kFeatureCpuSSE2)
+		return true;
+#endif
+	return ModularBackend::hasFeature(f);
+}
+
 bool OSystem_NULL::pollEvent(Common::Event &event) {
+	if (_benchmark)
+		return _benchmark->pollEvent(event);
 	return false;
 }
 
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
-	return 0;
+	if (_benchmark)
+		return _benchmark->getMillis(skipRecord);
+	return (uint32)((BenchmarkPlayback::getMicros() - _startMicros) / 1000);
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
+	if (_benchmark)
+		_benchmark->delayMillis(msecs);
+}
+
+void OSystem_NULL::updateScreen() {
+	if (_benchmark)
+		_benchmark->beginFlush();
+	ModularBackend::updateScreen();
+	if (_benchmark)
+		_benchmark->endFlush();
+}
+
+void OSystem_NULL::engineInit() {
+	if (_benchmark)
+		_benchmark->start();
+}
+
+void OSystem_NULL::engineDone() {
+	if (_benchmark)
+		_benchmark->writeReport();
 }
 
 void OSystem_NULL::quit() {
+	if (_benchmark)
+		_benchmark->writeReport();
 	exit(0);
 }
 
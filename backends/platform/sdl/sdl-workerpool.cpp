@@ -0,0 +1,240 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/platform/sdl/sdl-workerpool.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+enum {
+	/** Upper limit of the default number of threads. */
+	kMaxDefaultThreads = 4
+};
+
+SdlWorkerPool::SdlWorkerPool(uint numThreads)
+	: _numThreads(MAX<uint>(numThreads, 1)), _started(false), _quit(false), _busy(false),
+	  _job(nullptr), _param(nullptr), _count(0), _nextIndex(0),
+	  _backgroundThread(nullptr), _backgroundFailed(false), _backgroundLastId(0), _backgroundDoneId(0) {
+	_mutex = SDL_CreateMutex();
+	_startSem = SDL_CreateSemaphore(0);
+	_doneSem = SDL_CreateSemaphore(0);
+	_backgroundSem = SDL_CreateSemaphore(0);
+	_backgroundDoneCond = SDL_CreateCond();
+	if (!_mutex || !_startSem || !_doneSem || !_backgroundSem || !_backgroundDoneCond)
+		error("Could not create worker synchronization objects: %s", SDL_GetError());
+}
+
+SdlWorkerPool::~SdlWorkerPool() {
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _threads.size(); ++i)
+		SDL_SemPost(_startSem);
+	for (uint i = 0; i < _threads.size(); ++i)
+		SDL_WaitThread(_threads[i], nullptr);
+
+	// The background thread runs the jobs which are still queued first
+	if (_backgroundThread) {
+		SDL_SemPost(_backgroundSem);
+		SDL_WaitThread(_backgroundThread, nullptr);
+	}
+
+	SDL_DestroyCond(_backgroundDoneCond);
+	SDL_DestroySemaphore(_backgroundSem);
+	SDL_DestroySemaphore(_doneSem);
+	SDL_DestroySemaphore(_startSem);
+	SDL_DestroyMutex(_mutex);
+}
+
+uint SdlWorkerPool::getDefaultNumThreads() {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	return CLIP<int>(SDL_GetCPUCount(), 1, kMaxDefaultThreads);
+#else
+	// SDL 1.2 cannot tell the number of CPU cores
+	return 1;
+#endif
+}
+
+void SdlWorkerPool::startThreads() {
+	for (uint i = 1; i < _numThreads; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		SDL_Thread *thread = SDL_CreateThread(workerMain, "ScummVM worker", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(workerMain, this);
+#endif
+		if (!thread) {
+			warning("Could not create worker thread: %s", SDL_GetError());
+			break;
+		}
+		_threads.push_back(thread);
+	}
+	_numThreads = _threads.size() + 1;
+	_started = true;
+}
+
+void SdlWorkerPool::run(OSystem::ParallelJobProc job, void *param, uint count) {
+	SDL_LockMutex(_mutex);
+	const bool busy = _busy || _numThreads < 2 || count < 2;
+	if (!busy) {
+		_busy = true;
+		if (!_started)
+			startThreads();
+	}
+	SDL_UnlockMutex(_mutex);
+
+	if (busy || _threads.empty()) {
+		for (uint i = 0; i < count; ++i)
+			job(param, i);
+		if (!busy) {
+			SDL_LockMutex(_mutex);
+			_busy = false;
+			SDL_UnlockMutex(_mutex);
+		}
+		return;
+	}
+
+	_job = job;
+	_param = param;
+	_count = count;
+	_nextIndex = 0;
+
+	// Wake up the workers, help them and wait until they are done
+	const uint numWorkers = MIN<uint>(_threads.size(), count - 1);
+	for (uint i = 0; i < numWorkers; ++i)
+		SDL_SemPost(_startSem);
+	runJobs();
+	for (uint i = 0; i < numWorkers; ++i)
+		SDL_SemWait(_doneSem);
+
+	SDL_LockMutex(_mutex);
+	_busy = false;
+	SDL_UnlockMutex(_mutex);
+}
+
+void SdlWorkerPool::runJobs() {
+	while (true) {
+		SDL_LockMutex(_mutex);
+		const uint index = _nextIndex;
+		if (index < _count)
+			++_nextIndex;
+		SDL_UnlockMutex(_mutex);
+
+		if (index >= _count)
+			break;
+
+		_job(_param, index);
+	}
+}
+
+uint32 SdlWorkerPool::startBackgroundJob(OSystem::BackgroundJobProc job, void *param) {
+	SDL_LockMutex(_mutex);
+
+	if (!_backgroundThread && !_backgroundFailed) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		_backgroundThread = SDL_CreateThread(backgroundMain, "ScummVM background", this);
+#else
+		_backgroundThread = SDL_CreateThread(backgroundMain, this);
+#endif
+		if (!_backgroundThread) {
+			warning("Could not create background thread: %s", SDL_GetError());
+			_backgroundFailed = true;
+		}
+	}
+
+	if (!_backgroundThread || _quit) {
+		SDL_UnlockMutex(_mutex);
+		return 0;
+	}
+
+	// 0 means that no job was started, so it is skipped when the ids wrap
+	// around
+	if (++_backgroundLastId == 0)
+		++_backgroundLastId;
+
+	BackgroundJob backgroundJob;
+	backgroundJob.job = job;
+	backgroundJob.param = param;
+	backgroundJob.id = _backgroundLastId;
+	_backgroundJobs.push(backgroundJob);
+	SDL_UnlockMutex(_mutex);
+
+	SDL_SemPost(_backgroundSem);
+	return backgroundJob.id;
+}
+
+void SdlWorkerPool::waitForBackgroundJob(uint32 id) {
+	if (!id)
+		return;
+
+	// The difference keeps working when the ids wrap around
+	SDL_LockMutex(_mutex);
+	while ((int32)(_backgroundDoneId - id) < 0)
+		SDL_CondWait(_backgroundDoneCond, _mutex);
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL SdlWorkerPool::backgroundMain(void *arg) {
+	SdlWorkerPool *pool = (SdlWorkerPool *)arg;
+
+	while (true) {
+		SDL_SemWait(pool->_backgroundSem);
+
+		SDL_LockMutex(pool->_mutex);
+		if (pool->_backgroundJobs.empty()) {
+			// Only the destructor wakes the thread without queuing a job
+			SDL_UnlockMutex(pool->_mutex);
+			break;
+		}
+		const BackgroundJob job = pool->_backgroundJobs.pop();
+		SDL_UnlockMutex(pool->_mutex);
+
+		job.job(job.param);
+
+		SDL_LockMutex(pool->_mutex);
+		pool->_backgroundDoneId = job.id;
+		SDL_CondBroadcast(pool->_backgroundDoneCond);
+		SDL_UnlockMutex(pool->_mutex);
+	}
+
+	return 0;
+}
+
+int SDLCALL SdlWorkerPool::workerMain(void *arg) {
+	SdlWorkerPool *pool = (SdlWorkerPool *)arg;
+
+	while (true) {
+		SDL_SemWait(pool->_startSem);
+		if (pool->_quit)
+			break;
+
+		pool->runJobs();
+		SDL_SemPost(pool->_doneSem);
+	}
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_PLATFORM_SDL_WORKERPOOL_H
+#define BACKENDS_PLATFORM_SDL_WORKERPOOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+#include "common/array.h"
+#include "common/queue.h"
+#include "common/system.h"
+
+/**
+ * A pool of worker threads implementing OSystem::runParallel() and
+ * OSystem::startBackgroundJob().
+ *
+ * The threads are only started by the first call to run(), so the pool
+ * costs nothing unless something asks for parallel jobs. While the pool
+ * is busy, for instance when run() is called from another thread or from
+ * one of the jobs, the jobs are run on the calling thread instead.
+ *
+ * The background jobs run on a separate thread, which is started by the
+ * first call to startBackgroundJob(). When the pool is destroyed, that
+ * thread runs the jobs still queued before it quits, so that nobody waits
+ * for a job which never runs.
+ */
+class SdlWorkerPool {
+public:
+	/**
+	 * Create a pool running jobs on the given number of threads in total,
+	 * including the thread calling run().
+	 */
+	SdlWorkerPool(uint numThreads);
+	~SdlWorkerPool();
+
+	/** Return the number of threads running jobs in parallel. */
+	uint getNumThreads() const { return _numThreads; }
+
+	/**
+	 * Run job(param, index) for every index from 0 to count - 1, and return
+	 * once all of them are done.
+	 */
+	void run(OSystem::ParallelJobProc job, void *param, uint count);
+
+	/**
+	 * Queue job(param) to be run on the background thread.
+	 *
+	 * @return the id of the job, or 0 if the background thread could not
+	 *         be started
+	 */
+	uint32 startBackgroundJob(OSystem::BackgroundJobProc job, void *param);
+
+	/** Block until the background job with the given id is done. */
+	void waitForBackgroundJob(uint32 id);
+
+	/**
+	 * Return the number of threads to use by default, depending on the
+	 * number of CPU cores.
+	 */
+	static uint getDefaultNumThreads();
+
+private:
+	struct BackgroundJob {
+		OSystem::BackgroundJobProc job;
+		void *param;
+		uint32 id;
+	};
+
+	static int SDLCALL workerMain(void *arg);
+	static int SDLCALL backgroundMain(void *arg);
+	void startThreads();
+	void runJobs();
+
+	uint _numThreads;
+	bool _started;
+	Common::Array<SDL_Thread *> _threads;
+	SDL_mutex *_mutex;
+	SDL_sem *_startSem;
+	SDL_sem *_doneSem;
+	bool _quit;
+
+	// The current jobs, guarded by _mutex while they are running
+	bool _busy;
+	OSystem::ParallelJobProc _job;
+	void *_param;
+	uint _count;
+	uint _nextIndex;
+
+	// The background jobs, guarded by _mutex. They run in the order of
+	// their ids, so all jobs up to _backgroundDoneId are done.
+	SDL_Thread *_backgroundThread;
+	bool _backgroundFailed;
+	SDL_sem *_backgroundSem;
+	SDL_cond *_backgroundDoneCond;
+	Common::Queue<BackgroundJob> _backgroundJobs;
+	uint32 _backgroundLastId;
+	uint32 _backgroundDoneId;
+};
+
+#endif
@@ -86,7 +86,8 @@ OSystem_SDL::OSystem_SDL()
 	_mixerManager(0),
 	_eventSource(0),
 	_eventSourceWrapper(nullptr),
-	_window(0) {
+	_window(0),
+	_workerPool(nullptr) {
 }
 
 OSystem_SDL::~OSystem_SDL() {
@@ -115,6 +116,9 @@ OSystem_SDL::~OSystem_SDL() {
 	_audiocdManager = 0;
 	delete _mixerManager;
 	_mixerManager = 0;
+	// Only after the mixer, which may render audio in parallel
+	delete _workerPool;
+	_workerPool = nullptr;
 
 #ifdef ENABLE_EVENTRECORDER
 	// HACK HACK HACK
@@ -158,6 +162,9 @@ void OSystem_SDL::init() {
 	if (_window == 0)
 		_window = new SdlWindow();
 
+	if (!_workerPool)
+		_workerPool = new SdlWorkerPool(SdlWorkerPool::getDefaultNumThreads());
+
 #if defined(USE_TASKBAR)
 	if (_taskbarManager == 0)
 		_taskbarManager = new Common::TaskbarManager();
@@ -172,6 +179,8 @@ bool OSystem_SDL::hasFeature(Feature f) {
 	if (f == kFeatureJoystickDeadzone || f == kFeatureKbdMouseSpeed) {
 		return _eventSource->isJoystickConnected();
 	}
+	if (f == kFeatureCpuSSE2)
+		return SDL_HasSSE2();
 	return ModularBackend::hasFeature(f);
 }
 
@@ -570,6 +579,30 @@ SdlMixerManager *OSystem_SDL::getMixerManager() {
 #endif
 }
 
+void OSystem_SDL::runParallel(ParallelJobProc job, void *param, uint count) {
+	if (_workerPool)
+		_workerPool->run(job, param, count);
+	else
+		ModularBackend::runParallel(job, param, count);
+}
+
+uint OSystem_SDL::getParallelJobThreads() {
+	return _workerPool ? _workerPool->getNumThreads() : 1;
+}
+
+uint32 OSystem_SDL::startBackgroundJob(BackgroundJobProc job, void *param) {
+	return _workerPool ? _workerPool->startBackgroundJob(job, param) : 0;
+}
+
+void OSystem_SDL::waitForBackgroundJob(uint32 id) {
+	if (_workerPool)
+		_workerPool->waitForBackgroundJob(id);
+}
+
+bool OSystem_SDL::canRunBackgroundJobs() {
+	return _workerPool != nullptr;
+}
+
 Common::TimerManager *OSystem_SDL::getTimerManager() {
 #ifdef ENABLE_EVENTRECORDER
 	return g_eventRec.getTimerManager();
@@ -30,6 +30,7 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/log/log.h"
 #include "backends/platform/sdl/sdl-window.h"
+#include "backends/platform/sdl/sdl-workerpool.h"
 
 #include "common/array.h"
 
@@ -86,6 +87,11 @@ public:
 	virtual Audio::Mixer *getMixer() override;
 	virtual Common::TimerManager *getTimerManager() override;
 	virtual Common::SaveFileManager *getSavefileManager() override;
+	virtual void runParallel(ParallelJobProc job, void *param, uint count) override;
+	virtual uint getParallelJobThreads() override;
+	virtual uint32 startBackgroundJob(BackgroundJobProc job, void *param) override;
+	virtual void waitForBackgroundJob(uint32 id) override;
+	virtual bool canRunBackgroundJobs() override;
 
 	//Screenshots
 	virtual Common::String getScreenshotsPath();
@@ -124,6 +130,11 @@ protected:
 	 */
 	SdlWindow *_window;
 
+	/**
+	 * The worker threads for runParallel() and startBackgroundJob().
+	 */
+	SdlWorkerPool *_workerPool;
+
 	virtual Common::EventSource *getDefaultEventSource() override { return _eventSource; }
 
 	/**
@@ -27,12 +27,15 @@
 
 #include <limits.h>
 
+#include "engines/detectioncache.h"
+#include "engines/gamescanner.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
 
 #include "common/config-manager.h"
+#include "common/file.h"
 #include "common/fs.h"
 #include "common/rendermode.h"
 #include "common/system.h"
@@ -82,6 +85,14 @@ static const char HELP_STRING[] =
 	"  --auto-detect            Display a list of games from current or specified directory\n"
 	"                           and start the first one. Use --path=PATH to specify a directory.\n"
 	"  --recursive              In combination with --add or --detect recurse down all subdirectories\n"
+	"  --benchmark-startup      Display the time needed to start up until the launcher\n"
+	"                           is ready, and exit\n"
+	"  --write-plugin-index=FILE\n"
+	"                           Write the index of the engine plugins to FILE, and exit\n"
+#ifdef USE_NULL_DRIVER
+	"  --benchmark=FILE         Replay the event recording FILE as fast as possible and\n"
+	"                           print the time taken per frame as JSON\n"
+#endif
 #if defined(WIN32) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -146,6 +157,8 @@ static const char HELP_STRING[] =
                                                                      ", opl2lpt"
 #endif
                                                                               ")\n"
+	"  --opl-capture=FILE       Log all writes to the AdLib (OPL) emulator to FILE, for\n"
+	"                           devtools/opl_replay\n"
 	"  --aspect-ratio           Enable aspect ratio correction\n"
 	"  --render-mode=MODE       Enable additional render modes (hercGreen, hercAmber,\n"
 	"                           cga, ega, vga, amiga, fmtowns, pc9821, pc9801, 2gs,\n"
@@ -251,6 +264,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("cdrom", 0);
 
 	ConfMan.registerDefault("enable_unsupported_game_warning", true);
+	ConfMan.registerDefault("detection_cache", true);
 
 	// Game specific
 	ConfMan.registerDefault("path", "");
@@ -287,6 +301,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("joystick_num", 0);
 	ConfMan.registerDefault("confirm_exit", false);
 	ConfMan.registerDefault("disable_sdl_parachute", false);
+	ConfMan.registerDefault("scaler_threads", 0);
 
 	ConfMan.registerDefault("disable_display", false);
 	ConfMan.registerDefault("record_mode", "none");
@@ -564,6 +579,17 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_BOOL("debug-channels-only")
 			END_OPTION
 
+			DO_LONG_OPTION_BOOL("benchmark-startup")
+			END_OPTION
+
+			DO_LONG_OPTION("write-plugin-index")
+			END_OPTION
+
+#ifdef USE_NULL_DRIVER
+			DO_LONG_OPTION("benchmark")
+			END_OPTION
+#endif
+
 			DO_OPTION('e', "music-driver")
 			END_OPTION
 
@@ -593,6 +619,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("opl-driver")
 			END_OPTION
 
+			DO_LONG_OPTION("opl-capture")
+			END_OPTION
+
 			DO_OPTION('g', "gfx-mode")
 			END_OPTION
 
@@ -965,6 +994,61 @@ static void listAudioDevices() {
 	}
 }
 
+/**
+ * Write the index of the engine plugins, which the build installs with them.
+ * Each line has the name of a plugin file, its engine ID, and either the
+ * names of the files the engine detects games by, or "*" if it may detect
+ * games in any directory.
+ */
+static Common::Error writePluginIndex(const Common::String &fileName) {
+	Common::DumpFile out;
+	if (!out.open(fileName)) {
+		printf("Could not create the plugin index '%s'\n", fileName.c_str());
+		return Common::kCreatingFileFailed;
+	}
+
+	out.writeString("# ScummVM plugin index: plugin file, engine ID, detection files or \"*\"\n");
+
+	uint count = 0;
+	PluginMan.loadFirstPlugin();
+	do {
+		const PluginList &plugins = EngineMan.getPlugins();
+		for (PluginList::const_iterator iter = plugins.begin(); iter != plugins.end(); ++iter) {
+			const MetaEngine &metaEngine = (*iter)->get<MetaEngine>();
+
+			// Static plugins have no file, and only ever get an empty name
+			Common::String line;
+			if ((*iter)->getFileName())
+				line = Common::FSNode((*iter)->getFileName()).getName();
+			line += '\t';
+			line += metaEngine.getEngineId();
+
+			Common::StringArray names;
+			if (metaEngine.getDetectionFileNames(names)) {
+				for (uint i = 0; i < names.size(); ++i) {
+					line += '\t';
+					line += names[i];
+				}
+			} else {
+				line += "\t*";
+			}
+
+			line += '\n';
+			out.writeString(line);
+			count++;
+		}
+	} while (PluginMan.loadNextPlugin());
+
+	out.finalize();
+	if (out.err()) {
+		printf("Could not write the plugin index '%s'\n", fileName.c_str());
+		return Common::kWritingFailed;
+	}
+
+	printf("Wrote %u engines to the plugin index '%s'\n", count, fileName.c_str());
+	return Common::kNoError;
+}
+
 /** Display all games in the given directory, or current directory if empty */
 static DetectedGames getGameList(const Common::FSNode &dir) {
 	Common::FSList files;
@@ -1035,55 +1119,66 @@ static Common::String detectGames(const Common::String &path, const Common::Stri
 	return buildQualifiedGameName(candidates[0].engineId, candidates[0].gameId);
 }
 
-static int recAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
-	int count = 0;
-	DetectedGames list = getGameList(dir);
-	for (DetectedGames::const_iterator v = list.begin(); v != list.end(); ++v) {
-		if ((v->engineId != engineId || v->gameId != gameId)
-		    && !gameId.empty()) {
-			printf("Found %s, only adding %s per --game option, ignoring...\n",
-			       buildQualifiedGameName(v->engineId, v->gameId).c_str(),
-			       buildQualifiedGameName(engineId, gameId).c_str());
-		} else if (ConfMan.hasGameDomain(v->preferredTarget)) {
-			// TODO Better check for game already added?
-			printf("Found %s, but has already been added, skipping\n",
-			       buildQualifiedGameName(v->engineId, v->gameId).c_str());
-		} else {
-			Common::String target = EngineMan.createTargetForGame(*v);
-			count++;
-
-			// Display added game info
-			printf("Game Added: \n  Target:   %s\n  GameID:   %s\n  Name:     %s\n  Language: %s\n  Platform: %s\n",
-			       target.c_str(),
-			       buildQualifiedGameName(v->engineId, v->gameId).c_str(),
-			       v->description.c_str(),
-			       Common::getLanguageDescription(v->language),
-			       Common::getPlatformDescription(v->platform)
-			);
-		}
+static bool addGames(const Common::String &path, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+	//Current directory
+	Common::FSNode dir(path);
+	if (!dir.isDirectory()) {
+		printf("Path %s does not exist or is not a directory.\n", dir.getPath().c_str());
+		return true;
 	}
 
-	if (recursive) {
-		Common::FSList files;
-		if (dir.getChildren(files, Common::FSNode::kListDirectoriesOnly)) {
-			for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-				count += recAddGames(*file, engineId, gameId, recursive);
+	// FIXME HACK: The detection cache is kept by the savefile manager
+	g_system->initBackend();
+
+	int added = 0;
+	DetectionCacheMan.resetStats();
+	GameScanner scanner(dir, recursive);
+	GameScanner::Result result;
+	bool done;
+	do {
+		// Scan in slices, so the games are reported while the scan goes on
+		done = scanner.scan(100);
+
+		while (scanner.popResult(result)) {
+			for (DetectedGames::const_iterator v = result.games.begin(); v != result.games.end(); ++v) {
+				if ((v->engineId != engineId || v->gameId != gameId)
+				    && !gameId.empty()) {
+					printf("Found %s, only adding %s per --game option, ignoring...\n",
+					       buildQualifiedGameName(v->engineId, v->gameId).c_str(),
+					       buildQualifiedGameName(engineId, gameId).c_str());
+				} else if (ConfMan.hasGameDomain(v->preferredTarget)) {
+					// TODO Better check for game already added?
+					printf("Found %s, but has already been added, skipping\n",
+					       buildQualifiedGameName(v->engineId, v->gameId).c_str());
+				} else {
+					Common::String target = EngineMan.createTargetForGame(*v);
+					added++;
+
+					// Display added game info
+					printf("Game Added: \n  Target:   %s\n  GameID:   %s\n  Name:     %s\n  Language: %s\n  Platform: %s\n",
+					       target.c_str(),
+					       buildQualifiedGameName(v->engineId, v->gameId).c_str(),
+					       v->description.c_str(),
+					       Common::getLanguageDescription(v->language),
+					       Common::getPlatformDescription(v->platform)
+					);
+				}
 			}
 		}
-	}
-
-	return count;
-}
+	} while (!done);
 
-static bool addGames(const Common::String &path, const Common::String &engineId, const Common::String &gameId, bool recursive) {
-	//Current directory
-	Common::FSNode dir(path);
-	int added = recAddGames(dir, engineId, gameId, recursive);
+	const GameScannerStats &stats = scanner.getStats();
 	printf("Added %d games\n", added);
+	printf("Scanned %u directories in %u ms (%u ms listing, %u ms hashing %u files, %u ms detecting)\n",
+	       stats.dirsDetected, stats.listTime + stats.hashTime + stats.detectTime, stats.listTime,
+	       stats.hashTime, stats.filesHashed, stats.detectTime);
+	printf("Detection cache: %u of %u checksums cached (%u%%)\n", DetectionCacheMan.getHits(),
+	       DetectionCacheMan.getHits() + DetectionCacheMan.getMisses(), DetectionCacheMan.getHitRate());
 	if (added == 0 && !recursive) {
 		printf("Consider using --recursive to search inside subdirectories\n");
 	}
 	ConfMan.flushToDisk();
+	DetectionCacheMan.flush();
 	return true;
 }
 
@@ -1301,6 +1396,11 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 		}
 	}
 
+	if (settings.contains("write-plugin-index")) {
+		err = writePluginIndex(settings["write-plugin-index"]);
+		return true;
+	}
+
 	// Handle commands passed via the command line (like --list-targets and
 	// --list-games). This must be done after the config file and the plugins
 	// have been loaded.
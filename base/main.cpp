@@ -31,6 +31,7 @@
 // FIXME: Avoid using printf
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
+#include "engines/detectioncache.h"
 #include "engines/engine.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
@@ -106,6 +107,27 @@ static bool launcherDialog() {
 	return (dlg.runModal() != -1);
 }
 
+/**
+ * Report the time from the start of scummvm_main() until the launcher is
+ * ready to be shown, and the number of engine plugins in memory.
+ */
+static void benchmarkStartup(uint32 startTime) {
+	ConfMan.getDomain(Common::ConfigManager::kTransientDomain)->clear();
+	ConfMan.setActiveDomain("");
+
+	{
+		// Creating the launcher builds the list of targets
+#if defined(__DC__)
+		DCLauncherDialog dlg;
+#else
+		GUI::LauncherDialog dlg;
+#endif
+	}
+
+	printf("Time to launcher: %u ms, %u engine plugins in memory\n",
+	       g_system->getMillis() - startTime, PluginMan.getPlugins(PLUGIN_TYPE_ENGINE).size());
+}
+
 static const Plugin *detectPlugin() {
 	// Figure out the engine ID and game ID
 	Common::String engineId = ConfMan.get("engineid");
@@ -384,6 +406,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// Verify that the backend has been initialized (i.e. g_system has been set).
 	assert(g_system);
 	OSystem &system = *g_system;
+	const uint32 startTime = system.getMillis();
 
 	// Register config manager defaults
 	Base::registerDefaults();
@@ -518,7 +541,9 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 #endif
 
 	// Unless a game was specified, show the launcher dialog
-	if (0 == ConfMan.getActiveDomain())
+	if (settings.contains("benchmark-startup"))
+		benchmarkStartup(startTime);
+	else if (0 == ConfMan.getActiveDomain())
 		launcherDialog();
 
 	// FIXME: We're now looping the launcher. This, of course, doesn't
@@ -649,6 +674,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Cloud::CloudManager::destroy();
 #endif
 #endif
+	// Write the detection cache while the savefile manager is still usable
+	DetectionCache::destroy();
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
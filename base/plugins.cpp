@@ -30,6 +30,7 @@
 #ifdef DYNAMIC_MODULES
 #include "common/fs.h"
 #endif
+#include "common/file.h"
 
 // Plugin versioning
 
@@ -216,6 +217,81 @@ void FilePluginProvider::addCustomDirectories(Common::FSList &dirs) const {
 
 #pragma mark -
 
+const char *const PluginIndex::kFileName = "plugins.idx";
+
+bool PluginIndex::load(const Common::FSNode &dir) {
+	Common::FSNode node = dir.getChild(kFileName);
+	Common::File file;
+	if (!node.exists() || !file.open(node))
+		return false;
+
+	while (!file.eos() && !file.err()) {
+		Common::String line = file.readLine();
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		// The fields are the plugin file name, the engine ID, and either "*"
+		// or the detection file names
+		Common::StringArray fields;
+		const char *start = line.c_str();
+		for (const char *p = start; ; ++p) {
+			if (*p == '\t' || *p == '\0') {
+				fields.push_back(Common::String(start, p));
+				if (*p == '\0')
+					break;
+				start = p + 1;
+			}
+		}
+		if (fields.size() < 3 || fields[0].empty())
+			continue;
+
+		const Common::String path = dir.getChild(fields[0]).getPath();
+		Entry &entry = _plugins[path];
+		entry.anyFiles = (fields[2] == "*");
+		entry.fileNames.clear();
+		if (!entry.anyFiles) {
+			for (uint i = 2; i < fields.size(); ++i)
+				entry.fileNames[fields[i]] = true;
+		}
+		_engines[fields[1]] = path;
+	}
+
+	debug(1, "Read the plugin index '%s'", node.getPath().c_str());
+	return true;
+}
+
+void PluginIndex::clear() {
+	_plugins.clear();
+	_engines.clear();
+}
+
+Common::String PluginIndex::findEngine(const Common::String &engineId) const {
+	Common::HashMap<Common::String, Common::String>::const_iterator i = _engines.find(engineId);
+	return i != _engines.end() ? i->_value : Common::String();
+}
+
+bool PluginIndex::mayDetect(const char *pluginFileName, const Common::FSList &fslist) const {
+	if (!pluginFileName)
+		return true;
+
+	Common::HashMap<Common::String, Entry>::const_iterator i = _plugins.find(pluginFileName);
+	if (i == _plugins.end() || i->_value.anyFiles)
+		return true;
+
+	for (Common::FSList::const_iterator file = fslist.begin(); file != fslist.end(); ++file) {
+		if (file->isDirectory())
+			continue;
+
+		// Strip the trailing dot like the advanced detector does
+		Common::String name = file->getName();
+		if (name.lastChar() == '.')
+			name.deleteLastChar();
+		if (i->_value.fileNames.contains(name))
+			return true;
+	}
+	return false;
+}
+
 PluginManager *PluginManager::_instance = NULL;
 
 PluginManager &PluginManager::instance() {
@@ -257,9 +333,11 @@ void PluginManager::addPluginProvider(PluginProvider *pp) {
 void PluginManagerUncached::init() {
 	unloadAllPlugins();
 	_allEnginePlugins.clear();
+	_index.clear();
 
 	unloadPluginsExcept(PLUGIN_TYPE_ENGINE, NULL, false); // empty the engine plugins
 
+	Common::HashMap<Common::String, bool> pluginDirs;
 	for (ProviderList::iterator pp = _providers.begin();
 	                            pp != _providers.end();
 	                            ++pp) {
@@ -272,6 +350,7 @@ void PluginManagerUncached::init() {
 			// music or an engine plugin.
 			if ((*pp)->isFilePluginProvider()) {
 				_allEnginePlugins.push_back(*p);
+				pluginDirs[Common::FSNode((*p)->getFileName()).getParent().getPath()] = true;
 			} else if ((*p)->loadPlugin()) { // and this is the proper method
 				if ((*p)->getType() == PLUGIN_TYPE_ENGINE) {
 					(*p)->unloadPlugin();
@@ -283,13 +362,21 @@ void PluginManagerUncached::init() {
 			}
  		}
  	}
+
+	for (Common::HashMap<Common::String, bool>::const_iterator d = pluginDirs.begin(); d != pluginDirs.end(); ++d)
+		_index.load(Common::FSNode(d->_key));
 }
 
 /**
- * Try to load the plugin by searching in the ConfigManager for a matching
- * engine ID under the domain 'engine_plugin_files'.
+ * Try to load the plugin which the plugin index lists for the engine ID, then
+ * the one in the ConfigManager under the domain 'engine_plugin_files'. If
+ * there is none, try the plugin file named after the engine ID, which is how
+ * the build names the engine plugins.
  **/
 bool PluginManagerUncached::loadPluginFromEngineId(const Common::String &engineId) {
+	if (loadPluginByFileName(_index.findEngine(engineId)))
+		return true;
+
 	Common::ConfigManager::Domain *domain = ConfMan.getDomain("engine_plugin_files");
 
 	if (domain) {
@@ -301,6 +388,20 @@ bool PluginManagerUncached::loadPluginFromEngineId(const Common::String &engineI
 			}
 		}
 	}
+
+#if defined(PLUGIN_PREFIX) && defined(PLUGIN_SUFFIX)
+	const Common::String baseName = PLUGIN_PREFIX + engineId + PLUGIN_SUFFIX;
+	PluginList::iterator i;
+	for (i = _allEnginePlugins.begin(); i != _allEnginePlugins.end(); ++i) {
+		const Common::String filename((*i)->getFileName());
+		if (filename.size() > baseName.size() && filename.hasSuffix(baseName)) {
+			const char sep = filename[filename.size() - baseName.size() - 1];
+			if ((sep == '/' || sep == '\\') && loadPluginByFileName(filename))
+				return true;
+		}
+	}
+#endif
+
 	return false;
 }
 
@@ -369,6 +470,42 @@ bool PluginManagerUncached::loadNextPlugin() {
 	return false; // no more in list
 }
 
+/**
+ * Load the first plugin which may detect a game in the directory with the
+ * given files, skipping those the plugin index rules out.
+ **/
+void PluginManagerUncached::loadFirstPluginForDetection(const Common::FSList &fslist) {
+	unloadPluginsExcept(PLUGIN_TYPE_ENGINE, NULL, false);
+
+	_currentPlugin = _allEnginePlugins.begin();
+	loadCurrentPluginForDetection(fslist);
+}
+
+bool PluginManagerUncached::loadNextPluginForDetection(const Common::FSList &fslist) {
+	unloadPluginsExcept(PLUGIN_TYPE_ENGINE, NULL, false);
+
+	if (!_currentPlugin || _currentPlugin == _allEnginePlugins.end())
+		return false;
+
+	++_currentPlugin;
+	return loadCurrentPluginForDetection(fslist);
+}
+
+bool PluginManagerUncached::loadCurrentPluginForDetection(const Common::FSList &fslist) {
+	for (; _currentPlugin != _allEnginePlugins.end(); ++_currentPlugin) {
+		if (!_index.mayDetect((*_currentPlugin)->getFileName(), fslist)) {
+			debug(2, "Skipping the plugin '%s', which detects none of the files", (*_currentPlugin)->getFileName());
+			continue;
+		}
+
+		if ((*_currentPlugin)->loadPlugin()) {
+			addToPluginsInMemList(*_currentPlugin);
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  * Used by only the cached plugin manager. The uncached manager can only have
  * one plugin in memory at a time.
@@ -536,7 +673,7 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist) const
 	DetectedGames candidates;
 	PluginList plugins;
 	PluginList::const_iterator iter;
-	PluginMan.loadFirstPlugin();
+	PluginMan.loadFirstPluginForDetection(fslist);
 	do {
 		plugins = getPlugins();
 		// Iterate over all known games and for each check if it might be
@@ -552,11 +689,22 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist) const
 			}
 
 		}
-	} while (PluginMan.loadNextPlugin());
+	} while (PluginMan.loadNextPluginForDetection(fslist));
 
 	return DetectionResults(candidates);
 }
 
+void EngineManager::getDetectionChecksums(const Common::FSList &fslist, Common::Array<DetectionChecksum> &checksums) const {
+	PluginList plugins;
+	PluginList::const_iterator iter;
+	PluginMan.loadFirstPluginForDetection(fslist);
+	do {
+		plugins = getPlugins();
+		for (iter = plugins.begin(); iter != plugins.end(); ++iter)
+			(*iter)->get<MetaEngine>().getDetectionChecksums(fslist, checksums);
+	} while (PluginMan.loadNextPluginForDetection(fslist));
+}
+
 const PluginList &EngineManager::getPlugins() const {
 	return PluginManager::instance().getPlugins(PLUGIN_TYPE_ENGINE);
 }
@@ -25,7 +25,9 @@
 
 #include "common/array.h"
 #include "common/fs.h"
+#include "common/hash-str.h"
 #include "common/str.h"
+#include "common/str-array.h"
 #include "backends/plugins/elf/version.h"
 
 #define INCLUDED_FROM_BASE_PLUGINS_H
@@ -317,6 +319,8 @@ public:
 	virtual bool loadNextPlugin() { return false; }
 	virtual bool loadPluginFromEngineId(const Common::String &engineId) { return false; }
 	virtual void updateConfigWithFileName(const Common::String &engineId) {}
+	virtual void loadFirstPluginForDetection(const Common::FSList &fslist) { loadFirstPlugin(); }
+	virtual bool loadNextPluginForDetection(const Common::FSList &fslist) { return loadNextPlugin(); }
 
 	// Functions used only by the cached PluginManager
 	virtual void loadAllPlugins();
@@ -328,6 +332,47 @@ public:
 	const PluginList &getPlugins(PluginType t) { return _pluginsInMem[t]; }
 };
 
+/**
+ * The index of the engine plugin files, written at build time by
+ * --write-plugin-index into the directory of the plugins. For each file it
+ * lists the engine and the names of the files the engine detects games by,
+ * so that the uncached plugin manager only loads the plugins it needs.
+ * Plugin files which are not in an index are always loaded.
+ */
+class PluginIndex {
+public:
+	static const char *const kFileName;
+
+	/** Add the entries of the index in the given plugin directory. */
+	bool load(const Common::FSNode &dir);
+	void clear();
+
+	/**
+	 * Return the path of the plugin file with the given engine, or an empty
+	 * string if no index lists the engine.
+	 */
+	Common::String findEngine(const Common::String &engineId) const;
+
+	/**
+	 * Return whether the plugin in the given file may detect a game in a
+	 * directory with the given files.
+	 */
+	bool mayDetect(const char *pluginFileName, const Common::FSList &fslist) const;
+
+private:
+	typedef Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileNameSet;
+
+	struct Entry {
+		bool anyFiles;
+		FileNameSet fileNames;
+
+		Entry() : anyFiles(true) {}
+	};
+
+	Common::HashMap<Common::String, Entry> _plugins;
+	Common::HashMap<Common::String, Common::String> _engines;
+};
+
 /**
  *  Uncached version of plugin manager
  *  Keeps only one dynamic plugin in memory at a time
@@ -337,9 +382,11 @@ protected:
 	friend class PluginManager;
 	PluginList _allEnginePlugins;
 	PluginList::iterator _currentPlugin;
+	PluginIndex _index;
 
 	PluginManagerUncached() {}
 	bool loadPluginByFileName(const Common::String &filename);
+	bool loadCurrentPluginForDetection(const Common::FSList &fslist);
 
 public:
 	virtual void init();
@@ -347,6 +394,8 @@ public:
 	virtual bool loadNextPlugin();
 	virtual bool loadPluginFromEngineId(const Common::String &engineId);
 	virtual void updateConfigWithFileName(const Common::String &engineId);
+	virtual void loadFirstPluginForDetection(const Common::FSList &fslist);
+	virtual bool loadNextPluginForDetection(const Common::FSList &fslist);
 
 	virtual void loadAllPlugins() {} 	// we don't allow these
 	virtual void loadAllPluginsOfType(PluginType type) {}
@@ -0,0 +1,584 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+#include "common/math.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * The control bytes of a group of FlatHashMap slots, and functions to
+ * match all of them at once. A control byte is kEmpty, kDeleted, or
+ * holds the upper 7 bits of the hash of the key in the slot.
+ *
+ * The matching uses SSE2 if the compiler targets it anyway, so no
+ * runtime check is needed.
+ */
+struct FlatHashMapGroup {
+	enum {
+		kWidth = 16,
+		kEmpty = 0x80,
+		kDeleted = 0xFE
+	};
+
+#if defined(FLATHASHMAP_SSE2)
+	/** Return a mask of the slots whose control byte equals the given value. */
+	static uint32 match(const byte *ctrl, byte value) {
+		const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+	}
+
+	/** Return a mask of the empty and deleted slots. */
+	static uint32 matchFree(const byte *ctrl) {
+		return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+	}
+#else
+	static uint32 match(const byte *ctrl, byte value) {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; ++i)
+			mask |= (uint32)(ctrl[i] == value) << i;
+		return mask;
+	}
+
+	static uint32 matchFree(const byte *ctrl) {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; ++i)
+			mask |= (uint32)(ctrl[i] >> 7) << i;
+		return mask;
+	}
+#endif
+
+	/** Return the index of the lowest set bit of a non-zero mask. */
+	static uint lowestBit(uint32 mask) {
+		return intLog2(mask & (0 - mask));
+	}
+};
+
+/**
+ * FlatHashMap<Key,Val> has the same interface as HashMap<Key,Val>, but
+ * uses open addressing with the keys and values stored in the table
+ * itself, instead of pointers to separately allocated nodes. This saves
+ * a pointer indirection, and usually a cache miss, on each lookup.
+ *
+ * The table is split into groups of 16 slots, whose control bytes are
+ * compared at once with the hash of the key, so only a few keys need to
+ * be compared. The hash of each key is kept in its slot, so it is not
+ * recomputed when the table grows, and most mismatches are detected
+ * without calling the equality functor.
+ *
+ * Keys and values move when the table grows, so pointers and references
+ * to them are only valid until the next insertion. Iterators are
+ * invalidated by insertions too, but not by erasing other entries.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		/** The mixed hash of the key. */
+		const size_type _hashValue;
+
+		Node(const Key &key, size_type hashValue) : _key(key), _value(), _hashValue(hashValue) {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+	typedef FlatHashMapGroup Group;
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = Group::kWidth,
+
+		// The table grows when the used and deleted slots exceed this part
+		// of the capacity. Keeping some slots empty bounds the length of
+		// the probe sequences.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	byte *_ctrl;		///< One control byte per slot
+	Node *_slots;		///< Uninitialized memory for mask + 1 nodes
+	size_type _mask;	///< Capacity minus one; the capacity is a power of two
+	size_type _size;
+	size_type _deleted;	///< Number of slots marked as kDeleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Return the hash of a key, mixed so that the low bits select the
+	 * group and the high bits become the control byte. This is the
+	 * finalizer of MurmurHash3: a plain multiplication only carries bits
+	 * upwards, so keys differing only in their high bits, like keys with a
+	 * power of two stride, would all land in the same few groups.
+	 */
+	size_type hashOf(const Key &key) const {
+		uint32 hash = _hash(key);
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6BU;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35U;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	static byte tagOf(size_type hash) {
+		return (byte)(hash >> (sizeof(size_type) * 8 - 7));
+	}
+
+	size_type groupMask() const {
+		return (_mask + 1) / Group::kWidth - 1;
+	}
+
+	bool isFull(size_type idx) const {
+		return !(_ctrl[idx] & 0x80);
+	}
+
+	void allocate(size_type capacity);
+	void destroyNodes();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key, size_type hash) const;
+	size_type findFreeSlot(size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type idx);
+
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->isFull(_idx));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && !_hashmap->isFull(_idx));
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		destroyNodes();
+		delete[] _ctrl;
+		free(_slots);
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	/**
+	 * Return the largest number of groups a lookup of a stored key has to
+	 * visit. Meant for checking how well a hash function spreads the keys.
+	 */
+	size_type getMaxProbeLength() const;
+
+	iterator begin() {
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator begin() const {
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator find(const Key &key) {
+		const size_type ctr = lookup(key, hashOf(key));
+		return ctr <= _mask ? iterator(ctr, this) : end();
+	}
+
+	const_iterator find(const Key &key) const {
+		const size_type ctr = lookup(key, hashOf(key));
+		return ctr <= _mask ? const_iterator(ctr, this) : end();
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocate(FLATHASHMAP_MIN_CAPACITY);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	destroyNodes();
+	delete[] _ctrl;
+	free(_slots);
+}
+
+/**
+ * Allocate an empty table with the given capacity.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocate(size_type capacity) {
+	_mask = capacity - 1;
+	_ctrl = new byte[capacity];
+	memset(_ctrl, Group::kEmpty, capacity);
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	assert(_slots != nullptr);
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::destroyNodes() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(ctr))
+			_slots[ctr].~Node();
+	}
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap to this
+ * one. The nodes keep their slots, since the capacity is the same.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocate(map._mask + 1);
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(ctr))
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	destroyNodes();
+
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		delete[] _ctrl;
+		free(_slots);
+		allocate(FLATHASHMAP_MIN_CAPACITY);
+	} else {
+		memset(_ctrl, Group::kEmpty, _mask + 1);
+		_size = 0;
+		_deleted = 0;
+	}
+}
+
+/**
+ * Move all nodes into a table of the given capacity. This also drops the
+ * deleted slots.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	const size_type oldSize = _size;
+	const size_type oldMask = _mask;
+	byte *oldCtrl = _ctrl;
+	Node *oldSlots = _slots;
+
+	allocate(newCapacity);
+
+	for (size_type ctr = 0; ctr <= oldMask; ++ctr) {
+		if (oldCtrl[ctr] & 0x80)
+			continue;
+
+		// Since no key exists twice in the old table, we can just take the
+		// first free slot, without comparing any keys.
+		Node &node = oldSlots[ctr];
+		const size_type idx = findFreeSlot(node._hashValue);
+		_ctrl[idx] = oldCtrl[ctr];
+		new ((void *)&_slots[idx]) Node(node);
+		node.~Node();
+	}
+	_size = oldSize;
+
+	delete[] oldCtrl;
+	free(oldSlots);
+}
+
+/**
+ * Return the slot holding the given key, or mask + 1 if there is none.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FORCEINLINE typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
+	const byte tag = tagOf(hash);
+	const size_type mask = groupMask();
+	size_type group = hash & mask;
+
+	// Probe the groups in triangular steps, which visits every group since
+	// their number is a power of two. The load factor guarantees that there
+	// is an empty slot somewhere, which ends the search.
+	for (size_type step = 1; ; ++step) {
+		const byte *ctrl = _ctrl + group * Group::kWidth;
+		for (uint32 matches = Group::match(ctrl, tag); matches; matches &= matches - 1) {
+			const size_type idx = group * Group::kWidth + Group::lowestBit(matches);
+			if (_slots[idx]._hashValue == hash && _equal(_slots[idx]._key, key))
+				return idx;
+		}
+		if (Group::match(ctrl, Group::kEmpty))
+			return _mask + 1;
+
+		group = (group + step) & mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::getMaxProbeLength() const {
+	const size_type mask = groupMask();
+	size_type maxLength = 0;
+
+	for (size_type idx = 0; idx <= _mask; ++idx) {
+		if (!isFull(idx))
+			continue;
+
+		// Follow the probe sequence of the key until the group holding it
+		size_type group = _slots[idx]._hashValue & mask;
+		size_type length = 1;
+		while (group != idx / Group::kWidth) {
+			group = (group + length) & mask;
+			++length;
+		}
+		maxLength = MAX(maxLength, length);
+	}
+
+	return maxLength;
+}
+
+/**
+ * Return the first empty or deleted slot in the probe sequence of the hash.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(size_type hash) const {
+	const size_type mask = groupMask();
+	size_type group = hash & mask;
+
+	for (size_type step = 1; ; ++step) {
+		const uint32 freeSlots = Group::matchFree(_ctrl + group * Group::kWidth);
+		if (freeSlots)
+			return group * Group::kWidth + Group::lowestBit(freeSlots);
+
+		group = (group + step) & mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = hashOf(key);
+	size_type ctr = lookup(key, hash);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are
+	// also counted. If many of them are deleted, rehashing into a table
+	// of the same size is enough to get rid of them.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity *= 2;
+		rehash(capacity);
+	}
+
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == Group::kDeleted)
+		_deleted--;
+	_ctrl[ctr] = tagOf(hash);
+	new ((void *)&_slots[ctr]) Node(key, hash);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	_slots[idx].~Node();
+	_size--;
+
+	// If the group still has an empty slot, it was never full, so no probe
+	// sequence continues past it, and the slot can become empty again.
+	// Otherwise it must be marked as deleted to keep the probe sequences
+	// through this group intact.
+	if (Group::match(_ctrl + (idx & ~(size_type)(Group::kWidth - 1)), Group::kEmpty)) {
+		_ctrl[idx] = Group::kEmpty;
+	} else {
+		_ctrl[idx] = Group::kDeleted;
+		_deleted++;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key, hashOf(key)) <= _mask;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	// The lookup may reallocate the slots, so it must happen first
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	const size_type ctr = lookup(key, hashOf(key));
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	assert(entry._idx <= _mask);
+	assert(isFull(entry._idx));
+	eraseSlot(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	const size_type ctr = lookup(key, hashOf(key));
+	if (ctr <= _mask)
+		eraseSlot(ctr);
+}
+
+} // End of namespace Common
+
+#endif
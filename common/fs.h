@@ -213,6 +213,15 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this node, in seconds. The epoch is not specified, so this is only
+	 * suitable to detect whether the object changed.
+	 *
+	 * @return the modification time, or 0 if it is not known.
+	 */
+	uint32 getModificationTime() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -71,8 +71,11 @@ void MemoryPool::allocPage() {
 	_pages.push_back(page);
 
 
-	// Next time, we'll allocate a page twice as big as this one.
-	_chunksPerPage *= 2;
+	// Next time, we'll allocate a page twice as big as this one, unless
+	// that goes over the limit. Pools of large objects, like the config
+	// domains of thousands of games, keep adding pages of the largest size.
+	if (_chunksPerPage * 2 * _chunkSize < 16*1024*1024)
+		_chunksPerPage *= 2;
 
 	// Add the page to the pool of free chunk
 	addPageToPool(page);
@@ -112,6 +115,13 @@ void MemoryPool::freeChunk(void *ptr) {
 	_next = ptr;
 }
 
+size_t MemoryPool::getPageMemory() const {
+	size_t size = 0;
+	for (size_t i = 0; i < _pages.size(); ++i)
+		size += _pages[i].numChunks * _chunkSize;
+	return size;
+}
+
 // Technically not compliant C++ to compare unrelated pointers. In practice...
 bool MemoryPool::isPointerInPage(void *ptr, const Page &page) {
 	return (ptr >= page.start) && (ptr < (char *)page.start + page.numChunks * _chunkSize);
@@ -94,6 +94,12 @@ public:
 	 * Return the chunk size used by this memory pool.
 	 */
 	size_t	getChunkSize() const { return _chunkSize; }
+
+	/**
+	 * Return the number of bytes in the pages allocated by this memory
+	 * pool, not counting storage added by subclasses.
+	 */
+	size_t	getPageMemory() const;
 };
 
 /**
@@ -27,7 +27,9 @@ MODULE_OBJS := \
 	quicktime.o \
 	random.o \
 	rational.o \
+	recorderfile.o \
 	rendermode.o \
+	slaballocator.o \
 	str.o \
 	str-enc.o \
 	stream.o \
@@ -53,11 +55,6 @@ MODULE_OBJS += \
 	encoding.o \
 	sinetables.o
 
-ifdef ENABLE_EVENTRECORDER
-MODULE_OBJS += \
-	recorderfile.o
-endif
-
 ifdef USE_UPDATES
 MODULE_OBJS += \
 	updates.o
@@ -21,7 +21,7 @@
  */
 
 #include "common/system.h"
-#include "gui/EventRecorder.h"
+#include "common/debug.h"
 #include "common/md5.h"
 #include "common/recorderfile.h"
 #include "common/savefile.h"
@@ -347,7 +347,8 @@ RecorderEvent PlaybackFile::getNextEvent() {
 		}
 	}
 	RecorderEvent result;
-	readEvent(result);
+	if (!isEventsBufferEmpty())
+		readEvent(result);
 	return result;
 }
 
@@ -705,12 +706,22 @@ void PlaybackFile::writeSaveFilesSection() {
 }
 
 
+bool PlaybackFile::grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]) {
+	if (!createScreenShot(screen)) {
+		warning("Can't save screenshot");
+		return false;
+	}
+	MemoryReadStream bitmapStream((const byte*)screen.getPixels(), screen.w * screen.h * screen.format.bytesPerPixel);
+	computeStreamMD5(bitmapStream, md5);
+	return true;
+}
+
 void PlaybackFile::checkRecordedMD5() {
 	uint8 currentMD5[16];
 	uint8 savedMD5[16];
 	Graphics::Surface screen;
 	_readStream->read(savedMD5, 16);
-	if (!g_eventRec.grabScreenAndComputeMD5(screen, currentMD5)) {
+	if (!grabScreenAndComputeMD5(screen, currentMD5)) {
 		return;
 	}
 	uint32 seconds = g_system->getMillis(true) / 1000;
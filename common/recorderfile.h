@@ -127,6 +127,10 @@ public:
 	bool openRead(const String &fileName);
 	void close();
 
+	/**
+	 * Return the next recorded event. Once all events are read, this
+	 * returns a normal event of type EVENT_INVALID.
+	 */
 	RecorderEvent getNextEvent();
 	void writeEvent(const RecorderEvent &event);
 
@@ -138,6 +142,9 @@ public:
 	PlaybackFileHeader &getHeader() {return _header;}
 	void updateHeader();
 	void addSaveFile(const String &fileName, InSaveFile *saveStream);
+
+	/** Retrieve game screenshot and compute its checksum for comparison */
+	static bool grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]);
 private:
 	WriteStream *_recordFile;
 	WriteStream *_writeStream;
@@ -182,7 +189,6 @@ private:
 	bool skipToNextScreenshot();
 	void readEvent(RecorderEvent& event);
 	void readEventsToBuffer(uint32 size);
-	bool grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]);
 };
 
 } // End of namespace Common
@@ -0,0 +1,259 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "common/slaballocator.h"
+#include "common/math.h"
+
+namespace Common {
+
+SlabAllocator::SlabAllocator(bool threadSafe) : _threadSafe(threadSafe), _mutex(nullptr) {
+	memset(_stats, 0, sizeof(_stats));
+	for (uint i = 0; i < kNumSizeClasses; ++i) {
+		_pools[i] = new MemoryPool(kMinChunkSize << i);
+		_stats[i].chunkSize = kMinChunkSize << i;
+	}
+}
+
+SlabAllocator::~SlabAllocator() {
+	for (uint i = 0; i < kNumSizeClasses; ++i)
+		delete _pools[i];
+	if (_mutex)
+		g_system->deleteMutex(_mutex);
+}
+
+void SlabAllocator::lock() {
+	// Like the memory pool of String, this is used before the backend
+	// can create mutexes, but then there is only one thread anyway
+	if (!_threadSafe || !g_system || !g_system->backendInitialized())
+		return;
+	if (!_mutex)
+		_mutex = g_system->createMutex();
+	g_system->lockMutex(_mutex);
+}
+
+void SlabAllocator::unlock() {
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
+}
+
+uint SlabAllocator::getSizeClass(size_t size) {
+	if (size <= kMinChunkSize)
+		return 0;
+	if (size > kMaxChunkSize)
+		return kNumSizeClasses;
+	return intLog2((uint32)(size - 1)) - intLog2(kMinChunkSize) + 1;
+}
+
+void SlabAllocator::updateReserved(uint sizeClass) {
+	_stats[sizeClass].bytesReserved = _pools[sizeClass]->getPageMemory();
+}
+
+void *SlabAllocator::allocate(size_t size) {
+	const uint sizeClass = getSizeClass(size);
+
+	lock();
+	void *ptr;
+	SlabAllocatorStats &stats = _stats[sizeClass];
+	if (sizeClass == kNumSizeClasses) {
+		ptr = malloc(size);
+		stats.bytesReserved += size;
+	} else {
+		ptr = _pools[sizeClass]->allocChunk();
+		if (stats.chunksInUse * stats.chunkSize == stats.bytesReserved)
+			updateReserved(sizeClass);
+	}
+	stats.numAllocs++;
+	stats.chunksInUse++;
+	stats.bytesInUse += size;
+	stats.peakBytesInUse = MAX(stats.peakBytesInUse, stats.bytesInUse);
+	unlock();
+
+	return ptr;
+}
+
+void SlabAllocator::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	const uint sizeClass = getSizeClass(size);
+
+	lock();
+	SlabAllocatorStats &stats = _stats[sizeClass];
+	if (sizeClass == kNumSizeClasses) {
+		free(ptr);
+		stats.bytesReserved -= size;
+	} else {
+		_pools[sizeClass]->freeChunk(ptr);
+	}
+	stats.chunksInUse--;
+	stats.bytesInUse -= size;
+	unlock();
+}
+
+void *SlabAllocator::allocateBatch(uint sizeClass, uint count) {
+	assert(sizeClass < kNumSizeClasses && count > 0);
+
+	lock();
+	SlabAllocatorStats &stats = _stats[sizeClass];
+	void *list = nullptr;
+	for (uint i = 0; i < count; ++i) {
+		void *chunk = _pools[sizeClass]->allocChunk();
+		*(void **)chunk = list;
+		list = chunk;
+	}
+	updateReserved(sizeClass);
+	stats.numAllocs += count;
+	stats.chunksInUse += count;
+	stats.bytesInUse += count * stats.chunkSize;
+	stats.peakBytesInUse = MAX(stats.peakBytesInUse, stats.bytesInUse);
+	unlock();
+
+	return list;
+}
+
+void SlabAllocator::deallocateBatch(uint sizeClass, void *list, uint count) {
+	assert(sizeClass < kNumSizeClasses);
+
+	lock();
+	SlabAllocatorStats &stats = _stats[sizeClass];
+	while (list) {
+		void *next = *(void **)list;
+		_pools[sizeClass]->freeChunk(list);
+		list = next;
+	}
+	stats.chunksInUse -= count;
+	stats.bytesInUse -= count * stats.chunkSize;
+	unlock();
+}
+
+void SlabAllocator::freeUnusedPages() {
+	lock();
+	for (uint i = 0; i < kNumSizeClasses; ++i) {
+		_pools[i]->freeUnusedPages();
+		updateReserved(i);
+	}
+	unlock();
+}
+
+SlabAllocatorStats SlabAllocator::getTotalStats() const {
+	SlabAllocatorStats total;
+	memset(&total, 0, sizeof(total));
+	for (uint i = 0; i <= kNumSizeClasses; ++i) {
+		total.numAllocs += _stats[i].numAllocs;
+		total.chunksInUse += _stats[i].chunksInUse;
+		total.bytesInUse += _stats[i].bytesInUse;
+		total.peakBytesInUse += _stats[i].peakBytesInUse;
+		total.bytesReserved += _stats[i].bytesReserved;
+	}
+	return total;
+}
+
+
+#pragma mark -
+
+
+SlabCache::SlabCache(SlabAllocator &allocator) : _allocator(allocator) {
+	memset(_stats, 0, sizeof(_stats));
+	for (uint i = 0; i < SlabAllocator::kNumSizeClasses; ++i) {
+		_free[i] = nullptr;
+		_numFree[i] = 0;
+		_stats[i].chunkSize = SlabAllocator::kMinChunkSize << i;
+	}
+}
+
+SlabCache::~SlabCache() {
+	flush();
+}
+
+void *SlabCache::allocate(size_t size) {
+	const uint sizeClass = SlabAllocator::getSizeClass(size);
+	SlabAllocatorStats &stats = _stats[sizeClass];
+
+	void *ptr;
+	if (sizeClass == SlabAllocator::kNumSizeClasses) {
+		ptr = _allocator.allocate(size);
+		stats.bytesReserved += size;
+	} else {
+		if (!_free[sizeClass]) {
+			_free[sizeClass] = _allocator.allocateBatch(sizeClass, kBatchSize);
+			_numFree[sizeClass] = kBatchSize;
+			stats.bytesReserved += kBatchSize * stats.chunkSize;
+		}
+		ptr = _free[sizeClass];
+		_free[sizeClass] = *(void **)ptr;
+		_numFree[sizeClass]--;
+	}
+
+	stats.numAllocs++;
+	stats.chunksInUse++;
+	stats.bytesInUse += size;
+	stats.peakBytesInUse = MAX(stats.peakBytesInUse, stats.bytesInUse);
+	return ptr;
+}
+
+void SlabCache::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	const uint sizeClass = SlabAllocator::getSizeClass(size);
+	SlabAllocatorStats &stats = _stats[sizeClass];
+	stats.chunksInUse--;
+	stats.bytesInUse -= size;
+
+	if (sizeClass == SlabAllocator::kNumSizeClasses) {
+		_allocator.deallocate(ptr, size);
+		stats.bytesReserved -= size;
+		return;
+	}
+
+	*(void **)ptr = _free[sizeClass];
+	_free[sizeClass] = ptr;
+	_numFree[sizeClass]++;
+
+	// Keep at most two batches, and give one back when there are more,
+	// so alternating allocations and frees do not hit the allocator
+	if (_numFree[sizeClass] > 2 * kBatchSize) {
+		void *list = _free[sizeClass];
+		void *last = list;
+		for (uint i = 1; i < kBatchSize; ++i)
+			last = *(void **)last;
+		_free[sizeClass] = *(void **)last;
+		*(void **)last = nullptr;
+		_numFree[sizeClass] -= kBatchSize;
+		stats.bytesReserved -= kBatchSize * stats.chunkSize;
+		_allocator.deallocateBatch(sizeClass, list, kBatchSize);
+	}
+}
+
+void SlabCache::flush() {
+	for (uint i = 0; i < SlabAllocator::kNumSizeClasses; ++i) {
+		if (_free[i]) {
+			_allocator.deallocateBatch(i, _free[i], _numFree[i]);
+			_stats[i].bytesReserved -= _numFree[i] * _stats[i].chunkSize;
+			_free[i] = nullptr;
+			_numFree[i] = 0;
+		}
+	}
+}
+
+} // End of namespace Common
@@ -0,0 +1,211 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef COMMON_SLABALLOCATOR_H
+#define COMMON_SLABALLOCATOR_H
+
+#include "common/scummsys.h"
+#include "common/memorypool.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * Usage statistics of one size class of a SlabAllocator or SlabCache.
+ */
+struct SlabAllocatorStats {
+	/** Size of the chunks of this class, or 0 for the allocations too big for any class. */
+	size_t chunkSize;
+	/** Number of allocations made so far. */
+	uint32 numAllocs;
+	/** Number of chunks currently in use. */
+	size_t chunksInUse;
+	/** Number of bytes currently in use, as requested by the callers. */
+	size_t bytesInUse;
+	/** Highest value bytesInUse ever had. */
+	size_t peakBytesInUse;
+	/** Number of bytes reserved for this class, used or not. */
+	size_t bytesReserved;
+
+	/**
+	 * Return the percentage of the reserved memory which does not hold
+	 * requested bytes, either because chunks are free, or because they
+	 * are bigger than requested.
+	 */
+	uint getFragmentation() const {
+		return bytesReserved ? (uint)((bytesReserved - bytesInUse) * 100 / bytesReserved) : 0;
+	}
+};
+
+/**
+ * A general purpose allocator for small blocks, which are frequently
+ * allocated and freed, e.g. script objects, string buffers or decoded
+ * packets.
+ *
+ * Block sizes are rounded up to the next power of two, and each of
+ * these size classes is served by a MemoryPool. Blocks bigger than the
+ * biggest class are passed to malloc. Like with MemoryPool, the size
+ * of the block has to be passed when freeing it, so no header has to
+ * be stored with each block.
+ *
+ * An allocator created as thread safe locks a mutex around each call,
+ * as soon as the backend is initialized. Code allocating a lot from one
+ * thread, like the audio thread, should put a SlabCache in front of a
+ * shared allocator, or use an allocator of its own.
+ */
+class SlabAllocator {
+public:
+	enum {
+		/** Size of the smallest size class. */
+		kMinChunkSize = 16,
+		/** Number of size classes; their sizes go up to 2048 bytes. */
+		kNumSizeClasses = 8,
+		/** Size of the biggest size class. */
+		kMaxChunkSize = kMinChunkSize << (kNumSizeClasses - 1)
+	};
+
+	explicit SlabAllocator(bool threadSafe = false);
+	~SlabAllocator();
+
+	/**
+	 * Allocate a block of at least the given size. The block is aligned
+	 * like malloc'ed memory for the size classes of 16 bytes and more.
+	 */
+	void *allocate(size_t size);
+
+	/**
+	 * Free a block allocated by this allocator. The size must be the one
+	 * the block was allocated with.
+	 */
+	void deallocate(void *ptr, size_t size);
+
+	/**
+	 * Call the destructor of an object constructed in a block of this
+	 * allocator, e.g. with new (allocator.allocate(sizeof(T))) T, and
+	 * free the block.
+	 */
+	template<class T>
+	void deleteObject(T *ptr) {
+		if (ptr) {
+			ptr->~T();
+			deallocate(ptr, sizeof(T));
+		}
+	}
+
+	/**
+	 * Return the memory of the pages which contain no used chunks to the
+	 * system.
+	 */
+	void freeUnusedPages();
+
+	/**
+	 * Return the index of the size class serving the given size, or
+	 * kNumSizeClasses if the size is too big for any class.
+	 */
+	static uint getSizeClass(size_t size);
+
+	/**
+	 * Return the statistics of a size class. Index kNumSizeClasses holds
+	 * the statistics of the blocks too big for any class.
+	 */
+	const SlabAllocatorStats &getStats(uint sizeClass) const { return _stats[sizeClass]; }
+
+	/** Return the statistics summed up over all size classes. */
+	SlabAllocatorStats getTotalStats() const;
+
+private:
+	friend class SlabCache;
+
+	SlabAllocator(const SlabAllocator &);
+	SlabAllocator &operator=(const SlabAllocator &);
+
+	void lock();
+	void unlock();
+
+	/**
+	 * Allocate up to count chunks of the given size class at once, and
+	 * link them through their first word. Returns the first chunk.
+	 */
+	void *allocateBatch(uint sizeClass, uint count);
+
+	/** Free the given number of chunks, linked through their first word. */
+	void deallocateBatch(uint sizeClass, void *list, uint count);
+
+	void updateReserved(uint sizeClass);
+
+	MemoryPool *_pools[kNumSizeClasses];
+	SlabAllocatorStats _stats[kNumSizeClasses + 1];
+
+	bool _threadSafe;
+	OSystem::MutexRef _mutex;
+};
+
+/**
+ * A cache of free chunks in front of a SlabAllocator, which may only be
+ * used by one thread at a time. It takes chunks from the allocator and
+ * gives them back in batches, so the allocator is only locked once for
+ * many allocations.
+ *
+ * The statistics of the cache count the blocks allocated through it.
+ * The chunks it keeps for later use count as in use for the allocator.
+ */
+class SlabCache {
+public:
+	enum {
+		/** Number of chunks taken from or given back to the allocator at once. */
+		kBatchSize = 32
+	};
+
+	explicit SlabCache(SlabAllocator &allocator);
+
+	/** Give all cached chunks back to the allocator. */
+	~SlabCache();
+
+	/** Like SlabAllocator::allocate(). */
+	void *allocate(size_t size);
+
+	/** Like SlabAllocator::deallocate(). */
+	void deallocate(void *ptr, size_t size);
+
+	/** Give all cached chunks back to the allocator. */
+	void flush();
+
+	/** Like SlabAllocator::getStats(). */
+	const SlabAllocatorStats &getStats(uint sizeClass) const { return _stats[sizeClass]; }
+
+private:
+	SlabCache(const SlabCache &);
+	SlabCache &operator=(const SlabCache &);
+
+	SlabAllocator &_allocator;
+
+	/** The free chunks of each class, linked through their first word. */
+	void *_free[SlabAllocator::kNumSizeClasses];
+	uint _numFree[SlabAllocator::kNumSizeClasses];
+
+	SlabAllocatorStats _stats[SlabAllocator::kNumSizeClasses + 1];
+};
+
+} // End of namespace Common
+
+#endif
@@ -227,6 +227,11 @@ bool OSystem::isConnectionLimited() {
 	return false;
 }
 
+void OSystem::runParallel(ParallelJobProc job, void *param, uint count) {
+	for (uint i = 0; i < count; ++i)
+		job(param, i);
+}
+
 Common::TimerManager *OSystem::getTimerManager() {
 	return _timerManager;
 }
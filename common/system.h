@@ -418,7 +418,13 @@ public:
 		* Supports for using the native system file browser dialog
 		* through the DialogManager.
 		*/
-		kFeatureSystemBrowserDialog
+		kFeatureSystemBrowserDialog,
+
+		/**
+		* The CPU supports the SSE2 instruction set. Code paths using it
+		* are only built if SCUMMVM_SSE2 is defined.
+		*/
+		kFeatureCpuSSE2
 
 	};
 
@@ -1230,6 +1236,85 @@ public:
 
 
 
+	/**
+	 * @name Parallel jobs
+	 * There is no general threading API (see above), but backends able to
+	 * run code on several CPU cores can split up CPU intensive work, like
+	 * scaling the screen, into independent jobs, or run work which
+	 * takes too long for a timer callback, like decoding video frames ahead
+	 * of time, in the background.
+	 */
+	//@{
+
+	/**
+	 * A job run by runParallel(), for the given index.
+	 */
+	typedef void (*ParallelJobProc)(void *param, uint index);
+
+	/**
+	 * Run job(param, index) for each index from 0 to count - 1, possibly in
+	 * parallel on several threads, and return once all of them are done.
+	 * The jobs must not depend on the order they are run in.
+	 *
+	 * The default implementation runs them one after another on the calling
+	 * thread.
+	 *
+	 * @param job	the job to run
+	 * @param param	the parameter passed to every invocation of the job
+	 * @param count	the number of times to run the job
+	 */
+	virtual void runParallel(ParallelJobProc job, void *param, uint count);
+
+	/**
+	 * Return the number of threads runParallel() can run jobs on, or 1
+	 * if it runs them on the calling thread only.
+	 */
+	virtual uint getParallelJobThreads() { return 1; }
+
+	/**
+	 * A job run by startBackgroundJob().
+	 */
+	typedef void (*BackgroundJobProc)(void *param);
+
+	/**
+	 * Run job(param) on a background thread, and return without waiting for
+	 * it. The background jobs run one after another, in the order they were
+	 * started, on a thread of their own. Unlike timer callbacks, they may
+	 * take a while without holding up anything else. Every started job
+	 * runs exactly once: jobs still queued when the backend shuts down are
+	 * run before it does.
+	 *
+	 * The caller has to keep param valid until the job is done, e.g. by
+	 * calling waitForBackgroundJob(), and has to guard the data the job
+	 * shares with other threads with mutexes.
+	 *
+	 * The default implementation cannot run jobs in the background.
+	 *
+	 * @param job	the job to run
+	 * @param param	the parameter passed to the job
+	 * @return an id to pass to waitForBackgroundJob(), or 0 if the job is
+	 *         not run at all
+	 */
+	virtual uint32 startBackgroundJob(BackgroundJobProc job, void *param) { return 0; }
+
+	/**
+	 * Block until the background job with the given id is done. This
+	 * returns at once if it is done already, or if the id is 0. It must not
+	 * be called from a background job.
+	 *
+	 * @param id	the id returned by startBackgroundJob()
+	 */
+	virtual void waitForBackgroundJob(uint32 id) {}
+
+	/**
+	 * Return whether the backend can run jobs with startBackgroundJob().
+	 */
+	virtual bool canRunBackgroundJobs() { return false; }
+
+	//@}
+
+
+
 	/** @name Sound */
 	//@{
 
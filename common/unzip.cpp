@@ -106,6 +106,7 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/system.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -378,10 +379,81 @@ typedef struct {
 typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_Hash,
 	Common::IgnoreCase_EqualTo> ZipHash;
 
+namespace Common {
+
+/**
+ * The stream of a zip archive, shared by the archive and the streams of its
+ * members. The member streams keep it alive after the archive is deleted.
+ *
+ * Member streams may be used on another thread than the archive, e.g. when
+ * the mixer thread plays audio from a zip archive while the main thread opens
+ * other members. So the archive stream is only moved and read while holding
+ * the mutex, which also guards the reference count. Each member stream still
+ * has to be used by one thread at a time, like any other stream.
+ */
+class ZipSharedStream {
+public:
+	explicit ZipSharedStream(SeekableReadStream *stream)
+		: _stream(stream), _refCount(1) {
+		// The unit tests have no OSystem, but they only use one thread
+		_mutex = g_system ? g_system->createMutex() : nullptr;
+	}
+
+	void incRef() {
+		lock();
+		++_refCount;
+		unlock();
+	}
+
+	/** Drop a reference, and delete the stream with the last one. */
+	void decRef() {
+		lock();
+		const bool last = !--_refCount;
+		unlock();
+		if (last)
+			delete this;
+	}
+
+	void lock() {
+		if (_mutex)
+			g_system->lockMutex(_mutex);
+	}
+
+	void unlock() {
+		if (_mutex)
+			g_system->unlockMutex(_mutex);
+	}
+
+	/**
+	 * Read data at the given position of the archive stream, and return
+	 * whether all of it could be read.
+	 */
+	bool readAt(uint32 offset, void *dataPtr, uint32 dataSize) {
+		lock();
+		const bool ok = _stream->seek(offset, SEEK_SET) && _stream->read(dataPtr, dataSize) == dataSize;
+		unlock();
+		return ok;
+	}
+
+private:
+	~ZipSharedStream() {
+		delete _stream;
+		if (_mutex)
+			g_system->deleteMutex(_mutex);
+	}
+
+	SeekableReadStream *_stream;
+	int _refCount;
+	OSystem::MutexRef _mutex;
+};
+
+} // End of namespace Common
+
 /* unz_s contain internal information about the zipfile
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::ZipSharedStream *_sharedStream;			/* owner of _stream, shared with member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +616,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = new Common::ZipSharedStream(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +668,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
+		us->_sharedStream->decRef();
 		delete us;
 		return nullptr;
 	}
@@ -644,7 +717,7 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != nullptr)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	s->_sharedStream->decRef();
 	delete s;
 	return UNZ_OK;
 }
@@ -1419,6 +1492,301 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+/**
+ * A stream reading a stored zip member from the shared archive stream.
+ */
+class ZipStoredReadStream : public SeekableReadStream {
+public:
+	ZipStoredReadStream(ZipSharedStream *archive, uint32 dataOffset, uint32 size)
+		: _archive(archive), _dataOffset(dataOffset), _size(size), _pos(0), _eos(false), _err(false) {
+		_archive->incRef();
+	}
+	~ZipStoredReadStream() { _archive->decRef(); }
+
+	bool err() const { return _err; }
+	void clearErr() { _eos = false; _err = false; }
+	bool eos() const { return _eos; }
+	uint32 read(void *dataPtr, uint32 dataSize);
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	ZipSharedStream *_archive;
+	uint32 _dataOffset;
+	uint32 _size;
+	uint32 _pos;
+	bool _eos;
+	bool _err;
+};
+
+uint32 ZipStoredReadStream::read(void *dataPtr, uint32 dataSize) {
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	if (!_archive->readAt(_dataOffset + _pos, dataPtr, dataSize)) {
+		_err = true;
+		return 0;
+	}
+
+	_pos += dataSize;
+	return dataSize;
+}
+
+bool ZipStoredReadStream::seek(int32 offset, int whence) {
+	int32 newPos = 0;
+	switch (whence) {
+	default:
+		// fallthrough intended
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offset;
+		break;
+	case SEEK_END:
+		newPos = _size + offset;
+		break;
+	}
+
+	if (newPos < 0 || (uint32)newPos > _size)
+		return false;
+
+	_pos = newPos;
+	_eos = false;
+	return true;
+}
+
+#ifdef USE_ZLIB
+
+/**
+ * A stream inflating a deflated zip member on demand.
+ *
+ * Every stream has its own inflate state, so several of them can be used at
+ * the same time. While inflating, it saves a copy of the inflate state at
+ * regular intervals, so a seek only needs to inflate the data from the last
+ * of these checkpoints before the target position.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+public:
+	ZipInflateReadStream(ZipSharedStream *archive, uint32 dataOffset,
+	                     uint32 compressedSize, uint32 size, uint32 crc);
+	~ZipInflateReadStream();
+
+	bool err() const { return _zlibErr != Z_OK && _zlibErr != Z_STREAM_END; }
+	void clearErr() {
+		// only reset _eos; I/O errors are not recoverable
+		_eos = false;
+	}
+	bool eos() const { return _eos; }
+	uint32 read(void *dataPtr, uint32 dataSize);
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	enum {
+		BUFSIZE = UNZ_BUFSIZE,
+		/** Minimum amount of output between two checkpoints. */
+		kMinCheckpointInterval = 256 * 1024,
+		/** Upper limit of checkpoints, bounding their memory use for big members. */
+		kMaxCheckpoints = 64
+	};
+
+	/** A copy of the inflate state at some position of the output. */
+	struct Checkpoint {
+		z_stream stream;
+		uint32 pos;
+		uint32 compressedPos;
+		uLong crc;
+	};
+
+	/** Inflate data at the current position. */
+	uint32 inflateData(byte *dataPtr, uint32 dataSize);
+
+	/** Continue inflating from the given checkpoint, or from the start if it is null. */
+	void restart(Checkpoint *checkpoint);
+
+	ZipSharedStream *_archive;
+	uint32 _dataOffset;
+	uint32 _compressedSize;
+	uint32 _size;
+	uint32 _crc;
+
+	byte *_buf;
+	z_stream _stream;
+	int _zlibErr;
+	/** Position of the next compressed byte to read into _buf. */
+	uint32 _compressedPos;
+	uint32 _pos;
+	uLong _crcData;
+	bool _eos;
+
+	/**
+	 * The checkpoints are allocated separately, since zlib does not allow
+	 * to move a z_stream in memory.
+	 */
+	Array<Checkpoint *> _checkpoints;
+	uint32 _checkpointInterval;
+};
+
+ZipInflateReadStream::ZipInflateReadStream(ZipSharedStream *archive, uint32 dataOffset,
+                                           uint32 compressedSize, uint32 size, uint32 crc)
+	: _archive(archive), _dataOffset(dataOffset), _compressedSize(compressedSize), _size(size), _crc(crc),
+	  _stream(), _compressedPos(0), _pos(0), _crcData(0), _eos(false) {
+	_archive->incRef();
+	_buf = new byte[BUFSIZE];
+	_checkpointInterval = MAX<uint32>(kMinCheckpointInterval, size / kMaxCheckpoints);
+
+	// windowBits is passed < 0 to tell that there is no zlib header
+	_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+	_stream.next_in = _buf;
+	_stream.avail_in = 0;
+}
+
+ZipInflateReadStream::~ZipInflateReadStream() {
+	for (uint i = 0; i < _checkpoints.size(); ++i) {
+		inflateEnd(&_checkpoints[i]->stream);
+		delete _checkpoints[i];
+	}
+	inflateEnd(&_stream);
+	delete[] _buf;
+	_archive->decRef();
+}
+
+uint32 ZipInflateReadStream::read(void *dataPtr, uint32 dataSize) {
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	byte *dst = (byte *)dataPtr;
+	uint32 done = 0;
+	while (done < dataSize && !err()) {
+		// Save a checkpoint before reading past it, so the checkpoints
+		// end up at the same positions no matter how the data is read.
+		if (_pos == (_checkpoints.size() + 1) * _checkpointInterval && _checkpoints.size() < (uint)kMaxCheckpoints) {
+			Checkpoint *checkpoint = new Checkpoint();
+			if (inflateCopy(&checkpoint->stream, &_stream) == Z_OK) {
+				checkpoint->pos = _pos;
+				checkpoint->compressedPos = _compressedPos - _stream.avail_in;
+				checkpoint->crc = _crcData;
+				_checkpoints.push_back(checkpoint);
+			} else {
+				delete checkpoint;
+			}
+		}
+
+		const uint32 nextCheckpoint = (_checkpoints.size() + 1) * _checkpointInterval;
+		uint32 len = dataSize - done;
+		if (_pos < nextCheckpoint)
+			len = MIN(len, nextCheckpoint - _pos);
+
+		const uint32 inflated = inflateData(dst + done, len);
+		if (!inflated)
+			break;
+		done += inflated;
+	}
+
+	if (done < dataSize)
+		_eos = true;
+
+	return done;
+}
+
+uint32 ZipInflateReadStream::inflateData(byte *dataPtr, uint32 dataSize) {
+	_stream.next_out = dataPtr;
+	_stream.avail_out = dataSize;
+
+	while (_zlibErr == Z_OK && _stream.avail_out) {
+		if (_stream.avail_in == 0 && _compressedPos < _compressedSize) {
+			// If we are out of input data: Read more data, if available.
+			const uint32 len = MIN<uint32>(BUFSIZE, _compressedSize - _compressedPos);
+			if (!_archive->readAt(_dataOffset + _compressedPos, _buf, len)) {
+				_zlibErr = Z_ERRNO;
+				break;
+			}
+			_compressedPos += len;
+			_stream.next_in = _buf;
+			_stream.avail_in = len;
+		}
+		_zlibErr = inflate(&_stream, Z_SYNC_FLUSH);
+	}
+
+	const uint32 inflated = dataSize - _stream.avail_out;
+	_crcData = crc32(_crcData, dataPtr, inflated);
+	_pos += inflated;
+
+	if (_pos == _size && _crcData != _crc) {
+		warning("ZipInflateReadStream: CRC mismatch");
+		_zlibErr = Z_DATA_ERROR;
+	}
+
+	return inflated;
+}
+
+void ZipInflateReadStream::restart(Checkpoint *checkpoint) {
+	inflateEnd(&_stream);
+
+	if (checkpoint) {
+		_zlibErr = inflateCopy(&_stream, &checkpoint->stream);
+		_pos = checkpoint->pos;
+		_compressedPos = checkpoint->compressedPos;
+		_crcData = checkpoint->crc;
+	} else {
+		_stream = z_stream();
+		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		_pos = 0;
+		_compressedPos = 0;
+		_crcData = 0;
+	}
+
+	_stream.next_in = _buf;
+	_stream.avail_in = 0;
+}
+
+bool ZipInflateReadStream::seek(int32 offset, int whence) {
+	int32 newPos = 0;
+	switch (whence) {
+	default:
+		// fallthrough intended
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = _pos + offset;
+		break;
+	case SEEK_END:
+		newPos = _size + offset;
+		break;
+	}
+
+	if (newPos < 0 || (uint32)newPos > _size)
+		return false;
+
+	// Continue from the last checkpoint before the target, unless the
+	// current position is closer
+	Checkpoint *checkpoint = nullptr;
+	for (uint i = 0; i < _checkpoints.size() && _checkpoints[i]->pos <= (uint32)newPos; ++i)
+		checkpoint = _checkpoints[i];
+
+	if ((uint32)newPos < _pos || (checkpoint && checkpoint->pos > _pos))
+		restart(checkpoint);
+
+	// Skip the data up to the target
+	byte tmpBuf[4096];
+	while (!err() && _pos < (uint32)newPos) {
+		if (!read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), newPos - _pos)))
+			break;
+	}
+
+	_eos = false;
+	return !err();
+}
+
+#endif // USE_ZLIB
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
@@ -1489,32 +1857,44 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return nullptr;
 
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return nullptr;
+	unz_s *s = (unz_s *)_zipFile;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0) != UNZ_OK)
+	uInt iSizeVar;
+	uLong offset_local_extrafield;
+	uInt size_local_extrafield;
+	s->_sharedStream->lock();
+	const int err = unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar, &offset_local_extrafield, &size_local_extrafield);
+	s->_sharedStream->unlock();
+	if (err != UNZ_OK)
 		return nullptr;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	const unz_file_info &fileInfo = s->cur_file_info;
+	const uint32 dataOffset = s->byte_before_the_zipfile + s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return nullptr;
-	}
+	// The member streams share the archive stream, and keep it alive when
+	// the archive is deleted before them. They read it through readAt(),
+	// which seeks and reads while holding the lock of the archive stream.
+	if (fileInfo.compression_method == 0) {
+		if (fileInfo.compressed_size != fileInfo.uncompressed_size)
+			return nullptr;
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return nullptr;
+		return new ZipStoredReadStream(s->_sharedStream, dataOffset, fileInfo.uncompressed_size);
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+#ifdef USE_ZLIB
+	if (fileInfo.compression_method == Z_DEFLATED) {
+		ZipInflateReadStream *stream = new ZipInflateReadStream(s->_sharedStream, dataOffset,
+		                                                        fileInfo.compressed_size, fileInfo.uncompressed_size, fileInfo.crc);
+		if (stream->err()) {
+			delete stream;
+			return nullptr;
+		}
+		return stream;
+	}
+#endif
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	// Unknown compression method, or no zlib to inflate the data
+	return nullptr;
 }
 
 Archive *makeZipArchive(const String &name) {
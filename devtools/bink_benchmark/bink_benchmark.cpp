@@ -0,0 +1,289 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "audio/mixer_intern.h"
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/system.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+#include "video/bink_decoder.h"
+#include "video/bink_kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef USE_BINK
+
+/**
+ * Just enough of a system for the decoder: a mixer for the audio tracks to
+ * be stopped on, and the CPU features to pick the kernels with.
+ */
+class BenchmarkSystem : public OSystem {
+public:
+	BenchmarkSystem() : _mixer(nullptr) {}
+	~BenchmarkSystem() { delete _mixer; }
+
+	void init() {
+		_mixer = new Audio::MixerImpl(44100);
+		_mixer->setReady(true);
+	}
+
+	bool hasFeature(Feature f) {
+		// Same as the null backend, only report what the architecture
+		// guarantees
+#if defined(__x86_64__) || defined(_M_X64)
+		if (f == kFeatureCpuSSE2)
+			return true;
+#endif
+		return false;
+	}
+
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return nullptr; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return nullptr; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeXOffset, int shakeYOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	uint32 getMillis(bool skipRecord) { return 0; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	MutexRef createMutex() { return nullptr; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+	Audio::Mixer *getMixer() { return _mixer; }
+	void quit() { exit(0); }
+	void displayMessageOnOSD(const char *msg) {}
+	void displayActivityIconOnOSD(const Graphics::Surface *icon) {}
+
+	void logMessage(LogMessageType::Type type, const char *message) {
+		fputs(message, type == LogMessageType::kInfo ? stdout : stderr);
+		if (type == LogMessageType::kError)
+			exit(1);
+	}
+
+private:
+	Audio::MixerImpl *_mixer;
+};
+
+struct Decoding {
+	const char *name;
+	/** The FNV-1a hash of each frame */
+	Common::Array<uint32> hashes;
+	/** CPU time for decoding all the frames once, in seconds */
+	double cpuTime;
+};
+
+static uint32 hashFrame(const Graphics::Surface &frame) {
+	uint32 hash = 2166136261U;
+	const uint rowSize = frame.w * frame.format.bytesPerPixel;
+	for (int y = 0; y < frame.h; ++y) {
+		const byte *row = (const byte *)frame.getBasePtr(0, y);
+		for (uint x = 0; x < rowSize; ++x)
+			hash = (hash ^ row[x]) * 16777619U;
+	}
+	return hash;
+}
+
+/**
+ * Decode all the frames of the video with the given kernels.
+ *
+ * @return false if the video could not be decoded.
+ */
+static bool decode(const byte *data, uint32 size, const Graphics::PixelFormat &format, const Video::BinkKernels &kernels, Decoding &decoding) {
+	Video::BinkDecoder decoder;
+	decoder.setDefaultHighColorFormat(format);
+	decoder.setKernels(kernels);
+	if (!decoder.loadStream(new Common::MemoryReadStream(data, size)))
+		return false;
+
+	decoding.hashes.clear();
+	decoding.cpuTime = 0;
+	const int frameCount = decoder.getFrameCount();
+	for (int i = 0; i < frameCount; ++i) {
+		// Only the decoding itself is timed, not the hashing
+		const clock_t start = clock();
+		const Graphics::Surface *frame = decoder.decodeNextFrame();
+		decoding.cpuTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+		if (!frame)
+			break;
+		decoding.hashes.push_back(hashFrame(*frame));
+	}
+	return !decoding.hashes.empty();
+}
+
+static void printHelp(const char *bin) {
+	printf("Usage: %s [options] <video.bik>\n"
+	       "\n"
+	       "Decodes a Bink video with the plain C++ block transforms and with the\n"
+	       "fastest ones supported by the CPU. Reports the frames decoded per second,\n"
+	       "and whether both decodings give the same frames.\n"
+	       "\n"
+	       "Options:\n"
+	       "  --bpp=BPP            Bytes per pixel of the output, 2 or 4 (default: 4)\n"
+	       "  --repeat=COUNT       Decode COUNT times and report the fastest (default: 3)\n",
+	       bin);
+}
+
+static byte *readFile(const char *filename, uint32 &size) {
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return nullptr;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(MAX<long>(length, 1));
+	const bool ok = length >= 0 && fread(data, 1, length, file) == (size_t)length;
+	fclose(file);
+	if (!ok) {
+		fprintf(stderr, "Could not read '%s'\n", filename);
+		free(data);
+		return nullptr;
+	}
+
+	size = length;
+	return data;
+}
+
+int main(int argc, char *argv[]) {
+	uint bpp = 4;
+	uint repeat = 3;
+	const char *videoName = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		if (!strncmp(arg, "--bpp=", 6)) {
+			bpp = atoi(arg + 6);
+		} else if (!strncmp(arg, "--repeat=", 9)) {
+			repeat = atoi(arg + 9);
+		} else if (arg[0] != '-' && !videoName) {
+			videoName = arg;
+		} else {
+			printHelp(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!videoName || (bpp != 2 && bpp != 4) || !repeat) {
+		printHelp(argv[0]);
+		return 1;
+	}
+
+	BenchmarkSystem *system = new BenchmarkSystem();
+	g_system = system;
+	system->init();
+
+	uint32 size;
+	byte *data = readFile(videoName, size);
+	if (!data)
+		return 1;
+
+	const Graphics::PixelFormat format = (bpp == 2) ?
+		Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0) :
+		Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+	const Video::BinkKernels *kernels[2] = { &Video::getScalarBinkKernels(), &Video::getBinkKernels() };
+	const char *const names[2] = { "scalar", "native" };
+	const uint count = (kernels[1] == kernels[0]) ? 1 : 2;
+
+	Decoding decodings[2];
+	for (uint i = 0; i < count; ++i) {
+		decodings[i].name = names[i];
+		for (uint run = 0; run < repeat; ++run) {
+			Decoding current;
+			current.name = names[i];
+			if (!decode(data, size, format, *kernels[i], current)) {
+				fprintf(stderr, "Could not decode '%s'\n", videoName);
+				free(data);
+				return 1;
+			}
+			if (!run || current.cpuTime < decodings[i].cpuTime)
+				decodings[i] = current;
+		}
+	}
+	free(data);
+
+	printf("%s: %u frames, %u bytes per pixel\n", videoName, decodings[0].hashes.size(), bpp);
+	for (uint i = 0; i < count; ++i) {
+		const Decoding &decoding = decodings[i];
+		printf("%-6s %8.1f frames/sec, ", decoding.name, decoding.hashes.size() / MAX(decoding.cpuTime, 0.000001));
+		if (i == 0)
+			printf("reference\n");
+		else if (decoding.hashes == decodings[0].hashes)
+			printf("identical\n");
+		else
+			printf("DIFFERENT from the reference\n");
+	}
+	if (count == 1)
+		printf("The CPU has no faster kernels\n");
+
+	system->destroy();
+	g_system = nullptr;
+	return (count == 2 && decodings[1].hashes != decodings[0].hashes) ? 1 : 0;
+}
+
+#else
+
+int main(int argc, char *argv[]) {
+	fprintf(stderr, "This build has no Bink support\n");
+	return 1;
+}
+
+#endif // USE_BINK
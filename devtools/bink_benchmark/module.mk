@@ -0,0 +1,14 @@
+
+MODULE := devtools/bink_benchmark
+
+MODULE_OBJS := \
+	bink_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := bink_benchmark
+
+# The decoder is taken from the ScummVM libraries
+TOOL_LIBS := video/libvideo.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a $(ZLIB_LIBS)
+
+# Include common rules
+include $(srcdir)/rules.mk
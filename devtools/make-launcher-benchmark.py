@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+# encoding: utf-8
+#
+# Writes a configuration file with a large number of synthetic games, to
+# measure how fast the launcher lists, sorts and filters them. Run ScummVM
+# with "-c <file>" to use it.
+#
+# The descriptions are made of random words, so that the search box finds
+# a few hundred entries for most words. Every third game points to a
+# directory that does not exist, so that the launcher greys it out.
+import argparse
+import random
+
+WORDS = (
+	'Adventure', 'Amazon', 'Beneath', 'Broken', 'Castle', 'Curse', 'Day',
+	'Dragon', 'Fate', 'Flight', 'Gabriel', 'Island', 'Journey', 'King',
+	'Knight', 'Legend', 'Lost', 'Monkey', 'Mystery', 'Queen', 'Quest',
+	'Return', 'Revenge', 'Secret', 'Shadow', 'Sky', 'Space', 'Steel',
+	'Sword', 'Tentacle', 'Time', 'Tower', 'Treasure', 'Voyage', 'Zak'
+)
+
+PLATFORMS = ('DOS', 'Amiga', 'Macintosh', 'Windows', 'FM-TOWNS')
+LANGUAGES = ('English', 'German', 'French', 'Spanish', 'Italian')
+
+def writeConfig(filename, count, seed):
+	rng = random.Random(seed)
+	with open(filename, 'w') as f:
+		f.write('[scummvm]\n')
+		f.write('gui_theme=scummremastered\n')
+		f.write('\n')
+		for i in range(count):
+			gameid = '%s%d' % (rng.choice(WORDS).lower(), i % 97)
+			words = ' '.join(rng.choice(WORDS) for _ in range(rng.randint(2, 5)))
+			description = '%s (%s/%s)' % (words, rng.choice(PLATFORMS), rng.choice(LANGUAGES))
+			path = '.' if i % 3 else '/nonexistent/game%d' % i
+			f.write('[game%05d]\n' % i)
+			f.write('gameid=%s\n' % gameid)
+			f.write('description=%s\n' % description)
+			f.write('path=%s\n' % path)
+			f.write('\n')
+
+def main():
+	parser = argparse.ArgumentParser(description='Write a ScummVM configuration file with synthetic games.')
+	parser.add_argument('filename', help='the configuration file to write')
+	parser.add_argument('--count', type=int, default=50000, help='number of games (default: 50000)')
+	parser.add_argument('--seed', type=int, default=1, help='seed of the random descriptions (default: 1)')
+	args = parser.parse_args()
+	writeConfig(args.filename, args.count, args.seed)
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,14 @@
+
+MODULE := devtools/opl_replay
+
+MODULE_OBJS := \
+	opl_replay.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := opl_replay
+
+# The emulators are taken from the ScummVM libraries
+TOOL_LIBS := audio/libaudio.a common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,453 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "audio/fmopl.h"
+#include "audio/fmopl_capture.h"
+#include "audio/mixer_intern.h"
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/system.h"
+
+#include "graphics/pixelformat.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Just enough of a system for the OPL emulators: a mixer to take the output
+ * rate from, and a clock following the replayed audio.
+ */
+class ReplaySystem : public OSystem {
+public:
+	ReplaySystem() : _mixer(nullptr), _millis(0) {}
+	~ReplaySystem() { delete _mixer; }
+
+	void init(uint rate) {
+		_mixer = new Audio::MixerImpl(rate);
+		_mixer->setReady(true);
+	}
+
+	void setMillis(uint32 millis) { _millis = millis; }
+
+	bool hasFeature(Feature f) {
+		// Same as the null backend, only report what the architecture
+		// guarantees
+#if defined(__x86_64__) || defined(_M_X64)
+		if (f == kFeatureCpuSSE2)
+			return true;
+#endif
+		return false;
+	}
+
+	Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	int16 getHeight() { return 0; }
+	int16 getWidth() { return 0; }
+	PaletteManager *getPaletteManager() { return nullptr; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	Graphics::Surface *lockScreen() { return nullptr; }
+	void unlockScreen() {}
+	void fillScreen(uint32 col) {}
+	void updateScreen() {}
+	void setShakePos(int shakeXOffset, int shakeYOffset) {}
+	void showOverlay() {}
+	void hideOverlay() {}
+	Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() {}
+	void grabOverlay(void *buf, int pitch) {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	int16 getOverlayHeight() { return 0; }
+	int16 getOverlayWidth() { return 0; }
+	bool showMouse(bool visible) { return false; }
+	void warpMouse(int x, int y) {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+	uint32 getMillis(bool skipRecord) { return _millis; }
+	void delayMillis(uint msecs) {}
+	void getTimeAndDate(TimeDate &t) const { memset(&t, 0, sizeof(t)); }
+	MutexRef createMutex() { return nullptr; }
+	void lockMutex(MutexRef mutex) {}
+	void unlockMutex(MutexRef mutex) {}
+	void deleteMutex(MutexRef mutex) {}
+	Audio::Mixer *getMixer() { return _mixer; }
+	void quit() { exit(0); }
+	void displayMessageOnOSD(const char *msg) {}
+	void displayActivityIconOnOSD(const Graphics::Surface *icon) {}
+
+	void logMessage(LogMessageType::Type type, const char *message) {
+		fputs(message, type == LogMessageType::kInfo ? stdout : stderr);
+		if (type == LogMessageType::kError)
+			exit(1);
+	}
+
+private:
+	Audio::MixerImpl *_mixer;
+	uint32 _millis;
+};
+
+/**
+ * Plays the commands of a capture from the timer callback of an OPL.
+ */
+class Replay {
+public:
+	Replay(OPL::OPL *opl, const Common::Array<OPL::CaptureEvent> &events) :
+		_opl(opl), _events(events), _pos(0), _ticksLeft(0), _done(false) {}
+
+	/**
+	 * Apply the writes made before the timer was started.
+	 *
+	 * @return The timer callback frequency of the capture.
+	 */
+	int startFrequency() {
+		while (_pos < _events.size()) {
+			const OPL::CaptureEvent &event = _events[_pos];
+			if (event.command == OPL::kCaptureFrequency || event.command == OPL::kCaptureDelay || event.command == OPL::kCaptureLongDelay)
+				break;
+			apply(event);
+			++_pos;
+		}
+
+		if (_pos < _events.size() && _events[_pos].command == OPL::kCaptureFrequency)
+			return _events[_pos++].param;
+		return OPL::OPL::kDefaultCallbackFrequency;
+	}
+
+	void onTimer() {
+		if (_ticksLeft && --_ticksLeft)
+			return;
+
+		while (_pos < _events.size()) {
+			const OPL::CaptureEvent &event = _events[_pos++];
+			if (event.command == OPL::kCaptureDelay || event.command == OPL::kCaptureLongDelay) {
+				_ticksLeft = event.param;
+				return;
+			}
+			apply(event);
+		}
+		_done = true;
+	}
+
+	bool isDone() const { return _done; }
+
+private:
+	void apply(const OPL::CaptureEvent &event) {
+		switch (event.command) {
+		case OPL::kCaptureWrite:
+			_opl->write(event.param, event.value);
+			break;
+		case OPL::kCaptureWriteReg:
+			_opl->writeReg(event.param, event.value);
+			break;
+		case OPL::kCaptureFrequency:
+			_opl->setCallbackFrequency(event.param);
+			break;
+		case OPL::kCaptureReset:
+			_opl->reset();
+			break;
+		default:
+			break;
+		}
+	}
+
+	OPL::OPL *_opl;
+	const Common::Array<OPL::CaptureEvent> &_events;
+	uint _pos;
+	uint32 _ticksLeft;
+	bool _done;
+};
+
+struct Rendering {
+	Common::String name;
+	bool stereo;
+	/** The output, downmixed to mono */
+	Common::Array<int16> samples;
+	/** CPU time for rendering the capture once, in seconds */
+	double cpuTime;
+};
+
+static ReplaySystem *s_system;
+
+/**
+ * Render the capture with the given emulator.
+ *
+ * @return false if the emulator could not be created.
+ */
+static bool render(const char *name, OPL::Config::OplType type, const Common::Array<OPL::CaptureEvent> &events, uint rate, Rendering &rendering) {
+	enum { kChunkFrames = 256 };
+
+	OPL::OPL *opl = OPL::Config::create(OPL::Config::parse(name), type);
+	if (!opl || !opl->init()) {
+		delete opl;
+		return false;
+	}
+
+	// All the emulators are EmulatedOPLs, which are driven by reading from
+	// them, like the mixer does
+	OPL::EmulatedOPL *emulated = static_cast<OPL::EmulatedOPL *>(opl);
+	const uint channels = emulated->isStereo() ? 2 : 1;
+	int16 buffer[kChunkFrames * 2];
+	uint32 frames = 0;
+
+	rendering.name = name;
+	rendering.stereo = channels == 2;
+	rendering.samples.clear();
+
+	Replay replay(opl, events);
+	const int frequency = replay.startFrequency();
+	opl->start(new Common::Functor0Mem<void, Replay>(&replay, &Replay::onTimer), frequency);
+
+	const clock_t start = clock();
+	while (!replay.isDone()) {
+		s_system->setMillis((uint64)frames * 1000 / rate);
+		emulated->readBuffer(buffer, kChunkFrames * channels);
+		for (uint i = 0; i < kChunkFrames; ++i) {
+			if (channels == 2)
+				rendering.samples.push_back((buffer[i * 2] + buffer[i * 2 + 1]) / 2);
+			else
+				rendering.samples.push_back(buffer[i]);
+		}
+		frames += kChunkFrames;
+	}
+	rendering.cpuTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	opl->stop();
+	delete opl;
+	return true;
+}
+
+static void writeWav(const Common::String &filename, const Common::Array<int16> &samples, uint rate) {
+	FILE *file = fopen(filename.c_str(), "wb");
+	if (!file) {
+		fprintf(stderr, "Could not create '%s'\n", filename.c_str());
+		return;
+	}
+
+	byte header[44];
+	const uint32 size = samples.size() * 2;
+	WRITE_BE_UINT32(header, MKTAG('R', 'I', 'F', 'F'));
+	WRITE_LE_UINT32(header + 4, size + 36);
+	WRITE_BE_UINT32(header + 8, MKTAG('W', 'A', 'V', 'E'));
+	WRITE_BE_UINT32(header + 12, MKTAG('f', 'm', 't', ' '));
+	WRITE_LE_UINT32(header + 16, 16);
+	WRITE_LE_UINT16(header + 20, 1);		// PCM
+	WRITE_LE_UINT16(header + 22, 1);		// mono
+	WRITE_LE_UINT32(header + 24, rate);
+	WRITE_LE_UINT32(header + 28, rate * 2);
+	WRITE_LE_UINT16(header + 32, 2);
+	WRITE_LE_UINT16(header + 34, 16);
+	WRITE_BE_UINT32(header + 36, MKTAG('d', 'a', 't', 'a'));
+	WRITE_LE_UINT32(header + 40, size);
+	fwrite(header, 1, sizeof(header), file);
+
+	for (uint i = 0; i < samples.size(); ++i) {
+		byte sample[2];
+		WRITE_LE_UINT16(sample, samples[i]);
+		fwrite(sample, 1, 2, file);
+	}
+	fclose(file);
+}
+
+/**
+ * Print how much the output differs from the reference output.
+ */
+static void printDifference(const Rendering &rendering, const Rendering &reference) {
+	const uint size = MIN(rendering.samples.size(), reference.samples.size());
+	double signal = 0, noise = 0;
+	int peak = 0;
+	for (uint i = 0; i < size; ++i) {
+		const int diff = rendering.samples[i] - reference.samples[i];
+		signal += (double)reference.samples[i] * reference.samples[i];
+		noise += (double)diff * diff;
+		peak = MAX(peak, ABS(diff));
+	}
+
+	if (!noise)
+		printf("identical");
+	else if (!signal)
+		printf("reference is silent, peak difference %d", peak);
+	else
+		printf("SNR %6.1f dB, peak difference %5d", 10 * log10(signal / noise), peak);
+}
+
+static void printHelp(const char *bin) {
+	printf("Usage: %s [options] <capture>\n"
+	       "\n"
+	       "Replays an OPL capture, made with --opl-capture, through the OPL emulators.\n"
+	       "Reports the CPU time needed per second of audio, and how much the output\n"
+	       "of each emulator differs from the reference.\n"
+	       "\n"
+	       "Options:\n"
+	       "  --rate=RATE          Output rate in Hz (default: 44100)\n"
+	       "  --emulators=LIST     Comma separated emulators to use (default: all which\n"
+	       "                       support the OPL type of the capture)\n"
+	       "  --reference=NAME     Emulator to compare against (default: the first one)\n"
+	       "  --repeat=COUNT       Render COUNT times and report the fastest (default: 3)\n"
+	       "  --wav=PREFIX         Write the output of each emulator to PREFIX-NAME.wav\n",
+	       bin);
+}
+
+static bool readCapture(const char *filename, OPL::Config::OplType &type, Common::Array<OPL::CaptureEvent> &events) {
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(MAX<long>(size, 1));
+	const bool ok = size >= 0 && fread(data, 1, size, file) == (size_t)size;
+	fclose(file);
+	if (!ok) {
+		fprintf(stderr, "Could not read '%s'\n", filename);
+		free(data);
+		return false;
+	}
+
+	Common::MemoryReadStream stream(data, size, DisposeAfterUse::YES);
+	OPL::CaptureReader reader(&stream);
+	if (!reader.isValid()) {
+		fprintf(stderr, "'%s' is not an OPL capture\n", filename);
+		return false;
+	}
+
+	type = reader.getType();
+	OPL::CaptureEvent event;
+	while (reader.readEvent(event))
+		events.push_back(event);
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	// The software emulators, as named by OPL::Config
+	static const char *const allEmulators[] = { "mame", "db", "nuked", nullptr };
+
+	uint rate = 44100;
+	uint repeat = 3;
+	Common::String emulatorList, referenceName, wavPrefix;
+	const char *captureName = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		if (!strncmp(arg, "--rate=", 7)) {
+			rate = atoi(arg + 7);
+		} else if (!strncmp(arg, "--emulators=", 12)) {
+			emulatorList = arg + 12;
+		} else if (!strncmp(arg, "--reference=", 12)) {
+			referenceName = arg + 12;
+		} else if (!strncmp(arg, "--repeat=", 9)) {
+			repeat = atoi(arg + 9);
+		} else if (!strncmp(arg, "--wav=", 6)) {
+			wavPrefix = arg + 6;
+		} else if (arg[0] != '-' && !captureName) {
+			captureName = arg;
+		} else {
+			printHelp(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!captureName || !rate || !repeat) {
+		printHelp(argv[0]);
+		return 1;
+	}
+
+	s_system = new ReplaySystem();
+	g_system = s_system;
+	s_system->init(rate);
+
+	OPL::Config::OplType type;
+	Common::Array<OPL::CaptureEvent> events;
+	if (!readCapture(captureName, type, events))
+		return 1;
+
+	static const uint32 typeFlags[] = { OPL::Config::kFlagOpl2, OPL::Config::kFlagDualOpl2, OPL::Config::kFlagOpl3 };
+	Common::Array<Rendering> renderings;
+	for (uint i = 0; allEmulators[i]; ++i) {
+		const char *name = allEmulators[i];
+		if (!emulatorList.empty() && !("," + emulatorList + ",").contains(Common::String::format(",%s,", name)))
+			continue;
+		const OPL::Config::EmulatorDescription *driver = OPL::Config::findDriver(OPL::Config::parse(name));
+		if (!driver || !(driver->flags & typeFlags[type]))
+			continue;
+
+		Rendering rendering;
+		rendering.cpuTime = 0;
+		for (uint run = 0; run < repeat; ++run) {
+			Rendering current;
+			if (!render(name, type, events, rate, current))
+				break;
+			if (!run || current.cpuTime < rendering.cpuTime)
+				rendering = current;
+		}
+		if (!rendering.name.empty())
+			renderings.push_back(rendering);
+	}
+
+	if (renderings.empty()) {
+		fprintf(stderr, "No emulator supports this capture\n");
+		return 1;
+	}
+
+	uint reference = 0;
+	for (uint i = 0; i < renderings.size(); ++i) {
+		if (renderings[i].name == referenceName)
+			reference = i;
+	}
+
+	const double seconds = (double)renderings[reference].samples.size() / rate;
+	printf("%s: OPL type %d, %u commands, %.1f seconds at %u Hz\n", captureName, type, events.size(), seconds, rate);
+	for (uint i = 0; i < renderings.size(); ++i) {
+		const Rendering &rendering = renderings[i];
+		const double perSecond = rendering.cpuTime / MAX(seconds, 0.001) * 1000;
+		printf("%-6s %8.2f ms CPU per second of audio, ", rendering.name.c_str(), perSecond);
+		if (i == reference)
+			printf("reference");
+		else
+			printDifference(rendering, renderings[reference]);
+		printf("\n");
+
+		if (!wavPrefix.empty())
+			writeWav(wavPrefix + "-" + rendering.name + ".wav", rendering.samples, rate);
+	}
+
+	s_system->destroy();
+	g_system = nullptr;
+	return 0;
+}
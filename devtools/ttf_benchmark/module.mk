@@ -0,0 +1,14 @@
+
+MODULE := devtools/ttf_benchmark
+
+MODULE_OBJS := \
+	ttf_benchmark.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := ttf_benchmark
+
+# The font renderer is taken from the ScummVM libraries, and needs FreeType
+TOOL_LIBS := graphics/libgraphics.a common/libcommon.a $(LIBS)
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,258 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+// Disable symbol overrides so that we can use system headers.
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+// HACK to allow building with the SDL backend on MinGW
+// see bug #1800764 "TOOLS: MinGW tools building broken"
+#ifdef main
+#undef main
+#endif // main
+
+#include "common/memstream.h"
+#include "common/rect.h"
+#include "common/str.h"
+
+#include "graphics/font.h"
+#include "graphics/fonts/ttf.h"
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef USE_FREETYPE2
+
+/** Typical GUI strings, drawn again and again like the launcher does. */
+static const char *const strings[] = {
+	"Start",
+	"Load...",
+	"Add Game...",
+	"Edit Game...",
+	"Remove Game",
+	"Options...",
+	"About...",
+	"Quit",
+	"Beneath a Steel Sky (CD/DOS/English)",
+	"Broken Sword: The Shadow of the Templars (Windows/English)",
+	"Day of the Tentacle (CD/DOS/English)",
+	"Flight of the Amazon Queen (Talkie/DOS/English)",
+	"Gabriel Knight: Sins of the Fathers (CD/DOS/English)",
+	"King's Quest VI: Heir Today, Gone Tomorrow (CD/DOS/English)",
+	"Lure of the Temptress (DOS/English)",
+	"Sam & Max Hit the Road (CD/DOS/English)",
+	"The Secret of Monkey Island (VGA/DOS/English)",
+	"Space Quest IV: Roger Wilco and the Time Rippers (CD/DOS/English)",
+	"Version 2.2.0git",
+	"Search:"
+};
+
+enum {
+	kStringCount = ARRAYSIZE(strings),
+	kLineWidth = 600
+};
+
+/**
+ * Draw a string one character at a time through the public Font interface,
+ * the way Font::drawString() draws strings of fonts without a faster path.
+ */
+static void drawPerChar(const Graphics::Font &font, Graphics::Surface *dst, const Common::String &str, int x, int y, int w, uint32 color) {
+	const int leftX = x, rightX = x + w;
+
+	byte last = 0;
+	for (uint i = 0; i < str.size(); ++i) {
+		const byte cur = str[i];
+		x += font.getKerningOffset(last, cur);
+		last = cur;
+
+		const Common::Rect charBox = font.getBoundingBox(cur);
+		if (x + charBox.right > rightX)
+			break;
+		if (x + charBox.right >= leftX)
+			font.drawChar(dst, cur, x, y, color);
+
+		x += font.getCharWidth(cur);
+	}
+}
+
+static uint32 hashSurface(const Graphics::Surface &surface) {
+	uint32 hash = 2166136261U;
+	const uint rowSize = surface.w * surface.format.bytesPerPixel;
+	for (int y = 0; y < surface.h; ++y) {
+		const byte *row = (const byte *)surface.getBasePtr(0, y);
+		for (uint x = 0; x < rowSize; ++x)
+			hash = (hash ^ row[x]) * 16777619U;
+	}
+	return hash;
+}
+
+struct Rendering {
+	const char *name;
+	/** The FNV-1a hash of the surface after the last pass */
+	uint32 hash;
+	/** CPU time for drawing all the strings once, in seconds */
+	double cpuTime;
+};
+
+/**
+ * Draw all the strings the given number of times, clearing the surface
+ * before each pass.
+ */
+static void render(const Graphics::Font &font, Graphics::Surface &surface, bool perChar, uint passes, Rendering &rendering) {
+	const uint32 color = surface.format.RGBToColor(255, 255, 255);
+	const int lineHeight = font.getFontHeight() + 2;
+
+	rendering.cpuTime = 0;
+	for (uint pass = 0; pass < passes; ++pass) {
+		memset(surface.getPixels(), 0, surface.h * surface.pitch);
+
+		// Only the drawing itself is timed, not the clearing
+		const clock_t start = clock();
+		for (uint i = 0; i < kStringCount; ++i) {
+			const int y = (i * lineHeight) % MAX<int>(surface.h - lineHeight, 1);
+			if (perChar)
+				drawPerChar(font, &surface, strings[i], 20, y, kLineWidth, color);
+			else
+				font.drawString(&surface, strings[i], 20, y, kLineWidth, color, Graphics::kTextAlignLeft, 0, false);
+		}
+		rendering.cpuTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+	}
+	rendering.hash = hashSurface(surface);
+}
+
+static void printHelp(const char *bin) {
+	printf("Usage: %s [options] <font.ttf>\n"
+	       "\n"
+	       "Draws GUI strings with a TrueType font, one character at a time and\n"
+	       "with the cached string layouts of the font. Reports the strings drawn\n"
+	       "per second, and whether both give the same pixels.\n"
+	       "\n"
+	       "Options:\n"
+	       "  --size=SIZE          Font size in points (default: 16)\n"
+	       "  --bpp=BPP            Bytes per pixel of the surface, 2 or 4 (default: 4)\n"
+	       "  --passes=COUNT       Draw all the strings COUNT times (default: 2000)\n",
+	       bin);
+}
+
+static byte *readFile(const char *filename, uint32 &size) {
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open '%s'\n", filename);
+		return nullptr;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(MAX<long>(length, 1));
+	const bool ok = length >= 0 && fread(data, 1, length, file) == (size_t)length;
+	fclose(file);
+	if (!ok) {
+		fprintf(stderr, "Could not read '%s'\n", filename);
+		free(data);
+		return nullptr;
+	}
+
+	size = length;
+	return data;
+}
+
+int main(int argc, char *argv[]) {
+	int size = 16;
+	uint bpp = 4;
+	uint passes = 2000;
+	const char *fontName = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		if (!strncmp(arg, "--size=", 7)) {
+			size = atoi(arg + 7);
+		} else if (!strncmp(arg, "--bpp=", 6)) {
+			bpp = atoi(arg + 6);
+		} else if (!strncmp(arg, "--passes=", 9)) {
+			passes = atoi(arg + 9);
+		} else if (arg[0] != '-' && !fontName) {
+			fontName = arg;
+		} else {
+			printHelp(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!fontName || size <= 0 || (bpp != 2 && bpp != 4) || !passes) {
+		printHelp(argv[0]);
+		return 1;
+	}
+
+	uint32 fileSize;
+	byte *data = readFile(fontName, fileSize);
+	if (!data)
+		return 1;
+
+	Common::MemoryReadStream stream(data, fileSize, DisposeAfterUse::YES);
+	Graphics::Font *font = Graphics::loadTTFFont(stream, size);
+	if (!font) {
+		fprintf(stderr, "Could not load '%s'\n", fontName);
+		return 1;
+	}
+
+	const Graphics::PixelFormat format = (bpp == 2) ?
+		Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0) :
+		Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+	Graphics::Surface surface;
+	surface.create(640, 480, format);
+
+	Rendering renderings[2];
+	renderings[0].name = "char";
+	renderings[1].name = "string";
+	for (uint i = 0; i < 2; ++i)
+		render(*font, surface, i == 0, passes, renderings[i]);
+
+	printf("%s: size %d, %u strings, %u bytes per pixel\n", fontName, size, (uint)kStringCount, bpp);
+	for (uint i = 0; i < 2; ++i) {
+		const Rendering &rendering = renderings[i];
+		printf("%-6s %10.0f strings/sec, ", rendering.name, passes * kStringCount / MAX(rendering.cpuTime, 0.000001));
+		if (i == 0)
+			printf("reference\n");
+		else if (rendering.hash == renderings[0].hash)
+			printf("identical\n");
+		else
+			printf("DIFFERENT from the reference\n");
+	}
+
+	surface.free();
+	delete font;
+	return (renderings[1].hash != renderings[0].hash) ? 1 : 0;
+}
+
+#else
+
+int main(int argc, char *argv[]) {
+	fprintf(stderr, "This build has no FreeType support\n");
+	return 1;
+}
+
+#endif // USE_FREETYPE2
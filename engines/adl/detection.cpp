@@ -362,7 +362,9 @@ const DiskImageExt diskImageExts[] = {
 
 class AdlMetaEngine : public AdvancedMetaEngine {
 public:
-	AdlMetaEngine() : AdvancedMetaEngine(gameFileDescriptions, sizeof(AdlGameDescription), adlGames, optionsList) { }
+	AdlMetaEngine() : AdvancedMetaEngine(gameFileDescriptions, sizeof(AdlGameDescription), adlGames, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
+	}
 
 	const char *getName() const override {
 		return "ADL";
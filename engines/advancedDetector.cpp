@@ -33,6 +33,7 @@
 #include "gui/gui-manager.h"
 #include "gui/message.h"
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static Common::String sanitizeName(const char *name) {
@@ -319,6 +320,58 @@ Common::Error AdvancedMetaEngine::createInstance(OSystem *syst, Engine **engine)
 		return Common::kNoError;
 }
 
+void AdvancedMetaEngine::getDetectionChecksums(const Common::FSList &fslist, Common::Array<DetectionChecksum> &checksums) const {
+	if (fslist.empty())
+		return;
+
+	FileMap allFiles;
+	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
+
+	// The files checksummed by detectGame(). Like there, the first entry
+	// listing a file decides whether the MD5 of its resource fork is used,
+	// which the MacResManager computes without the detection cache.
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> seen;
+	for (const byte *descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			const Common::String fname = fileDesc->fileName;
+			if (seen.contains(fname))
+				continue;
+			seen[fname] = true;
+
+			if (!(g->flags & ADGF_MACRESFORK) && allFiles.contains(fname)) {
+				DetectionChecksum checksum;
+				checksum.node = allFiles[fname];
+				checksum.length = _md5Bytes;
+				checksums.push_back(checksum);
+			}
+		}
+	}
+}
+
+bool AdvancedMetaEngine::getDetectionFileNames(Common::StringArray &names) const {
+	// Files in subdirectories are not in the listing of the directory, and
+	// resource forks may be in files of other names
+	if ((_flags & kADFlagDetectsUnlistedFiles) || _maxScanDepth > 1)
+		return false;
+
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> seen;
+	for (const byte *descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+		if (g->flags & ADGF_MACRESFORK)
+			return false;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			if (!seen.contains(fileDesc->fileName)) {
+				seen[fileDesc->fileName] = true;
+				names.push_back(fileDesc->fileName);
+			}
+		}
+	}
+	return true;
+}
+
 void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSList &fslist, int depth, const Common::String &parentName) const {
 	if (depth <= 0)
 		return;
@@ -385,7 +438,7 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 		return false;
 
 	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	fileProps.md5 = DetectionCacheMan.computeStreamMD5AsString(allFiles[fname], testFile, _md5Bytes);
 	return true;
 }
 
@@ -143,7 +143,15 @@ enum ADFlags {
 	 * In addition, this is useful if two variants of a game sharing the same
 	 * gameid are contained in a single directory.
 	 */
-	kADFlagUseExtraAsHint = (1 << 0)
+	kADFlagUseExtraAsHint = (1 << 0),
+
+	/**
+	 * The detector may recognize games in directories which contain none of
+	 * the files listed in the game descriptions, e.g. with fallbackDetect()
+	 * or an own detectGame(). Such engines are always run when detecting
+	 * games, whatever files the plugin index lists for them.
+	 */
+	kADFlagDetectsUnlistedFiles = (1 << 1)
 };
 
 
@@ -258,6 +266,10 @@ public:
 
 	DetectedGames detectGames(const Common::FSList &fslist) const override;
 
+	void getDetectionChecksums(const Common::FSList &fslist, Common::Array<DetectionChecksum> &checksums) const override;
+
+	bool getDetectionFileNames(Common::StringArray &names) const override;
+
 	virtual Common::Error createInstance(OSystem *syst, Engine **engine) const override;
 
 	virtual const ExtraGuiOptions getExtraGuiOptions(const Common::String &target) const override;
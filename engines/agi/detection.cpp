@@ -202,6 +202,7 @@ class AgiMetaEngine : public AdvancedMetaEngine {
 
 public:
 	AgiMetaEngine() : AdvancedMetaEngine(Agi::gameDescriptions, sizeof(Agi::AGIGameDescription), agiGames, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_guiOptions = GUIO1(GUIO_NOSPEECH);
 	}
 
@@ -115,6 +115,7 @@ static const ADExtraGuiOptionsMap optionsList[] = {
 class CGEMetaEngine : public AdvancedMetaEngine {
 public:
 	CGEMetaEngine() : AdvancedMetaEngine(CGE::gameDescriptions, sizeof(ADGameDescription), CGEGames, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
 	}
 
 	const char *getEngineId() const override {
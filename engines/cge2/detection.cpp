@@ -121,6 +121,7 @@ static const ADExtraGuiOptionsMap optionsList[] = {
 class CGE2MetaEngine : public AdvancedMetaEngine {
 public:
 	CGE2MetaEngine() : AdvancedMetaEngine(gameDescriptions, sizeof(ADGameDescription), CGE2Games, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
 	}
 
 	const char *getEngineId() const override {
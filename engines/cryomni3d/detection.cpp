@@ -86,6 +86,7 @@ class CryOmni3DMetaEngine : public AdvancedMetaEngine {
 public:
 	CryOmni3DMetaEngine() : AdvancedMetaEngine(CryOmni3D::gameDescriptions,
 				sizeof(CryOmni3DGameDescription), cryomni3DGames, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_directoryGlobs = directoryGlobs;
 		_maxScanDepth = 5;
 	}
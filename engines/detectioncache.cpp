@@ -0,0 +1,247 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/md5.h"
+#include "common/savefile.h"
+#include "common/system.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+static const char *const kCacheFileName = "scummvm-detection.cache";
+
+enum {
+	kCacheVersion = 2
+};
+
+static Common::String readString(Common::ReadStream &stream) {
+	Common::String str;
+	for (uint16 len = stream.readUint16BE(); len && !stream.eos(); --len)
+		str += (char)stream.readByte();
+	return str;
+}
+
+static void writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16BE(str.size());
+	stream.writeString(str);
+}
+
+DetectionCache::DetectionCache() : _session(0), _loaded(false), _dirty(false), _hits(0), _misses(0) {
+}
+
+DetectionCache::~DetectionCache() {
+	flush();
+}
+
+bool DetectionCache::isCacheable(uint32 mtime) const {
+	return mtime && ConfMan.getBool("detection_cache");
+}
+
+Common::String DetectionCache::getKey(const Common::FSNode &node, uint32 length) {
+	return Common::String::format("%u:%s", length, node.getPath().c_str());
+}
+
+Common::String DetectionCache::computeStreamMD5AsString(const Common::FSNode &node, Common::SeekableReadStream &stream, uint32 length) {
+	const uint32 mtime = node.getModificationTime();
+	if (!isCacheable(mtime))
+		return Common::computeStreamMD5AsString(stream, length);
+
+	load();
+
+	const uint32 size = stream.size();
+	EntryMap::iterator i = _entries.find(getKey(node, length));
+	if (i != _entries.end() && i->_value.size == size && i->_value.mtime == mtime) {
+		if (i->_value.ahead) {
+			i->_value.ahead = false;
+			++_misses;
+		} else {
+			++_hits;
+		}
+		if (i->_value.session != _session) {
+			i->_value.session = _session;
+			_dirty = true;
+		}
+		return i->_value.md5;
+	}
+
+	++_misses;
+	const Common::String md5 = Common::computeStreamMD5AsString(stream, length);
+	if (!md5.empty()) {
+		Entry &entry = _entries[getKey(node, length)];
+		entry.size = size;
+		entry.mtime = mtime;
+		entry.session = _session;
+		entry.ahead = false;
+		entry.md5 = md5;
+		_dirty = true;
+	}
+	return md5;
+}
+
+bool DetectionCache::needsChecksum(const Common::FSNode &node, uint32 length) {
+	const uint32 mtime = node.getModificationTime();
+	if (!isCacheable(mtime))
+		return false;
+
+	load();
+
+	// The size is only checked by the lookup, which checksums the file
+	// again if it changed
+	EntryMap::const_iterator i = _entries.find(getKey(node, length));
+	return i == _entries.end() || i->_value.mtime != mtime;
+}
+
+void DetectionCache::addChecksum(const Common::FSNode &node, uint32 size, uint32 length, const Common::String &md5) {
+	const uint32 mtime = node.getModificationTime();
+	if (!isCacheable(mtime) || md5.empty())
+		return;
+
+	load();
+
+	Entry &entry = _entries[getKey(node, length)];
+	entry.size = size;
+	entry.mtime = mtime;
+	entry.session = _session;
+	entry.ahead = true;
+	entry.md5 = md5;
+	_dirty = true;
+}
+
+uint DetectionCache::getHitRate() const {
+	const uint32 lookups = _hits + _misses;
+	return lookups ? (uint)((uint64)_hits * 100 / lookups) : 0;
+}
+
+void DetectionCache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	if (!saveFileMan)
+		return;
+
+	Common::InSaveFile *file = saveFileMan->openForLoading(kCacheFileName);
+	if (!file)
+		return;
+
+	if (file->readUint32BE() != MKTAG('D', 'C', 'A', 'C') || file->readUint32BE() != kCacheVersion) {
+		warning("DetectionCache: Ignoring invalid cache file");
+		delete file;
+		return;
+	}
+
+	// The entries used from now on are marked with a new session
+	_session = file->readUint32BE() + 1;
+
+	const uint32 count = file->readUint32BE();
+	for (uint32 i = 0; i < count && !file->eos() && !file->err(); ++i) {
+		const Common::String key = readString(*file);
+		Entry entry;
+		entry.size = file->readUint32BE();
+		entry.mtime = file->readUint32BE();
+		entry.session = file->readUint32BE();
+		entry.ahead = false;
+		entry.md5 = readString(*file);
+		if (!file->eos() && !file->err())
+			_entries[key] = entry;
+	}
+
+	debug(2, "DetectionCache: Loaded %u entries", _entries.size());
+	delete file;
+}
+
+void DetectionCache::flush() {
+	if (!_dirty)
+		return;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	if (!saveFileMan)
+		return;
+
+	Common::OutSaveFile *file = saveFileMan->openForSaving(kCacheFileName);
+	if (!file) {
+		warning("DetectionCache: Could not write the cache file");
+		return;
+	}
+
+	prune();
+
+	file->writeUint32BE(MKTAG('D', 'C', 'A', 'C'));
+	file->writeUint32BE(kCacheVersion);
+	file->writeUint32BE(_session);
+	file->writeUint32BE(_entries.size());
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		writeString(*file, i->_key);
+		file->writeUint32BE(i->_value.size);
+		file->writeUint32BE(i->_value.mtime);
+		file->writeUint32BE(i->_value.session);
+		writeString(*file, i->_value.md5);
+	}
+	file->finalize();
+
+	if (file->err())
+		warning("DetectionCache: Could not write the cache file");
+	else
+		_dirty = false;
+	delete file;
+}
+
+void DetectionCache::prune() {
+	if (_entries.size() <= kMaxEntries)
+		return;
+
+	// Keep the entries of the kMaxEntries most recent uses. Entries of the
+	// oldest session kept are only dropped as long as there are too many.
+	Common::Array<uint32> sessions;
+	sessions.reserve(_entries.size());
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+		sessions.push_back(i->_value.session);
+	Common::sort(sessions.begin(), sessions.end());
+	const uint32 oldestKept = sessions[sessions.size() - kMaxEntries];
+
+	Common::Array<Common::String> dropped;
+	uint32 excess = _entries.size() - kMaxEntries;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->_value.session < oldestKept)
+			dropped.push_back(i->_key);
+	}
+	excess -= dropped.size();
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end() && excess; ++i) {
+		if (i->_value.session == oldestKept) {
+			dropped.push_back(i->_key);
+			--excess;
+		}
+	}
+
+	for (uint i = 0; i < dropped.size(); ++i)
+		_entries.erase(dropped[i]);
+	debug(2, "DetectionCache: Dropped %u entries", dropped.size());
+}
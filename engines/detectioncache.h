@@ -0,0 +1,147 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+class SeekableReadStream;
+}
+
+/**
+ * A file whose MD5 the detector computes through the DetectionCache, see
+ * MetaEngine::getDetectionChecksums().
+ */
+struct DetectionChecksum {
+	Common::FSNode node;
+	uint32 length; ///< Number of bytes to checksum; 0 means all
+};
+
+/**
+ * Persistent cache of the MD5 checksums computed during game detection.
+ *
+ * Checksums are looked up by the path of the file and the number of bytes
+ * they cover. An entry is only used when the size and the modification
+ * time of the file still match, so changed files are checksummed again.
+ * Files whose modification time is not known are never cached.
+ *
+ * The cache is loaded from the savefile manager on first use, and written
+ * back by flush(), which is also called on destruction. It can be disabled
+ * with the "detection_cache" config key.
+ *
+ * Every load of the cache starts a new session. The entries remember the
+ * session in which they were last used, and flush() drops the ones which
+ * were used least recently beyond kMaxEntries, e.g. for deleted files.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	enum {
+		/** Number of checksums kept when writing the cache */
+		kMaxEntries = 20000
+	};
+
+	DetectionCache();
+	~DetectionCache();
+
+	/**
+	 * Compute the MD5 of the file referred to by the given node, or return
+	 * the cached MD5 if the file did not change. The stream must have been
+	 * opened from the node.
+	 *
+	 * @param node		the node of the file
+	 * @param stream	the stream to read, if the MD5 is not cached
+	 * @param length	the number of bytes to checksum; 0 means all
+	 * @return the MD5 as a hex string, or an empty string on error
+	 */
+	Common::String computeStreamMD5AsString(const Common::FSNode &node, Common::SeekableReadStream &stream, uint32 length);
+
+	/**
+	 * Return whether computeStreamMD5AsString() would store the MD5 of the
+	 * file, and it is not cached yet. Only those are worth computing ahead.
+	 */
+	bool needsChecksum(const Common::FSNode &node, uint32 length);
+
+	/**
+	 * Store an MD5 which was computed ahead of the detector, e.g. on
+	 * another thread. The lookup by the detector counts as a miss.
+	 *
+	 * @param node		the node of the file
+	 * @param size		the size of the file
+	 * @param length	the number of bytes checksummed; 0 means all
+	 * @param md5		the MD5 as a hex string
+	 */
+	void addChecksum(const Common::FSNode &node, uint32 size, uint32 length, const Common::String &md5);
+
+	/** Write the cache, if it was changed since it was loaded or written. */
+	void flush();
+
+	/** Return the number of lookups answered by the cache. */
+	uint32 getHits() const { return _hits; }
+
+	/** Return the number of lookups which required computing the MD5. */
+	uint32 getMisses() const { return _misses; }
+
+	/** Return the percentage of the lookups answered by the cache. */
+	uint getHitRate() const;
+
+	/** Reset the hit and miss counters. */
+	void resetStats() { _hits = _misses = 0; }
+
+private:
+	struct Entry {
+		uint32 size;
+		uint32 mtime;
+		uint32 session; ///< Session in which the entry was last used
+		bool ahead;     ///< Computed by addChecksum() and not looked up yet
+		Common::String md5;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	/** Return whether the MD5 of files with the given time can be cached. */
+	bool isCacheable(uint32 mtime) const;
+
+	static Common::String getKey(const Common::FSNode &node, uint32 length);
+
+	void load();
+
+	/** Drop the least recently used entries beyond kMaxEntries. */
+	void prune();
+
+	EntryMap _entries;
+	uint32 _session;
+	bool _loaded;
+	bool _dirty;
+	uint32 _hits;
+	uint32 _misses;
+};
+
+/** Convenience shortcut for accessing the detection cache. */
+#define DetectionCacheMan DetectionCache::instance()
+
+#endif
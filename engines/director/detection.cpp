@@ -110,6 +110,7 @@ static const char *directoryGlobs[] = {
 class DirectorMetaEngine : public AdvancedMetaEngine {
 public:
 	DirectorMetaEngine() : AdvancedMetaEngine(Director::gameDescriptions, sizeof(Director::DirectorGameDescription), directorGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_maxScanDepth = 2;
 		_directoryGlobs = directoryGlobs;
 	}
@@ -0,0 +1,230 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/gamescanner.h"
+#include "engines/detectioncache.h"
+#include "engines/metaengine.h"
+
+#include "common/config-manager.h"
+#include "common/hash-str.h"
+#include "common/md5.h"
+#include "common/stream.h"
+#include "common/system.h"
+
+enum {
+	/**
+	 * Number of directories the listing stage may run ahead of the
+	 * detection stage. This bounds the memory used by the listed files.
+	 */
+	kMaxListAhead = 16
+};
+
+GameScanner::GameScanner(const Common::FSNode &startDir, bool recursive) : _recursive(recursive) {
+	memset(&_stats, 0, sizeof(_stats));
+	_dirQueue.push(startDir);
+	_stats.dirsFound = 1;
+}
+
+bool GameScanner::scan(uint32 timeLimit) {
+	const uint32 start = g_system->getMillis();
+
+	while (!isDone()) {
+		// The listed directories are hashed once the detector ran out of
+		// them, so that their files are hashed in large batches
+		if (!_dirQueue.empty() && _listedQueue.size() + _hashedQueue.size() < kMaxListAhead)
+			listNextDirs();
+		else if (_hashedQueue.empty())
+			hashNextDirs();
+		else
+			detectNextDir();
+
+		if (timeLimit && g_system->getMillis() - start >= timeLimit)
+			break;
+	}
+
+	return isDone();
+}
+
+bool GameScanner::popResult(Result &result) {
+	if (_results.empty())
+		return false;
+	result = _results.pop();
+	return true;
+}
+
+namespace {
+
+struct DirListing {
+	Common::FSNode dir;
+	Common::FSList files;
+	Common::FSList subdirs;
+	bool success;
+};
+
+struct DirListingBatch {
+	Common::Array<DirListing> *listings;
+	bool recursive;
+};
+
+/**
+ * List a directory of a batch and find its subdirectories. The jobs may
+ * run in parallel, so they only touch the nodes of their own listing.
+ * Copying these is safe, because the scanner waits for the jobs and no
+ * other thread uses its nodes.
+ */
+void listDir(void *param, uint index) {
+	const DirListingBatch &batch = *(const DirListingBatch *)param;
+	DirListing &listing = (*batch.listings)[index];
+	listing.success = listing.dir.getChildren(listing.files, Common::FSNode::kListAll);
+	if (listing.success && batch.recursive) {
+		for (Common::FSList::const_iterator file = listing.files.begin(); file != listing.files.end(); ++file) {
+			if (file->isDirectory())
+				listing.subdirs.push_back(*file);
+		}
+	}
+}
+
+struct FileChecksum {
+	Common::FSNode node;
+	uint32 length;
+	uint32 size;
+	Common::String md5;
+};
+
+/**
+ * Compute the MD5 of a file of a batch. Like listDir(), the jobs only touch
+ * their own entry of the batch, which the scanner reads once all of them
+ * are done.
+ */
+void hashFile(void *param, uint index) {
+	FileChecksum &checksum = (*(Common::Array<FileChecksum> *)param)[index];
+	Common::SeekableReadStream *stream = checksum.node.createReadStream();
+	if (!stream)
+		return;
+
+	checksum.size = stream->size();
+	checksum.md5 = Common::computeStreamMD5AsString(*stream, checksum.length);
+	delete stream;
+}
+
+} // End of anonymous namespace
+
+void GameScanner::listNextDirs() {
+	const uint32 start = g_system->getMillis();
+
+	Common::Array<DirListing> listings;
+	listings.resize(MIN<uint>(_dirQueue.size(), kMaxListAhead - _listedQueue.size()));
+	for (uint i = 0; i < listings.size(); ++i)
+		listings[i].dir = _dirQueue.pop();
+
+	DirListingBatch batch;
+	batch.listings = &listings;
+	batch.recursive = _recursive;
+	g_system->runParallel(listDir, &batch, listings.size());
+
+	// Queue the results in order, so the scan order does not depend on
+	// the number of threads
+	for (uint i = 0; i < listings.size(); ++i) {
+		DirListing &listing = listings[i];
+		if (listing.success) {
+			for (Common::FSList::const_iterator subdir = listing.subdirs.begin(); subdir != listing.subdirs.end(); ++subdir)
+				_dirQueue.push(*subdir);
+			_stats.dirsFound += listing.subdirs.size();
+
+			ListedDir listed;
+			listed.dir = listing.dir;
+			listed.files = listing.files;
+			_listedQueue.push(listed);
+		}
+	}
+	_stats.dirsListed += listings.size();
+
+	_stats.listTime += g_system->getMillis() - start;
+}
+
+void GameScanner::hashNextDirs() {
+	if (!ConfMan.getBool("detection_cache") || g_system->getParallelJobThreads() <= 1) {
+		while (!_listedQueue.empty())
+			_hashedQueue.push(_listedQueue.pop());
+		return;
+	}
+
+	const uint32 start = g_system->getMillis();
+
+	// Several engines may checksum the same files
+	Common::Array<FileChecksum> checksums;
+	Common::HashMap<Common::String, bool> seen;
+	Common::Array<DetectionChecksum> requested;
+	while (!_listedQueue.empty()) {
+		const ListedDir listed = _listedQueue.pop();
+
+		requested.clear();
+		EngineMan.getDetectionChecksums(listed.files, requested);
+		for (uint i = 0; i < requested.size(); ++i) {
+			const Common::String key = Common::String::format("%u:%s", requested[i].length, requested[i].node.getPath().c_str());
+			if (seen.contains(key) || !DetectionCacheMan.needsChecksum(requested[i].node, requested[i].length))
+				continue;
+			seen[key] = true;
+
+			FileChecksum checksum;
+			checksum.node = requested[i].node;
+			checksum.length = requested[i].length;
+			checksum.size = 0;
+			checksums.push_back(checksum);
+		}
+
+		_hashedQueue.push(listed);
+	}
+
+	g_system->runParallel(hashFile, &checksums, checksums.size());
+
+	for (uint i = 0; i < checksums.size(); ++i) {
+		const FileChecksum &checksum = checksums[i];
+		DetectionCacheMan.addChecksum(checksum.node, checksum.size, checksum.length, checksum.md5);
+	}
+	_stats.filesHashed += checksums.size();
+
+	_stats.hashTime += g_system->getMillis() - start;
+}
+
+void GameScanner::detectNextDir() {
+	const uint32 start = g_system->getMillis();
+
+	const ListedDir listed = _hashedQueue.pop();
+	DetectionResults detectionResults = EngineMan.detectGames(listed.files);
+
+	if (detectionResults.foundUnknownGames()) {
+		Common::String report = detectionResults.generateUnknownGameReport(false, 80);
+		g_system->logMessage(LogMessageType::kInfo, report.c_str());
+	}
+
+	Result result;
+	result.dir = listed.dir;
+	result.games = detectionResults.listRecognizedGames();
+	if (!result.games.empty()) {
+		_stats.gamesFound += result.games.size();
+		_results.push(result);
+	}
+	_stats.dirsDetected++;
+
+	_stats.detectTime += g_system->getMillis() - start;
+}
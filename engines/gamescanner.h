@@ -0,0 +1,139 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_GAMESCANNER_H
+#define ENGINES_GAMESCANNER_H
+
+#include "engines/game.h"
+
+#include "common/fs.h"
+#include "common/queue.h"
+
+/**
+ * Timing statistics of a GameScanner.
+ */
+struct GameScannerStats {
+	/** Number of directories which were found, including the start directory. */
+	uint32 dirsFound;
+	/** Number of directories whose contents were listed. */
+	uint32 dirsListed;
+	/** Number of directories on which the detector was run. */
+	uint32 dirsDetected;
+	/** Number of games recognized. */
+	uint32 gamesFound;
+	/** Number of files checksummed ahead of the detector. */
+	uint32 filesHashed;
+	/** Milliseconds spent listing directories. */
+	uint32 listTime;
+	/** Milliseconds spent checksumming files ahead of the detector. */
+	uint32 hashTime;
+	/** Milliseconds spent detecting games. */
+	uint32 detectTime;
+};
+
+/**
+ * Scans a directory tree for games, as used by the mass add dialog and by
+ * the --add command line option.
+ *
+ * The scan is a pipeline of three stages: the first one lists directories
+ * and queues their subdirectories, the second one computes the MD5s the
+ * detector needs for the listed directories, the third one runs the
+ * detector. The listing stage runs ahead of the detection stage by a
+ * limited number of directories, so slow directory listings, e.g. on
+ * network storage, are not interleaved with every detection run. The
+ * directories of the listing stage are listed in batches with
+ * OSystem::runParallel(), and so are the files of the hashing stage, while
+ * the detector runs on the calling thread.
+ *
+ * The hashing stage stores the MD5s in the DetectionCache, where the
+ * detector finds them. It is skipped when the cache is disabled, or when
+ * runParallel() only has one thread.
+ *
+ * The work can be split into slices with a time limit, so a dialog can
+ * stay responsive while scanning. The recognized games of each directory
+ * are queued as results and can be fetched while the scan continues.
+ */
+class GameScanner {
+public:
+	/** The games recognized in a directory. */
+	struct Result {
+		Common::FSNode dir;
+		DetectedGames games;
+	};
+
+	/**
+	 * @param startDir	the directory to start the scan at
+	 * @param recursive	whether to scan the subdirectories
+	 */
+	GameScanner(const Common::FSNode &startDir, bool recursive = true);
+
+	/**
+	 * Continue scanning.
+	 *
+	 * @param timeLimit	the number of milliseconds after which to return,
+	 *                 	or 0 to scan until done
+	 * @return true if the scan is done
+	 */
+	bool scan(uint32 timeLimit = 0);
+
+	/** Return whether all directories were scanned. */
+	bool isDone() const { return _dirQueue.empty() && _listedQueue.empty() && _hashedQueue.empty(); }
+
+	/**
+	 * Fetch the next directory in which games were recognized.
+	 *
+	 * @return false if there are no pending results
+	 */
+	bool popResult(Result &result);
+
+	const GameScannerStats &getStats() const { return _stats; }
+
+private:
+	struct ListedDir {
+		Common::FSNode dir;
+		Common::FSList files;
+	};
+
+	/**
+	 * List the next queued directories, as many as the detection stage may
+	 * run behind, and queue their subdirectories.
+	 */
+	void listNextDirs();
+
+	/**
+	 * Compute the MD5s the detector needs for all listed directories, and
+	 * queue the directories for detection.
+	 */
+	void hashNextDirs();
+
+	/** Run the detector on the next hashed directory. */
+	void detectNextDir();
+
+	bool _recursive;
+	Common::Queue<Common::FSNode> _dirQueue;
+	Common::Queue<ListedDir> _listedQueue;
+	Common::Queue<ListedDir> _hashedQueue;
+	Common::Queue<Result> _results;
+	GameScannerStats _stats;
+};
+
+#endif
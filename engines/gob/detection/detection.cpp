@@ -56,6 +56,7 @@ private:
 GobMetaEngine::GobMetaEngine() :
 	AdvancedMetaEngine(Gob::gameDescriptions, sizeof(Gob::GOBGameDescription), gobGames) {
 
+	_flags = kADFlagDetectsUnlistedFiles;
 	_guiOptions = GUIO1(GUIO_NOLAUNCHLOAD);
 }
 
@@ -56,6 +56,7 @@ static const PlainGameDescriptor madeGames[] = {
 class MadeMetaEngine : public AdvancedMetaEngine {
 public:
 	MadeMetaEngine() : AdvancedMetaEngine(Made::gameDescriptions, sizeof(Made::MadeGameDescription), madeGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 	}
 
 	const char *getEngineId() const override {
@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/error.h"
 #include "common/array.h"
+#include "common/str-array.h"
 
 #include "engines/game.h"
 #include "engines/savestate.h"
@@ -34,6 +35,7 @@
 
 class Engine;
 class OSystem;
+struct DetectionChecksum;
 
 namespace Common {
 class Keymap;
@@ -126,6 +128,25 @@ public:
 	 */
 	virtual DetectedGames detectGames(const Common::FSList &fslist) const = 0;
 
+	/**
+	 * Add the files whose MD5 detectGames() computes through the
+	 * DetectionCache for the given list of files, so that the game scanner
+	 * can checksum them ahead, in parallel. The default implementation adds
+	 * none.
+	 */
+	virtual void getDetectionChecksums(const Common::FSList &fslist, Common::Array<DetectionChecksum> &checksums) const {}
+
+	/**
+	 * Add the names of the files one of which must be in a directory for
+	 * detectGames() to recognize a game in it, or to report an unknown one.
+	 * The plugin index lists them, so that plugins which cannot detect
+	 * anything in a directory are not loaded.
+	 *
+	 * @return false if the engine may recognize games without any of the
+	 *         files, which is what the default implementation returns
+	 */
+	virtual bool getDetectionFileNames(Common::StringArray &names) const { return false; }
+
 	/**
 	 * Tries to instantiate an engine instance based on the settings of
 	 * the currently active ConfMan target. That is, the MetaEngine should
@@ -392,6 +413,12 @@ public:
 	 */
 	DetectionResults detectGames(const Common::FSList &fslist) const;
 
+	/**
+	 * Add the files whose MD5 the engines compute through the
+	 * DetectionCache when detecting games in the given list of files.
+	 */
+	void getDetectionChecksums(const Common::FSList &fslist, Common::Array<DetectionChecksum> &checksums) const;
+
 	/** Find a plugin by its engine ID */
 	const Plugin *findPlugin(const Common::String &engineId) const;
 
@@ -2,8 +2,10 @@ MODULE := engines
 
 MODULE_OBJS := \
 	advancedDetector.o \
+	detectioncache.o \
 	dialogs.o \
 	engine.o \
+	gamescanner.o \
 	game.o \
 	metaengine.o \
 	obsolete.o \
@@ -174,6 +174,7 @@ static const char *directoryGlobs[] = {
 class MohawkMetaEngine : public AdvancedMetaEngine {
 public:
 	MohawkMetaEngine() : AdvancedMetaEngine(Mohawk::gameDescriptions, sizeof(Mohawk::MohawkGameDescription), mohawkGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_maxScanDepth = 2;
 		_directoryGlobs = directoryGlobs;
 	}
@@ -482,6 +482,7 @@ static const QueenGameDescription gameDescriptions[] = {
 class QueenMetaEngine : public AdvancedMetaEngine {
 public:
 	QueenMetaEngine() : AdvancedMetaEngine(Queen::gameDescriptions, sizeof(Queen::QueenGameDescription), queenGames, optionsList) {
+		_flags = kADFlagDetectsUnlistedFiles;
 	}
 
 	const char *getEngineId() const override {
@@ -84,6 +84,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	// Variables
 	registerVar("sleeptime_factor",	&g_debug_sleeptime_factor);
 	registerVar("gc_interval",		&engine->_gamestate->scriptGCInterval);
+	registerVar("gc_incremental",	&engine->_gamestate->gcIncremental);
 	registerVar("simulated_key",		&g_debug_simulated_key);
 	registerVar("track_mouse_clicks",	&g_debug_track_mouse_clicks);
 	// FIXME: This actually passes an enum type instead of an integer but no
@@ -117,6 +118,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
 	registerCmd("list",				WRAP_METHOD(Console, cmdList));
 	registerCmd("alloc_list",				WRAP_METHOD(Console, cmdAllocList));
+	registerCmd("resource_stats",		WRAP_METHOD(Console, cmdResourceStats));
 	registerCmd("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	registerCmd("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
 	registerCmd("integrity_dump",	WRAP_METHOD(Console, cmdResourceIntegrityDump));
@@ -163,6 +165,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	registerCmd("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	registerCmd("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	registerCmd("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	// Music/SFX
 	registerCmd("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	registerCmd("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -225,6 +228,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	registerCmd("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	registerCmd("vm_profile",			WRAP_METHOD(Console, cmdVMProfile));
 	registerCmd("script_objects",   WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("scro",             WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("script_strings",   WRAP_METHOD(Console, cmdScriptStrings));
@@ -256,6 +260,9 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	_debugState.breakpointWasHit = false;
 	_debugState._breakpoints.clear(); // No breakpoints defined
 	_debugState._activeBreakpointTypes = 0;
+	_debugState._profile.enabled = false;
+	_debugState._profile.generation = 0;
+	_debugState._profile.reset();
 }
 
 Console::~Console() {
@@ -308,6 +315,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("---------\n");
 	debugPrintf("sleeptime_factor: Factor to multiply with wait times in kWait()\n");
 	debugPrintf("gc_interval: Number of kernel calls in between garbage collections\n");
+	debugPrintf("gc_incremental: Spreads the marking of garbage collections over the kernel calls that follow\n");
 	debugPrintf("simulated_key: Add a key with the specified scan code to the event list\n");
 	debugPrintf("track_mouse_clicks: Toggles mouse click tracking to the console\n");
 	debugPrintf("weak_validations: Turns some validation errors into warnings\n");
@@ -347,6 +355,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" resource_types - Shows the valid resource types\n");
 	debugPrintf(" list - Lists all the resources of a given type\n");
 	debugPrintf(" alloc_list - Lists all allocated resources\n");
+	debugPrintf(" resource_stats - Shows the hit rates of the resource cache\n");
 	debugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	debugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
 	debugPrintf(" integrity_dump - Dumps integrity data about resources in the current game to disk\n");
@@ -388,6 +397,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	debugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	debugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	debugPrintf(" gc_stats - Shows the pause times and the memory reclaimed by the garbage collector\n");
 	debugPrintf("\n");
 	debugPrintf("Music/SFX:\n");
 	debugPrintf(" songlib - Shows the song library\n");
@@ -433,6 +443,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("\n");
 	debugPrintf("VM:\n");
 	debugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	debugPrintf(" vm_profile - Counts the executed SCI operations and their time, per opcode and per method\n");
 	debugPrintf(" vm_varlist / vmvarlist / vl - Shows the addresses of variables in the VM\n");
 	debugPrintf(" vm_vars / vmvars / vv - Displays or changes variables in the VM\n");
 	debugPrintf(" stack - Lists the specified number of stack elements\n");
@@ -1037,6 +1048,41 @@ bool Console::cmdAllocList(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceStats(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		debugPrintf("Shows how often the resources of each type were found in the\n");
+		debugPrintf("resource cache, and how long loading the others took.\n");
+		debugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		resMan->resetCacheStats();
+		debugPrintf("Resource cache statistics reset\n");
+		return true;
+	}
+
+	debugPrintf("Type          Hits  Misses  Hit rate  Load ms  Evicted\n");
+	for (int i = 0; i < kResourceTypeInvalid; ++i) {
+		const ResourceCacheStats &stats = resMan->getCacheStats((ResourceType)i);
+		const uint32 requests = stats.hits + stats.misses;
+		if (!requests)
+			continue;
+
+		debugPrintf("%-12s %5u %7u %8u%% %8u %8u\n", getResourceTypeName((ResourceType)i),
+			stats.hits, stats.misses, stats.hits * 100 / requests,
+			stats.missMillis, stats.evictions);
+	}
+
+	debugPrintf("Cache: %d of %d bytes, %d in small resources, %d in large ones\n",
+		resMan->getLRUMemory(kResLRUSmall) + resMan->getLRUMemory(kResLRULarge), resMan->getMaxLRUMemory(),
+		resMan->getLRUMemory(kResLRUSmall), resMan->getLRUMemory(kResLRULarge));
+
+	return true;
+}
+
 bool Console::cmdDissectScript(int argc, const char **argv) {
 	if (argc != 2) {
 		debugPrintf("Examines a script\n");
@@ -2727,6 +2773,9 @@ bool Console::cmdIsSample(int argc, const char **argv) {
 bool Console::cmdGCInvoke(int argc, const char **argv) {
 	debugPrintf("Performing garbage collection...\n");
 	run_gc(_engine->_gamestate);
+
+	const GCStatistics &stats = _engine->_gamestate->gcStats;
+	debugPrintf("Freed %u objects (%u bytes) in %u ms\n", stats.lastFreedObjects, stats.lastFreedBytes, stats.lastPause);
 	return true;
 }
 
@@ -2836,6 +2885,25 @@ bool Console::cmdGCNormalize(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	const GCStatistics &stats = _engine->_gamestate->gcStats;
+
+	debugPrintf("Collections: %u, every %d kernel calls\n", stats.collections, _engine->_gamestate->scriptGCInterval);
+	if (!stats.collections)
+		return true;
+
+	debugPrintf("Last collection: %u ms, %u addresses in use, freed %u objects (%u bytes)\n",
+		stats.lastPause, stats.lastReachable, stats.lastFreedObjects, stats.lastFreedBytes);
+	debugPrintf("Pause: %u ms on average, %u ms at most, %u ms in total\n",
+		stats.totalPause / stats.collections, stats.maxPause, stats.totalPause);
+	if (stats.lastSteps)
+		debugPrintf("Last collection marked incrementally: %u steps taking %u ms, %u written objects looked at again\n",
+			stats.lastSteps, stats.lastStepTime, stats.lastRescanned);
+	debugPrintf("Incremental marking step: %u ms at most\n", stats.maxStepPause);
+	debugPrintf("Freed in total: %u objects (%u KB)\n", stats.totalFreedObjects, (uint)(stats.totalFreedBytes / 1024));
+	return true;
+}
+
 bool Console::cmdVMVarlist(int argc, const char **argv) {
 	EngineState *s = _engine->_gamestate;
 	const char *varnames[] = {"global", "local", "temp", "param"};
@@ -3265,6 +3333,86 @@ bool Console::cmdScriptSteps(int argc, const char **argv) {
 	return true;
 }
 
+extern const char *opcodeNames[];
+
+namespace {
+struct OpcodeCountComparator {
+	const VmProfile &_profile;
+	OpcodeCountComparator(const VmProfile &profile) : _profile(profile) {}
+	bool operator()(int a, int b) const {
+		return _profile.opcodeCounts[a] > _profile.opcodeCounts[b];
+	}
+};
+
+struct MethodTimeComparator {
+	bool operator()(const VmProfileMethod *a, const VmProfileMethod *b) const {
+		if (a->time != b->time)
+			return a->time > b->time;
+		return a->instructions > b->instructions;
+	}
+};
+} // End of anonymous namespace
+
+bool Console::cmdVMProfile(int argc, const char **argv) {
+	VmProfile &profile = _debugState._profile;
+
+	if (argc < 2) {
+		debugPrintf("Counts the executed SCI operations and samples the time spent in them.\n");
+		debugPrintf("Usage: %s on|off|reset|opcodes|methods [<count>]\n", argv[0]);
+		debugPrintf("  on / off - Starts or stops counting\n");
+		debugPrintf("  reset - Clears the counts\n");
+		debugPrintf("  opcodes - Shows the counts and time per opcode\n");
+		debugPrintf("  methods - Shows the <count> methods with the most time (default: 20)\n");
+		debugPrintf("Counting is %s\n", profile.enabled ? "on" : "off");
+		return true;
+	}
+
+	if (!scumm_stricmp(argv[1], "on")) {
+		profile.enabled = true;
+		// Don't charge the time while counting was off to the last operation
+		profile.lastOpcode = -1;
+	} else if (!scumm_stricmp(argv[1], "off")) {
+		profile.enabled = false;
+	} else if (!scumm_stricmp(argv[1], "reset")) {
+		profile.reset();
+	} else if (!scumm_stricmp(argv[1], "opcodes")) {
+		Common::Array<int> opcodes;
+		uint32 total = 0;
+		for (int i = 0; i < ARRAYSIZE(profile.opcodeCounts); i++) {
+			if (profile.opcodeCounts[i]) {
+				opcodes.push_back(i);
+				total += profile.opcodeCounts[i];
+			}
+		}
+		Common::sort(opcodes.begin(), opcodes.end(), OpcodeCountComparator(profile));
+
+		debugPrintf("Opcode       Count      %%  Time (ms)\n");
+		for (uint i = 0; i < opcodes.size(); i++) {
+			const int opcode = opcodes[i];
+			debugPrintf("%-8s %9u %6.2f %10u\n", opcodeNames[opcode], profile.opcodeCounts[opcode],
+				100.0 * profile.opcodeCounts[opcode] / total, profile.opcodeTimes[opcode]);
+		}
+		debugPrintf("%u operations\n", total);
+	} else if (!scumm_stricmp(argv[1], "methods")) {
+		uint count = (argc > 2) ? atoi(argv[2]) : 20;
+
+		Common::Array<const VmProfileMethod *> methods;
+		Common::HashMap<VmProfileMethodKey, VmProfileMethod, VmProfileMethodKeyHash>::const_iterator it;
+		for (it = profile.methods.begin(); it != profile.methods.end(); ++it)
+			methods.push_back(&it->_value);
+		Common::sort(methods.begin(), methods.end(), MethodTimeComparator());
+
+		debugPrintf("Time (ms)  Operations  Method\n");
+		for (uint i = 0; i < methods.size() && i < count; i++)
+			debugPrintf("%9u %11u  %s\n", methods[i]->time, methods[i]->instructions, methods[i]->name.c_str());
+		debugPrintf("%u methods\n", methods.size());
+	} else {
+		debugPrintf("Unknown argument '%s'\n", argv[1]);
+	}
+
+	return true;
+}
+
 bool Console::cmdScriptObjects(int argc, const char **argv) {
 	int curScriptNr = -1;
 
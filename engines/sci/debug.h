@@ -23,7 +23,9 @@
 #ifndef SCI_DEBUG_H
 #define SCI_DEBUG_H
 
+#include "common/hashmap.h"
 #include "common/list.h"
+#include "common/str.h"
 #include "sci/engine/vm_types.h"	// for StackPtr
 
 namespace Sci {
@@ -72,6 +74,54 @@ enum DebugSeeking {
 	kDebugSeekStepOver = 5      // Step forward until we reach same stack-level again
 };
 
+/** Identifies a method for the VM profiler: the script its code is in, and its selector, export or local call */
+struct VmProfileMethodKey {
+	int scriptNumber;
+	int selector;
+	int exportId;
+	int localCallOffset;
+
+	bool operator==(const VmProfileMethodKey &other) const {
+		return scriptNumber == other.scriptNumber && selector == other.selector &&
+			exportId == other.exportId && localCallOffset == other.localCallOffset;
+	}
+};
+
+struct VmProfileMethodKeyHash : public Common::UnaryFunction<VmProfileMethodKey, uint> {
+	uint operator()(const VmProfileMethodKey &key) const {
+		return ((uint)key.scriptNumber << 16) ^ ((uint)key.selector << 8) ^ (uint)key.exportId ^ ((uint)key.localCallOffset << 4);
+	}
+};
+
+struct VmProfileMethod {
+	Common::String name;  ///< Object and selector, export or local call, as first seen
+	uint32 instructions;
+	uint32 time;          ///< In milliseconds
+};
+
+/**
+ * Execution counts and time of the VM, collected while enabled with the
+ * vm_profile console command. The time is sampled with the millisecond
+ * clock: each tick is charged to the instruction which was running when
+ * it happened.
+ */
+struct VmProfile {
+	bool enabled;
+	uint32 opcodeCounts[128];
+	uint32 opcodeTimes[128];   ///< In milliseconds
+	Common::HashMap<VmProfileMethodKey, VmProfileMethod, VmProfileMethodKeyHash> methods;
+
+	/** Instruction and method to charge the next clock tick to, -1 / NULL if none */
+	int lastOpcode;
+	VmProfileMethod *lastMethod;
+	uint32 lastMillis;
+
+	/** Incremented by reset(), which invalidates pointers to the methods */
+	uint32 generation;
+
+	void reset();
+};
+
 struct DebugState {
 	bool debugging;
 	bool breakpointWasHit;
@@ -84,6 +134,7 @@ struct DebugState {
 	StackPtr old_sp;
 	Common::List<Breakpoint> _breakpoints;   //< List of breakpoints
 	int _activeBreakpointTypes;  //< Bit mask specifying which types of breakpoints are active
+	VmProfile _profile;
 
 	void updateActiveBreakpointTypes();
 };
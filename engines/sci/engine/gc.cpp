@@ -22,6 +22,8 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/debug-channels.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 #ifdef ENABLE_SCI32
@@ -32,6 +34,10 @@ namespace Sci {
 
 //#define GC_DEBUG_CODE
 
+enum {
+	kGCStepSize = 1000 ///< Addresses each step of an incremental collection marks
+};
+
 #ifdef GC_DEBUG_CODE
 const char *segmentTypeNames[] = {
 	"invalid",   // 0
@@ -50,16 +56,69 @@ const char *segmentTypeNames[] = {
 };
 #endif
 
+AddrMarks::AddrMarks(const Common::Array<SegmentObj *> &heap) : _bits(heap.size()) {
+	for (uint i = 0; i < heap.size(); i++) {
+		if (heap[i])
+			_bits[i].resize((MIN<uint32>(heap[i]->getOffsetLimit(), kMaxOffset) + 31) >> 5);
+	}
+}
+
+bool AddrMarks::mark(reg_t addr) {
+	const uint segment = addr.getSegment();
+	const uint word = addr.getOffset() >> 5;
+	if (segment >= _bits.size() || word >= _bits[segment].size()) {
+		if (_overflow.contains(addr))
+			return false;
+		_overflow.setVal(addr, true);
+		return true;
+	}
+
+	Common::Array<uint32> &bits = _bits[segment];
+	const uint32 offset = addr.getOffset();
+	const uint32 bit = 1U << (offset & 31);
+	if (bits[word] & bit)
+		return false;
+	bits[word] |= bit;
+	return true;
+}
+
+bool AddrMarks::contains(reg_t addr) const {
+	const uint segment = addr.getSegment();
+	const uint word = addr.getOffset() >> 5;
+	if (segment >= _bits.size() || word >= _bits[segment].size())
+		return _overflow.contains(addr);
+
+	return _bits[segment][word] & (1U << (addr.getOffset() & 31));
+}
+
+void AddrMarks::resetSegment(const Common::Array<SegmentObj *> &heap, SegmentId segment) {
+	if (_bits.size() < heap.size())
+		_bits.resize(heap.size());
+
+	Common::Array<uint32> &bits = _bits[segment];
+	bits.clear();
+	if (heap[segment])
+		bits.resize((MIN<uint32>(heap[segment]->getOffsetLimit(), kMaxOffset) + 31) >> 5);
+
+	Common::Array<reg_t> stale;
+	for (AddrSet::const_iterator it = _overflow.begin(); it != _overflow.end(); ++it) {
+		if (it->_key.getSegment() == segment)
+			stale.push_back(it->_key);
+	}
+	for (Common::Array<reg_t>::const_iterator it = stale.begin(); it != stale.end(); ++it)
+		_overflow.erase(*it);
+}
+
 void WorklistManager::push(reg_t reg) {
 	if (!reg.getSegment()) // No numbers
 		return;
 
 	debugC(kDebugLevelGC, "[GC] Adding %04x:%04x", PRINT_REG(reg));
 
-	if (_map.contains(reg))
+	if (!_marks.mark(reg))
 		return; // already dealt with it
 
-	_map.setVal(reg, true);
+	_found.push_back(reg);
 	_worklist.push_back(reg);
 }
 
@@ -68,11 +127,11 @@ void WorklistManager::pushArray(const Common::Array<reg_t> &tmp) {
 		push(*it);
 }
 
-static AddrSet *normalizeAddresses(SegManager *segMan, const AddrSet &nonnormal_map) {
+static AddrSet *normalizeAddresses(SegManager *segMan, const Common::Array<reg_t> &nonnormal_addresses) {
 	AddrSet *normal_map = new AddrSet();
 
-	for (AddrSet::const_iterator i = nonnormal_map.begin(); i != nonnormal_map.end(); ++i) {
-		reg_t reg = i->_key;
+	for (Common::Array<reg_t>::const_iterator i = nonnormal_addresses.begin(); i != nonnormal_addresses.end(); ++i) {
+		reg_t reg = *i;
 		SegmentObj *mobj = segMan->getSegmentObj(reg.getSegment());
 
 		if (mobj) {
@@ -84,26 +143,31 @@ static AddrSet *normalizeAddresses(SegManager *segMan, const AddrSet &nonnormal_
 	return normal_map;
 }
 
-static void processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap) {
+/**
+ * Takes addresses off the work list and pushes their outgoing references,
+ * until the list is empty or, if budget isn't 0, budget addresses have been
+ * taken.
+ */
+static void processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap, uint budget = 0) {
 	SegmentId stackSegment = segMan->findSegmentByType(SEG_TYPE_STACK);
-	while (!wm._worklist.empty()) {
+	for (uint count = 0; !wm._worklist.empty() && (!budget || count < budget); count++) {
 		reg_t reg = wm._worklist.back();
 		wm._worklist.pop_back();
 		if (reg.getSegment() != stackSegment) { // No need to repeat this one
 			debugC(kDebugLevelGC, "[GC] Checking %04x:%04x", PRINT_REG(reg));
-			if (reg.getSegment() < heap.size() && heap[reg.getSegment()]) {
-				// Valid heap object? Find its outgoing references!
+			// Valid heap object? Find its outgoing references! Between the
+			// steps of an incremental collection, the scripts may have freed
+			// an entry which is on the work list.
+			if (reg.getSegment() < heap.size() && heap[reg.getSegment()] && heap[reg.getSegment()]->isValidOffset(reg.getOffset())) {
 				wm.pushArray(heap[reg.getSegment()]->listAllOutgoingReferences(reg));
 			}
 		}
 	}
 }
 
-AddrSet *findAllActiveReferences(EngineState *s) {
+static void findRoots(EngineState *s, WorklistManager &wm) {
 	assert(!s->_executionStack.empty());
 
-	WorklistManager wm;
-
 	// Initialize registers
 	wm.push(s->r_acc);
 	wm.push(s->r_prev);
@@ -170,20 +234,62 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	}
 
 	debugC(kDebugLevelGC, "[GC] -- Finished explicitly loaded scripts, done with root set");
+}
 
-	processWorkList(s->_segMan, wm, heap);
+static void findActiveReferences(EngineState *s, WorklistManager &wm) {
+	findRoots(s, wm);
+
+	processWorkList(s->_segMan, wm, s->_segMan->getSegments());
 
 	if (g_sci->_gfxPorts)
 		g_sci->_gfxPorts->processEngineHunkList(wm);
+}
+
+/**
+ * Pushes the outgoing references of the objects, lists, nodes, arrays and
+ * variable blocks written to since this was last called, and forgets the
+ * marks of segments allocated since then.
+ */
+static void rescanWrites(SegManager *segMan, GCCycle &cycle) {
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+	GCWriteLog &log = segMan->getGCWriteLog();
+
+	for (Common::Array<SegmentId>::const_iterator it = log.newSegments.begin(); it != log.newSegments.end(); ++it)
+		cycle._wm._marks.resetSegment(heap, *it);
+	log.newSegments.clear();
+
+	const SegmentId stackSegment = segMan->findSegmentByType(SEG_TYPE_STACK);
+	AddrSet rescanned;
+	for (Common::Array<reg_t>::const_iterator it = log.writes.begin(); it != log.writes.end(); ++it) {
+		const reg_t addr = *it;
+		const SegmentId segment = addr.getSegment();
+		// The stack is a root, and is looked at again as a whole
+		if (!segment || segment == stackSegment || segment >= heap.size() || !heap[segment])
+			continue;
+		if (!heap[segment]->isValidOffset(addr.getOffset()) || rescanned.contains(addr))
+			continue;
+
+		rescanned.setVal(addr, true);
+		cycle._wm.pushArray(heap[segment]->listAllOutgoingReferences(addr));
+	}
+	cycle._rescanned += rescanned.size();
+	log.writes.clear();
+}
 
-	return normalizeAddresses(s->_segMan, wm._map);
+AddrSet *findAllActiveReferences(EngineState *s) {
+	WorklistManager wm(s->_segMan->getSegments());
+	findActiveReferences(s, wm);
+	return normalizeAddresses(s->_segMan, wm._found);
 }
 
-void run_gc(EngineState *s) {
+/**
+ * Frees everything on the heap which the marking has not found, and records
+ * the statistics of the collection
+ */
+static void sweep(EngineState *s, const WorklistManager &wm, uint32 startTime) {
 	SegManager *segMan = s->_segMan;
 
 	// Some debug stuff
-	debugC(kDebugLevelGC, "[GC] Running...");
 #ifdef GC_DEBUG_CODE
 	const char *segnames[SEG_TYPE_MAX + 1];
 	int segcount[SEG_TYPE_MAX + 1];
@@ -191,12 +297,21 @@ void run_gc(EngineState *s) {
 	memset(segcount, 0, sizeof(segcount));
 #endif
 
-	// Compute the set of all segments references currently in use.
-	AddrSet *activeRefs = findAllActiveReferences(s);
+	// Normalise the set of all references currently in use to the
+	// addresses the segments deallocate.
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+	AddrMarks activeRefs(heap);
+	for (Common::Array<reg_t>::const_iterator it = wm._found.begin(); it != wm._found.end(); ++it) {
+		SegmentObj *mobj = segMan->getSegmentObj(it->getSegment());
+		if (mobj)
+			activeRefs.mark(mobj->findCanonicAddress(segMan, *it));
+	}
+
+	uint32 freedObjects = 0;
+	uint32 freedBytes = 0;
 
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
-	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
 	for (uint seg = 1; seg < heap.size(); seg++) {
 		SegmentObj *mobj = heap[seg];
 
@@ -211,10 +326,15 @@ void run_gc(EngineState *s) {
 			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
 			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
 				const reg_t addr = *it;
-				if (!activeRefs->contains(addr)) {
+				if (!activeRefs.contains(addr)) {
 					// Not found -> we can free it
+					const uint32 size = mobj->getEntrySize(addr);
 					mobj->freeAtAddress(segMan, addr);
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+					if (size) {
+						freedObjects++;
+						freedBytes += size;
+					}
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
 #endif
@@ -224,7 +344,18 @@ void run_gc(EngineState *s) {
 		}
 	}
 
-	delete activeRefs;
+	const uint32 pause = g_system->getMillis() - startTime;
+	GCStatistics &stats = s->gcStats;
+	stats.collections++;
+	stats.lastPause = pause;
+	stats.maxPause = MAX(stats.maxPause, pause);
+	stats.totalPause += pause;
+	stats.lastReachable = wm._found.size();
+	stats.lastFreedObjects = freedObjects;
+	stats.lastFreedBytes = freedBytes;
+	stats.totalFreedObjects += freedObjects;
+	stats.totalFreedBytes += freedBytes;
+	debugC(kDebugLevelGC, "[GC] Freed %u objects (%u bytes) in %u ms", freedObjects, freedBytes, pause);
 
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
@@ -235,4 +366,102 @@ void run_gc(EngineState *s) {
 #endif
 }
 
+void run_gc(EngineState *s) {
+	const uint32 startTime = g_system->getMillis();
+
+	debugC(kDebugLevelGC, "[GC] Running...");
+	abort_gc(s);
+
+	// Compute the set of all segments references currently in use
+	WorklistManager wm(s->_segMan->getSegments());
+	findActiveReferences(s, wm);
+
+	GCStatistics &stats = s->gcStats;
+	stats.lastSteps = 0;
+	stats.lastStepTime = 0;
+	stats.lastRescanned = 0;
+	sweep(s, wm, startTime);
+}
+
+bool run_gc_step(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	GCWriteLog &log = segMan->getGCWriteLog();
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+	const uint32 startTime = g_system->getMillis();
+
+	// Restarting or restoring the game replaces the heap
+	if (s->gcCycle && !log.active)
+		abort_gc(s);
+
+	if (!s->gcCycle) {
+		debugC(kDebugLevelGC, "[GC] Starting incremental collection");
+		s->gcCycle = new GCCycle(heap);
+		log.active = true;
+		findRoots(s, s->gcCycle->_wm);
+	}
+
+	GCCycle &cycle = *s->gcCycle;
+	rescanWrites(segMan, cycle);
+	processWorkList(segMan, cycle._wm, heap, kGCStepSize);
+
+	if (!cycle._wm._worklist.empty()) {
+		const uint32 pause = g_system->getMillis() - startTime;
+		cycle._steps++;
+		cycle._stepTime += pause;
+		cycle._maxStepPause = MAX(cycle._maxStepPause, pause);
+		return false;
+	}
+
+	// Marking has caught up with the scripts. Anything they have done since
+	// it began is either on the roots or in the objects they wrote to since
+	// the last step, so looking at those again finds the rest.
+	debugC(kDebugLevelGC, "[GC] Finishing incremental collection after %u steps", cycle._steps);
+	findRoots(s, cycle._wm);
+	// Some engine code sets globals directly instead of through write_var()
+	segMan->noteWrite(make_reg(s->variablesSegment[VAR_GLOBAL], 0));
+	rescanWrites(segMan, cycle);
+	processWorkList(segMan, cycle._wm, heap);
+	if (g_sci->_gfxPorts)
+		g_sci->_gfxPorts->processEngineHunkList(cycle._wm);
+	log.active = false;
+
+	if (DebugMan.isDebugChannelEnabled(kDebugLevelGC)) {
+		// Check against a full mark, and keep whatever the write barrier
+		// has missed
+		WorklistManager full(heap);
+		findActiveReferences(s, full);
+		for (Common::Array<reg_t>::const_iterator it = full._found.begin(); it != full._found.end(); ++it) {
+			if (cycle._wm._marks.mark(*it)) {
+				warning("[GC] Incremental marking missed %04x:%04x", PRINT_REG(*it));
+				cycle._wm._found.push_back(*it);
+			}
+		}
+	}
+
+	GCStatistics &stats = s->gcStats;
+	stats.lastSteps = cycle._steps;
+	stats.lastStepTime = cycle._stepTime;
+	stats.maxStepPause = MAX(stats.maxStepPause, cycle._maxStepPause);
+	stats.lastRescanned = cycle._rescanned;
+	sweep(s, cycle._wm, startTime);
+
+	delete s->gcCycle;
+	s->gcCycle = NULL;
+	return true;
+}
+
+void abort_gc(EngineState *s) {
+	if (!s->gcCycle)
+		return;
+
+	debugC(kDebugLevelGC, "[GC] Abandoning incremental collection");
+	delete s->gcCycle;
+	s->gcCycle = NULL;
+
+	GCWriteLog &log = s->_segMan->getGCWriteLog();
+	log.active = false;
+	log.writes.clear();
+	log.newSegments.clear();
+}
+
 } // End of namespace Sci
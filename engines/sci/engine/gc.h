@@ -42,6 +42,41 @@ struct reg_t_Hash {
  */
 typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
 
+/**
+ * A set of addresses, kept as one bit per offset of each segment. This is
+ * much cheaper to fill and query than an AddrSet, which allocates a node
+ * for every address. The bits of each segment are allocated once, for the
+ * offsets the segment reports as valid. Addresses beyond these, which only
+ * garbage values point to, go to an AddrSet instead.
+ */
+class AddrMarks {
+public:
+	AddrMarks(const Common::Array<SegmentObj *> &heap);
+
+	/**
+	 * Adds an address to the set
+	 * @return false if the address was in the set already
+	 */
+	bool mark(reg_t addr);
+
+	bool contains(reg_t addr) const;
+
+	/**
+	 * Removes all addresses of a segment from the set, and makes room for
+	 * the offsets it reports as valid now. Used when a segment has been
+	 * allocated anew.
+	 */
+	void resetSegment(const Common::Array<SegmentObj *> &heap, SegmentId segment);
+
+private:
+	enum {
+		kMaxOffset = 1 << 20
+	};
+
+	Common::Array<Common::Array<uint32> > _bits;	// indexed by segment, then by offset / 32
+	AddrSet _overflow;
+};
+
 /**
  * Finds all used references and normalises them to their memory addresses
  * @param s The state to gather all information from
@@ -50,19 +85,52 @@ typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
 AddrSet *findAllActiveReferences(EngineState *s);
 
 /**
- * Runs garbage collection on the current system state
+ * Runs garbage collection on the current system state. This abandons an
+ * incremental collection in progress.
  * @param s The state in which we should gc
  */
 void run_gc(EngineState *s);
 
+/**
+ * Takes one step of an incremental garbage collection, starting one if none
+ * is in progress. Each step marks a bounded number of addresses, so that the
+ * scripts run in between steps; SegManager::noteWrite() records what they
+ * change meanwhile. The step which finds nothing left to mark looks at the
+ * roots and at the objects written since the step before again, and then
+ * sweeps.
+ * @param s The state in which we should gc
+ * @return true if the collection has finished
+ */
+bool run_gc_step(EngineState *s);
+
+/**
+ * Abandons the incremental garbage collection in progress, if any
+ * @param s The state in which we should gc
+ */
+void abort_gc(EngineState *s);
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
-	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
+	Common::Array<reg_t> _found;	// all addresses pushed so far, each one once
+	AddrMarks _marks;	// the addresses in _found, used by push()
+
+	WorklistManager(const Common::Array<SegmentObj *> &heap) : _marks(heap) {}
 
 	void push(reg_t reg);
 	void pushArray(const Common::Array<reg_t> &tmp);
 };
 
+/** The state an incremental garbage collection keeps in between its steps */
+struct GCCycle {
+	WorklistManager _wm;
+	uint32 _steps;
+	uint32 _stepTime; ///< In milliseconds
+	uint32 _maxStepPause; ///< In milliseconds
+	uint32 _rescanned; ///< Number of written objects looked at again
+
+	GCCycle(const Common::Array<SegmentObj *> &heap) : _wm(heap), _steps(0), _stepTime(0), _maxStepPause(0), _rescanned(0) {}
+};
+
 
 } // End of namespace Sci
 
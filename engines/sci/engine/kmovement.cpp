@@ -365,6 +365,7 @@ reg_t kDoBresen(EngineState *s, int argc, reg_t *argv) {
 			// We restore the backup of the client variables
 			for (uint i = 0; i < clientVarNum; ++i)
 				clientObject->getVariableRef(i) = clientBackup[i];
+			segMan->noteWrite(client);
 
 			mover_i1 = mover_org_i1;
 			mover_i2 = mover_org_i2;
@@ -73,6 +73,8 @@ void Script::freeScript(const bool keepLocalsSegment) {
 	_offsetLookupObjectCount = 0;
 	_offsetLookupStringCount = 0;
 	_offsetLookupSaidCount = 0;
+
+	freeDecodedInstructions();
 }
 
 enum {
@@ -705,6 +707,46 @@ bool Script::relocateLocal(SegmentId segment, int location, uint32 offset) {
 		return false;
 }
 
+const DecodedInstruction &Script::decodeInstruction(uint32 offset) {
+	assert(offset < getBufSize());
+
+	if (_decodedPages.empty())
+		_decodedPages.resize((getBufSize() + kDecodedPageSize - 1) >> kDecodedPageBits);
+
+	DecodedInstruction *&page = _decodedPages[offset >> kDecodedPageBits];
+	if (!page) {
+		page = new DecodedInstruction[kDecodedPageSize];
+		memset(page, 0, kDecodedPageSize * sizeof(DecodedInstruction));
+	}
+
+	DecodedInstruction &instruction = page[offset & (kDecodedPageSize - 1)];
+	instruction.size = readPMachineInstruction(getBuf(offset), instruction.extOpcode, instruction.opparams);
+	instruction.fusedSize = 0;
+
+	// Nearly every comparison is followed by a bt or bnt, so the VM runs
+	// both of them in one go
+	const byte opcode = instruction.extOpcode >> 1;
+	const uint32 nextOffset = offset + instruction.size;
+	if (opcode >= op_eq_ && opcode <= op_ule_ && nextOffset < getBufSize()) {
+		const byte nextOpcode = *getBuf(nextOffset) >> 1;
+		if (nextOpcode == op_bt || nextOpcode == op_bnt) {
+			byte extOpcode;
+			int16 opparams[4];
+			instruction.fusedOpcode = nextOpcode;
+			instruction.fusedSize = readPMachineInstruction(getBuf(nextOffset), extOpcode, opparams);
+			instruction.fusedOffset = opparams[0];
+		}
+	}
+
+	return instruction;
+}
+
+void Script::freeDecodedInstructions() {
+	for (uint i = 0; i < _decodedPages.size(); ++i)
+		delete[] _decodedPages[i];
+	_decodedPages.clear();
+}
+
 uint32 Script::getRelocationOffset(const uint32 offset) const {
 	if (getSciVersion() == SCI_VERSION_3) {
 		SciSpan<const byte> relocStart = _buf->subspan(_buf->getUint32SEAt(8));
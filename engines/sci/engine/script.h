@@ -69,6 +69,23 @@ struct offsetLookupArrayEntry {
 
 typedef Common::Array<offsetLookupArrayEntry> offsetLookupArrayType;
 
+/**
+ * An instruction of a script, as decoded by readPMachineInstruction(). The
+ * VM decodes every instruction once and then runs it from this form.
+ */
+struct DecodedInstruction {
+	int16 opparams[4];
+	uint16 size;       ///< Length of the instruction in bytes, 0 if not decoded yet
+	byte extOpcode;
+	/**
+	 * If the instruction is a comparison directly followed by a bt or bnt,
+	 * the branch is run together with it: its opcode, length and offset.
+	 */
+	byte fusedOpcode;
+	byte fusedSize;    ///< 0 if the instruction is not fused
+	int16 fusedOffset;
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -94,6 +111,17 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	enum {
+		kDecodedPageBits = 8,
+		kDecodedPageSize = 1 << kDecodedPageBits
+	};
+
+	/**
+	 * Decoded instructions, in pages of kDecodedPageSize buffer offsets which
+	 * are only allocated once code in them runs.
+	 */
+	Common::Array<DecodedInstruction *> _decodedPages;
+
 protected:
 	offsetLookupArrayType _offsetLookupArray; // Table of all elements of currently loaded script, that may get pointed to
 
@@ -128,6 +156,20 @@ public:
 	const ObjMap &getObjectMap() const { return _objects; }
 	bool offsetIsObject(uint32 offset) const;
 
+	/**
+	 * Returns the instruction at the given offset of the buffer, decoding
+	 * it the first time it is asked for.
+	 */
+	const DecodedInstruction &getDecodedInstruction(uint32 offset) {
+		const uint32 page = offset >> kDecodedPageBits;
+		if (page < _decodedPages.size() && _decodedPages[page]) {
+			const DecodedInstruction &instruction = _decodedPages[page][offset & (kDecodedPageSize - 1)];
+			if (instruction.size)
+				return instruction;
+		}
+		return decodeInstruction(offset);
+	}
+
 public:
 	Script();
 	~Script() override;
@@ -136,9 +178,11 @@ public:
 	void load(int script_nr, ResourceManager *resMan, ScriptPatcher *scriptPatcher, bool applyScriptPatches = true);
 
 	bool isValidOffset(uint32 offset) const override;
+	uint32 getOffsetLimit() const override { return getBufSize(); }
 	SegmentRef dereference(reg_t pointer) override;
 	reg_t findCanonicAddress(SegManager *segMan, reg_t sub_addr) const override;
 	void freeAtAddress(SegManager *segMan, reg_t sub_addr) override;
+	uint32 getEntrySize(reg_t sub_addr) const override { return _markedAsDeleted ? getBufSize() : 0; }
 	Common::Array<reg_t> listAllDeallocatable(SegmentId segId) const override;
 	Common::Array<reg_t> listAllOutgoingReferences(reg_t object) const override;
 
@@ -321,6 +365,12 @@ private:
 
 	bool relocateLocal(SegmentId segment, int location, uint32 offset);
 
+	/** Decodes the instruction at the given offset into its page. */
+	const DecodedInstruction &decodeInstruction(uint32 offset);
+
+	/** Frees the decoded instructions. */
+	void freeDecodedInstructions();
+
 #ifdef ENABLE_SCI32
 	/**
 	 * Gets a pointer to the beginning of the objects in a SCI3 script
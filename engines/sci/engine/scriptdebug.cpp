@@ -81,6 +81,16 @@ void DebugState::updateActiveBreakpointTypes() {
 	_activeBreakpointTypes = type;
 }
 
+void VmProfile::reset() {
+	memset(opcodeCounts, 0, sizeof(opcodeCounts));
+	memset(opcodeTimes, 0, sizeof(opcodeTimes));
+	methods.clear();
+	lastOpcode = -1;
+	lastMethod = NULL;
+	lastMillis = 0;
+	++generation;
+}
+
 // Disassembles one command from the heap, returns address of next command or 0 if a ret was encountered.
 reg_t disassemble(EngineState *s, reg_t pos, const Object *obj, bool printBWTag, bool printBytecode, bool printCSyntax) {
 	SegmentObj *mobj = s->_segMan->getSegment(pos.getSegment(), SEG_TYPE_SCRIPT);
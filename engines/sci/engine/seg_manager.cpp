@@ -35,6 +35,8 @@ SegManager::SegManager(ResourceManager *resMan, ScriptPatcher *scriptPatcher)
 	: _resMan(resMan), _scriptPatcher(scriptPatcher) {
 	_heap.push_back(0);
 
+	_gcLog.active = false;
+
 	_clonesSegId = 0;
 	_listsSegId = 0;
 	_nodesSegId = 0;
@@ -67,6 +69,11 @@ void SegManager::resetSegMan() {
 	// And reinitialize
 	_heap.push_back(0);
 
+	// A garbage collection in progress can't carry on over a new heap
+	_gcLog.active = false;
+	_gcLog.writes.clear();
+	_gcLog.newSegments.clear();
+
 	_clonesSegId = 0;
 	_listsSegId = 0;
 	_nodesSegId = 0;
@@ -126,6 +133,9 @@ SegmentObj *SegManager::allocSegment(SegmentObj *mem, SegmentId *segid) {
 	}
 	_heap[id] = mem;
 
+	if (_gcLog.active)
+		_gcLog.newSegments.push_back(id);
+
 	return mem;
 }
 
@@ -440,6 +450,7 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_clonesSegId, offset);
+	noteWrite(*addr);
 	return &table->at(offset);
 }
 
@@ -454,6 +465,7 @@ List *SegManager::allocateList(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_listsSegId, offset);
+	noteWrite(*addr);
 	return &table->at(offset);
 }
 
@@ -468,6 +480,7 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_nodesSegId, offset);
+	noteWrite(*addr);
 	return &table->at(offset);
 }
 
@@ -494,6 +507,8 @@ List *SegManager::lookupList(reg_t addr) {
 		return NULL;
 	}
 
+	// The caller may change the list through the pointer
+	noteWrite(addr);
 	return &(lt[addr.getOffset()]);
 }
 
@@ -518,6 +533,8 @@ Node *SegManager::lookupNode(reg_t addr, bool stopOnDiscarded) {
 		return NULL;
 	}
 
+	// The caller may change the node through the pointer
+	noteWrite(addr);
 	return &(nt[addr.getOffset()]);
 }
 
@@ -531,7 +548,11 @@ SegmentRef SegManager::dereference(reg_t pointer) {
 	}
 
 	SegmentObj *mobj = _heap[pointer.getSegment()];
-	return mobj->dereference(pointer);
+	ret = mobj->dereference(pointer);
+	// References can only be written through reg_t based memory
+	if (!ret.isRaw)
+		noteWrite(pointer);
+	return ret;
 }
 
 static void *derefPtr(SegManager *segMan, reg_t pointer, int entries, bool wantRaw) {
@@ -895,6 +916,7 @@ SciArray *SegManager::allocateArray(SciArrayType type, uint16 size, reg_t *addr)
 	offset = table->allocEntry();
 
 	*addr = make_reg(_arraysSegId, offset);
+	noteWrite(*addr);
 
 	SciArray *array = &table->at(offset);
 	array->setType(type);
@@ -911,6 +933,7 @@ SciArray *SegManager::lookupArray(reg_t addr) {
 	if (!arrayTable.isValidEntry(addr.getOffset()))
 		error("Attempt to use non-array %04x:%04x as array", PRINT_REG(addr));
 
+	noteWrite(addr);
 	return &(arrayTable[addr.getOffset()]);
 }
 
@@ -1050,6 +1073,14 @@ int SegManager::instantiateScript(int scriptNum, bool applyScriptPatches) {
 	g_sci->_guestAdditions->instantiateScriptHook(*scr);
 #endif
 
+	// The segment may be one a garbage collection has marked already, when
+	// the script was reloaded into it
+	if (_gcLog.active) {
+		const Common::Array<reg_t> objects = scr->listObjectReferences();
+		for (Common::Array<reg_t>::const_iterator it = objects.begin(); it != objects.end(); ++it)
+			noteWrite(*it);
+	}
+
 	return segmentId;
 }
 
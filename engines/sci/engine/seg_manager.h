@@ -46,6 +46,17 @@ enum ScriptLoadType {
 
 class Script;
 
+/**
+ * The changes to the heap made while an incremental garbage collection is
+ * marking, which the collection has to look at again before it sweeps. See
+ * run_gc_step().
+ */
+struct GCWriteLog {
+	bool active; ///< Set while a collection is marking
+	Common::Array<reg_t> writes; ///< Objects, lists, nodes, arrays and variable blocks written to
+	Common::Array<SegmentId> newSegments; ///< Segments allocated since marking began
+};
+
 class SegManager : public Common::Serializable {
 	friend class Console;
 public:
@@ -458,6 +469,19 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Records that a reference may have been stored in the object, list,
+	 * node, array or variable block at the given address. This is the write
+	 * barrier of incremental garbage collection, and does nothing unless a
+	 * collection is marking.
+	 */
+	void noteWrite(reg_t addr) {
+		if (_gcLog.active && (_gcLog.writes.empty() || _gcLog.writes.back() != addr))
+			_gcLog.writes.push_back(addr);
+	}
+
+	GCWriteLog &getGCWriteLog() { return _gcLog; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -467,6 +491,8 @@ private:
 	ResourceManager *_resMan;
 	ScriptPatcher *_scriptPatcher;
 
+	GCWriteLog _gcLog;
+
 	SegmentId _clonesSegId; ///< ID of the (a) clones segment
 	SegmentId _listsSegId; ///< ID of the (a) list segment
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
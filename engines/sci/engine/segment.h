@@ -98,6 +98,12 @@ public:
 	 */
 	virtual bool isValidOffset(uint32 offset) const = 0;
 
+	/**
+	 * Returns an upper bound of the offsets isValidOffset() accepts, or 0 if
+	 * there is none. Used by the garbage collector to size its mark bits.
+	 */
+	virtual uint32 getOffsetLimit() const { return 0; }
+
 	/**
 	 * Dereferences a raw memory pointer.
 	 * @param reg	reference to dereference
@@ -123,6 +129,13 @@ public:
 	 */
 	virtual void freeAtAddress(SegManager *segMan, reg_t sub_addr) {}
 
+	/**
+	 * Returns the number of bytes freeAtAddress() would release for the
+	 * specified address, or 0 if it would not release anything.
+	 * Used by the garbage collector to report the memory it reclaims.
+	 */
+	virtual uint32 getEntrySize(reg_t sub_addr) const { return 0; }
+
 	/**
 	 * Iterates over and reports all addresses within the segment.
 	 * Used by the garbage collector.
@@ -155,6 +168,7 @@ public:
 	bool isValidOffset(uint32 offset) const override {
 		return offset < _locals.size() * 2;
 	}
+	uint32 getOffsetLimit() const override { return _locals.size() * 2; }
 	SegmentRef dereference(reg_t pointer) override;
 	reg_t findCanonicAddress(SegManager *segMan, reg_t sub_addr) const override;
 	Common::Array<reg_t> listAllOutgoingReferences(reg_t object) const override;
@@ -177,6 +191,7 @@ public:
 	bool isValidOffset(uint32 offset) const override {
 		return offset < _capacity * 2;
 	}
+	uint32 getOffsetLimit() const override { return _capacity * 2; }
 	SegmentRef dereference(reg_t pointer) override;
 	reg_t findCanonicAddress(SegManager *segMan, reg_t addr) const override {
 		return make_reg(addr.getSegment(), 0);
@@ -282,6 +297,7 @@ public:
 	bool isValidOffset(uint32 offset) const override {
 		return isValidEntry(offset);
 	}
+	uint32 getOffsetLimit() const override { return _table.size(); }
 
 	bool isValidEntry(int idx) const {
 		return idx >= 0 && (uint)idx < _table.size() && _table[idx].next_free == idx;
@@ -323,6 +339,10 @@ struct CloneTable : public SegmentObjTable<Clone> {
 	void freeAtAddress(SegManager *segMan, reg_t sub_addr) override;
 	Common::Array<reg_t> listAllOutgoingReferences(reg_t object) const override;
 
+	uint32 getEntrySize(reg_t sub_addr) const override {
+		return sizeof(Clone) + at(sub_addr.getOffset()).getVarCount() * sizeof(reg_t);
+	}
+
 	void saveLoadWithSerializer(Common::Serializer &ser) override;
 };
 
@@ -334,6 +354,9 @@ struct NodeTable : public SegmentObjTable<Node> {
 	void freeAtAddress(SegManager *segMan, reg_t sub_addr) override {
 		freeEntry(sub_addr.getOffset());
 	}
+	uint32 getEntrySize(reg_t sub_addr) const override {
+		return sizeof(Node);
+	}
 	Common::Array<reg_t> listAllOutgoingReferences(reg_t object) const override;
 
 	void saveLoadWithSerializer(Common::Serializer &ser) override;
@@ -347,6 +370,9 @@ struct ListTable : public SegmentObjTable<List> {
 	void freeAtAddress(SegManager *segMan, reg_t sub_addr) override {
 		freeEntry(sub_addr.getOffset());
 	}
+	uint32 getEntrySize(reg_t sub_addr) const override {
+		return sizeof(List);
+	}
 	Common::Array<reg_t> listAllOutgoingReferences(reg_t object) const override;
 
 	void saveLoadWithSerializer(Common::Serializer &ser) override;
@@ -377,6 +403,10 @@ struct HunkTable : public SegmentObjTable<Hunk> {
 		freeEntry(sub_addr.getOffset());
 	}
 
+	uint32 getEntrySize(reg_t sub_addr) const override {
+		return sizeof(Hunk) + at(sub_addr.getOffset()).size;
+	}
+
 	void saveLoadWithSerializer(Common::Serializer &ser) override;
 };
 
@@ -397,6 +427,7 @@ public:
 	bool isValidOffset(uint32 offset) const override {
 		return offset < _size;
 	}
+	uint32 getOffsetLimit() const override { return _size; }
 	SegmentRef dereference(reg_t pointer) override;
 	reg_t findCanonicAddress(SegManager *segMan, reg_t addr) const override {
 		return make_reg(addr.getSegment(), 0);
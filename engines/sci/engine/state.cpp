@@ -24,6 +24,7 @@
 #include "sci/sci.h"	// for INCLUDE_OLDGFX
 #include "sci/debug.h"	// for g_debug_sleeptime_factor
 #include "sci/engine/file.h"
+#include "sci/engine/gc.h"
 #include "sci/engine/guest_additions.h"
 #include "sci/engine/kernel.h"
 #include "sci/engine/state.h"
@@ -68,13 +69,15 @@ static const uint16 s_halfWidthSJISMap[256] = {
 
 EngineState::EngineState(SegManager *segMan)
 : _segMan(segMan),
-	_dirseeker() {
+	_dirseeker(),
+	gcCycle(NULL) {
 
 	reset(false);
 }
 
 EngineState::~EngineState() {
 	delete _msgState;
+	delete gcCycle;
 }
 
 void EngineState::reset(bool isRestoring) {
@@ -103,6 +106,8 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	abort_gc(this);
+	memset(&gcStats, 0, sizeof(gcStats));
 
 #ifdef ENABLE_SCI32
 	_eventCounter = 0;
@@ -120,6 +125,7 @@ void EngineState::reset(bool isRestoring) {
 
 	scriptStepCounter = 0;
 	scriptGCInterval = GC_INTERVAL;
+	gcIncremental = true;
 }
 
 void EngineState::speedThrottler(uint32 neededSleep) {
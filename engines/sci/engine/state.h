@@ -45,6 +45,7 @@ namespace Sci {
 
 class FileHandle;
 class DirSeeker;
+struct GCCycle;
 class EventManager;
 class MessageState;
 class SoundCommandParser;
@@ -98,6 +99,27 @@ struct SciCallOrigin {
 	}
 };
 
+/**
+ * Statistics of the garbage collector, shown by the gc_stats console command.
+ * The pauses of an incremental collection are those of its last step, which
+ * finishes marking and sweeps.
+ */
+struct GCStatistics {
+	uint32 collections;
+	uint32 lastPause;  ///< In milliseconds
+	uint32 maxPause;   ///< In milliseconds
+	uint32 totalPause; ///< In milliseconds
+	uint32 lastSteps;  ///< Marking steps taken by the last collection
+	uint32 lastStepTime; ///< In milliseconds, for all marking steps of the last collection
+	uint32 maxStepPause; ///< In milliseconds
+	uint32 lastRescanned; ///< Number of written objects the last collection looked at again
+	uint32 lastReachable; ///< Number of addresses the last collection found in use
+	uint32 lastFreedObjects;
+	uint32 lastFreedBytes;
+	uint32 totalFreedObjects;
+	uint64 totalFreedBytes;
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -194,6 +216,9 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	bool gcIncremental; /**< Spread marking over the kernel calls following gcCountDown running out */
+	GCCycle *gcCycle; /**< The incremental collection in progress, if any */
+	GCStatistics gcStats;
 
 	MessageState *_msgState;
 
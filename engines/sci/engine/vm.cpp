@@ -23,6 +23,7 @@
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/debug-channels.h"
+#include "common/system.h"
 
 #include "sci/sci.h"
 #include "sci/console.h"
@@ -189,6 +190,7 @@ static void write_var(EngineState *s, int type, int index, reg_t value) {
 				if (lookupSelector(s->_segMan, stopGroopPos, SELECTOR(client), &varp, NULL) == kSelectorVariable) {
 					reg_t *clientVar = varp.getPointer(s->_segMan);
 					*clientVar = value;
+					s->_segMan->noteWrite(stopGroopPos);
 				}
 			}
 		}
@@ -201,6 +203,8 @@ static void write_var(EngineState *s, int type, int index, reg_t value) {
 			value.setSegment(0);
 
 		s->variables[type][index] = value;
+		if (type == VAR_GLOBAL || type == VAR_LOCAL)
+			s->_segMan->noteWrite(make_reg(s->variablesSegment[type], 0));
 
 		g_sci->_guestAdditions->writeVarHook(type, index, value);
 	}
@@ -250,6 +254,7 @@ static void _exec_varselectors(EngineState *s) {
 			// varselector access?
 			if (xs.argc) { // write?
 				*var = xs.variables_argp[1];
+				s->_segMan->noteWrite(xs.addr.varp.obj);
 
 #ifdef ENABLE_SCI32
 				updateInfoFlagViewVisible(s->_segMan->getObject(xs.addr.varp.obj), xs.addr.varp.varindex);
@@ -570,6 +575,64 @@ uint32 findOffset(const int16 relOffset, const Script *scr, const uint32 pcOffse
 	return offset;
 }
 
+static VmProfileMethod *findProfileMethod(EngineState *s, VmProfile &profile, Script *scr) {
+	const ExecStack &call = *s->xs;
+	const VmProfileMethodKey key = { scr->getScriptNumber(), call.debugSelector, call.debugExportId, call.debugLocalCallOffset };
+
+	Common::HashMap<VmProfileMethodKey, VmProfileMethod, VmProfileMethodKeyHash>::iterator it = profile.methods.find(key);
+	if (it != profile.methods.end())
+		return &it->_value;
+
+	VmProfileMethod &method = profile.methods[key];
+	if (call.debugSelector != -1)
+		method.name = Common::String::format("script %d - %s::%s", key.scriptNumber, s->_segMan->getObjectName(call.sendp),
+			g_sci->getKernel()->getSelectorName(call.debugSelector).c_str());
+	else if (call.debugExportId != -1)
+		method.name = Common::String::format("script %d - export %d", key.scriptNumber, call.debugExportId);
+	else
+		method.name = Common::String::format("script %d - call %x", key.scriptNumber, call.debugLocalCallOffset);
+	method.instructions = 0;
+	method.time = 0;
+	return &method;
+}
+
+// Counts the instruction about to run, and charges the time since the last
+// one to the last one
+static void profileInstruction(VmProfile &profile, VmProfileMethod *method, byte opcode) {
+	const uint32 now = g_system->getMillis();
+	if (profile.lastOpcode != -1) {
+		const uint32 elapsed = now - profile.lastMillis;
+		profile.opcodeTimes[profile.lastOpcode] += elapsed;
+		if (profile.lastMethod)
+			profile.lastMethod->time += elapsed;
+	}
+
+	profile.lastOpcode = opcode;
+	profile.lastMethod = method;
+	profile.lastMillis = now;
+	++profile.opcodeCounts[opcode];
+	++method->instructions;
+}
+
+/**
+ * The checks run before every instruction, including a bt or bnt fused with
+ * the comparison before it.
+ */
+static void checkInstructionState(EngineState *s, const Script *scr) {
+	Console *con = g_sci->getSciDebugger();
+	con->onFrame();
+
+	if (s->xs->sp < s->xs->fp)
+		error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
+		PRINT_REG(*s->xs->sp), PRINT_REG(*s->xs->fp));
+
+	s->variablesMax[VAR_TEMP] = s->xs->sp - s->xs->fp;
+
+	if (s->xs->addr.pc.getOffset() >= scr->getBufSize())
+		error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
+		s->xs->addr.pc.getOffset(), scr->getBufSize());
+}
+
 void run_vm(EngineState *s) {
 	assert(s);
 
@@ -579,6 +642,9 @@ void run_vm(EngineState *s) {
 	int16 opparams[4]; // opcode parameters
 
 	VmHooks vmHooks;
+	VmProfile &profile = g_sci->_debugState._profile;
+	VmProfileMethod *profileMethod = NULL; // Looked up when needed, as the method changes
+	uint32 profileGeneration = 0;
 
 	s->r_rest = 0;	// &rest adjusts the parameter count by this value
 	// Current execution data:
@@ -595,6 +661,11 @@ void run_vm(EngineState *s) {
 
 	s->executionStackBase = s->_executionStack.size() - 1;
 
+	// Don't charge the time spent outside of the VM to the instruction
+	// which returned to it last
+	if (!s->executionStackBase)
+		profile.lastOpcode = -1;
+
 	s->variablesSegment[VAR_TEMP] = s->variablesSegment[VAR_PARAM] = s->_segMan->findSegmentByType(SEG_TYPE_STACK);
 	s->variablesBase[VAR_TEMP] = s->variablesBase[VAR_PARAM] = s->stack_base;
 
@@ -622,6 +693,7 @@ void run_vm(EngineState *s) {
 				error("No script in segment %d",  s->xs->addr.pc.getSegment());
 			s->xs = &(s->_executionStack.back());
 			s->_executionStackPosChanged = false;
+			profileMethod = NULL;
 
 			obj = s->_segMan->getObject(s->xs->objp);
 			local_script = s->_segMan->getScriptIfLoaded(s->xs->local_segment);
@@ -649,28 +721,41 @@ void run_vm(EngineState *s) {
 			g_sci->scriptDebug();
 			g_sci->_debugState.breakpointWasHit = false;
 		}
-		Console *con = g_sci->getSciDebugger();
-		con->onFrame();
-
-		if (s->xs->sp < s->xs->fp)
-			error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
-			PRINT_REG(*s->xs->sp), PRINT_REG(*s->xs->fp));
-
-		s->variablesMax[VAR_TEMP] = s->xs->sp - s->xs->fp;
-
-		if (s->xs->addr.pc.getOffset() >= scr->getBufSize())
-			error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
-			s->xs->addr.pc.getOffset(), scr->getBufSize());
+		checkInstructionState(s, scr);
 
 		// Get opcode
 		byte extOpcode;
-		if (!vmHooks.isActive())
-			s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
-		else {
+		byte fusedOpcode = 0;
+		byte fusedSize = 0;
+		int16 fusedOffset = 0;
+		if (!vmHooks.isActive()) {
+			const DecodedInstruction &instruction = scr->getDecodedInstruction(s->xs->addr.pc.getOffset());
+			extOpcode = instruction.extOpcode;
+			memcpy(opparams, instruction.opparams, sizeof(opparams));
+			s->xs->addr.pc.incOffset(instruction.size);
+
+			// A fused branch skips the checks above, so it must not run when
+			// they could stop at it: when debugging, with address breakpoints,
+			// or with hooks which may patch it
+			if (instruction.fusedSize && !g_sci->_debugState.debugging &&
+				!(g_sci->_debugState._activeBreakpointTypes & BREAK_ADDRESS) && !vmHooks.hasHooks()) {
+				fusedOpcode = instruction.fusedOpcode;
+				fusedSize = instruction.fusedSize;
+				fusedOffset = instruction.fusedOffset;
+			}
+		} else {
 			int offset = readPMachineInstruction(vmHooks.data(), extOpcode, opparams);
 			vmHooks.advance(offset);
 		}
 		const byte opcode = extOpcode >> 1;
+
+		if (profile.enabled) {
+			if (!profileMethod || profileGeneration != profile.generation) {
+				profileMethod = findProfileMethod(s, profile, scr);
+				profileGeneration = profile.generation;
+			}
+			profileInstruction(profile, profileMethod, opcode);
+		}
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
 #ifdef ABORT_ON_INFINITE_LOOP
@@ -906,10 +991,17 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
+			// Run the garbage collector, if needed. An incremental collection
+			// takes a step on each kernel call from the outermost run_vm()
+			// until it has finished; kernel functions which run scripts
+			// through invokeSelector() may still be changing the heap.
+			if (s->gcCountDown > 0) {
+				s->gcCountDown--;
+			} else if (!s->gcIncremental) {
 				s->gcCountDown = s->scriptGCInterval;
 				run_gc(s);
+			} else if (!s->executionStackBase && run_gc_step(s)) {
+				s->gcCountDown = s->scriptGCInterval;
 			}
 
 			// Call kernel function
@@ -991,6 +1083,7 @@ void run_vm(EngineState *s) {
 					reg_t *var = old_xs->getVarPointer(s->_segMan);
 					if (old_xs->argc) { // write?
 						*var = old_xs->variables_argp[1];
+						s->_segMan->noteWrite(old_xs->addr.varp.obj);
 
 #ifdef ENABLE_SCI32
 						updateInfoFlagViewVisible(s->_segMan->getObject(old_xs->addr.varp.obj), old_xs->addr.varp.varindex);
@@ -1177,6 +1270,7 @@ void run_vm(EngineState *s) {
 			}
 
 			opProperty = s->r_acc;
+			s->_segMan->noteWrite(s->xs->objp);
 #ifdef ENABLE_SCI32
 			updateInfoFlagViewVisible(obj, opparams[0], true);
 #endif
@@ -1207,6 +1301,7 @@ void run_vm(EngineState *s) {
 				                    s->_segMan, BREAK_SELECTORWRITE);
 			}
 			opProperty = newValue;
+			s->_segMan->noteWrite(s->xs->objp);
 #ifdef ENABLE_SCI32
 			updateInfoFlagViewVisible(obj, opparams[0], true);
 #endif
@@ -1233,6 +1328,7 @@ void run_vm(EngineState *s) {
 				opProperty += 1;
 			else
 				opProperty -= 1;
+			s->_segMan->noteWrite(s->xs->objp);
 
 			if (g_sci->_debugState._activeBreakpointTypes & BREAK_SELECTORWRITE) {
 				debugPropertyAccess(obj, s->xs->objp, opparams[0], NULL_SELECTOR,
@@ -1443,6 +1539,36 @@ void run_vm(EngineState *s) {
 
 		} // switch (opcode)
 
+		if (fusedSize) {
+			// Run the bt or bnt following the comparison, after the checks
+			// done at the start of the loop. A comparison can't change the
+			// execution stack, and the debugger, address breakpoints and
+			// hooks rule out fusing.
+			++s->scriptStepCounter;
+			g_sci->_debugState.old_pc_offset = s->xs->addr.pc.getOffset();
+			g_sci->_debugState.old_sp = s->xs->sp;
+			if (s->abortScriptProcessing != kAbortNone)
+				return; // Stop processing
+			checkInstructionState(s, scr);
+
+			s->xs->addr.pc.incOffset(fusedSize);
+			if ((fusedOpcode == op_bt) == (s->r_acc.getOffset() || s->r_acc.getSegment()))
+				s->xs->addr.pc.incOffset(fusedOffset);
+
+			if (s->xs->addr.pc.getOffset() >= local_script->getScriptSize())
+				error("[VM] %s: request to jump past the end of script %d (offset %d, script is %d bytes)",
+					fusedOpcode == op_bt ? "op_bt" : "op_bnt",
+					local_script->getScriptNumber(), s->xs->addr.pc.getOffset(), local_script->getScriptSize());
+
+			if (profile.enabled) {
+				++profile.opcodeCounts[fusedOpcode];
+				++profileMethod->instructions;
+			}
+#ifdef ABORT_ON_INFINITE_LOOP
+			prevOpcode = fusedOpcode;
+#endif
+		}
+
 		if (s->_executionStackPosChanged) // Force initialization
 			s->xs = xs_new;
 
@@ -122,6 +122,10 @@ bool hook_exec_match(Sci::EngineState *s, HookEntry entry) {
 
 
 void VmHooks::vm_hook_before_exec(Sci::EngineState *s) {
+	// Most games have no hooks, don't look up the script for every opcode
+	if (_hooksMap.empty())
+		return;
+
 	Script *scr = s->_segMan->getScript(s->xs->addr.pc.getSegment());
 	int scriptNumber = scr->getScriptNumber();
 	HookHashKey key = { scriptNumber, s->xs->addr.pc.getOffset() };
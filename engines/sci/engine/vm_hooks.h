@@ -82,6 +82,9 @@ public:
 
 	bool isActive();
 
+	/** Returns true if the game has any hooks */
+	bool hasHooks() const { return !_hooksMap.empty(); }
+
 	void advance(int offset);
 
 private:
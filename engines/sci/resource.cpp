@@ -22,9 +22,11 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 #ifdef ENABLE_SCI32
@@ -211,6 +213,7 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : SciSpan<const byte>
 	_fileOffset = 0;
 	_status = kResStatusNoMalloc;
 	_lockers = 0;
+	_lruClass = kResLRUSmall;
 	_source = nullptr;
 	_header = nullptr;
 	_headerSize = 0;
@@ -980,7 +983,11 @@ void ResourceManager::init() {
 	_maxMemoryLRU = 256 * 1024; // 256KiB
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	for (int i = 0; i < kResLRUClassCount; i++) {
+		_memoryLRUClass[i] = 0;
+		_LRU[i].clear();
+	}
+	resetCacheStats();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 #ifdef ENABLE_SCI32
@@ -1100,8 +1107,9 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+	_LRU[res->_lruClass].erase(res->_lruPosition);
 	_memoryLRU -= res->size();
+	_memoryLRUClass[res->_lruClass] -= res->size();
 	res->_status = kResStatusAllocated;
 }
 
@@ -1110,8 +1118,11 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+	res->_lruClass = ((int)res->size() > _maxMemoryLRU / 8) ? kResLRULarge : kResLRUSmall;
+	_LRU[res->_lruClass].push_front(res);
+	res->_lruPosition = _LRU[res->_lruClass].begin();
 	_memoryLRU += res->size();
+	_memoryLRUClass[res->_lruClass] += res->size();
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s (%d bytes) to lru control: %d bytes total",
 	      res->_id.toString().c_str(), res->size,
@@ -1123,15 +1134,18 @@ void ResourceManager::addToLRU(Resource *res) {
 void ResourceManager::printLRU() {
 	int mem = 0;
 	int entries = 0;
-	Common::List<Resource *>::iterator it = _LRU.begin();
-	Resource *res;
-
-	while (it != _LRU.end()) {
-		res = *it;
-		debug("\t%s: %u bytes", res->_id.toString().c_str(), res->size());
-		mem += res->size();
-		++entries;
-		++it;
+
+	for (int i = 0; i < kResLRUClassCount; i++) {
+		Common::List<Resource *>::iterator it = _LRU[i].begin();
+		Resource *res;
+
+		while (it != _LRU[i].end()) {
+			res = *it;
+			debug("\t%s: %u bytes", res->_id.toString().c_str(), res->size());
+			mem += res->size();
+			++entries;
+			++it;
+		}
 	}
 
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
@@ -1139,9 +1153,17 @@ void ResourceManager::printLRU() {
 
 void ResourceManager::freeOldResources() {
 	while (_maxMemoryLRU < _memoryLRU) {
-		assert(!_LRU.empty());
-		Resource *goner = _LRU.back();
+		// Large resources may use half of the cache, and whatever the small
+		// ones leave over. Past that, the least recently used large resource
+		// goes first, so that loading a few pictures doesn't flush all the
+		// small resources which are used all the time.
+		int goners = kResLRUSmall;
+		if (_LRU[kResLRUSmall].empty() || _memoryLRUClass[kResLRULarge] > _maxMemoryLRU / 2)
+			goners = kResLRULarge;
+		assert(!_LRU[goners].empty());
+		Resource *goner = _LRU[goners].back();
 		removeFromLRU(goner);
+		_cacheStats[goner->getType()].evictions++;
 		goner->unalloc();
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s (%d bytes)", goner->_id.toString().c_str(), goner->size);
@@ -1149,6 +1171,10 @@ void ResourceManager::freeOldResources() {
 	}
 }
 
+void ResourceManager::resetCacheStats() {
+	memset(_cacheStats, 0, sizeof(_cacheStats));
+}
+
 Common::List<ResourceId> ResourceManager::listResources(ResourceType type, int mapNumber) {
 	Common::List<ResourceId> resources;
 
@@ -1185,9 +1211,17 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	ResourceCacheStats &stats = _cacheStats[retval->getType()];
+	if (retval->_status == kResStatusNoMalloc) {
+		stats.misses++;
+		const uint32 startTime = g_system->getMillis();
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
+		stats.missMillis += g_system->getMillis() - startTime;
+	} else {
+		stats.hits++;
+	}
+
+	if (retval->_status == kResStatusEnqueued)
 		// The resource is removed from its current position
 		// in the LRU list because it has been requested
 		// again. Below, it will either be locked, or it
@@ -79,6 +79,25 @@ enum {
 	MAX_OPENED_VOLUMES = 5 ///< Max number of simultaneously opened volumes
 };
 
+/**
+ * Size classes of the LRU resource cache. Resources larger than an eighth of
+ * the cache go into their own list, so that a few big pictures or sounds
+ * can't flush all the small scripts, heaps and palettes out of the cache.
+ */
+enum ResourceLRUClass {
+	kResLRUSmall = 0,
+	kResLRULarge,
+	kResLRUClassCount
+};
+
+/** Counters of the resource cache, for one resource type */
+struct ResourceCacheStats {
+	uint32 hits;         ///< Requests for resources that were already loaded
+	uint32 misses;       ///< Requests that had to load the resource
+	uint32 missMillis;   ///< Time spent loading resources on a miss
+	uint32 evictions;    ///< Resources freed to stay within the cache size
+};
+
 enum ResourceType {
 	kResourceTypeView = 0,
 	kResourceTypePic,
@@ -298,6 +317,8 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	ResourceLRUClass _lruClass; /**< LRU list of the resource, while enqueued */
+	Common::List<Resource *>::iterator _lruPosition; /**< Position in that list, while enqueued */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -396,6 +417,19 @@ public:
 	 */
 	bool hasResourceType(ResourceType type);
 
+	/**
+	 * Returns the counters of the resource cache for a resource type.
+	 */
+	const ResourceCacheStats &getCacheStats(ResourceType type) const { return _cacheStats[type]; }
+	void resetCacheStats();
+
+	/**
+	 * Returns the number of resource bytes in one size class of the LRU
+	 * cache, and how many of them the whole cache may hold.
+	 */
+	int getLRUMemory(ResourceLRUClass lruClass) const { return _memoryLRUClass[lruClass]; }
+	int getMaxLRUMemory() const { return _maxMemoryLRU; }
+
 	void setAudioLanguage(int language);
 	int getAudioLanguage() const;
 	void changeAudioDirectory(Common::String path);
@@ -487,7 +521,9 @@ protected:
 	SourcesList _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _memoryLRUClass[kResLRUClassCount]; ///< Amount of those bytes in each size class
+	Common::List<Resource *> _LRU[kResLRUClassCount]; ///< Last Resource Used lists, one per size class
+	ResourceCacheStats _cacheStats[kResourceTypeInvalid + 1];
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -79,6 +79,7 @@ static char s_fallbackFileNameBuffer[51];
 class SludgeMetaEngine : public AdvancedMetaEngine {
 public:
 	SludgeMetaEngine() : AdvancedMetaEngine(Sludge::gameDescriptions, sizeof(Sludge::SludgeGameDescription), sludgeGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_maxScanDepth = 1;
 	}
 
@@ -84,6 +84,7 @@ static const PlainGameDescriptor tinselGames[] = {
 class TinselMetaEngine : public AdvancedMetaEngine {
 public:
 	TinselMetaEngine() : AdvancedMetaEngine(Tinsel::gameDescriptions, sizeof(Tinsel::TinselGameDescription), tinselGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 	}
 
 	const char *getEngineId() const  override{
@@ -137,6 +137,7 @@ static const char * const directoryGlobs[] = {
 class ToonMetaEngine : public AdvancedMetaEngine {
 public:
 	ToonMetaEngine() : AdvancedMetaEngine(Toon::gameDescriptions, sizeof(ADGameDescription), toonGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_maxScanDepth = 3;
 		_directoryGlobs = directoryGlobs;
 	}
@@ -124,6 +124,7 @@ static const ADGameDescription tuckerDemoGameDescription = {
 class TuckerMetaEngine : public AdvancedMetaEngine {
 public:
 	TuckerMetaEngine() : AdvancedMetaEngine(tuckerGameDescriptions, sizeof(ADGameDescription), tuckerGames) {
+		_flags = kADFlagDetectsUnlistedFiles;
 		_md5Bytes = 512;
 	}
 
@@ -33,6 +33,7 @@
 #include "common/rect.h"
 #include "graphics/surface.h"
 #include "common/list.h"
+#include "graphics/transform_cache.h"
 #include "graphics/transform_struct.h"
 
 namespace Wintermute {
@@ -115,6 +116,8 @@ public:
 	void endSaveLoad() override;
 	void drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform);
 	BaseSurface *createSurface() override;
+	/** The scaled and rotated surfaces of recent tickets, shared by new tickets drawing them the same way. */
+	Graphics::TransformCache &getTransformCache() { return _transformCache; }
 private:
 	/**
 	 * Mark a specified rect of the screen as dirty.
@@ -137,6 +140,7 @@ private:
 	Common::Rect _renderRect;
 	Graphics::Surface *_renderSurface;
 	Graphics::Surface *_blankSurface;
+	Graphics::TransformCache _transformCache;
 
 	int _borderLeft;
 	int _borderTop;
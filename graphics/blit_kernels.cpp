@@ -0,0 +1,52 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/blit_kernels.h"
+#include "common/system.h"
+
+namespace Graphics {
+
+static const BlitKernels *detectBlitKernels() {
+#ifdef SCUMMVM_SSE2
+	if (g_system && g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		return &getSSE2BlitKernels();
+#endif
+	return 0;
+}
+
+static bool s_blitKernelsSet = false;
+static const BlitKernels *s_blitKernels = 0;
+
+const BlitKernels *getBlitKernels() {
+	if (!s_blitKernelsSet) {
+		s_blitKernels = detectBlitKernels();
+		s_blitKernelsSet = true;
+	}
+	return s_blitKernels;
+}
+
+void setBlitKernels(const BlitKernels *kernels) {
+	s_blitKernels = kernels;
+	s_blitKernelsSet = true;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,103 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_BLIT_KERNELS_H
+#define GRAPHICS_BLIT_KERNELS_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+/**
+ * Vectorized row blitters and filters for TransparentSurface and
+ * ManagedSurface. They give bit-identical results to the plain C++ code of
+ * these classes.
+ *
+ * The TransparentSurface blitters work on 32 bit pixels in the format of
+ * TransparentSurface::getSupportedPixelFormat(). in points to the first
+ * source pixel, and inStep is either 4 or -4 to read the row backwards.
+ * color is the color modulation of TransparentSurface::blit(). The width
+ * must be a multiple of 4; the caller blits the remaining pixels.
+ */
+struct BlitKernels {
+	/** Copy the pixels, making them opaque. inStep must be 4. */
+	void (*blitOpaque)(byte *out, const byte *in, uint32 width, int32 inStep);
+
+	/** Copy the pixels with a non-zero alpha value, making them opaque. */
+	void (*blitBinary)(byte *out, const byte *in, uint32 width, int32 inStep);
+
+	/** Blend the pixels with BLEND_NORMAL. */
+	void (*blitAlphaBlend)(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color);
+
+	/** Blend the pixels with BLEND_ADDITIVE. */
+	void (*blitAdditiveBlend)(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color);
+
+	/** Blend the pixels with BLEND_MULTIPLY. */
+	void (*blitMultiplyBlend)(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color);
+
+	/**
+	 * Copy the pixels of a row which differ from transColor, like the
+	 * color keyed ManagedSurface::transBlitFrom(). These work on rows of
+	 * any width.
+	 */
+	void (*keyBlit8)(byte *dst, const byte *src, uint32 width, uint32 transColor);
+	void (*keyBlit16)(uint16 *dst, const uint16 *src, uint32 width, uint32 transColor);
+	void (*keyBlit32)(uint32 *dst, const uint32 *src, uint32 width, uint32 transColor);
+
+	/**
+	 * Interpolate a row of TransparentSurface::scaleT<FILTER_BILINEAR>().
+	 * Pixel x samples the source rows row0 and row1 at the 16.16 fixed
+	 * point column sax[x], with the fraction ey between the rows. Columns
+	 * right of lastX are clamped to it. These work on rows of any width.
+	 */
+	void (*scaleBilinearRow)(uint32 *out, const uint32 *row0, const uint32 *row1, const int *sax, uint32 width, int lastX, uint32 ey);
+
+	/**
+	 * Interpolate a row of TransparentSurface::rotoscaleT<FILTER_BILINEAR>().
+	 * Pixel x samples the source at the 16.16 fixed point position
+	 * (sdx + x * stepX, sdy + x * stepY). Pixels sampling outside of the
+	 * source, or on its last row or column, are left alone.
+	 */
+	void (*rotoscaleBilinearRow)(uint32 *out, const byte *src, uint32 pitch, int srcW, int srcH, int sdx, int sdy, int stepX, int stepY, uint32 width);
+};
+
+#ifdef SCUMMVM_SSE2
+/** Kernels using SSE2. Only use them if OSystem::kFeatureCpuSSE2 is set. */
+const BlitKernels &getSSE2BlitKernels();
+#endif
+
+/**
+ * Return the kernels used by the blitters, or 0 if they use plain C++
+ * code. Unless setBlitKernels() was called, these are the fastest kernels
+ * supported by the CPU, chosen on the first call.
+ */
+const BlitKernels *getBlitKernels();
+
+/**
+ * Select the kernels used by the blitters, or 0 to use plain C++ code.
+ * Meant for tests and benchmarks.
+ */
+void setBlitKernels(const BlitKernels *kernels);
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,415 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/blit_kernels.h"
+
+#ifdef SCUMMVM_SSE2
+
+#include <emmintrin.h>
+
+namespace Graphics {
+
+// SSE2 is only available on little endian CPUs, where the alpha value of
+// the pixels of TransparentSurface is their lowest byte, followed by blue,
+// green and red. Unpacked to 16 bits, they are in lanes 0 to 3.
+
+namespace {
+
+/** The color modulation of a blit, prepared for the 16 bit lanes. */
+struct Modulation {
+	/** The factor to scale the alpha values of the source pixels by, in 1/256 */
+	__m128i alpha;
+
+	/** The factors to scale the products of color and alpha values by, in 1/65536 */
+	__m128i color;
+
+	bool tinted;
+};
+
+} // End of anonymous namespace
+
+/**
+ * Prepare the color modulation. Without tint, the alpha and color values
+ * are not scaled at all. With full255, color values of 255 do not scale
+ * either, like in the additive and multiplicative blend modes.
+ */
+static FORCEINLINE Modulation prepareModulation(uint32 color, bool full255) {
+	Modulation m;
+	m.tinted = (color != 0xFFFFFFFF);
+	if (!m.tinted) {
+		m.alpha = _mm_set1_epi16(256);
+		m.color = _mm_set_epi16(256, 256, 256, 0, 256, 256, 256, 0);
+		return m;
+	}
+
+	int r = (color >> 16) & 0xFF;
+	int g = (color >> 8) & 0xFF;
+	int b = color & 0xFF;
+	if (full255) {
+		r = (r == 255) ? 256 : r;
+		g = (g == 255) ? 256 : g;
+		b = (b == 255) ? 256 : b;
+	}
+	m.alpha = _mm_set1_epi16((color >> 24) & 0xFF);
+	m.color = _mm_set_epi16(r, g, b, 0, r, g, b, 0);
+	return m;
+}
+
+template<bool reversed>
+static FORCEINLINE __m128i loadPixels(const byte *in) {
+	if (reversed)
+		return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_loadu_si128((const __m128i *)in);
+}
+
+/** Copy the alpha value of each unpacked pixel to all of its lanes. */
+static FORCEINLINE __m128i broadcastAlpha(__m128i x) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+/** Return the bits of mask set from a and the other bits from b. */
+static FORCEINLINE __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void blitOpaque(byte *out, const byte *in, uint32 width, int32 inStep) {
+	assert(inStep == 4);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+
+	for (uint32 i = 0; i < width; i += 4, in += 16, out += 16)
+		_mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_loadu_si128((const __m128i *)in), alphaMask));
+}
+
+template<bool reversed>
+static void blitBinaryT(byte *out, const byte *in, uint32 width) {
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+	const int32 step = reversed ? -16 : 16;
+
+	for (uint32 i = 0; i < width; i += 4, in += step, out += 16) {
+		const __m128i s = loadPixels<reversed>(in);
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), _mm_setzero_si128());
+		const __m128i o = _mm_loadu_si128((const __m128i *)out);
+		_mm_storeu_si128((__m128i *)out, select(transparent, o, _mm_or_si128(s, alphaMask)));
+	}
+}
+
+static void blitBinary(byte *out, const byte *in, uint32 width, int32 inStep) {
+	if (inStep < 0)
+		blitBinaryT<true>(out, in, width);
+	else
+		blitBinaryT<false>(out, in, width);
+}
+
+template<bool reversed, bool tinted>
+static void blitAlphaBlendT(byte *out, const byte *in, uint32 width, const Modulation &m) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+	const __m128i c255 = _mm_set1_epi16(255);
+	const int32 step = reversed ? -16 : 16;
+
+	for (uint32 i = 0; i < width; i += 4, in += step, out += 16) {
+		const __m128i s = loadPixels<reversed>(in);
+		const __m128i o = _mm_loadu_si128((const __m128i *)out);
+		const __m128i sLo = _mm_unpacklo_epi8(s, zero);
+		const __m128i sHi = _mm_unpackhi_epi8(s, zero);
+		const __m128i oLo = _mm_unpacklo_epi8(o, zero);
+		const __m128i oHi = _mm_unpackhi_epi8(o, zero);
+		__m128i aLo = broadcastAlpha(sLo);
+		__m128i aHi = broadcastAlpha(sHi);
+		__m128i rLo, rHi;
+
+		if (tinted) {
+			aLo = _mm_srli_epi16(_mm_mullo_epi16(aLo, m.alpha), 8);
+			aHi = _mm_srli_epi16(_mm_mullo_epi16(aHi, m.alpha), 8);
+			rLo = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(oLo, _mm_sub_epi16(c255, aLo)), 8),
+				_mm_mulhi_epu16(_mm_mullo_epi16(sLo, aLo), m.color));
+			rHi = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(oHi, _mm_sub_epi16(c255, aHi)), 8),
+				_mm_mulhi_epu16(_mm_mullo_epi16(sHi, aHi), m.color));
+		} else {
+			rLo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(sLo, aLo), _mm_mullo_epi16(oLo, _mm_sub_epi16(c255, aLo))), 8);
+			rHi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(sHi, aHi), _mm_mullo_epi16(oHi, _mm_sub_epi16(c255, aHi))), 8);
+		}
+
+		// Pixels with an alpha value of zero are left alone
+		const __m128i transparent = _mm_packs_epi16(_mm_cmpeq_epi16(aLo, zero), _mm_cmpeq_epi16(aHi, zero));
+		_mm_storeu_si128((__m128i *)out, select(transparent, o, _mm_or_si128(_mm_packus_epi16(rLo, rHi), alphaMask)));
+	}
+}
+
+static void blitAlphaBlend(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color) {
+	const Modulation m = prepareModulation(color, false);
+	if (inStep < 0) {
+		if (m.tinted)
+			blitAlphaBlendT<true, true>(out, in, width, m);
+		else
+			blitAlphaBlendT<true, false>(out, in, width, m);
+	} else {
+		if (m.tinted)
+			blitAlphaBlendT<false, true>(out, in, width, m);
+		else
+			blitAlphaBlendT<false, false>(out, in, width, m);
+	}
+}
+
+/**
+ * Return the products of the color and alpha values of the source pixels,
+ * with the color modulation applied. The alpha lanes are zero.
+ */
+static FORCEINLINE __m128i modulate(__m128i s, const Modulation &m) {
+	const __m128i a = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(s), m.alpha), 8);
+	return _mm_mulhi_epu16(_mm_mullo_epi16(s, a), m.color);
+}
+
+template<bool reversed>
+static void blitAdditiveBlendT(byte *out, const byte *in, uint32 width, const Modulation &m) {
+	const __m128i zero = _mm_setzero_si128();
+	const int32 step = reversed ? -16 : 16;
+
+	for (uint32 i = 0; i < width; i += 4, in += step, out += 16) {
+		const __m128i s = loadPixels<reversed>(in);
+		const __m128i o = _mm_loadu_si128((const __m128i *)out);
+		const __m128i add = _mm_packus_epi16(modulate(_mm_unpacklo_epi8(s, zero), m), modulate(_mm_unpackhi_epi8(s, zero), m));
+
+		// The alpha lanes of add are zero, keeping the alpha values
+		_mm_storeu_si128((__m128i *)out, _mm_adds_epu8(o, add));
+	}
+}
+
+static void blitAdditiveBlend(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color) {
+	const Modulation m = prepareModulation(color, true);
+	if (inStep < 0)
+		blitAdditiveBlendT<true>(out, in, width, m);
+	else
+		blitAdditiveBlendT<false>(out, in, width, m);
+}
+
+template<bool reversed>
+static void blitMultiplyBlendT(byte *out, const byte *in, uint32 width, const Modulation &m) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+	const int32 step = reversed ? -16 : 16;
+
+	for (uint32 i = 0; i < width; i += 4, in += step, out += 16) {
+		const __m128i s = loadPixels<reversed>(in);
+		const __m128i o = _mm_loadu_si128((const __m128i *)out);
+		const __m128i rLo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(o, zero), modulate(_mm_unpacklo_epi8(s, zero), m)), 8);
+		const __m128i rHi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(o, zero), modulate(_mm_unpackhi_epi8(s, zero), m)), 8);
+
+		// Keep the alpha values, and without tint the transparent pixels
+		__m128i keep = alphaMask;
+		if (!m.tinted)
+			keep = _mm_or_si128(keep, _mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), zero));
+		_mm_storeu_si128((__m128i *)out, select(keep, o, _mm_packus_epi16(rLo, rHi)));
+	}
+}
+
+static void blitMultiplyBlend(byte *out, const byte *in, uint32 width, int32 inStep, uint32 color) {
+	const Modulation m = prepareModulation(color, true);
+	if (inStep < 0)
+		blitMultiplyBlendT<true>(out, in, width, m);
+	else
+		blitMultiplyBlendT<false>(out, in, width, m);
+}
+
+static void keyBlit8(byte *dst, const byte *src, uint32 width, uint32 transColor) {
+	const __m128i key = _mm_set1_epi8((char)transColor);
+	uint32 x = 0;
+
+	for (; x + 16 <= width; x += 16) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+		const __m128i transparent = _mm_cmpeq_epi8(s, key);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128((__m128i *)(dst + x), select(transparent, d, s));
+	}
+
+	for (; x < width; x++) {
+		if (src[x] != (byte)transColor)
+			dst[x] = src[x];
+	}
+}
+
+static void keyBlit16(uint16 *dst, const uint16 *src, uint32 width, uint32 transColor) {
+	const __m128i key = _mm_set1_epi16((int16)transColor);
+	uint32 x = 0;
+
+	for (; x + 8 <= width; x += 8) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+		const __m128i transparent = _mm_cmpeq_epi16(s, key);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128((__m128i *)(dst + x), select(transparent, d, s));
+	}
+
+	for (; x < width; x++) {
+		if (src[x] != (uint16)transColor)
+			dst[x] = src[x];
+	}
+}
+
+static void keyBlit32(uint32 *dst, const uint32 *src, uint32 width, uint32 transColor) {
+	const __m128i key = _mm_set1_epi32((int32)transColor);
+	uint32 x = 0;
+
+	for (; x + 4 <= width; x += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+		const __m128i transparent = _mm_cmpeq_epi32(s, key);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128((__m128i *)(dst + x), select(transparent, d, s));
+	}
+
+	for (; x < width; x++) {
+		if (src[x] != transColor)
+			dst[x] = src[x];
+	}
+}
+
+/**
+ * Return (a * b) >> 16 for each signed 16 bit lane of a and unsigned lane
+ * of b. mulhi treats b as signed, which is off by a for b >= 32768.
+ */
+static FORCEINLINE __m128i mulFraction(__m128i a, __m128i b) {
+	return _mm_add_epi16(_mm_mulhi_epi16(a, b), _mm_and_si128(a, _mm_srai_epi16(b, 15)));
+}
+
+/**
+ * Interpolate two unpacked pixels between the pixels c00 and c01 of one
+ * row and c10 and c11 of the next one, like the bilinear transforms.
+ */
+static FORCEINLINE __m128i interpolate(__m128i c00, __m128i c01, __m128i c10, __m128i c11, __m128i ex, __m128i ey) {
+	const __m128i t1 = _mm_add_epi16(c00, mulFraction(_mm_sub_epi16(c01, c00), ex));
+	const __m128i t2 = _mm_add_epi16(c10, mulFraction(_mm_sub_epi16(c11, c10), ex));
+	return _mm_add_epi16(t1, mulFraction(_mm_sub_epi16(t2, t1), ey));
+}
+
+/** Load a pixel and its right neighbor, or the pixel twice. */
+static FORCEINLINE __m128i loadNeighbors(const uint32 *p, bool right) {
+	if (right)
+		return _mm_loadl_epi64((const __m128i *)p);
+	const __m128i c = _mm_cvtsi32_si128(*p);
+	return _mm_unpacklo_epi32(c, c);
+}
+
+/** Interpolate the two unpacked pixels of a scaled row at the columns sx0 and sx1. */
+static FORCEINLINE __m128i scaleBilinearPair(const uint32 *row0, const uint32 *row1, int sx0, int sx1, int lastX, __m128i ey) {
+	const int cx0 = sx0 >> 16;
+	const int cx1 = sx1 >> 16;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i top = _mm_unpacklo_epi32(loadNeighbors(row0 + cx0, cx0 < lastX), loadNeighbors(row0 + cx1, cx1 < lastX));
+	const __m128i bottom = _mm_unpacklo_epi32(loadNeighbors(row1 + cx0, cx0 < lastX), loadNeighbors(row1 + cx1, cx1 < lastX));
+	const __m128i ex = _mm_unpacklo_epi64(_mm_set1_epi16((int16)(sx0 & 0xFFFF)), _mm_set1_epi16((int16)(sx1 & 0xFFFF)));
+	return interpolate(_mm_unpacklo_epi8(top, zero), _mm_unpackhi_epi8(top, zero),
+		_mm_unpacklo_epi8(bottom, zero), _mm_unpackhi_epi8(bottom, zero), ex, ey);
+}
+
+static void scaleBilinearRow(uint32 *out, const uint32 *row0, const uint32 *row1, const int *sax, uint32 width, int lastX, uint32 ey) {
+	const __m128i eyv = _mm_set1_epi16((int16)ey);
+	uint32 x = 0;
+
+	for (; x + 4 <= width; x += 4) {
+		const __m128i lo = scaleBilinearPair(row0, row1, sax[x], sax[x + 1], lastX, eyv);
+		const __m128i hi = scaleBilinearPair(row0, row1, sax[x + 2], sax[x + 3], lastX, eyv);
+		_mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(lo, hi));
+	}
+
+	for (; x < width; x++) {
+		const __m128i c = scaleBilinearPair(row0, row1, sax[x], sax[x], lastX, eyv);
+		out[x] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+	}
+}
+
+/**
+ * Interpolate the unpacked pixels of a rotated row at the source positions
+ * (sdx0, sdy0) and (sdx1, sdy1), which must not be on the last row or
+ * column of the source.
+ */
+static FORCEINLINE __m128i rotoscaleBilinearPair(const byte *src, uint32 pitch, int sdx0, int sdy0, int sdx1, int sdy1) {
+	const __m128i zero = _mm_setzero_si128();
+	const byte *p0 = src + (sdy0 >> 16) * pitch + (sdx0 >> 16) * 4;
+	const byte *p1 = src + (sdy1 >> 16) * pitch + (sdx1 >> 16) * 4;
+	const __m128i top = _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i *)p0), _mm_loadl_epi64((const __m128i *)p1));
+	const __m128i bottom = _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i *)(p0 + pitch)), _mm_loadl_epi64((const __m128i *)(p1 + pitch)));
+	const __m128i ex = _mm_unpacklo_epi64(_mm_set1_epi16((int16)(sdx0 & 0xFFFF)), _mm_set1_epi16((int16)(sdx1 & 0xFFFF)));
+	const __m128i ey = _mm_unpacklo_epi64(_mm_set1_epi16((int16)(sdy0 & 0xFFFF)), _mm_set1_epi16((int16)(sdy1 & 0xFFFF)));
+	return interpolate(_mm_unpacklo_epi8(top, zero), _mm_unpackhi_epi8(top, zero),
+		_mm_unpacklo_epi8(bottom, zero), _mm_unpackhi_epi8(bottom, zero), ex, ey);
+}
+
+static void rotoscaleBilinearRow(uint32 *out, const byte *src, uint32 pitch, int srcW, int srcH, int sdx, int sdy, int stepX, int stepY, uint32 width) {
+	const int sw = srcW - 1;
+	const int sh = srcH - 1;
+
+	for (uint32 x = 0; x < width; x += 2, sdx += 2 * stepX, sdy += 2 * stepY) {
+		const int dx0 = sdx >> 16;
+		const int dy0 = sdy >> 16;
+		const bool inside0 = (dx0 > -1) && (dy0 > -1) && (dx0 < sw) && (dy0 < sh);
+
+		if (x + 1 == width) {
+			if (inside0) {
+				const __m128i c = rotoscaleBilinearPair(src, pitch, sdx, sdy, sdx, sdy);
+				out[x] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+			}
+			break;
+		}
+
+		const int sdx1 = sdx + stepX;
+		const int sdy1 = sdy + stepY;
+		const int dx1 = sdx1 >> 16;
+		const int dy1 = sdy1 >> 16;
+		const bool inside1 = (dx1 > -1) && (dy1 > -1) && (dx1 < sw) && (dy1 < sh);
+
+		if (inside0 && inside1) {
+			const __m128i c = rotoscaleBilinearPair(src, pitch, sdx, sdy, sdx1, sdy1);
+			_mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(c, c));
+		} else if (inside0) {
+			const __m128i c = rotoscaleBilinearPair(src, pitch, sdx, sdy, sdx, sdy);
+			out[x] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+		} else if (inside1) {
+			const __m128i c = rotoscaleBilinearPair(src, pitch, sdx1, sdy1, sdx1, sdy1);
+			out[x + 1] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+		}
+	}
+}
+
+const BlitKernels &getSSE2BlitKernels() {
+	static const BlitKernels kernels = {
+		blitOpaque,
+		blitBinary,
+		blitAlphaBlend,
+		blitAdditiveBlend,
+		blitMultiplyBlend,
+		keyBlit8,
+		keyBlit16,
+		keyBlit32,
+		scaleBilinearRow,
+		rotoscaleBilinearRow
+	};
+	return kernels;
+}
+
+} // End of namespace Graphics
+
+#endif // SCUMMVM_SSE2
@@ -0,0 +1,159 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/dirtyregion.h"
+
+namespace Graphics {
+
+// Plain structs, so they do not need global constructors
+static DirtyRegionStats s_lastFrameStats;
+static DirtyRegionStats s_totalStats;
+
+static uint32 getRectArea(const Common::Rect &rect) {
+	return rect.width() * rect.height();
+}
+
+void DirtyRegionStats::reset() {
+	frames = 0;
+	rectsSubmitted = 0;
+	rectsMerged = 0;
+	rectsUpdated = 0;
+	pixelsUpdated = 0;
+}
+
+void DirtyRegionStats::add(const DirtyRegionStats &stats) {
+	frames += stats.frames;
+	rectsSubmitted += stats.rectsSubmitted;
+	rectsMerged += stats.rectsMerged;
+	rectsUpdated += stats.rectsUpdated;
+	pixelsUpdated += stats.pixelsUpdated;
+}
+
+DirtyRegion::DirtyRegion(uint maxRects, uint rectCost) : _maxRects(maxRects), _rectCost(rectCost) {
+	assert(maxRects > 0);
+	_stats.reset();
+}
+
+void DirtyRegion::addRect(const Common::Rect &rect) {
+	if (rect.isEmpty())
+		return;
+
+	_stats.rectsSubmitted++;
+	_rects.push_back(rect);
+
+	uint index = _rects.size() - 1;
+	if (_rects.size() > _maxRects)
+		index = mergeCheapest(index);
+	mergeRect(index);
+}
+
+void DirtyRegion::setRect(const Common::Rect &rect) {
+	_rects.resize(1);
+	_rects[0] = rect;
+}
+
+uint32 DirtyRegion::getArea() const {
+	uint32 area = 0;
+	for (uint i = 0; i < _rects.size(); ++i)
+		area += getRectArea(_rects[i]);
+	return area;
+}
+
+void DirtyRegion::clear() {
+	// Keep the storage, this is done every frame
+	_rects.resize(0);
+}
+
+void DirtyRegion::flush() {
+	_stats.rectsUpdated += _rects.size();
+	_stats.pixelsUpdated += getArea();
+	clear();
+}
+
+void DirtyRegion::endFrame() {
+	_stats.frames = 1;
+	s_lastFrameStats = _stats;
+	s_totalStats.add(_stats);
+	_stats.reset();
+}
+
+const DirtyRegionStats &DirtyRegion::getLastFrameStats() {
+	return s_lastFrameStats;
+}
+
+const DirtyRegionStats &DirtyRegion::getTotalStats() {
+	return s_totalStats;
+}
+
+void DirtyRegion::resetTotalStats() {
+	s_totalStats.reset();
+}
+
+void DirtyRegion::mergeRect(uint index) {
+	bool merged;
+	do {
+		merged = false;
+		const uint32 cost = getCost(getRectArea(_rects[index]));
+
+		for (uint i = 0; i < _rects.size(); ++i) {
+			if (i == index)
+				continue;
+
+			Common::Rect merge = _rects[index];
+			merge.extend(_rects[i]);
+			if (getCost(getRectArea(merge)) <= cost + getCost(getRectArea(_rects[i]))) {
+				index = mergePair(index, i);
+				merged = true;
+				break;
+			}
+		}
+	} while (merged);
+}
+
+uint DirtyRegion::mergeCheapest(uint index) {
+	uint best = index;
+	uint32 bestArea = 0xFFFFFFFF;
+
+	for (uint i = 0; i < _rects.size(); ++i) {
+		if (i == index)
+			continue;
+
+		Common::Rect merge = _rects[index];
+		merge.extend(_rects[i]);
+		const uint32 addedArea = getRectArea(merge) - getRectArea(_rects[i]);
+		if (addedArea < bestArea) {
+			bestArea = addedArea;
+			best = i;
+		}
+	}
+
+	return (best == index) ? index : mergePair(index, best);
+}
+
+uint DirtyRegion::mergePair(uint a, uint b) {
+	_rects[a].extend(_rects[b]);
+	_rects.remove_at(b);
+	_stats.rectsMerged++;
+	return (b < a) ? a - 1 : a;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,150 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_DIRTYREGION_H
+#define GRAPHICS_DIRTYREGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * Counters describing how the dirty regions of a graphics manager were
+ * updated.
+ */
+struct DirtyRegionStats {
+	/** Number of frames counted. */
+	uint32 frames;
+	/** Number of rects passed to DirtyRegion::addRect(). */
+	uint32 rectsSubmitted;
+	/** Number of rects which were merged into another one. */
+	uint32 rectsMerged;
+	/** Number of rects which were finally updated. */
+	uint32 rectsUpdated;
+	/** Number of pixels in the updated rects. */
+	uint64 pixelsUpdated;
+
+	void reset();
+	void add(const DirtyRegionStats &stats);
+};
+
+/**
+ * A set of rectangles which need to be redrawn.
+ *
+ * Rects which overlap or touch are merged, when updating their union is
+ * cheaper than updating them separately. The cost of a rect is its area
+ * plus a fixed overhead, which accounts for the setup work needed per
+ * rect, like calling the scaler and passing the rect to the display.
+ * The number of rects is limited; beyond the limit, a new rect is merged
+ * with the rect where this adds the least area.
+ *
+ * Graphics managers are expected to call endFrame() once per screen
+ * update, which makes the statistics of the frame available through
+ * getLastFrameStats(), e.g. for the debugger.
+ */
+class DirtyRegion {
+public:
+	enum {
+		/** Default upper limit of the number of rects. */
+		kDefaultMaxRects = 100,
+		/** Default overhead of updating a rect, in pixels. */
+		kDefaultRectCost = 256
+	};
+
+	DirtyRegion(uint maxRects = kDefaultMaxRects, uint rectCost = kDefaultRectCost);
+
+	/**
+	 * Add a rect to the region. Empty rects are ignored.
+	 */
+	void addRect(const Common::Rect &rect);
+
+	/**
+	 * Replace the region with a single rect, e.g. for a full redraw.
+	 * This does not count as a submitted rect.
+	 */
+	void setRect(const Common::Rect &rect);
+
+	/** Return whether the region is empty. */
+	bool empty() const { return _rects.empty(); }
+
+	/** Return the rects making up the region. They may overlap. */
+	const Common::Array<Common::Rect> &getRects() const { return _rects; }
+
+	/** Return the sum of the areas of the rects. */
+	uint32 getArea() const;
+
+	/** Remove all rects, without counting them as updated. */
+	void clear();
+
+	/** Count the current rects as updated and remove them. */
+	void flush();
+
+	/**
+	 * Finish the current frame. The rects of the region are kept, the
+	 * statistics are published and reset.
+	 */
+	void endFrame();
+
+	/** Return the statistics of the current frame. */
+	const DirtyRegionStats &getStats() const { return _stats; }
+
+	/** Return the statistics of the frame which was finished last. */
+	static const DirtyRegionStats &getLastFrameStats();
+
+	/** Return the statistics summed up over all finished frames. */
+	static const DirtyRegionStats &getTotalStats();
+
+	/** Reset the statistics returned by getTotalStats(). */
+	static void resetTotalStats();
+
+private:
+	/** Return the cost of updating a rect with the given area. */
+	uint32 getCost(uint32 area) const { return area + _rectCost; }
+
+	/**
+	 * Merge the rect at the given index with other rects as long as this
+	 * lowers the cost.
+	 */
+	void mergeRect(uint index);
+
+	/**
+	 * Merge the rect at the given index with the rect whose union adds
+	 * the least area. Returns the index of the union.
+	 */
+	uint mergeCheapest(uint index);
+
+	/**
+	 * Replace the rect at index a with its union with the rect at index b,
+	 * and remove the latter. Returns the index of the union.
+	 */
+	uint mergePair(uint a, uint b);
+
+	Common::Array<Common::Rect> _rects;
+	uint _maxRects;
+	uint32 _rectCost;
+	DirtyRegionStats _stats;
+};
+
+} // End of namespace Graphics
+
+#endif
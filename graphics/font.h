@@ -180,6 +180,15 @@ public:
 	int wordWrapText(const Common::String &str, int maxWidth, Common::Array<Common::String> &lines, int initWidth = 0, bool evenWidthLinesModeEnabled = false, bool wrapOnExplicitNewLines = true) const;
 	int wordWrapText(const Common::U32String &str, int maxWidth, Common::Array<Common::U32String> &lines, int initWidth = 0, bool evenWidthLinesModeEnabled = false, bool wrapOnExplicitNewLines = true) const;
 
+protected:
+	/**
+	 * Draw a string for drawString(), after inserting the ellipsis. The
+	 * default implementation draws the characters one at a time with
+	 * drawChar(). Fonts can override these to draw whole strings at once.
+	 */
+	virtual void drawAlignedString(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+	virtual void drawAlignedString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+
 private:
 	Common::String handleEllipsis(const Common::String &str, int w) const;
 };
@@ -31,6 +31,7 @@
 #include "graphics/font.h"
 #include "graphics/surface.h"
 
+#include "common/array.h"
 #include "common/encoding.h"
 #include "common/file.h"
 #include "common/config-manager.h"
@@ -153,6 +154,9 @@ public:
 	virtual Common::Rect getBoundingBox(uint32 chr) const;
 
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const;
+protected:
+	virtual void drawAlignedString(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+	virtual void drawAlignedString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
 private:
 	bool _initialized;
 	FT_Face _face;
@@ -164,6 +168,7 @@ private:
 	int _ascent, _descent;
 
 	struct Glyph {
+		/** The image of the glyph in the atlas */
 		Surface image;
 		int xOffset, yOffset;
 		int advance;
@@ -175,6 +180,49 @@ private:
 	mutable GlyphCache _glyphs;
 	bool _allowLateCaching;
 	void assureCached(uint32 chr) const;
+	void drawGlyph(Surface *dst, const Glyph &glyph, int x, int y, uint32 color) const;
+
+	/**
+	 * The glyph images are packed into the pages of an atlas, in shelves
+	 * filled from left to right. The pages never move, so the images can
+	 * refer to them.
+	 */
+	enum {
+		kAtlasPageSize = 256
+	};
+
+	mutable Common::Array<Surface *> _atlasPages;
+	mutable int _atlasX, _atlasY;
+	mutable int _atlasShelfHeight;
+	void allocateGlyphImage(Surface &image, int w, int h) const;
+
+	/** A character of a laid out string. */
+	struct RunChar {
+		/** The glyph of the character, or 0 if the font has none */
+		const Glyph *glyph;
+		/** The position of the character, relative to the start of the string */
+		int x;
+		/** The right edge of the bounding box of the character, relative to x */
+		int right;
+	};
+
+	/** A string laid out with kerning, for drawing it again quickly. */
+	struct Run {
+		Common::Array<RunChar> chars;
+		int width;
+	};
+
+	struct U32StringHash {
+		uint operator()(const Common::U32String &str) const;
+	};
+
+	enum {
+		kMaxCachedRuns = 512
+	};
+
+	typedef Common::HashMap<Common::U32String, Run, U32StringHash> RunCache;
+	mutable RunCache _runs;
+	const Run &layoutRun(const Common::U32String &str) const;
 
 	Common::SeekableReadStream *readTTFTable(FT_ULong tag) const;
 
@@ -192,7 +240,7 @@ private:
 
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
-      _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
+      _descent(0), _glyphs(), _atlasX(0), _atlasY(0), _atlasShelfHeight(0), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
       _hasKerning(false), _allowLateCaching(false), _fakeBold(false), _fakeItalic(false) {
 }
 
@@ -203,11 +251,13 @@ TTFFont::~TTFFont() {
 		delete[] _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
-
 		_initialized = false;
 	}
+
+	for (uint i = 0; i < _atlasPages.size(); ++i) {
+		_atlasPages[i]->free();
+		delete _atlasPages[i];
+	}
 }
 
 bool TTFFont::load(Common::SeekableReadStream &stream, int size, TTFSizeMode sizeMode,
@@ -609,8 +659,85 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 	if (glyphEntry == _glyphs.end())
 		return;
 
-	const Glyph &glyph = glyphEntry->_value;
+	drawGlyph(dst, glyphEntry->_value, x, y, color);
+}
+
+void TTFFont::drawAlignedString(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	// The characters of plain strings are the code points we draw
+	Common::U32String u32str;
+	for (uint i = 0; i < str.size(); ++i)
+		u32str += (Common::U32String::value_type)(byte)str[i];
+	drawAlignedString(dst, u32str, x, y, w, color, align, deltax);
+}
+
+void TTFFont::drawAlignedString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	// This follows drawStringImpl in font.cpp
+	assert(dst != 0);
+
+	const Run &run = layoutRun(str);
+	const int leftX = x, rightX = x + w;
+
+	if (align == kTextAlignCenter)
+		x = x + (w - run.width)/2;
+	else if (align == kTextAlignRight)
+		x = x + w - run.width;
+	x += deltax;
+
+	for (uint i = 0; i < run.chars.size(); ++i) {
+		const RunChar &chr = run.chars[i];
+		const int charX = x + chr.x;
+		if (charX + chr.right > rightX)
+			break;
+		if (charX + chr.right >= leftX && chr.glyph)
+			drawGlyph(dst, *chr.glyph, charX, y, color);
+	}
+}
 
+uint TTFFont::U32StringHash::operator()(const Common::U32String &str) const {
+	uint hash = 0;
+	for (uint i = 0; i < str.size(); ++i)
+		hash = hash * 33 + str[i];
+	return hash;
+}
+
+const TTFFont::Run &TTFFont::layoutRun(const Common::U32String &str) const {
+	RunCache::iterator cached = _runs.find(str);
+	if (cached != _runs.end())
+		return cached->_value;
+
+	if (_runs.size() >= kMaxCachedRuns)
+		_runs.clear();
+
+	Run &run = _runs[str];
+	run.chars.resize(str.size());
+
+	int x = 0;
+	uint32 last = 0;
+	for (uint i = 0; i < str.size(); ++i) {
+		const uint32 cur = str[i];
+		x += getKerningOffset(last, cur);
+		last = cur;
+
+		RunChar &chr = run.chars[i];
+		assureCached(cur);
+		GlyphCache::const_iterator glyphEntry = _glyphs.find(cur);
+		if (glyphEntry != _glyphs.end()) {
+			chr.glyph = &glyphEntry->_value;
+			chr.right = chr.glyph->xOffset + chr.glyph->image.w;
+		} else {
+			chr.glyph = 0;
+			chr.right = 0;
+		}
+		chr.x = x;
+
+		x += getCharWidth(cur);
+	}
+	run.width = x;
+
+	return run;
+}
+
+void TTFFont::drawGlyph(Surface *dst, const Glyph &glyph, int x, int y, uint32 color) const {
 	x += glyph.xOffset;
 	y += glyph.yOffset;
 
@@ -741,7 +868,13 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 
 
-	glyph.image.create(bitmap->width, bitmap->rows, PixelFormat::createFormatCLUT8());
+	if (bitmap->pixel_mode != FT_PIXEL_MODE_MONO && bitmap->pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
+		return false;
+	}
+
+	// The atlas pages are cleared when created
+	allocateGlyphImage(glyph.image, bitmap->width, bitmap->rows);
 
 	const uint8 *src = bitmap->buffer;
 	int srcPitch = bitmap->pitch;
@@ -751,7 +884,6 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 
 	uint8 *dst = (uint8 *)glyph.image.getPixels();
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
 
 	switch (bitmap->pixel_mode) {
 	case FT_PIXEL_MODE_MONO:
@@ -764,12 +896,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 					mask = *curSrc++;
 
 				if (mask & 0x80)
-					*dst = 255;
+					dst[x] = 255;
 
 				mask <<= 1;
-				++dst;
 			}
 
+			dst += glyph.image.pitch;
 			src += srcPitch;
 		}
 		break;
@@ -783,9 +915,7 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 		break;
 
 	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
-		glyph.image.free();
-		return false;
+		break;
 	}
 
 #if FAKE_BOLD == 1
@@ -797,6 +927,36 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	return true;
 }
 
+void TTFFont::allocateGlyphImage(Surface &image, int w, int h) const {
+	Surface *page = 0;
+	if (!_atlasPages.empty()) {
+		page = _atlasPages.back();
+
+		// Start a new shelf when the current one is full
+		if (_atlasX + w > page->w) {
+			_atlasX = 0;
+			_atlasY += _atlasShelfHeight;
+			_atlasShelfHeight = 0;
+		}
+
+		if (_atlasY + h > page->h)
+			page = 0;
+	}
+
+	if (!page) {
+		page = new Surface();
+		page->create(MAX<int>(kAtlasPageSize, w), MAX<int>(kAtlasPageSize, h), PixelFormat::createFormatCLUT8());
+		_atlasPages.push_back(page);
+		_atlasX = 0;
+		_atlasY = 0;
+		_atlasShelfHeight = 0;
+	}
+
+	image = page->getSubArea(Common::Rect(_atlasX, _atlasY, _atlasX + w, _atlasY + h));
+	_atlasX += w;
+	_atlasShelfHeight = MAX(_atlasShelfHeight, h);
+}
+
 void TTFFont::assureCached(uint32 chr) const {
 	if (!chr || !_allowLateCaching || _glyphs.contains(chr)) {
 		return;
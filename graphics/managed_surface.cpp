@@ -21,6 +21,7 @@
  */
 
 #include "graphics/managed_surface.h"
+#include "graphics/blit_kernels.h"
 #include "common/algorithm.h"
 #include "common/textconsole.h"
 
@@ -361,6 +362,18 @@ void ManagedSurface::transBlitFrom(const ManagedSurface &src, const Common::Rect
 		srcAlpha, palette, mask, maskOnly);
 }
 
+static inline void keyBlitRow(const BlitKernels *kernels, byte *dst, const byte *src, uint32 width, uint32 transColor) {
+	kernels->keyBlit8(dst, src, width, transColor);
+}
+
+static inline void keyBlitRow(const BlitKernels *kernels, uint16 *dst, const uint16 *src, uint32 width, uint32 transColor) {
+	kernels->keyBlit16(dst, src, width, transColor);
+}
+
+static inline void keyBlitRow(const BlitKernels *kernels, uint32 *dst, const uint32 *src, uint32 width, uint32 transColor) {
+	kernels->keyBlit32(dst, src, width, transColor);
+}
+
 template<typename TSRC, typename TDEST>
 void transBlit(const Surface &src, const Common::Rect &srcRect, Surface &dest, const Common::Rect &destRect,
 		TSRC transColor, bool flipped, uint overrideColor, uint srcAlpha, const uint32 *palette,
@@ -373,6 +386,13 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, Surface &dest, c
 	byte rDest, gDest, bDest;
 	double alpha;
 
+	// Unscaled color keyed copies are done a row at a time by the SIMD kernels
+	const BlitKernels *kernels = getBlitKernels();
+	const bool keyBlit = kernels && sizeof(TSRC) == sizeof(TDEST) && srcFormat == destFormat &&
+		scaleX == SCALE_THRESHOLD && !flipped && !mask && !maskOnly && srcAlpha == 0xff && !overrideColor;
+	const int keyBlitLeft = MAX<int>(destRect.left, 0);
+	const int keyBlitRight = MIN<int>(destRect.right, dest.w);
+
 	// Loop through drawing output lines
 	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
 		if (destY < 0 || destY >= dest.h)
@@ -385,6 +405,13 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, Surface &dest, c
 
 		TDEST *destLine = (TDEST *)dest.getBasePtr(destRect.left, destY);
 
+		if (keyBlit) {
+			if (keyBlitLeft < keyBlitRight)
+				keyBlitRow(kernels, (TSRC *)(destLine + keyBlitLeft - destRect.left), srcLine + keyBlitLeft - destRect.left,
+					keyBlitRight - keyBlitLeft, transColor);
+			continue;
+		}
+
 		// Loop through drawing the pixels of the row
 		for (int destX = destRect.left, xCtr = 0, scaleXCtr = 0; destX < destRect.right; ++destX, ++xCtr, scaleXCtr += scaleX) {
 			if (destX < 0 || destX >= dest.w)
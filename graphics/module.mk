@@ -1,8 +1,10 @@
 MODULE := graphics
 
 MODULE_OBJS := \
+	blit_kernels.o \
 	conversion.o \
 	cursorman.o \
+	dirtyregion.o \
 	font.o \
 	fontman.o \
 	fonts/bdf.o \
@@ -32,6 +34,7 @@ MODULE_OBJS := \
 	screen.o \
 	sjis.o \
 	surface.o \
+	transform_cache.o \
 	transform_struct.o \
 	transform_tools.o \
 	transparent_surface.o \
@@ -41,6 +44,15 @@ MODULE_OBJS := \
 	wincursor.o \
 	yuv_to_rgb.o
 
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	blit_kernels_sse2.o \
+	yuv_to_rgb_sse2.o
+
+$(MODULE)/blit_kernels_sse2.o: CXXFLAGS += -msse2
+$(MODULE)/yuv_to_rgb_sse2.o: CXXFLAGS += -msse2
+endif
+
 ifdef USE_SCALERS
 MODULE_OBJS += \
 	scaler/2xsai.o \
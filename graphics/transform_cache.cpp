@@ -0,0 +1,180 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "graphics/transform_cache.h"
+
+namespace Graphics {
+
+bool TransformCache::Key::operator==(const Key &key) const {
+	return owner == key.owner && srcRect == key.srcRect &&
+		width == key.width && height == key.height &&
+		angle == key.angle && zoom == key.zoom && hotspot == key.hotspot &&
+		filteringMode == key.filteringMode;
+}
+
+uint TransformCache::KeyHash::operator()(const Key &key) const {
+	uint hash = (uint)(size_t)key.owner;
+	hash = hash * 31 + (uint16)key.srcRect.left + ((uint16)key.srcRect.top << 16);
+	hash = hash * 31 + (uint16)key.srcRect.right + ((uint16)key.srcRect.bottom << 16);
+	hash = hash * 31 + key.width + (key.height << 16);
+	hash = hash * 31 + (uint)key.angle;
+	hash = hash * 31 + (uint16)key.zoom.x + ((uint16)key.zoom.y << 16);
+	hash = hash * 31 + (uint16)key.hotspot.x + ((uint16)key.hotspot.y << 16);
+	return hash * 31 + key.filteringMode;
+}
+
+TransformCache::TransformCache(uint32 memoryBudget) : _memoryBudget(memoryBudget), _memoryUsage(0) {
+	resetStats();
+}
+
+TransformCache::~TransformCache() {
+	clear();
+}
+
+TransformCache::SurfacePtr TransformCache::scale(const void *owner, const Surface &src, const Common::Rect &srcRect, uint16 newWidth, uint16 newHeight, TFilteringMode filteringMode) {
+	Key key;
+	key.owner = owner;
+	key.srcRect = srcRect;
+	key.width = newWidth;
+	key.height = newHeight;
+	key.angle = 0;
+	key.zoom = Common::Point();
+	key.hotspot = Common::Point();
+	key.filteringMode = filteringMode;
+
+	SurfacePtr surface = lookup(key);
+	if (surface)
+		return surface;
+
+	// The transforms assume that the pitch matches the width, so copy the part
+	TransparentSurface part(src.getSubArea(srcRect), true);
+	Surface *scaled;
+	if (filteringMode == FILTER_BILINEAR)
+		scaled = part.scaleT<FILTER_BILINEAR>(newWidth, newHeight);
+	else
+		scaled = part.scaleT<FILTER_NEAREST>(newWidth, newHeight);
+	part.free();
+	return insert(key, scaled);
+}
+
+TransformCache::SurfacePtr TransformCache::rotoscale(const void *owner, const Surface &src, const Common::Rect &srcRect, const TransformStruct &transform, TFilteringMode filteringMode) {
+	Key key;
+	key.owner = owner;
+	key.srcRect = srcRect;
+	key.width = 0;
+	key.height = 0;
+	key.angle = transform._angle;
+	key.zoom = transform._zoom;
+	key.hotspot = transform._hotspot;
+	key.filteringMode = filteringMode;
+
+	SurfacePtr surface = lookup(key);
+	if (surface)
+		return surface;
+
+	TransparentSurface part(src.getSubArea(srcRect), true);
+	Surface *rotated;
+	if (filteringMode == FILTER_BILINEAR)
+		rotated = part.rotoscaleT<FILTER_BILINEAR>(transform);
+	else
+		rotated = part.rotoscaleT<FILTER_NEAREST>(transform);
+	part.free();
+	return insert(key, rotated);
+}
+
+void TransformCache::invalidate(const void *owner) {
+	for (KeyList::iterator i = _lru.begin(); i != _lru.end();) {
+		if (i->owner == owner) {
+			EntryMap::iterator entry = _entries.find(*i);
+			_memoryUsage -= entry->_value.size;
+			_entries.erase(entry);
+			i = _lru.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void TransformCache::clear() {
+	_entries.clear();
+	_lru.clear();
+	_memoryUsage = 0;
+}
+
+void TransformCache::setMemoryBudget(uint32 memoryBudget) {
+	_memoryBudget = memoryBudget;
+	evict(memoryBudget);
+}
+
+void TransformCache::resetStats() {
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+TransformCache::SurfacePtr TransformCache::lookup(const Key &key) {
+	EntryMap::iterator entry = _entries.find(key);
+	if (entry == _entries.end()) {
+		_stats.misses++;
+		return SurfacePtr();
+	}
+
+	_stats.hits++;
+	if (entry->_value.lruPos != _lru.begin()) {
+		_lru.erase(entry->_value.lruPos);
+		_lru.push_front(key);
+		entry->_value.lruPos = _lru.begin();
+	}
+	return entry->_value.surface;
+}
+
+TransformCache::SurfacePtr TransformCache::insert(const Key &key, Surface *surface) {
+	SurfacePtr ptr(surface, SurfaceDeleter());
+	const uint32 size = surface->pitch * surface->h;
+
+	// Copies larger than the whole budget are not worth keeping
+	if (size > _memoryBudget)
+		return ptr;
+
+	evict(_memoryBudget - size);
+
+	_lru.push_front(key);
+	Entry &entry = _entries[key];
+	entry.surface = ptr;
+	entry.size = size;
+	entry.lruPos = _lru.begin();
+	_memoryUsage += size;
+	return ptr;
+}
+
+void TransformCache::evict(uint32 memoryBudget) {
+	while (_memoryUsage > memoryBudget && !_lru.empty()) {
+		EntryMap::iterator entry = _entries.find(_lru.back());
+		_memoryUsage -= entry->_value.size;
+		_entries.erase(entry);
+		_lru.pop_back();
+		_stats.evictions++;
+	}
+}
+
+} // End of namespace Graphics
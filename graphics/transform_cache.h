@@ -0,0 +1,134 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef GRAPHICS_TRANSFORM_CACHE_H
+#define GRAPHICS_TRANSFORM_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/rect.h"
+#include "graphics/transparent_surface.h"
+
+namespace Graphics {
+
+/**
+ * A cache of scaled and rotated copies of surfaces, for sprites which are
+ * drawn with the same transformation again and again.
+ *
+ * The copies are looked up by their owner, which is any pointer identifying
+ * the source surface, the part of the source surface and the transformation.
+ * The least recently used copies are dropped once all of them take more
+ * memory than the budget. The owner has to call invalidate() whenever its
+ * surface changes or goes away.
+ */
+class TransformCache {
+public:
+	typedef Common::SharedPtr<Surface> SurfacePtr;
+
+	struct Stats {
+		uint32 hits;
+		uint32 misses;
+		uint32 evictions;
+	};
+
+	enum {
+		kDefaultMemoryBudget = 16 * 1024 * 1024
+	};
+
+	TransformCache(uint32 memoryBudget = kDefaultMemoryBudget);
+	~TransformCache();
+
+	/**
+	 * Return the part srcRect of the 32 bit surface src scaled to the given
+	 * size, like TransparentSurface::scaleT().
+	 */
+	SurfacePtr scale(const void *owner, const Surface &src, const Common::Rect &srcRect, uint16 newWidth, uint16 newHeight, TFilteringMode filteringMode);
+
+	/**
+	 * Return the part srcRect of the 32 bit surface src rotated and scaled,
+	 * like TransparentSurface::rotoscaleT().
+	 */
+	SurfacePtr rotoscale(const void *owner, const Surface &src, const Common::Rect &srcRect, const TransformStruct &transform, TFilteringMode filteringMode);
+
+	/** Drop the copies of the surface of the given owner. */
+	void invalidate(const void *owner);
+
+	/** Drop all copies. */
+	void clear();
+
+	/** Set the number of bytes the copies may take, dropping copies if needed. */
+	void setMemoryBudget(uint32 memoryBudget);
+	uint32 getMemoryBudget() const { return _memoryBudget; }
+
+	/** Return the number of bytes taken by the cached copies. */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+
+	/** Return the number of cached copies. */
+	uint size() const { return _entries.size(); }
+
+	const Stats &getStats() const { return _stats; }
+	void resetStats();
+
+private:
+	struct Key {
+		const void *owner;
+		Common::Rect srcRect;
+		uint16 width, height;
+		int32 angle;
+		Common::Point zoom;
+		Common::Point hotspot;
+		TFilteringMode filteringMode;
+
+		bool operator==(const Key &key) const;
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const;
+	};
+
+	typedef Common::List<Key> KeyList;
+
+	struct Entry {
+		SurfacePtr surface;
+		uint32 size;
+		KeyList::iterator lruPos;
+	};
+
+	typedef Common::HashMap<Key, Entry, KeyHash> EntryMap;
+
+	SurfacePtr lookup(const Key &key);
+	SurfacePtr insert(const Key &key, Surface *surface);
+	void evict(uint32 memoryBudget);
+
+	EntryMap _entries;
+	/** The keys of the entries, most recently used first */
+	KeyList _lru;
+	uint32 _memoryBudget;
+	uint32 _memoryUsage;
+	Stats _stats;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -33,6 +33,7 @@
 #include "common/rect.h"
 #include "common/math.h"
 #include "common/textconsole.h"
+#include "graphics/blit_kernels.h"
 #include "graphics/primitives.h"
 #include "graphics/transparent_surface.h"
 #include "graphics/transform_tools.h"
@@ -396,6 +397,68 @@ void doBlitMultiplyBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 
 }
 
+/**
+ * Blit the largest part of the rows the kernel can handle with it, and
+ * return the number of columns blitted.
+ */
+static uint32 blitKernelRows(void (*blitRow)(byte *, const byte *, uint32, int32), byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep) {
+	const uint32 kernelWidth = width & ~3;
+	if (kernelWidth) {
+		for (uint32 i = 0; i < height; i++, ino += inoStep, outo += pitch)
+			blitRow(outo, ino, kernelWidth, inStep);
+	}
+	return kernelWidth;
+}
+
+static uint32 blitKernelRows(void (*blitRow)(byte *, const byte *, uint32, int32, uint32), byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	const uint32 kernelWidth = width & ~3;
+	if (kernelWidth) {
+		for (uint32 i = 0; i < height; i++, ino += inoStep, outo += pitch)
+			blitRow(outo, ino, kernelWidth, inStep, color);
+	}
+	return kernelWidth;
+}
+
+/**
+ * Blit with the given color modulation and blend mode, using the SIMD
+ * kernels when possible. The plain C++ code blits the remaining columns.
+ */
+static void doBlit(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color, TSpriteBlendMode blendMode, AlphaType alphaMode) {
+	const BlitKernels *kernels = getBlitKernels();
+	uint32 done = 0;
+
+	if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && alphaMode == ALPHA_OPAQUE) {
+		// The opaque blitter always copies rows forwards
+		if (kernels && inStep == 4)
+			done = blitKernelRows(kernels->blitOpaque, ino, outo, width, height, pitch, inStep, inoStep);
+		if (done < width)
+			doBlitOpaqueFast(ino + (int32)done * inStep, outo + done * 4, width - done, height, pitch, inStep, inoStep);
+	} else if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && alphaMode == ALPHA_BINARY) {
+		if (kernels)
+			done = blitKernelRows(kernels->blitBinary, ino, outo, width, height, pitch, inStep, inoStep);
+		if (done < width)
+			doBlitBinaryFast(ino + (int32)done * inStep, outo + done * 4, width - done, height, pitch, inStep, inoStep);
+	} else if (blendMode == BLEND_ADDITIVE) {
+		if (kernels)
+			done = blitKernelRows(kernels->blitAdditiveBlend, ino, outo, width, height, pitch, inStep, inoStep, color);
+		if (done < width)
+			doBlitAdditiveBlend(ino + (int32)done * inStep, outo + done * 4, width - done, height, pitch, inStep, inoStep, color);
+	} else if (blendMode == BLEND_SUBTRACTIVE) {
+		doBlitSubtractiveBlend(ino, outo, width, height, pitch, inStep, inoStep, color);
+	} else if (blendMode == BLEND_MULTIPLY) {
+		if (kernels)
+			done = blitKernelRows(kernels->blitMultiplyBlend, ino, outo, width, height, pitch, inStep, inoStep, color);
+		if (done < width)
+			doBlitMultiplyBlend(ino + (int32)done * inStep, outo + done * 4, width - done, height, pitch, inStep, inoStep, color);
+	} else {
+		assert(blendMode == BLEND_NORMAL);
+		if (kernels)
+			done = blitKernelRows(kernels->blitAlphaBlend, ino, outo, width, height, pitch, inStep, inoStep, color);
+		if (done < width)
+			doBlitAlphaBlend(ino + (int32)done * inStep, outo + done * 4, width - done, height, pitch, inStep, inoStep, color);
+	}
+}
+
 Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, TSpriteBlendMode blendMode) {
 
 	Common::Rect retSize;
@@ -513,23 +576,7 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 		byte *ino = (byte *)img->getBasePtr(xp, yp);
 		byte *outo = (byte *)target.getBasePtr(posX, posY);
 
-		if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_OPAQUE) {
-			doBlitOpaqueFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-		} else if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_BINARY) {
-			doBlitBinaryFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-		} else {
-			if (blendMode == BLEND_ADDITIVE) {
-				doBlitAdditiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else if (blendMode == BLEND_SUBTRACTIVE) {
-				doBlitSubtractiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else if (blendMode == BLEND_MULTIPLY) {
-				doBlitMultiplyBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else {
-				assert(blendMode == BLEND_NORMAL);
-				doBlitAlphaBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			}
-		}
-
+		doBlit(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color, blendMode, _alphaMode);
 	}
 
 	retSize.setWidth(img->w);
@@ -660,23 +707,7 @@ Common::Rect TransparentSurface::blitClip(Graphics::Surface &target, Common::Rec
 		byte *ino = (byte *)img->getBasePtr(xp, yp);
 		byte *outo = (byte *)target.getBasePtr(posX, posY);
 
-		if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_OPAQUE) {
-			doBlitOpaqueFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-		} else if (color == 0xFFFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_BINARY) {
-			doBlitBinaryFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
-		} else {
-			if (blendMode == BLEND_ADDITIVE) {
-				doBlitAdditiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else if (blendMode == BLEND_SUBTRACTIVE) {
-				doBlitSubtractiveBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else if (blendMode == BLEND_MULTIPLY) {
-				doBlitMultiplyBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			} else {
-				assert(blendMode == BLEND_NORMAL);
-				doBlitAlphaBlend(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
-			}
-		}
-
+		doBlit(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color, blendMode, _alphaMode);
 	}
 
 	retSize.setWidth(img->w);
@@ -841,11 +872,17 @@ TransparentSurface *TransparentSurface::rotoscaleT(const TransformStruct &transf
 	int sh = srcH - 1;
 
 	tColorRGBA *pc = (tColorRGBA*)target->getBasePtr(0, 0);
+	const BlitKernels *kernels = (filteringMode == FILTER_BILINEAR && !flipx && !flipy) ? getBlitKernels() : nullptr;
 
 	for (int y = 0; y < dstH; y++) {
 		int t = cy - y;
 		int sdx = ax + (isinx * t) + xd;
 		int sdy = ay - (icosy * t) + yd;
+		if (kernels) {
+			kernels->rotoscaleBilinearRow((uint32 *)pc, (const byte *)getPixels(), pitch, srcW, srcH, sdx, sdy, icosx, isiny, dstW);
+			pc += dstW;
+			continue;
+		}
 		for (int x = 0; x < dstW; x++) {
 			int dx = (sdx >> 16);
 			int dy = (sdy >> 16);
@@ -981,86 +1018,96 @@ TransparentSurface *TransparentSurface::scaleT(uint16 newWidth, uint16 newHeight
 			sp += spixelgap * spixelh;
 		}
 
-		csay = say;
-		for (int y = 0; y < dstH; y++) {
-			const tColorRGBA *csp = sp;
-			csax = sax;
-			for (int x = 0; x < dstW; x++) {
-				/*
-				* Setup color source pointers
-				*/
-				int ex = (*csax & 0xffff);
-				int ey = (*csay & 0xffff);
-				int cx = (*csax >> 16);
-				int cy = (*csay >> 16);
-
-				const tColorRGBA *c00, *c01, *c10, *c11;
-				c00 = sp;
-				c01 = sp;
-				c10 = sp;
-				if (cy < spixelh) {
-					if (flipy) {
-						c10 -= spixelgap;
-					} else {
-						c10 += spixelgap;
+		const BlitKernels *kernels = (!flipx && !flipy) ? getBlitKernels() : nullptr;
+		if (kernels) {
+			for (int y = 0; y < dstH; y++) {
+				const int cy = say[y] >> 16;
+				const uint32 *row0 = (const uint32 *)sp + cy * spixelgap;
+				const uint32 *row1 = (cy < spixelh) ? row0 + spixelgap : row0;
+				kernels->scaleBilinearRow((uint32 *)target->getBasePtr(0, y), row0, row1, sax, dstW, spixelw, say[y] & 0xffff);
+			}
+		} else {
+			csay = say;
+			for (int y = 0; y < dstH; y++) {
+				const tColorRGBA *csp = sp;
+				csax = sax;
+				for (int x = 0; x < dstW; x++) {
+					/*
+					* Setup color source pointers
+					*/
+					int ex = (*csax & 0xffff);
+					int ey = (*csay & 0xffff);
+					int cx = (*csax >> 16);
+					int cy = (*csay >> 16);
+
+					const tColorRGBA *c00, *c01, *c10, *c11;
+					c00 = sp;
+					c01 = sp;
+					c10 = sp;
+					if (cy < spixelh) {
+						if (flipy) {
+							c10 -= spixelgap;
+						} else {
+							c10 += spixelgap;
+						}
 					}
-				}
-				c11 = c10;
-				if (cx < spixelw) {
+					c11 = c10;
+					if (cx < spixelw) {
+						if (flipx) {
+							c01--;
+							c11--;
+						} else {
+							c01++;
+							c11++;
+						}
+					}
+
+					/*
+					* Draw and interpolate colors
+					*/
+					int t1, t2;
+					t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
+					t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
+					dp->r = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
+					t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
+					dp->g = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
+					t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
+					dp->b = (((t2 - t1) * ey) >> 16) + t1;
+					t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
+					t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
+					dp->a = (((t2 - t1) * ey) >> 16) + t1;
+
+					/*
+					* Advance source pointer x
+					*/
+					int *salastx = csax;
+					csax++;
+					int sstepx = (*csax >> 16) - (*salastx >> 16);
 					if (flipx) {
-						c01--;
-						c11--;
+						sp -= sstepx;
 					} else {
-						c01++;
-						c11++;
+						sp += sstepx;
 					}
-				}
-
-				/*
-				* Draw and interpolate colors
-				*/
-				int t1, t2;
-				t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
-				t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
-				dp->r = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
-				t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
-				dp->g = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
-				t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
-				dp->b = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
-				t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
-				dp->a = (((t2 - t1) * ey) >> 16) + t1;
 
+					/*
+					* Advance destination pointer x
+					*/
+					dp++;
+				}
 				/*
-				* Advance source pointer x
+				* Advance source pointer y
 				*/
-				int *salastx = csax;
-				csax++;
-				int sstepx = (*csax >> 16) - (*salastx >> 16);
-				if (flipx) {
-					sp -= sstepx;
+				int *salasty = csay;
+				csay++;
+				int sstepy = (*csay >> 16) - (*salasty >> 16);
+				sstepy *= spixelgap;
+				if (flipy) {
+					sp = csp - sstepy;
 				} else {
-					sp += sstepx;
+					sp = csp + sstepy;
 				}
-
-				/*
-				* Advance destination pointer x
-				*/
-				dp++;
-			}
-			/*
-			* Advance source pointer y
-			*/
-			int *salasty = csay;
-			csay++;
-			int sstepy = (*csay >> 16) - (*salasty >> 16);
-			sstepy *= spixelgap;
-			if (flipy) {
-				sp = csp - sstepy;
-			} else {
-				sp = csp + sstepy;
 			}
 		}
 
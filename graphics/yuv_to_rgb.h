@@ -42,6 +42,7 @@
 namespace Graphics {
 
 class YUVToRGBLookup;
+struct YUVToRGBKernels;
 
 class YUVToRGBManager : public Common::Singleton<YUVToRGBManager> {
 public:
@@ -102,6 +103,16 @@ public:
 	 */
 	void convert410(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+	/**
+	 * Select the vectorized kernels used for the conversions, or 0 to only
+	 * use the lookup tables. By default, the fastest kernels supported by
+	 * the CPU are used. Meant for tests and benchmarks.
+	 */
+	void setKernels(const YUVToRGBKernels *kernels) { _kernels = kernels; }
+
+	/** Return the kernels used for the conversions, or 0 if there are none. */
+	const YUVToRGBKernels *getKernels() const { return _kernels; }
+
 private:
 	friend class Common::Singleton<SingletonBaseType>;
 	YUVToRGBManager();
@@ -110,6 +121,7 @@ private:
 	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
 
 	YUVToRGBLookup *_lookup;
+	const YUVToRGBKernels *_kernels;
 	int16 _colorTab[4 * 256]; // 2048 bytes
 };
 
@@ -0,0 +1,88 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_YUV_TO_RGB_KERNELS_H
+#define GRAPHICS_YUV_TO_RGB_KERNELS_H
+
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+/**
+ * The description of the destination pixel format used by the YUV to RGB
+ * kernels, see PixelFormat::RGBToColor().
+ */
+struct YUVToRGBParams {
+	byte rLoss, gLoss, bLoss;
+	byte rShift, gShift, bShift;
+
+	/** The alpha bits set in every pixel */
+	uint32 alphaBits;
+
+	/** Whether luminance values range from [16, 235] instead of [0, 255] */
+	bool itu;
+};
+
+/**
+ * Vectorized row converters for YUVToRGBManager. They compute the colors
+ * with fixed point arithmetic that gives bit-identical results to the
+ * lookup tables used by the manager otherwise.
+ *
+ * The width passed to all converters must be a multiple of 16. They read
+ * and write exactly width pixels; the manager converts the remaining
+ * pixels of a row with the lookup tables.
+ */
+struct YUVToRGBKernels {
+	/** Convert a row with one chroma sample per pixel. */
+	void (*convert444Row16)(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params);
+	void (*convert444Row32)(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params);
+
+	/** Convert a row with one chroma sample per two pixels. */
+	void (*convert420Row16)(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params);
+	void (*convert420Row32)(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params);
+
+	/**
+	 * Convert a row with one chroma sample per four pixels, interpolating
+	 * between uSrc/vSrc and the chroma row uvPitch bytes below. yDiff is
+	 * the position of the row between the two chroma rows, from 0 to 3.
+	 * Like YUVToRGBManager::convert410(), this reads one chroma sample
+	 * past the end of the row.
+	 */
+	void (*convert410Row16)(uint16 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, int uvPitch, int yDiff, const YUVToRGBParams &params);
+	void (*convert410Row32)(uint32 *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, int uvPitch, int yDiff, const YUVToRGBParams &params);
+};
+
+#ifdef SCUMMVM_SSE2
+/** Kernels using SSE2. Only use them if OSystem::kFeatureCpuSSE2 is set. */
+const YUVToRGBKernels &getSSE2YUVToRGBKernels();
+#endif
+
+/**
+ * Return the fastest kernels supported by the CPU, or 0 if there are none
+ * and the lookup tables should be used. The choice is made once, on the
+ * first call.
+ */
+const YUVToRGBKernels *getYUVToRGBKernels();
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,308 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/yuv_to_rgb_kernels.h"
+
+#ifdef SCUMMVM_SSE2
+
+#include "common/endian.h"
+
+#include <emmintrin.h>
+
+namespace Graphics {
+
+namespace {
+
+/**
+ * The fixed point factors of the chroma terms. With c the chroma value
+ * minus 128, ((|c| << 1) * factor) >> 16 gives the same result as
+ * truncating the floating point products the lookup tables are built of.
+ */
+enum {
+	kCrToR = 45876, // 0.419 / 0.299
+	kCrToG = 23368, // 0.299 / 0.419
+	kCbToG = 11281, // 0.114 / 0.331
+	kCbToB = 58109, // 0.587 / 0.331
+
+	// ((c << 1) * kITUScale) >> 16 == c * 255 / 219 for c from 0 to 219
+	kITUScale = 38155
+};
+
+struct Format {
+	__m128i rLoss, gLoss, bLoss;
+	__m128i rShift, gShift, bShift;
+	__m128i alpha16, alpha32;
+	bool itu;
+
+	/**
+	 * Whether every color component takes a whole byte of 32 bit pixels,
+	 * which can then be assembled by interleaving the bytes. fill holds
+	 * the value of each byte that is not a color component.
+	 */
+	bool bytes;
+	int rByte, gByte, bByte;
+	__m128i fill[4];
+};
+
+/** The color components of eight pixels, or their chroma terms. */
+struct Components {
+	__m128i r, g, b;
+};
+
+} // End of anonymous namespace
+
+static FORCEINLINE Format prepareFormat(const YUVToRGBParams &params) {
+	Format f;
+	f.rLoss = _mm_cvtsi32_si128(params.rLoss);
+	f.gLoss = _mm_cvtsi32_si128(params.gLoss);
+	f.bLoss = _mm_cvtsi32_si128(params.bLoss);
+	f.rShift = _mm_cvtsi32_si128(params.rShift);
+	f.gShift = _mm_cvtsi32_si128(params.gShift);
+	f.bShift = _mm_cvtsi32_si128(params.bShift);
+	f.alpha16 = _mm_set1_epi16((int16)params.alphaBits);
+	f.alpha32 = _mm_set1_epi32((int32)params.alphaBits);
+	f.itu = params.itu;
+
+	f.rByte = params.rShift / 8;
+	f.gByte = params.gShift / 8;
+	f.bByte = params.bShift / 8;
+	f.bytes = !params.rLoss && !params.gLoss && !params.bLoss &&
+		!(params.rShift & 7) && !(params.gShift & 7) && !(params.bShift & 7);
+	for (int i = 0; i < 4; i++) {
+		const byte fill = (byte)(params.alphaBits >> (i * 8));
+		f.fill[i] = _mm_set1_epi8((char)fill);
+		if (fill != 0 && fill != 0xFF)
+			f.bytes = false;
+	}
+	return f;
+}
+
+/** Return the truncated product of the chroma values and a factor. */
+static FORCEINLINE __m128i mulChroma(__m128i absChroma2, __m128i sign, int factor) {
+	const __m128i x = _mm_mulhi_epu16(absChroma2, _mm_set1_epi16((int16)factor));
+	return _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+}
+
+/** Compute the chroma terms of eight pixels from their U and V values. */
+static FORCEINLINE Components chromaOffsets(__m128i u, __m128i v) {
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i cu = _mm_sub_epi16(u, bias);
+	const __m128i cv = _mm_sub_epi16(v, bias);
+	const __m128i su = _mm_srai_epi16(cu, 15);
+	const __m128i sv = _mm_srai_epi16(cv, 15);
+	const __m128i au = _mm_slli_epi16(_mm_sub_epi16(_mm_xor_si128(cu, su), su), 1);
+	const __m128i av = _mm_slli_epi16(_mm_sub_epi16(_mm_xor_si128(cv, sv), sv), 1);
+
+	Components c;
+	c.r = mulChroma(av, sv, kCrToR);
+	c.g = _mm_add_epi16(mulChroma(av, sv, kCrToG), mulChroma(au, su, kCbToG));
+	c.b = mulChroma(au, su, kCbToB);
+	return c;
+}
+
+/** Scale a color component from ITU luminance, clamping it to [0, 255]. */
+static FORCEINLINE __m128i scaleITU(__m128i x) {
+	x = _mm_max_epi16(_mm_min_epi16(x, _mm_set1_epi16(235)), _mm_set1_epi16(16));
+	x = _mm_slli_epi16(_mm_sub_epi16(x, _mm_set1_epi16(16)), 1);
+	return _mm_mulhi_epu16(x, _mm_set1_epi16((int16)kITUScale));
+}
+
+/** Clamp a color component to [0, 255], scaling it first for ITU luminance. */
+static FORCEINLINE __m128i clampComponent(__m128i x, bool itu) {
+	if (itu)
+		return scaleITU(x);
+
+	return _mm_max_epi16(_mm_min_epi16(x, _mm_set1_epi16(255)), _mm_setzero_si128());
+}
+
+static FORCEINLINE __m128i packComponents16(const Components &c, const Format &f) {
+	const __m128i r = _mm_sll_epi16(_mm_srl_epi16(clampComponent(c.r, f.itu), f.rLoss), f.rShift);
+	const __m128i g = _mm_sll_epi16(_mm_srl_epi16(clampComponent(c.g, f.itu), f.gLoss), f.gShift);
+	const __m128i b = _mm_sll_epi16(_mm_srl_epi16(clampComponent(c.b, f.itu), f.bLoss), f.bShift);
+	return _mm_or_si128(_mm_or_si128(f.alpha16, r), _mm_or_si128(g, b));
+}
+
+static FORCEINLINE void storePixels(uint16 *dst, const Components &lo, const Components &hi, const Format &f) {
+	_mm_storeu_si128((__m128i *)dst, packComponents16(lo, f));
+	_mm_storeu_si128((__m128i *)(dst + 8), packComponents16(hi, f));
+}
+
+static FORCEINLINE __m128i packComponents32(__m128i r, __m128i g, __m128i b, const Format &f) {
+	r = _mm_sll_epi32(r, f.rShift);
+	g = _mm_sll_epi32(g, f.gShift);
+	b = _mm_sll_epi32(b, f.bShift);
+	return _mm_or_si128(_mm_or_si128(f.alpha32, r), _mm_or_si128(g, b));
+}
+
+static FORCEINLINE void storePixels32(uint32 *dst, const Components &c, const Format &f) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i r = _mm_srl_epi16(clampComponent(c.r, f.itu), f.rLoss);
+	const __m128i g = _mm_srl_epi16(clampComponent(c.g, f.itu), f.gLoss);
+	const __m128i b = _mm_srl_epi16(clampComponent(c.b, f.itu), f.bLoss);
+	_mm_storeu_si128((__m128i *)dst, packComponents32(_mm_unpacklo_epi16(r, zero),
+		_mm_unpacklo_epi16(g, zero), _mm_unpacklo_epi16(b, zero), f));
+	_mm_storeu_si128((__m128i *)(dst + 4), packComponents32(_mm_unpackhi_epi16(r, zero),
+		_mm_unpackhi_epi16(g, zero), _mm_unpackhi_epi16(b, zero), f));
+}
+
+/** Pack the components of sixteen pixels to bytes, clamping them. */
+static FORCEINLINE __m128i packBytes(__m128i lo, __m128i hi, bool itu) {
+	if (itu)
+		return _mm_packus_epi16(scaleITU(lo), scaleITU(hi));
+
+	return _mm_packus_epi16(lo, hi);
+}
+
+static FORCEINLINE void storePixels(uint32 *dst, const Components &lo, const Components &hi, const Format &f) {
+	if (!f.bytes) {
+		storePixels32(dst, lo, f);
+		storePixels32(dst + 8, hi, f);
+		return;
+	}
+
+	__m128i bytes[4] = { f.fill[0], f.fill[1], f.fill[2], f.fill[3] };
+	bytes[f.rByte] = packBytes(lo.r, hi.r, f.itu);
+	bytes[f.gByte] = packBytes(lo.g, hi.g, f.itu);
+	bytes[f.bByte] = packBytes(lo.b, hi.b, f.itu);
+
+	const __m128i lo01 = _mm_unpacklo_epi8(bytes[0], bytes[1]);
+	const __m128i hi01 = _mm_unpackhi_epi8(bytes[0], bytes[1]);
+	const __m128i lo23 = _mm_unpacklo_epi8(bytes[2], bytes[3]);
+	const __m128i hi23 = _mm_unpackhi_epi8(bytes[2], bytes[3]);
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpacklo_epi16(hi01, hi23));
+	_mm_storeu_si128((__m128i *)(dst + 12), _mm_unpackhi_epi16(hi01, hi23));
+}
+
+static FORCEINLINE Components addLuminance(__m128i y, const Components &chroma) {
+	Components c;
+	c.r = _mm_add_epi16(y, chroma.r);
+	c.g = _mm_sub_epi16(y, chroma.g);
+	c.b = _mm_add_epi16(y, chroma.b);
+	return c;
+}
+
+/** Convert and store sixteen pixels from their luminance and chroma terms. */
+template<typename PixelInt>
+static FORCEINLINE void convert16(PixelInt *dst, __m128i y, const Components &chromaLo, const Components &chromaHi, const Format &f) {
+	const __m128i zero = _mm_setzero_si128();
+	storePixels(dst, addLuminance(_mm_unpacklo_epi8(y, zero), chromaLo),
+		addLuminance(_mm_unpackhi_epi8(y, zero), chromaHi), f);
+}
+
+template<typename PixelInt>
+static void convert444Row(PixelInt *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params) {
+	const Format f = prepareFormat(params);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (uint x = 0; x < width; x += 16) {
+		const __m128i u = _mm_loadu_si128((const __m128i *)(uSrc + x));
+		const __m128i v = _mm_loadu_si128((const __m128i *)(vSrc + x));
+
+		convert16(dst + x, _mm_loadu_si128((const __m128i *)(ySrc + x)),
+			chromaOffsets(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(v, zero)),
+			chromaOffsets(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(v, zero)), f);
+	}
+}
+
+template<typename PixelInt>
+static void convert420Row(PixelInt *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, const YUVToRGBParams &params) {
+	const Format f = prepareFormat(params);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (uint x = 0; x < width; x += 16) {
+		const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2)), zero);
+		const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2)), zero);
+
+		// Every chroma sample covers two pixels
+		const Components chroma = chromaOffsets(u, v);
+		Components lo, hi;
+		lo.r = _mm_unpacklo_epi16(chroma.r, chroma.r);
+		lo.g = _mm_unpacklo_epi16(chroma.g, chroma.g);
+		lo.b = _mm_unpacklo_epi16(chroma.b, chroma.b);
+		hi.r = _mm_unpackhi_epi16(chroma.r, chroma.r);
+		hi.g = _mm_unpackhi_epi16(chroma.g, chroma.g);
+		hi.b = _mm_unpackhi_epi16(chroma.b, chroma.b);
+
+		convert16(dst + x, _mm_loadu_si128((const __m128i *)(ySrc + x)), lo, hi, f);
+	}
+}
+
+/**
+ * Interpolate the chroma values of sixteen pixels from five chroma samples
+ * of two rows, the same way as the lookup table code does.
+ */
+static FORCEINLINE void interpolate410(const byte *src, int uvPitch, __m128i topWeight, __m128i bottomWeight, __m128i &lo, __m128i &hi) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i top = _mm_unpacklo_epi8(_mm_cvtsi32_si128(READ_UINT32(src)), zero);
+	__m128i bottom = _mm_unpacklo_epi8(_mm_cvtsi32_si128(READ_UINT32(src + uvPitch)), zero);
+	top = _mm_insert_epi16(top, src[4], 4);
+	bottom = _mm_insert_epi16(bottom, src[uvPitch + 4], 4);
+
+	// Interpolate vertically, then horizontally between neighbouring columns
+	const __m128i col = _mm_add_epi16(_mm_mullo_epi16(top, topWeight), _mm_mullo_epi16(bottom, bottomWeight));
+	const __m128i next = _mm_srli_si128(col, 2);
+	const __m128i colPairs = _mm_unpacklo_epi16(col, col);
+	const __m128i nextPairs = _mm_unpacklo_epi16(next, next);
+	const __m128i rightWeight = _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+	const __m128i leftWeight = _mm_sub_epi16(_mm_set1_epi16(4), rightWeight);
+
+	lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi32(colPairs, colPairs), leftWeight),
+	                   _mm_mullo_epi16(_mm_unpacklo_epi32(nextPairs, nextPairs), rightWeight));
+	hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi32(colPairs, colPairs), leftWeight),
+	                   _mm_mullo_epi16(_mm_unpackhi_epi32(nextPairs, nextPairs), rightWeight));
+	lo = _mm_srli_epi16(lo, 4);
+	hi = _mm_srli_epi16(hi, 4);
+}
+
+template<typename PixelInt>
+static void convert410Row(PixelInt *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, uint width, int uvPitch, int yDiff, const YUVToRGBParams &params) {
+	const Format f = prepareFormat(params);
+	const __m128i topWeight = _mm_set1_epi16(4 - yDiff);
+	const __m128i bottomWeight = _mm_set1_epi16(yDiff);
+
+	for (uint x = 0; x < width; x += 16) {
+		__m128i uLo, uHi, vLo, vHi;
+		interpolate410(uSrc + x / 4, uvPitch, topWeight, bottomWeight, uLo, uHi);
+		interpolate410(vSrc + x / 4, uvPitch, topWeight, bottomWeight, vLo, vHi);
+
+		convert16(dst + x, _mm_loadu_si128((const __m128i *)(ySrc + x)),
+			chromaOffsets(uLo, vLo), chromaOffsets(uHi, vHi), f);
+	}
+}
+
+const YUVToRGBKernels &getSSE2YUVToRGBKernels() {
+	static const YUVToRGBKernels kernels = {
+		convert444Row<uint16>,
+		convert444Row<uint32>,
+		convert420Row<uint16>,
+		convert420Row<uint32>,
+		convert410Row<uint16>,
+		convert410Row<uint32>
+	};
+	return kernels;
+}
+
+} // End of namespace Graphics
+
+#endif // SCUMMVM_SSE2
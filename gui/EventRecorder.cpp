@@ -512,13 +512,7 @@ void EventRecorder::takeScreenshot() {
 }
 
 bool EventRecorder::grabScreenAndComputeMD5(Graphics::Surface &screen, uint8 md5[16]) {
-	if (!createScreenShot(screen)) {
-		warning("Can't save screenshot");
-		return false;
-	}
-	Common::MemoryReadStream bitmapStream((const byte*)screen.getPixels(), screen.w * screen.h * screen.format.bytesPerPixel);
-	computeStreamMD5(bitmapStream, md5);
-	return true;
+	return Common::PlaybackFile::grabScreenAndComputeMD5(screen, md5);
 }
 
 Common::SeekableReadStream *EventRecorder::processSaveStream(const Common::String &fileName) {
@@ -87,6 +87,9 @@ struct WidgetDrawData {
 
 	DrawLayer _layer;
 
+	/** Whether the drawing can be kept in the widget cache */
+	bool _cacheable;
+
 
 	/**
 	 * Calculates the background threshold offset of a given DrawData item.
@@ -96,6 +99,13 @@ struct WidgetDrawData {
 	 * value will be added when restoring the background of the widget.
 	 */
 	void calcBackgroundOffset();
+
+	/**
+	 * Calculates whether drawing the DrawData item gives the same pixels
+	 * every time. This is the case when every DrawStep sets the colors
+	 * it uses, instead of taking the ones left by the previous drawing.
+	 */
+	void calcCacheable();
 };
 
 /**********************************************************
@@ -175,7 +185,8 @@ static const DrawDataInfo kDrawDataDefaults[] = {
 ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system(nullptr), _vectorRenderer(nullptr),
 	_layerToDraw(kDrawLayerBackground), _bytesPerPixel(0),  _graphicsMode(kGfxDisabled),
-	_font(nullptr), _initOk(false), _themeOk(false), _enabled(false), _themeFiles(),
+	_font(nullptr), _dirtyScreen(Graphics::DirtyRegion::kDefaultMaxRects, 0), _widgetCacheSize(0), _widgetCacheHits(0), _widgetCacheMisses(0),
+	_showRepaints(false), _initOk(false), _themeOk(false), _enabled(false), _themeFiles(),
 	_cursor(nullptr) {
 
 	_system = g_system;
@@ -223,6 +234,7 @@ ThemeEngine::~ThemeEngine() {
 	_vectorRenderer = nullptr;
 	_screen.free();
 	_backBuffer.free();
+	clearWidgetCache();
 
 	unloadTheme();
 
@@ -303,6 +315,8 @@ bool ThemeEngine::init() {
 	_overlayFormat = _system->getOverlayFormat();
 	setGraphicsMode(_graphicsMode);
 
+	_showRepaints = ConfMan.hasKey("gui_show_repaints") && ConfMan.getBool("gui_show_repaints");
+
 	if (_screen.getPixels() && _backBuffer.getPixels()) {
 		_initOk = true;
 	}
@@ -354,6 +368,7 @@ void ThemeEngine::clearAll() {
 	if (_initOk) {
 		_system->clearOverlay();
 		_system->grabOverlay(_backBuffer.getPixels(), _backBuffer.pitch);
+		clearWidgetCache();
 	}
 }
 
@@ -451,6 +466,9 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	// list. Clearing it avoids invalid overlay writes when the backend
 	// resizes the overlay.
 	_dirtyScreen.clear();
+	_repaintMarks.clear();
+	_restoredRect = Common::Rect();
+	clearWidgetCache();
 }
 
 void WidgetDrawData::calcBackgroundOffset() {
@@ -468,6 +486,28 @@ void WidgetDrawData::calcBackgroundOffset() {
 	_shadowOffset = maxShadow;
 }
 
+void WidgetDrawData::calcCacheable() {
+	_cacheable = true;
+	for (Common::List<Graphics::DrawStep>::const_iterator step = _steps.begin();
+	        step != _steps.end(); ++step) {
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_BITMAP ||
+		        step->drawingCall == &Graphics::VectorRenderer::drawCallback_ALPHABITMAP ||
+		        step->drawingCall == &Graphics::VectorRenderer::drawCallback_VOID)
+			continue;
+
+		const bool usesFg = step->stroke || (step->fillMode != Graphics::VectorRenderer::kFillBackground &&
+		                                     step->fillMode != Graphics::VectorRenderer::kFillGradient);
+		const bool usesBg = step->fillMode == Graphics::VectorRenderer::kFillBackground;
+		const bool usesGradient = step->fillMode == Graphics::VectorRenderer::kFillGradient;
+		const bool usesBevel = step->bevel || step->drawingCall == &Graphics::VectorRenderer::drawCallback_BEVELSQ;
+
+		if ((usesFg && !step->fgColor.set) || (usesBg && !step->bgColor.set) ||
+		        (usesGradient && (!step->gradColor1.set || !step->gradColor2.set)) ||
+		        (usesBevel && !step->bevelColor.set))
+			_cacheable = false;
+	}
+}
+
 void ThemeEngine::restoreBackground(Common::Rect r) {
 	if (_vectorRenderer->getActiveSurface() == &_backBuffer) {
 		// Only restore the background when drawing to the screen surface
@@ -478,6 +518,7 @@ void ThemeEngine::restoreBackground(Common::Rect r) {
 	_vectorRenderer->blitSurface(&_backBuffer, r);
 
 	addDirtyRect(r);
+	_restoredRect = r;
 }
 
 
@@ -696,6 +737,7 @@ bool ThemeEngine::addDrawData(const Common::String &data, bool cached) {
 	_widgets[id] = new WidgetDrawData;
 	_widgets[id]->_layer = kDrawDataDefaults[id].layer;
 	_widgets[id]->_textDataId = kTextDataNone;
+	_widgets[id]->_cacheable = false;
 
 	return true;
 }
@@ -726,6 +768,7 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 			warning("Missing data asset: '%s'", kDrawDataDefaults[i].name);
 		} else {
 			_widgets[i]->calcBackgroundOffset();
+			_widgets[i]->calcCacheable();
 		}
 	}
 }
@@ -734,6 +777,8 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	clearWidgetCache();
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = nullptr;
@@ -885,15 +930,105 @@ void ThemeEngine::drawDD(DrawData type, const Common::Rect &r, uint32 dynamic, b
 		restoreBackground(extendedRect);
 
 	if (drawData->_layer == _layerToDraw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = drawData->_steps.begin(); step != drawData->_steps.end(); ++step) {
-			_vectorRenderer->drawStep(area, _clip, *step, dynamic);
+		// When the steps are drawn over the restored background, the result
+		// can be copied from the widget cache
+		Common::Rect screenRect = extendedRect;
+		screenRect.clip(_screen.w, _screen.h);
+		const bool cacheable = drawData->_cacheable && !screenRect.isEmpty() &&
+			_vectorRenderer->getActiveSurface() == &_screen && _restoredRect.contains(screenRect);
+
+		WidgetCacheKey key;
+		key.type = type;
+		key.area = area;
+		key.clip = _clip;
+		key.dynamic = dynamic;
+
+		if (!cacheable || !blitCachedWidget(key, screenRect)) {
+			Common::List<Graphics::DrawStep>::const_iterator step;
+			for (step = drawData->_steps.begin(); step != drawData->_steps.end(); ++step) {
+				_vectorRenderer->drawStep(area, _clip, *step, dynamic);
+			}
+
+			if (cacheable)
+				cacheWidget(key, screenRect);
 		}
 
 		addDirtyRect(extendedRect);
 	}
 }
 
+bool ThemeEngine::WidgetCacheKey::operator==(const WidgetCacheKey &key) const {
+	return type == key.type && area == key.area && clip == key.clip && dynamic == key.dynamic;
+}
+
+uint ThemeEngine::WidgetCacheKeyHash::operator()(const WidgetCacheKey &key) const {
+	uint hash = key.type;
+	hash = hash * 31 + (uint16)key.area.left;
+	hash = hash * 31 + (uint16)key.area.top;
+	hash = hash * 31 + (uint16)key.area.right;
+	hash = hash * 31 + (uint16)key.area.bottom;
+	hash = hash * 31 + (uint16)key.clip.left;
+	hash = hash * 31 + (uint16)key.clip.top;
+	hash = hash * 31 + (uint16)key.clip.right;
+	hash = hash * 31 + (uint16)key.clip.bottom;
+	return hash * 31 + key.dynamic;
+}
+
+bool ThemeEngine::blitCachedWidget(const WidgetCacheKey &key, const Common::Rect &r) {
+	WidgetCache::iterator cached = _widgetCache.find(key);
+	if (cached == _widgetCache.end()) {
+		++_widgetCacheMisses;
+		return false;
+	}
+
+	WidgetCacheEntry &entry = cached->_value;
+	if (entry.lruPos != _widgetCacheLRU.begin()) {
+		_widgetCacheLRU.erase(entry.lruPos);
+		_widgetCacheLRU.push_front(key);
+		entry.lruPos = _widgetCacheLRU.begin();
+	}
+
+	const Graphics::Surface *rendering = entry.rendering;
+	_screen.copyRectToSurface(*rendering, r.left, r.top, Common::Rect(rendering->w, rendering->h));
+	++_widgetCacheHits;
+	return true;
+}
+
+void ThemeEngine::cacheWidget(const WidgetCacheKey &key, const Common::Rect &r) {
+	const uint32 size = r.width() * r.height() * _screen.format.bytesPerPixel;
+
+	// Large areas like dialog backgrounds are rarely drawn again the same way
+	if (size > kWidgetCacheBudget / 8)
+		return;
+
+	evictWidgetCache(kWidgetCacheBudget - size);
+
+	Graphics::Surface *rendering = new Graphics::Surface();
+	rendering->copyFrom(_screen.getSubArea(r));
+
+	_widgetCacheLRU.push_front(key);
+	WidgetCacheEntry &entry = _widgetCache[key];
+	entry.rendering = rendering;
+	entry.size = size;
+	entry.lruPos = _widgetCacheLRU.begin();
+	_widgetCacheSize += size;
+}
+
+void ThemeEngine::evictWidgetCache(uint32 budget) {
+	while (_widgetCacheSize > budget && !_widgetCacheLRU.empty()) {
+		WidgetCache::iterator cached = _widgetCache.find(_widgetCacheLRU.back());
+		_widgetCacheSize -= cached->_value.size;
+		cached->_value.rendering->free();
+		delete cached->_value.rendering;
+		_widgetCache.erase(cached);
+		_widgetCacheLRU.pop_back();
+	}
+}
+
+void ThemeEngine::clearWidgetCache() {
+	evictWidgetCache(0);
+}
+
 void ThemeEngine::drawDDText(TextData type, TextColor color, const Common::Rect &r, const Common::String &text,
                              bool restoreBg, bool ellipsis, Graphics::TextAlign alignH, TextAlignVertical alignV,
                              int deltax, const Common::Rect &drawableTextArea) {
@@ -1351,6 +1486,9 @@ void ThemeEngine::updateScreen() {
 }
 
 void ThemeEngine::addDirtyRect(Common::Rect r) {
+	// Whatever was drawn there is not the back buffer anymore
+	_restoredRect = Common::Rect();
+
 	// Clip the rect to screen coords
 	r.clip(_screen.w, _screen.h);
 
@@ -1358,38 +1496,73 @@ void ThemeEngine::addDirtyRect(Common::Rect r) {
 	if (r.isEmpty())
 		return;
 
-	// Check if the new rectangle is contained within another in the list
-	Common::List<Common::Rect>::iterator it;
-	for (it = _dirtyScreen.begin(); it != _dirtyScreen.end();) {
-		// If we find a rectangle which fully contains the new one,
-		// we can abort the search.
-		if (it->contains(r))
-			return;
-
-		// Conversely, if we find rectangles which are contained in
-		// the new one, we can remove them
-		if (r.contains(*it))
-			it = _dirtyScreen.erase(it);
-		else
-			++it;
-	}
-
-	// If we got here, we can safely add r to the list of dirty rects.
-	_dirtyScreen.push_back(r);
+	// The region drops rects contained in another one, and merges the
+	// ones whose union is not larger than they are
+	_dirtyScreen.addRect(r);
 }
 
 void ThemeEngine::updateDirtyScreen() {
 	if (_dirtyScreen.empty())
 		return;
 
+	const Common::Array<Common::Rect> &rects = _dirtyScreen.getRects();
+	for (uint i = 0; i < rects.size(); ++i) {
+		_vectorRenderer->copyFrame(_system, rects[i]);
+	}
+
+	// Erase the previous repaint marks, and draw the new ones
 	Common::List<Common::Rect>::iterator i;
-	for (i = _dirtyScreen.begin(); i != _dirtyScreen.end(); ++i) {
+	for (i = _repaintMarks.begin(); i != _repaintMarks.end(); ++i) {
 		_vectorRenderer->copyFrame(_system, *i);
 	}
+	_repaintMarks.clear();
+
+	if (_showRepaints)
+		drawRepaintMarks(rects);
 
 	_dirtyScreen.clear();
 }
 
+void ThemeEngine::drawRepaintMarks(const Common::Array<Common::Rect> &rects) {
+	const uint32 color = _overlayFormat.RGBToColor(255, 0, 255);
+	const int bpp = _overlayFormat.bytesPerPixel;
+
+	// A line of marker pixels, copied as rows and as columns
+	Graphics::Surface line;
+	line.create(MAX<int>(_screen.w, _screen.h), 1, _overlayFormat);
+	line.fillRect(Common::Rect(line.w, 1), color);
+
+	uint32 area = 0;
+	for (uint i = 0; i < rects.size(); ++i) {
+		const Common::Rect &r = rects[i];
+		area += r.width() * r.height();
+
+		_system->copyRectToOverlay(line.getPixels(), line.pitch, r.left, r.top, r.width(), 1);
+		_system->copyRectToOverlay(line.getPixels(), line.pitch, r.left, r.bottom - 1, r.width(), 1);
+		_system->copyRectToOverlay(line.getPixels(), bpp, r.left, r.top, 1, r.height());
+		_system->copyRectToOverlay(line.getPixels(), bpp, r.right - 1, r.top, 1, r.height());
+		_repaintMarks.push_back(r);
+	}
+	line.free();
+
+	if (_font) {
+		const Common::String text = Common::String::format("%u px (%u%%), %u rects, cache %u/%u",
+			area, area * 100 / (_screen.w * _screen.h), rects.size(),
+			_widgetCacheHits, _widgetCacheHits + _widgetCacheMisses);
+
+		Graphics::Surface label;
+		label.create(MIN<int>(_font->getStringWidth(text) + 4, _screen.w), MIN<int>(_font->getFontHeight() + 2, _screen.h), _overlayFormat);
+		label.fillRect(Common::Rect(label.w, label.h), _overlayFormat.RGBToColor(0, 0, 0));
+		_font->drawString(&label, text, 2, 1, label.w - 2, color);
+
+		_system->copyRectToOverlay(label.getPixels(), label.pitch, 0, 0, label.w, label.h);
+		_repaintMarks.push_back(Common::Rect(label.w, label.h));
+		label.free();
+	}
+
+	_widgetCacheHits = _widgetCacheMisses = 0;
+}
+
 void ThemeEngine::applyScreenShading(ShadingStyle style) {
 	if (style != kShadingNone) {
 		_vectorRenderer->applyScreenShading(style);
@@ -1939,6 +2112,9 @@ void ThemeEngine::hideCursor() {
 
 void ThemeEngine::drawToBackbuffer() {
 	_vectorRenderer->setSurface(&_backBuffer);
+
+	// The widget renderings include the current back buffer
+	clearWidgetCache();
 }
 
 void ThemeEngine::drawToScreen() {
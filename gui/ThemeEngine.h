@@ -31,6 +31,7 @@
 #include "common/str.h"
 #include "common/rect.h"
 
+#include "graphics/dirtyregion.h"
 #include "graphics/surface.h"
 #include "graphics/transparent_surface.h"
 #include "graphics/font.h"
@@ -629,12 +630,68 @@ protected:
 	Common::String genCacheFilename(const Common::String &filename) const;
 	const Graphics::Font *loadFont(const Common::String &filename, const Common::String &scalableFilename, const Common::String &charset, const int pointsize, const bool makeLocalizedFont);
 
+	/**
+	 * The widget cache holds renderings of DrawData descriptors drawn over the
+	 * restored background. They only depend on the descriptor, its area and
+	 * the clip rect, as long as the back buffer does not change.
+	 */
+	struct WidgetCacheKey {
+		DrawData type;
+		Common::Rect area;
+		Common::Rect clip;
+		uint32 dynamic;
+
+		bool operator==(const WidgetCacheKey &key) const;
+	};
+
+	struct WidgetCacheKeyHash {
+		uint operator()(const WidgetCacheKey &key) const;
+	};
+
+	typedef Common::List<WidgetCacheKey> WidgetCacheKeyList;
+
+	struct WidgetCacheEntry {
+		Graphics::Surface *rendering;
+		uint32 size;
+		WidgetCacheKeyList::iterator lruPos;
+	};
+
+	typedef Common::HashMap<WidgetCacheKey, WidgetCacheEntry, WidgetCacheKeyHash> WidgetCache;
+
+	enum {
+		/** Number of bytes the cached renderings may take */
+		kWidgetCacheBudget = 4 * 1024 * 1024
+	};
+
 	/**
 	 * Dirty Screen handling function.
 	 * Draws all the dirty rectangles in the list to the overlay.
 	 */
 	void updateDirtyScreen();
 
+	/**
+	 * Outline the rectangles just copied to the overlay, and write the area
+	 * they cover in the top left corner. The marks are drawn on the overlay
+	 * only, and are erased with the next screen update.
+	 */
+	void drawRepaintMarks(const Common::Array<Common::Rect> &rects);
+
+	/**
+	 * Copy the rendering of a DrawData descriptor from the widget cache to
+	 * the screen surface.
+	 *
+	 * @return false if the rendering is not cached.
+	 */
+	bool blitCachedWidget(const WidgetCacheKey &key, const Common::Rect &r);
+	/**
+	 * Copy the rendering of a DrawData descriptor from the screen surface to
+	 * the widget cache, dropping the least recently used renderings if
+	 * needed to stay within kWidgetCacheBudget.
+	 */
+	void cacheWidget(const WidgetCacheKey &key, const Common::Rect &r);
+	void evictWidgetCache(uint32 budget);
+	void clearWidgetCache();
+
 	/**
 	 * Draws a GUI element according to a DrawData descriptor.
 	 *
@@ -729,8 +786,28 @@ protected:
 	Graphics::PixelFormat _cursorFormat;
 #endif
 
-	/** List of all the dirty screens that must be blitted to the overlay. */
-	Common::List<Common::Rect> _dirtyScreen;
+	/**
+	 * The dirty screens that must be blitted to the overlay. Rectangles are
+	 * merged when their union covers no more pixels than they do.
+	 */
+	Graphics::DirtyRegion _dirtyScreen;
+
+	/**
+	 * Part of the screen surface which holds the back buffer since it was
+	 * last restored, until something else is drawn.
+	 */
+	Common::Rect _restoredRect;
+
+	WidgetCache _widgetCache;
+	/** The keys of the cached renderings, most recently used first */
+	WidgetCacheKeyList _widgetCacheLRU;
+	uint32 _widgetCacheSize;
+	uint _widgetCacheHits, _widgetCacheMisses;
+
+	/** Whether to outline the repainted rectangles, see drawRepaintMarks() */
+	bool _showRepaints;
+	/** The repaint marks on the overlay, to be erased by the next update */
+	Common::List<Common::Rect> _repaintMarks;
 
 	bool _initOk;  ///< Class and renderer properly initialized
 	bool _themeOk; ///< Theme data successfully loaded.
@@ -36,6 +36,8 @@
 
 #include "engines/engine.h"
 
+#include "graphics/dirtyregion.h"
+
 #include "gui/debugger.h"
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 	#include "gui/console.h"
@@ -77,6 +79,8 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+
+	registerCmd("dirtyrects",		WRAP_METHOD(Debugger, cmdDirtyRects));
 }
 
 Debugger::~Debugger() {
@@ -776,6 +780,27 @@ bool Debugger::cmdDebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdDirtyRects(int argc, const char **argv) {
+	if (argc > 1 && !scumm_stricmp(argv[1], "reset")) {
+		Graphics::DirtyRegion::resetTotalStats();
+		debugPrintf("Dirty rect statistics reset\n");
+		return true;
+	}
+
+	const Graphics::DirtyRegionStats &last = Graphics::DirtyRegion::getLastFrameStats();
+	debugPrintf("Last frame: %u rects submitted, %u merged, %u updated, %u pixels scaled\n",
+	            last.rectsSubmitted, last.rectsMerged, last.rectsUpdated, (uint32)last.pixelsUpdated);
+
+	const Graphics::DirtyRegionStats &total = Graphics::DirtyRegion::getTotalStats();
+	if (total.frames > 0) {
+		debugPrintf("Average of %u frames: %.1f rects submitted, %.1f merged, %.1f updated, %.0f pixels scaled\n",
+		            total.frames, (double)total.rectsSubmitted / total.frames, (double)total.rectsMerged / total.frames,
+		            (double)total.rectsUpdated / total.frames, (double)total.pixelsUpdated / total.frames);
+	}
+	debugPrintf("Use '%s reset' to restart the averages\n", argv[0]);
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
@@ -22,6 +22,7 @@
 
 #include "base/version.h"
 
+#include "common/algorithm.h"
 #include "common/config-manager.h"
 #include "common/events.h"
 #include "common/fs.h"
@@ -253,14 +254,50 @@ void LauncherDialog::close() {
 	Dialog::close();
 }
 
-void LauncherDialog::updateListing() {
-	StringArray l;
-	ListWidget::ColorList colors;
-	ThemeEngine::FontColor color;
+namespace {
+
+struct LauncherEntry {
+	Common::String key;
+	Common::String description;
+	Common::String gameid;
+	Common::String path;
+	bool isDirectory;
+};
+
+struct LauncherEntryComparator {
+	bool operator()(const LauncherEntry *x, const LauncherEntry *y) const {
+		const int cmp = scumm_stricmp(x->description.c_str(), y->description.c_str());
+		return cmp < 0 || (cmp == 0 && x->key < y->key);
+	}
+};
 
+enum {
+	/** Number of game paths checked by each job of checkGamePaths() */
+	kGamePathsPerJob = 256
+};
+
+struct GamePathCheck {
+	Common::Array<LauncherEntry> *entries;
+};
+
+/**
+ * Check whether the paths of a range of entries are directories. The jobs
+ * may run in parallel, so they only touch the strings of their own entries.
+ */
+void checkGamePaths(void *param, uint index) {
+	Common::Array<LauncherEntry> &entries = *((GamePathCheck *)param)->entries;
+	const uint end = MIN<uint>(entries.size(), (index + 1) * kGamePathsPerJob);
+	for (uint i = index * kGamePathsPerJob; i < end; ++i)
+		entries[i].isDirectory = Common::FSNode(entries[i].path).isDirectory();
+}
+
+} // End of anonymous namespace
+
+void LauncherDialog::updateListing() {
 	// Retrieve a list of all games defined in the config file
-	_domains.clear();
+	Common::Array<LauncherEntry> entries;
 	const ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
+	entries.reserve(domains.size());
 	ConfigManager::DomainMap::const_iterator iter;
 	for (iter = domains.begin(); iter != domains.end(); ++iter) {
 #ifdef __DS__
@@ -273,7 +310,6 @@ void LauncherDialog::updateListing() {
 
 		String gameid(iter->_value.getVal("gameid"));
 		String description(iter->_value.getVal("description"));
-		Common::FSNode path(iter->_value.getVal("path"));
 
 		if (gameid.empty())
 			gameid = iter->_key;
@@ -289,30 +325,57 @@ void LauncherDialog::updateListing() {
 		}
 
 		if (!gameid.empty() && !description.empty()) {
-			// Insert the game into the launcher list
-			int pos = 0, size = l.size();
-
-			while (pos < size && (scumm_stricmp(description.c_str(), l[pos].c_str()) > 0))
-				pos++;
+			LauncherEntry entry;
+			entry.key = iter->_key;
+			entry.description = description;
+			entry.gameid = gameid;
+			// Unshared copy, as the paths are checked on other threads
+			entry.path = String(iter->_value.getVal("path").c_str());
+			entry.isDirectory = false;
+			entries.push_back(entry);
+		}
+	}
 
-			color = ThemeEngine::kFontColorNormal;
-			if (!path.isDirectory()) {
-				color = ThemeEngine::kFontColorAlternate;
-				// If more conditions which grey out entries are added we should consider
-				// enabling this so that it is easy to spot why a certain game entry cannot
-				// be started.
+	// Looking up thousands of game paths is slow, do it on all the threads
+	GamePathCheck check;
+	check.entries = &entries;
+	g_system->runParallel(checkGamePaths, &check, (entries.size() + kGamePathsPerJob - 1) / kGamePathsPerJob);
 
-				// description += Common::String::format(" (%s)", _("Not found"));
-			}
+	Common::Array<const LauncherEntry *> sorted;
+	sorted.resize(entries.size());
+	for (uint i = 0; i < entries.size(); ++i)
+		sorted[i] = &entries[i];
+	Common::sort(sorted.begin(), sorted.end(), LauncherEntryComparator());
 
-			l.insert_at(pos, description);
-			colors.insert_at(pos, color);
-			_domains.insert_at(pos, iter->_key);
+	StringArray l, gameids;
+	ListWidget::ColorList colors;
+	_domains.clear();
+	l.reserve(sorted.size());
+	gameids.reserve(sorted.size());
+	colors.reserve(sorted.size());
+	_domains.reserve(sorted.size());
+	for (uint i = 0; i < sorted.size(); ++i) {
+		const LauncherEntry &entry = *sorted[i];
+
+		ThemeEngine::FontColor color = ThemeEngine::kFontColorNormal;
+		if (!entry.isDirectory) {
+			color = ThemeEngine::kFontColorAlternate;
+			// If more conditions which grey out entries are added we should consider
+			// enabling this so that it is easy to spot why a certain game entry cannot
+			// be started.
+
+			// description += Common::String::format(" (%s)", _("Not found"));
 		}
+
+		// Insert the game into the launcher list
+		l.push_back(entry.description);
+		gameids.push_back(entry.gameid);
+		colors.push_back(color);
+		_domains.push_back(entry.key);
 	}
 
 	const int oldSel = _list->getSelected();
-	_list->setList(l, &colors);
+	_list->setList(l, &colors, &gameids);
 	if (oldSel < (int)l.size())
 		_list->setSelected(oldSel);	// Restore the old selection
 	else if (oldSel != -1)
@@ -20,6 +20,7 @@
  *
  */
 
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
@@ -57,17 +58,15 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
-	_dirsScanned(0),
+	_scanner(startDir),
 	_oldGamesCount(0),
-	_dirTotal(0),
 	_okButton(nullptr),
 	_dirProgressText(nullptr),
 	_gameProgressText(nullptr) {
 
 	StringArray l;
 
-	// The dir we start our scan at
-	_scanStack.push(startDir);
+	DetectionCacheMan.resetStats();
 
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
@@ -169,39 +168,23 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (_scanner.isDone())
 		return;	// We have finished scanning
 
-	uint32 t = g_system->getMillis();
-
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
-
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
-
-		// Run the detector on the dir
-		DetectionResults detectionResults = EngineMan.detectGames(files);
-
-		if (detectionResults.foundUnknownGames()) {
-			Common::String report = detectionResults.generateUnknownGameReport(false, 80);
-			g_system->logMessage(LogMessageType::kInfo, report.c_str());
-		}
+	_scanner.scan(kMaxScanTime);
 
+	GameScanner::Result scanResult;
+	while (_scanner.popResult(scanResult)) {
 		// Just add all detected games / game variants. If we get more than one,
 		// that either means the directory contains multiple games, or the detector
 		// could not fully determine which game variant it was seeing. In either
 		// case, let the user choose which entries he wants to keep.
 		//
 		// However, we only add games which are not already in the config file.
-		DetectedGames candidates = detectionResults.listRecognizedGames();
-		for (DetectedGames::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
+		for (DetectedGames::const_iterator cand = scanResult.games.begin(); cand != scanResult.games.end(); ++cand) {
 			const DetectedGame &result = *cand;
 
-			Common::String path = dir.getPath();
+			Common::String path = scanResult.dir.getPath();
 
 			// Remove trailing slashes
 			while (path != "/" && path.lastChar() == '/')
@@ -236,41 +219,40 @@ void MassAddDialog::handleTickle() {
 
 			_list->append(result.description);
 		}
+	}
 
-
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
-
-				_dirTotal++;
-			}
-		}
-
-		_dirsScanned++;
+	const GameScannerStats &stats = _scanner.getStats();
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(stats.dirsDetected, stats.dirsFound);
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
-	}
 
 
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanner.isDone()) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
-		buf = _("Scan complete!");
+		// Keep the checksums of the scan, even if we crash later
+		DetectionCacheMan.flush();
+		debug(1, "Scanned %u directories in %u ms listing, %u ms hashing %u files and %u ms detecting",
+		      stats.dirsDetected, stats.listTime, stats.hashTime, stats.filesHashed, stats.detectTime);
+		debug(1, "Detection cache: %u hits, %u misses", DetectionCacheMan.getHits(), DetectionCacheMan.getMisses());
+
+		if (DetectionCacheMan.getHits() + DetectionCacheMan.getMisses())
+			buf = Common::String::format(_("Scan complete! %u%% of the checksums were cached."), DetectionCacheMan.getHitRate());
+		else
+			buf = _("Scan complete!");
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games."), _games.size(), _oldGamesCount);
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::String::format(_("Scanned %d directories ..."), stats.dirsDetected);
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
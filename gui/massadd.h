@@ -25,9 +25,9 @@
 
 #include "gui/dialog.h"
 #include "gui/widgets/list.h"
+#include "engines/gamescanner.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
-#include "common/stack.h"
 #include "common/str.h"
 
 namespace GUI {
@@ -50,7 +50,7 @@ public:
 	}
 
 private:
-	Common::Stack<Common::FSNode>  _scanStack;
+	GameScanner _scanner;
 	DetectedGames _games;
 
 	/**
@@ -60,9 +60,7 @@ private:
 	 */
 	Common::HashMap<Common::String, StringArray>	_pathToTargets;
 
-	int _dirsScanned;
 	int _oldGamesCount;
-	int _dirTotal;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
@@ -151,7 +151,7 @@ ThemeEngine::FontColor ListWidget::getSelectionColor() const {
 		return _listColors[_listIndex[_selectedItem]];
 }
 
-void ListWidget::setList(const StringArray &list, const ColorList *colors) {
+void ListWidget::setList(const StringArray &list, const ColorList *colors, const StringArray *searchKeys) {
 	if (_editMode && _caretVisible)
 		drawCaret(true);
 
@@ -167,6 +167,16 @@ void ListWidget::setList(const StringArray &list, const ColorList *colors) {
 		assert(_listColors.size() == _dataList.size());
 	}
 
+	// The filter never contains line breaks, so it can not match across
+	// the entry and its search keys
+	_searchList.resize(list.size());
+	for (uint i = 0; i < list.size(); ++i) {
+		_searchList[i] = list[i];
+		if (searchKeys)
+			_searchList[i] += '\n' + (*searchKeys)[i];
+		_searchList[i].toLowercase();
+	}
+
 	int size = list.size();
 	if (_currentPos >= size)
 		_currentPos = size - 1;
@@ -193,6 +203,8 @@ void ListWidget::append(const String &s, ThemeEngine::FontColor color) {
 
 	_dataList.push_back(s);
 	_list.push_back(s);
+	_searchList.push_back(s);
+	_searchList.back().toLowercase();
 
 	setFilter(_filter, false);
 
@@ -700,6 +712,11 @@ void ListWidget::setFilter(const String &filter, bool redraw) {
 	if (_filter == filt) // Filter was not changed
 		return;
 
+	// Typing more characters only narrows the matches down, so only the
+	// entries matching the previous filter need to be checked again
+	const bool narrowing = !_filter.empty() && filt.hasPrefix(_filter);
+	const Common::Array<int> previousMatches = narrowing ? _listIndex : Common::Array<int>();
+
 	_filter = filt;
 
 	if (_filter.empty()) {
@@ -711,26 +728,25 @@ void ListWidget::setFilter(const String &filter, bool redraw) {
 		// as substrings, ignoring case.
 
 		Common::StringTokenizer tok(_filter);
-		String tmp;
-		int n = 0;
 
 		_list.clear();
 		_listIndex.clear();
 
-		for (StringArray::iterator i = _dataList.begin(); i != _dataList.end(); ++i, ++n) {
-			tmp = *i;
-			tmp.toLowercase();
+		const uint count = narrowing ? previousMatches.size() : _dataList.size();
+		for (uint i = 0; i < count; ++i) {
+			const int n = narrowing ? previousMatches[i] : i;
+			const String &entry = _searchList[n];
 			bool matches = true;
 			tok.reset();
 			while (!tok.empty()) {
-				if (!tmp.contains(tok.nextToken())) {
+				if (!entry.contains(tok.nextToken())) {
 					matches = false;
 					break;
 				}
 			}
 
 			if (matches) {
-				_list.push_back(*i);
+				_list.push_back(_dataList[n]);
 				_listIndex.push_back(n);
 			}
 		}
@@ -55,6 +55,8 @@ public:
 protected:
 	StringArray		_list;
 	StringArray		_dataList;
+	/** Lowercase copies of the entries and their search keys, for the filter */
+	StringArray		_searchList;
 	ColorList		_listColors;
 	Common::Array<int>		_listIndex;
 	bool			_editable;
@@ -93,7 +95,15 @@ public:
 	bool containsWidget(Widget *) const override;
 	Widget *findWidget(int x, int y) override;
 
-	void setList(const StringArray &list, const ColorList *colors = nullptr);
+	/**
+	 * Set the entries of the list.
+	 *
+	 * @param list			the entries
+	 * @param colors		the color of each entry, or nullptr to use the normal color
+	 * @param searchKeys	text matched by the filter for each entry in addition
+	 *						to the entry itself, or nullptr
+	 */
+	void setList(const StringArray &list, const ColorList *colors = nullptr, const StringArray *searchKeys = nullptr);
 	const StringArray &getList()	const			{ return _dataList; }
 
 	void append(const String &s, ThemeEngine::FontColor color = ThemeEngine::kFontColorNormal);
@@ -25,6 +25,9 @@ install:
 ifdef DYNAMIC_MODULES
 	$(INSTALL) -d "$(DESTDIR)$(libdir)/scummvm/"
 	$(INSTALL) -c -m 644 $(PLUGINS) "$(DESTDIR)$(libdir)/scummvm/"
+ifdef PLUGIN_INDEX
+	$(INSTALL) -c -m 644 plugins/plugins.idx "$(DESTDIR)$(libdir)/scummvm/"
+endif
 endif
 
 install-strip:
@@ -47,6 +50,9 @@ install-strip:
 ifdef DYNAMIC_MODULES
 	$(INSTALL) -d "$(DESTDIR)$(libdir)/scummvm/"
 	$(INSTALL) -c -s -m 644 $(PLUGINS) "$(DESTDIR)$(libdir)/scummvm/"
+ifdef PLUGIN_INDEX
+	$(INSTALL) -c -m 644 plugins/plugins.idx "$(DESTDIR)$(libdir)/scummvm/"
+endif
 endif
 
 uninstall:
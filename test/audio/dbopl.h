@@ -0,0 +1,239 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/dbopl.h"
+#include "common/array.h"
+
+#include "test/benchmark.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+/**
+ * A sequence of register writes, like the ones an AdLib player makes. Each
+ * write is preceded by a number of samples to generate.
+ */
+struct OPLWrite {
+	uint32 delay;
+	uint16 reg;
+	uint8 val;
+};
+
+class OPLSequence {
+public:
+	enum Flags {
+		kOpl3 = 1 << 0,
+		kPercussion = 1 << 1
+	};
+
+	OPLSequence(uint32 seed, int flags, uint numNotes) : _seed(seed), _flags(flags), _numSamples(0) {
+		write(0x01, 0x20);
+		if (_flags & kOpl3) {
+			write(0x105, 0x01);
+			write(0x104, getRandom(0x40));
+		}
+		write(0xbd, (_flags & kPercussion) ? 0x20 : 0x00);
+
+		for (uint i = 0; i < numNotes; ++i) {
+			const uint bank = (_flags & kOpl3) ? getRandom(2) : 0;
+			const uint channel = getRandom(9);
+			setupInstrument(bank, channel);
+
+			// Key on a note, let it play and sometimes release it
+			const uint16 fnum = 0x100 + getRandom(0x300);
+			const uint8 block = getRandom(8);
+			write(bank * 0x100 + 0xa0 + channel, fnum & 0xff);
+			write(bank * 0x100 + 0xb0 + channel, 0x20 | (block << 2) | (fnum >> 8));
+			if (_flags & kPercussion)
+				write(0xbd, 0x20 | (getRandom(0x100) & 0xdf));
+			else if (getRandom(4) == 0)
+				write(0xbd, getRandom(0x100) & 0xc0);
+			if (getRandom(3) == 0)
+				write(bank * 0x100 + 0xb0 + channel, (block << 2) | (fnum >> 8), getRandom(400));
+			if (getRandom(20) == 0 && (_flags & kOpl3))
+				write(0x104, getRandom(0x40));
+			const uint32 pause = getRandom(300);
+			_writes.back().delay += pause;
+			_numSamples += pause;
+		}
+		write(0xbd, 0x00, 2000);
+	}
+
+	const Common::Array<OPLWrite> &getWrites() const { return _writes; }
+	uint32 getNumSamples() const { return _numSamples; }
+	bool isOpl3() const { return _flags & kOpl3; }
+
+private:
+	uint getRandom(uint range) {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) % range;
+	}
+
+	void write(uint16 reg, uint8 val, uint32 delay = 0) {
+		OPLWrite w = { delay, reg, val };
+		_writes.push_back(w);
+		_numSamples += delay;
+	}
+
+	void setupInstrument(uint bank, uint channel) {
+		const uint16 base = bank * 0x100;
+		const uint16 slot = (channel / 3) * 8 + channel % 3;
+		for (uint op = 0; op < 2; ++op) {
+			const uint16 reg = base + slot + op * 3;
+			write(0x20 + reg, getRandom(0x100));
+			// Mostly audible levels
+			write(0x40 + reg, (getRandom(0x100) & 0xc0) | getRandom(0x20));
+			write(0x60 + reg, getRandom(0x100) | 0x10);
+			write(0x80 + reg, getRandom(0x100));
+			write(0xe0 + reg, getRandom(8));
+		}
+		write(base + 0xc0 + channel, getRandom(0x100));
+	}
+
+	uint32 _seed;
+	int _flags;
+	uint32 _numSamples;
+	Common::Array<OPLWrite> _writes;
+};
+
+class DBOPLTestSuite : public CxxTest::TestSuite
+{
+	typedef OPL::DOSBox::DBOPL::Chip Chip;
+	typedef OPL::DOSBox::DBOPL::Kernels Kernels;
+
+	enum { kBlockSize = 512 };
+
+	static void generate(Chip &chip, bool opl3, int32 *buffer, uint32 numSamples) {
+		if (opl3)
+			chip.GenerateBlock3(numSamples, buffer);
+		else
+			chip.GenerateBlock2(numSamples, buffer);
+	}
+
+	/**
+	 * Play the sequence, in blocks of at most kBlockSize samples, and return
+	 * the FNV-1a hash of the samples. If output is given, the samples are
+	 * also stored there.
+	 */
+	static uint32 play(const Kernels &kernels, const OPLSequence &seq, uint32 rate, int32 *output = nullptr) {
+		OPL::DOSBox::DBOPL::InitTables();
+		Chip chip;
+		chip.kernels = &kernels;
+		chip.Setup(rate);
+
+		const uint channels = seq.isOpl3() ? 2 : 1;
+		int32 buffer[kBlockSize * 2];
+		uint32 hash = 2166136261U;
+		uint32 energy = 0;
+		const Common::Array<OPLWrite> &writes = seq.getWrites();
+		for (uint i = 0; i < writes.size(); ++i) {
+			for (uint32 left = writes[i].delay; left > 0;) {
+				const uint32 len = MIN<uint32>(left, kBlockSize);
+				generate(chip, seq.isOpl3(), buffer, len);
+				for (uint32 j = 0; j < len * channels; ++j) {
+					for (uint k = 0; k < 4; ++k)
+						hash = (hash ^ ((uint32)buffer[j] >> (k * 8) & 0xff)) * 16777619U;
+					energy |= buffer[j];
+				}
+				if (output) {
+					memcpy(output, buffer, len * channels * sizeof(int32));
+					output += len * channels;
+				}
+				left -= len;
+			}
+			chip.WriteReg(writes[i].reg, writes[i].val);
+		}
+		// Make sure there was something to compare
+		TS_ASSERT_DIFFERS(energy, 0U);
+		return hash;
+	}
+
+	struct Golden {
+		uint32 seed;
+		int flags;
+		uint32 rate;
+		uint32 hash;
+	};
+
+	static const Golden *getGolden(uint &size) {
+		// Output of the original per sample implementation
+		static const Golden golden[] = {
+			{ 1, 0,                                               44100, 0x516b3930 },
+			{ 2, 0,                                               22050, 0xba8a8fbe },
+			{ 3, OPLSequence::kPercussion,                        44100, 0x99d31cfd },
+			{ 4, OPLSequence::kOpl3,                              44100, 0x8a19d0bf },
+			{ 5, OPLSequence::kOpl3,                              49716, 0x78ca14fe },
+			{ 6, OPLSequence::kOpl3,                              96000, 0x13cfa6b9 },
+			{ 7, OPLSequence::kOpl3 | OPLSequence::kPercussion,   48000, 0xe1fbef62 }
+		};
+		size = ARRAYSIZE(golden);
+		return golden;
+	}
+
+	static void checkGolden(const Kernels &kernels) {
+		uint size;
+		const Golden *golden = getGolden(size);
+		for (uint i = 0; i < size; ++i) {
+			OPLSequence seq(golden[i].seed, golden[i].flags, 300);
+			TS_ASSERT_EQUALS(play(kernels, seq, golden[i].rate), golden[i].hash);
+		}
+	}
+
+	static void checkKernels(const Kernels &kernels) {
+		uint32 positions[2][67], counter[2] = { 0xfff00000, 0xfff00000 };
+		kernels.forwardWave(positions[0], counter[0], 0x1234567, 67);
+		OPL::DOSBox::DBOPL::GetScalarKernels().forwardWave(positions[1], counter[1], 0x1234567, 67);
+		TS_ASSERT_EQUALS(memcmp(positions[0], positions[1], sizeof(positions[0])), 0);
+		TS_ASSERT_EQUALS(counter[0], counter[1]);
+
+		// All combinations of extreme wave samples and factors
+		int16 wave[1024];
+		int32 modulation[67], output[2][67];
+		uint16 mul[67];
+		for (uint i = 0; i < 1024; ++i)
+			wave[i] = (i & 1) ? -4085 + i : 4085 - i;
+		for (uint i = 0; i < 67; ++i) {
+			modulation[i] = (int32)(i * 97) - 3000;
+			mul[i] = (i & 2) ? 65535 - i * 300 : i * 7;
+		}
+		for (uint modulated = 0; modulated < 2; ++modulated) {
+			kernels.getWave(output[0], wave, 1023, positions[0], modulated ? modulation : nullptr, mul, 67);
+			OPL::DOSBox::DBOPL::GetScalarKernels().getWave(output[1], wave, 1023, positions[0], modulated ? modulation : nullptr, mul, 67);
+			TS_ASSERT_EQUALS(memcmp(output[0], output[1], sizeof(output[0])), 0);
+		}
+	}
+
+	static void benchmark(const char *name, const Kernels &kernels, int flags) {
+		OPLSequence seq(1, flags, 300);
+		int32 *output = new int32[seq.getNumSamples() * 2];
+		const uint64 start = Benchmark::getMicros();
+		play(kernels, seq, 44100, output);
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		delete[] output;
+		Benchmark::report("DOSBox OPL %-6s %s: %10u samples/sec\n", name,
+			(flags & OPLSequence::kOpl3) ? "OPL3" : "OPL2", (uint)(seq.getNumSamples() * 1000000ULL / time));
+	}
+
+public:
+	void test_golden_output() {
+		checkGolden(OPL::DOSBox::DBOPL::GetScalarKernels());
+	}
+
+	void test_sse2_kernels() {
+#ifdef SCUMMVM_SSE2
+		checkKernels(OPL::DOSBox::DBOPL::GetSSE2Kernels());
+		checkGolden(OPL::DOSBox::DBOPL::GetSSE2Kernels());
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		benchmark("scalar", OPL::DOSBox::DBOPL::GetScalarKernels(), 0);
+		benchmark("scalar", OPL::DOSBox::DBOPL::GetScalarKernels(), OPLSequence::kOpl3);
+#ifdef SCUMMVM_SSE2
+		benchmark("SSE2", OPL::DOSBox::DBOPL::GetSSE2Kernels(), 0);
+		benchmark("SSE2", OPL::DOSBox::DBOPL::GetSSE2Kernels(), OPLSequence::kOpl3);
+#endif
+#endif // TEST_BENCHMARKS
+	}
+};
+
+#endif // !DISABLE_DOSBOX_OPL
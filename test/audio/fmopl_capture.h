@@ -0,0 +1,122 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/fmopl_capture.h"
+#include "common/array.h"
+#include "common/memstream.h"
+
+/**
+ * An OPL which only counts the writes and runs its callback on request.
+ */
+class CountingOPL : public OPL::OPL {
+public:
+	CountingOPL() : _writes(0), _frequency(0) {}
+
+	bool init() { return true; }
+	void reset() {}
+	void write(int a, int v) { ++_writes; }
+	byte read(int a) { return 0; }
+	void writeReg(int r, int v) { ++_writes; }
+	void setCallbackFrequency(int timerFrequency) { _frequency = timerFrequency; }
+
+	void tick() {
+		if (_callback && _callback->isValid())
+			(*_callback)();
+	}
+
+	uint _writes;
+	int _frequency;
+
+protected:
+	void startCallbacks(int timerFrequency) { _frequency = timerFrequency; }
+	void stopCallbacks() { _frequency = 0; }
+};
+
+class ArrayWriteStream : public Common::WriteStream {
+public:
+	ArrayWriteStream(Common::Array<byte> &data) : _data(data) {}
+
+	uint32 write(const void *dataPtr, uint32 dataSize) {
+		for (uint32 i = 0; i < dataSize; ++i)
+			_data.push_back(((const byte *)dataPtr)[i]);
+		return dataSize;
+	}
+
+	int32 pos() const { return _data.size(); }
+
+private:
+	Common::Array<byte> &_data;
+};
+
+class OPLCaptureTestSuite : public CxxTest::TestSuite
+{
+	::OPL::OPL *_capture;
+	uint _callbacks;
+
+	void onTimer() {
+		// Only write in the first few callbacks, to get a long delay
+		if (_callbacks < 3)
+			_capture->writeReg(0xa0, _callbacks);
+		++_callbacks;
+	}
+
+	static void checkEvent(::OPL::CaptureReader &reader, ::OPL::CaptureCommand command, uint32 param, uint8 value = 0) {
+		::OPL::CaptureEvent event;
+		TS_ASSERT(reader.readEvent(event));
+		TS_ASSERT_EQUALS(event.command, command);
+		TS_ASSERT_EQUALS(event.param, param);
+		TS_ASSERT_EQUALS(event.value, value);
+	}
+
+public:
+	void test_capture_and_read() {
+		Common::Array<byte> data;
+		CountingOPL *opl = new CountingOPL();
+		_capture = new ::OPL::CaptureOPL(opl, ::OPL::Config::kOpl3, new ArrayWriteStream(data));
+		_callbacks = 0;
+
+		_capture->writeReg(0x20, 1);
+		_capture->start(new Common::Functor0Mem<void, OPLCaptureTestSuite>(this, &OPLCaptureTestSuite::onTimer), 100);
+		TS_ASSERT_EQUALS(opl->_frequency, 100);
+		for (uint i = 0; i < 303; ++i)
+			opl->tick();
+		_capture->write(0x388, 0xbd);
+		_capture->reset();
+		opl->tick();
+		TS_ASSERT_EQUALS(opl->_writes, 5U);
+		delete _capture;
+
+		Common::MemoryReadStream stream(data.begin(), data.size());
+		::OPL::CaptureReader reader(&stream);
+		TS_ASSERT(reader.isValid());
+		TS_ASSERT_EQUALS(reader.getType(), ::OPL::Config::kOpl3);
+		checkEvent(reader, ::OPL::kCaptureWriteReg, 0x20, 1);
+		checkEvent(reader, ::OPL::kCaptureFrequency, 100);
+		checkEvent(reader, ::OPL::kCaptureWriteReg, 0xa0, 0);
+		checkEvent(reader, ::OPL::kCaptureDelay, 1);
+		checkEvent(reader, ::OPL::kCaptureWriteReg, 0xa0, 1);
+		checkEvent(reader, ::OPL::kCaptureDelay, 1);
+		checkEvent(reader, ::OPL::kCaptureWriteReg, 0xa0, 2);
+		checkEvent(reader, ::OPL::kCaptureLongDelay, 301);
+		checkEvent(reader, ::OPL::kCaptureWrite, 0x388, 0xbd);
+		checkEvent(reader, ::OPL::kCaptureReset, 0);
+		checkEvent(reader, ::OPL::kCaptureDelay, 1);
+
+		::OPL::CaptureEvent event;
+		TS_ASSERT(!reader.readEvent(event));
+	}
+
+	void test_invalid_capture() {
+		static const byte notCapture[] = { 'R', 'I', 'F', 'F', 1, 0 };
+		Common::MemoryReadStream stream(notCapture, sizeof(notCapture));
+		::OPL::CaptureReader reader(&stream);
+		TS_ASSERT(!reader.isValid());
+
+		// Truncated in the middle of a write
+		static const byte truncated[] = { 'O', 'P', 'L', 'C', 1, 0, ::OPL::kCaptureWriteReg, 0x20 };
+		Common::MemoryReadStream truncatedStream(truncated, sizeof(truncated));
+		::OPL::CaptureReader truncatedReader(&truncatedStream);
+		TS_ASSERT(truncatedReader.isValid());
+		::OPL::CaptureEvent event;
+		TS_ASSERT(!truncatedReader.readEvent(event));
+	}
+};
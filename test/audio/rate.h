@@ -0,0 +1,282 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+#include "audio/decoders/raw.h"
+
+#include "test/benchmark.h"
+
+/**
+ * An endless stream of pseudo-random samples, covering the full sample range.
+ * The samples are generated up front and repeated, so reading is cheap
+ * enough for benchmarking.
+ */
+class NoiseStream : public Audio::AudioStream {
+public:
+	NoiseStream(int rate, bool stereo) : _rate(rate), _stereo(stereo), _pos(0) {
+		uint32 seed = 12345;
+		for (int i = 0; i < kNoiseSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_noise[i] = (int16)(seed >> 16);
+		}
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int done = 0; done < numSamples;) {
+			const int len = MIN(numSamples - done, kNoiseSize - _pos);
+			memcpy(buffer + done, _noise + _pos, len * sizeof(int16));
+			_pos = (_pos + len) % kNoiseSize;
+			done += len;
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	enum { kNoiseSize = 4099 };
+
+	int _rate;
+	bool _stereo;
+	int16 _noise[kNoiseSize];
+	int _pos;
+};
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+#ifdef SCUMM_LITTLE_ENDIAN
+	enum { kRawFlags = Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN };
+#else
+	enum { kRawFlags = Audio::FLAG_16BITS };
+#endif
+
+	static void fillNoise(int16 *buffer, int numSamples, uint32 offset) {
+		NoiseStream noise(11025, false);
+		for (uint32 i = 0; i < offset; ++i)
+			noise.readBuffer(buffer, 1);
+		noise.readBuffer(buffer, numSamples);
+	}
+
+	static void compareKernels(const Audio::RateKernels &kernels) {
+		const Audio::RateKernels &scalar = Audio::getScalarRateKernels();
+		const uint numFrames = 77;
+		int16 in[numFrames * 2 + 4];
+		int16 expected[numFrames * 2], result[numFrames * 2];
+
+		// Full scale input, including the extreme values, to check clamping
+		fillNoise(in, ARRAYSIZE(in), 1);
+		in[0] = -32768;
+		in[1] = 32767;
+
+		const int volumes[][2] = { { 256, 256 }, { 255, 17 }, { 0, 128 }, { 300, 1000 } };
+		for (uint v = 0; v < ARRAYSIZE(volumes); ++v) {
+			const int volL = volumes[v][0], volR = volumes[v][1];
+
+			fillNoise(expected, ARRAYSIZE(expected), 2);
+			fillNoise(result, ARRAYSIZE(result), 2);
+			scalar.mixMono(expected, in, numFrames, volL, volR);
+			kernels.mixMono(result, in, numFrames, volL, volR);
+			TS_ASSERT_EQUALS(memcmp(expected, result, sizeof(expected)), 0);
+
+			fillNoise(expected, ARRAYSIZE(expected), 3);
+			fillNoise(result, ARRAYSIZE(result), 3);
+			scalar.mixStereo(expected, in, numFrames, volL, volR);
+			kernels.mixStereo(result, in, numFrames, volL, volR);
+			TS_ASSERT_EQUALS(memcmp(expected, result, sizeof(expected)), 0);
+
+			fillNoise(expected, ARRAYSIZE(expected), 4);
+			fillNoise(result, ARRAYSIZE(result), 4);
+			scalar.mixStereoReverse(expected, in, numFrames, volL, volR);
+			kernels.mixStereoReverse(result, in, numFrames, volL, volR);
+			TS_ASSERT_EQUALS(memcmp(expected, result, sizeof(expected)), 0);
+		}
+
+		// Upsampling and downsampling steps
+		const uint32 increments[] = { 8192, 30106, 32768, 40000 };
+		int16 expectedInterpolated[(numFrames + 1) * 4 * 2], resultInterpolated[(numFrames + 1) * 4 * 2];
+		for (uint i = 0; i < ARRAYSIZE(increments); ++i) {
+			const uint32 inc = increments[i];
+			const uint frames = (uint)((numFrames + 1) * (uint32)Audio::FRAC_ONE_LOW / inc) - 1;
+
+			scalar.interpolateMono(expectedInterpolated, in, Audio::FRAC_ONE_LOW + 5, inc, frames);
+			kernels.interpolateMono(resultInterpolated, in, Audio::FRAC_ONE_LOW + 5, inc, frames);
+			TS_ASSERT_EQUALS(memcmp(expectedInterpolated, resultInterpolated, frames * sizeof(int16)), 0);
+
+			scalar.interpolateStereo(expectedInterpolated, in, Audio::FRAC_ONE_LOW + 5, inc, frames);
+			kernels.interpolateStereo(resultInterpolated, in, Audio::FRAC_ONE_LOW + 5, inc, frames);
+			TS_ASSERT_EQUALS(memcmp(expectedInterpolated, resultInterpolated, frames * 2 * sizeof(int16)), 0);
+		}
+	}
+
+	static void compareConverters(const Audio::RateKernels &kernels, int inRate, int outRate, bool stereo, bool reverseStereo, Audio::ResamplingQuality quality) {
+		NoiseStream expectedStream(inRate, stereo), resultStream(inRate, stereo);
+		Audio::RateConverter *expectedConverter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, quality, Audio::getScalarRateKernels());
+		Audio::RateConverter *resultConverter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, quality, kernels);
+
+		// Odd block sizes, so the converters have to keep state between calls
+		int16 expected[2 * 1023], result[2 * 1023];
+		for (int block = 1; block < 1023; block += 111) {
+			memset(expected, 0, sizeof(expected));
+			memset(result, 0, sizeof(result));
+			TS_ASSERT_EQUALS(expectedConverter->flow(expectedStream, expected, block, 200, 131), block);
+			TS_ASSERT_EQUALS(resultConverter->flow(resultStream, result, block, 200, 131), block);
+			TS_ASSERT_EQUALS(memcmp(expected, result, block * 2 * sizeof(int16)), 0);
+		}
+
+		delete expectedConverter;
+		delete resultConverter;
+	}
+
+	static void compareAllConverters(const Audio::RateKernels &kernels) {
+		const int rates[][2] = { { 44100, 44100 }, { 44100, 22050 }, { 11025, 44100 }, { 22050, 48000 }, { 48000, 44100 } };
+		const Audio::ResamplingQuality qualities[] = { Audio::kResamplingLinear, Audio::kResamplingSincFast, Audio::kResamplingSincMedium, Audio::kResamplingSincBest };
+		for (uint q = 0; q < ARRAYSIZE(qualities); ++q) {
+			for (uint i = 0; i < ARRAYSIZE(rates); ++i) {
+				compareConverters(kernels, rates[i][0], rates[i][1], false, false, qualities[q]);
+				compareConverters(kernels, rates[i][0], rates[i][1], true, false, qualities[q]);
+				compareConverters(kernels, rates[i][0], rates[i][1], true, true, qualities[q]);
+			}
+		}
+	}
+
+	/**
+	 * Convert a full scale sine wave and return the RMS amplitude of the output,
+	 * ignoring the start where the filter has not settled yet.
+	 */
+	static double convertSine(Audio::ResamplingQuality quality, int inRate, int outRate, double frequency) {
+		const int numInFrames = inRate / 4;
+		int16 *in = new int16[numInFrames];
+		for (int i = 0; i < numInFrames; ++i)
+			in[i] = (int16)(16384 * sin(2 * M_PI * frequency * i / inRate));
+
+		Audio::AudioStream *stream = Audio::makeRawStream((const byte *)in, numInFrames * sizeof(int16), inRate, kRawFlags, DisposeAfterUse::YES);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, quality, Audio::getScalarRateKernels());
+
+		const int numOutFrames = (int)((int64)numInFrames * outRate / inRate) - 64;
+		int16 *out = new int16[numOutFrames * 2];
+		memset(out, 0, numOutFrames * 2 * sizeof(int16));
+		TS_ASSERT_EQUALS(converter->flow(*stream, out, numOutFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), numOutFrames);
+
+		double sum = 0;
+		for (int i = 64; i < numOutFrames; ++i)
+			sum += (double)out[i * 2] * out[i * 2];
+
+		delete[] out;
+		delete converter;
+		delete stream;
+		return sqrt(sum / (numOutFrames - 64));
+	}
+
+	static void benchmarkConverter(const char *kernelsName, const Audio::RateKernels &kernels, Audio::ResamplingQuality quality, int inRate, int outRate, bool stereo) {
+		const int seconds = 60;
+		const int blockSize = 1024;
+		int16 buffer[2 * blockSize];
+
+		NoiseStream stream(inRate, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, false, quality, kernels);
+
+		const uint64 start = Benchmark::getMicros();
+		int frames = 0;
+		while (frames < seconds * outRate) {
+			memset(buffer, 0, sizeof(buffer));
+			frames += converter->flow(stream, buffer, blockSize, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume / 2);
+		}
+		const uint64 elapsed = MAX<uint64>(Benchmark::getMicros() - start, 1);
+
+		static const char *const qualityNames[] = { "linear", "fast", "medium", "best" };
+		Benchmark::report("RateConverter %-6s %-6s %5d -> %5d %-6s: %10.0f frames/sec",
+		                  kernelsName, qualityNames[quality], inRate, outRate, stereo ? "stereo" : "mono", frames * 1000000.0 / elapsed);
+
+		delete converter;
+	}
+
+	static void benchmarkKernels(const char *kernelsName, const Audio::RateKernels &kernels) {
+		const int rates[][2] = { { 11025, 44100 }, { 11025, 48000 }, { 22050, 48000 }, { 44100, 44100 }, { 44100, 22050 } };
+		for (uint i = 0; i < ARRAYSIZE(rates); ++i) {
+			benchmarkConverter(kernelsName, kernels, Audio::kResamplingLinear, rates[i][0], rates[i][1], false);
+			benchmarkConverter(kernelsName, kernels, Audio::kResamplingLinear, rates[i][0], rates[i][1], true);
+		}
+		for (int quality = Audio::kResamplingSincFast; quality <= Audio::kResamplingSincBest; ++quality) {
+			benchmarkConverter(kernelsName, kernels, (Audio::ResamplingQuality)quality, 22050, 48000, false);
+			benchmarkConverter(kernelsName, kernels, (Audio::ResamplingQuality)quality, 22050, 48000, true);
+		}
+	}
+
+public:
+	void test_linear_output() {
+		// Doubling the rate interpolates halfway between the input frames
+		const int16 in[] = { 1000, -1000, 3000 };
+		int16 out[4];
+		Audio::getScalarRateKernels().interpolateMono(out, in, Audio::FRAC_ONE_LOW, Audio::FRAC_HALF_LOW, 4);
+		TS_ASSERT_EQUALS(out[0], 1000);
+		TS_ASSERT_EQUALS(out[1], 0);
+		TS_ASSERT_EQUALS(out[2], -1000);
+		TS_ASSERT_EQUALS(out[3], 1000);
+	}
+
+	void test_mix_clamping() {
+		int16 out[] = { 32000, -32000, 100, -100 };
+		const int16 in[] = { 32767, -32768 };
+		Audio::getScalarRateKernels().mixMono(out, in, 2, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume / 2);
+		TS_ASSERT_EQUALS(out[0], 32767);
+		TS_ASSERT_EQUALS(out[1], -15617);
+		TS_ASSERT_EQUALS(out[2], -32668);
+		TS_ASSERT_EQUALS(out[3], -16484);
+	}
+
+	void test_sinc_passes_dc() {
+		// Every filter phase has unity gain, so a constant stays constant
+		const int rates[][2] = { { 11025, 44100 }, { 22050, 48000 }, { 48000, 44100 }, { 44100, 22050 } };
+		for (int quality = Audio::kResamplingSincFast; quality <= Audio::kResamplingSincBest; ++quality) {
+			for (uint i = 0; i < ARRAYSIZE(rates); ++i) {
+				const int numInFrames = 4096;
+				int16 *in = new int16[numInFrames];
+				for (int j = 0; j < numInFrames; ++j)
+					in[j] = 12345;
+
+				Audio::AudioStream *stream = Audio::makeRawStream((const byte *)in, numInFrames * sizeof(int16), rates[i][0], kRawFlags, DisposeAfterUse::YES);
+				Audio::RateConverter *converter = Audio::makeRateConverter(rates[i][0], rates[i][1], false, false, (Audio::ResamplingQuality)quality, Audio::getScalarRateKernels());
+
+				int16 out[2 * 1024];
+				memset(out, 0, sizeof(out));
+				TS_ASSERT_EQUALS(converter->flow(*stream, out, 1024, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1024);
+				for (int j = 128; j < 1024; ++j)
+					TS_ASSERT_EQUALS(out[j * 2], 12345);
+
+				delete converter;
+				delete stream;
+			}
+		}
+	}
+
+	void test_sinc_aliasing() {
+		// A tone above the output Nyquist frequency must be filtered out when
+		// downsampling, while linear interpolation lets much of it alias.
+		const double linear = convertSine(Audio::kResamplingLinear, 44100, 22050, 15000);
+		const double passband = convertSine(Audio::kResamplingSincMedium, 44100, 22050, 2000);
+		TS_ASSERT_LESS_THAN(11000, passband);
+		TS_ASSERT_LESS_THAN(1000, linear);
+		for (int quality = Audio::kResamplingSincFast; quality <= Audio::kResamplingSincBest; ++quality)
+			TS_ASSERT_LESS_THAN(convertSine((Audio::ResamplingQuality)quality, 44100, 22050, 15000), 200);
+	}
+
+	void test_sse2_kernels() {
+#ifdef SCUMMVM_SSE2
+		compareKernels(Audio::getSSE2RateKernels());
+		compareAllConverters(Audio::getSSE2RateKernels());
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		benchmarkKernels("scalar", Audio::getScalarRateKernels());
+#ifdef SCUMMVM_SSE2
+		benchmarkKernels("SSE2", Audio::getSSE2RateKernels());
+#endif
+#endif // TEST_BENCHMARKS
+	}
+};
@@ -0,0 +1,47 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include "common/scummsys.h"
+
+/**
+ * Helpers for the benchmark tests. The test runner has no OSystem, and the
+ * timer and stdio functions are forbidden in regular code, so these live in
+ * their own translation unit.
+ *
+ * The benchmark tests only time and print anything when TEST_BENCHMARKS is
+ * defined, see test/module.mk, so that a regular test run stays fast and
+ * quiet.
+ */
+namespace Benchmark {
+
+/** Return the wall clock time in microseconds, relative to an arbitrary epoch. */
+uint64 getMicros();
+
+/** Print a line of benchmark results to stdout. */
+void report(const char *format, ...) GCC_PRINTF(1, 2);
+
+} // End of namespace Benchmark
+
+#endif
@@ -0,0 +1,229 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+#include "test/benchmark.h"
+
+/** A hash function which makes all keys collide. */
+struct ConstantHash {
+	uint operator()(int) const { return 42; }
+};
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String> FlatStringMap;
+	typedef Common::HashMap<Common::String, Common::String> StringMap;
+
+	/**
+	 * Apply the same random inserts and erases to a FlatHashMap and a
+	 * HashMap, and check that they end up with the same content.
+	 */
+	template<class HashFunc>
+	void checkAgainstHashMap(uint numOps, uint keyRange) {
+		Common::FlatHashMap<int, int, HashFunc> flat;
+		Common::HashMap<int, int> reference;
+
+		uint32 seed = 1;
+		for (uint i = 0; i < numOps; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const int key = (seed >> 8) % keyRange;
+			if ((seed >> 4) & 3) {
+				flat[key] = i;
+				reference[key] = i;
+			} else {
+				flat.erase(key);
+				reference.erase(key);
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Common::HashMap<int, int>::const_iterator i = reference.begin(); i != reference.end(); ++i) {
+			TS_ASSERT(flat.contains(i->_key));
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, -1), i->_value);
+		}
+
+		uint count = 0;
+		for (typename Common::FlatHashMap<int, int, HashFunc>::const_iterator i = flat.begin(); i != flat.end(); ++i) {
+			TS_ASSERT_EQUALS(reference.getVal(i->_key, -1), i->_value);
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+
+	template<class Map, class Key>
+	static void benchmarkMap(const char *name, const Common::Array<Key> &keys, const Common::Array<Key> &lookupKeys) {
+		const uint numKeys = keys.size();
+		Map map;
+
+		uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < numKeys; ++i)
+			map[keys[i]] = i;
+		const uint64 insertTime = Benchmark::getMicros() - start;
+
+		uint found = 0;
+		start = Benchmark::getMicros();
+		for (int pass = 0; pass < 4; ++pass) {
+			for (uint i = 0; i < numKeys; ++i)
+				found += map.contains(lookupKeys[i]);
+		}
+		const uint64 findTime = Benchmark::getMicros() - start;
+
+		uint64 sum = 0;
+		start = Benchmark::getMicros();
+		for (int pass = 0; pass < 4; ++pass) {
+			for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+				sum += i->_value;
+		}
+		const uint64 iterateTime = Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		for (uint i = 0; i < numKeys; i += 2)
+			map.erase(keys[i]);
+		const uint64 eraseTime = Benchmark::getMicros() - start;
+
+		TS_ASSERT_EQUALS(found, numKeys * 4);
+		TS_ASSERT_EQUALS(sum, (uint64)numKeys * (numKeys - 1) * 2);
+		Benchmark::report("%-22s %6u keys: insert %6u us, find %6u us, iterate %6u us, erase %6u us",
+		                  name, numKeys, (uint)insertTime, (uint)findTime, (uint)iterateTime, (uint)eraseTime);
+	}
+
+public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(0));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "baz";
+		TS_ASSERT_EQUALS(container2["foo"], "baz");
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; ++i)
+			container[i] = i * 10;
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 4U);
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		TS_ASSERT(!container.contains(0));
+		for (int i = 1; i < 5; ++i)
+			container.erase(i);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(1, -10), -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.find(17), containerRef.end());
+		TS_ASSERT_EQUALS(containerRef.size(), 2U);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; ++i)
+			container[i] = i;
+		container.erase(1);
+		container[1] = 42;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			const int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT_EQUALS(found, 16 + 8 + 4);
+	}
+
+	void test_copy() {
+		FlatStringMap map1, map2;
+		for (int i = 0; i < 100; ++i)
+			map1[Common::String::format("key%d", i)] = Common::String::format("value%d", i);
+		map1.erase("key50");
+
+		map2 = map1;
+		FlatStringMap map3(map2);
+		map1.clear();
+		TS_ASSERT_EQUALS(map3.size(), 99U);
+		TS_ASSERT_EQUALS(map3["key99"], "value99");
+		TS_ASSERT(!map3.contains("key50"));
+	}
+
+	void test_random_operations() {
+		// Many erases leave deleted slots, which must not break the probing
+		checkAgainstHashMap<Common::Hash<int> >(100000, 3000);
+		checkAgainstHashMap<Common::Hash<int> >(20000, 20000);
+		// All keys collide, so every group is probed
+		checkAgainstHashMap<ConstantHash>(3000, 200);
+	}
+
+	void test_strided_keys() {
+		// Keys which only differ in their high bits must still spread over
+		// the whole table, instead of piling up in a few groups with long
+		// probe sequences.
+		const uint numKeys = 20000;
+		Common::FlatHashMap<int, uint> map;
+		for (uint i = 0; i < numKeys; ++i)
+			map[i * 4096] = i;
+
+		for (uint i = 0; i < numKeys; ++i)
+			TS_ASSERT_EQUALS(map.getVal(i * 4096, numKeys), i);
+		TS_ASSERT_LESS_THAN(map.getMaxProbeLength(), 16U);
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		const uint numKeys = 50000;
+		Common::Array<int> intKeys;
+		Common::Array<Common::String> stringKeys;
+		uint32 seed = 1;
+		for (uint i = 0; i < numKeys; ++i) {
+			seed = seed * 1103515245 + 12345;
+			intKeys.push_back(seed & 0x7FFFFFFF);
+			stringKeys.push_back(Common::String::format("object_%u_%u", i, seed % 1000));
+		}
+
+		// Look the keys up in another order than they were inserted in, so
+		// the nodes of the HashMap are not visited in the order of their
+		// allocation
+		Common::Array<int> intLookupKeys(intKeys);
+		Common::Array<Common::String> stringLookupKeys(stringKeys);
+		for (uint i = numKeys - 1; i > 0; --i) {
+			seed = seed * 1103515245 + 12345;
+			const uint j = (seed >> 8) % (i + 1);
+			SWAP(intLookupKeys[i], intLookupKeys[j]);
+			SWAP(stringLookupKeys[i], stringLookupKeys[j]);
+		}
+
+		benchmarkMap<Common::HashMap<int, uint>, int>("HashMap<int>", intKeys, intLookupKeys);
+		benchmarkMap<Common::FlatHashMap<int, uint>, int>("FlatHashMap<int>", intKeys, intLookupKeys);
+		benchmarkMap<Common::HashMap<Common::String, uint>, Common::String>("HashMap<String>", stringKeys, stringLookupKeys);
+		benchmarkMap<Common::FlatHashMap<Common::String, uint>, Common::String>("FlatHashMap<String>", stringKeys, stringLookupKeys);
+#endif // TEST_BENCHMARKS
+	}
+};
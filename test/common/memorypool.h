@@ -0,0 +1,56 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite
+{
+	/** Gives access to the pages of the pool. */
+	class TestPool : public Common::MemoryPool {
+	public:
+		explicit TestPool(size_t chunkSize) : MemoryPool(chunkSize) {}
+
+		size_t getPageCount() const { return _pages.size(); }
+		size_t getPageSize(size_t page) const { return _pages[page].numChunks * _chunkSize; }
+	};
+
+	enum {
+		kChunkSize = 4096,
+		kPageLimit = 16 * 1024 * 1024,
+		kNumChunks = 3 * kPageLimit / kChunkSize
+	};
+
+public:
+	void test_alloc_past_page_limit() {
+		TestPool pool(kChunkSize);
+		Common::Array<byte *> chunks;
+		chunks.resize(kNumChunks);
+
+		// Allocates 48MB in chunks, so pages stop doubling at the 16MB limit
+		for (uint i = 0; i < kNumChunks; ++i) {
+			chunks[i] = (byte *)pool.allocChunk();
+			TS_ASSERT(chunks[i]);
+			chunks[i][0] = (byte)i;
+			chunks[i][kChunkSize - 1] = (byte)(i >> 8);
+		}
+
+		TS_ASSERT_LESS_THAN_EQUALS((size_t)kNumChunks * kChunkSize, pool.getPageMemory());
+		for (size_t i = 0; i < pool.getPageCount(); ++i)
+			TS_ASSERT_LESS_THAN(pool.getPageSize(i), (size_t)kPageLimit);
+
+		// The chunks do not overlap
+		for (uint i = 0; i < kNumChunks; ++i) {
+			TS_ASSERT_EQUALS(chunks[i][0], (byte)i);
+			TS_ASSERT_EQUALS(chunks[i][kChunkSize - 1], (byte)(i >> 8));
+		}
+
+		for (uint i = 0; i < kNumChunks; ++i)
+			pool.freeChunk(chunks[i]);
+		pool.freeUnusedPages();
+		TS_ASSERT_EQUALS(pool.getPageCount(), 0U);
+
+		// Once emptied, the pool can grow again
+		void *chunk = pool.allocChunk();
+		TS_ASSERT(chunk);
+		pool.freeChunk(chunk);
+	}
+};
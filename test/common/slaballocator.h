@@ -0,0 +1,177 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/slaballocator.h"
+
+#include "test/benchmark.h"
+
+class SlabAllocatorTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kNumLive = 4096,
+		kNumOps = 200000
+	};
+
+	/** Return a random block size, mostly small, sometimes too big for any class. */
+	static size_t randomSize(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		const uint32 r = seed >> 8;
+		if ((r & 63) == 0)
+			return 2049 + r % 4096;
+		return 1 + (r >> 6) % ((r & 1) ? 64 : 512);
+	}
+
+	/**
+	 * Keep kNumLive blocks alive, and replace a random one kNumOps times,
+	 * like code creating many short-lived objects. Returns the time taken.
+	 */
+	template<class Alloc>
+	static uint64 churn(Alloc &alloc) {
+		void *blocks[kNumLive];
+		size_t sizes[kNumLive];
+		uint32 seed = 1;
+		for (uint i = 0; i < kNumLive; ++i) {
+			sizes[i] = randomSize(seed);
+			blocks[i] = alloc.allocate(sizes[i]);
+		}
+
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < kNumOps; ++i) {
+			const uint idx = (seed >> 4) % kNumLive;
+			alloc.deallocate(blocks[idx], sizes[idx]);
+			sizes[idx] = randomSize(seed);
+			blocks[idx] = alloc.allocate(sizes[idx]);
+			*(byte *)blocks[idx] = (byte)i;
+		}
+		const uint64 time = Benchmark::getMicros() - start;
+
+		for (uint i = 0; i < kNumLive; ++i)
+			alloc.deallocate(blocks[i], sizes[i]);
+		return time;
+	}
+
+	struct MallocAllocator {
+		void *allocate(size_t size) { return malloc(size); }
+		void deallocate(void *ptr, size_t) { free(ptr); }
+	};
+
+public:
+	void test_size_classes() {
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(1), 0U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(16), 0U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(17), 1U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(32), 1U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(33), 2U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(2048), 7U);
+		TS_ASSERT_EQUALS(Common::SlabAllocator::getSizeClass(2049), (uint)Common::SlabAllocator::kNumSizeClasses);
+	}
+
+	void test_stats() {
+		Common::SlabAllocator allocator;
+		void *a = allocator.allocate(20);
+		void *b = allocator.allocate(30);
+		void *big = allocator.allocate(10000);
+		memset(a, 1, 20);
+		memset(b, 2, 30);
+		memset(big, 3, 10000);
+
+		const Common::SlabAllocatorStats &stats = allocator.getStats(1);
+		TS_ASSERT_EQUALS(stats.chunkSize, 32U);
+		TS_ASSERT_EQUALS(stats.numAllocs, 2U);
+		TS_ASSERT_EQUALS(stats.chunksInUse, 2U);
+		TS_ASSERT_EQUALS(stats.bytesInUse, 50U);
+		TS_ASSERT(stats.bytesReserved >= 64U);
+		TS_ASSERT(stats.getFragmentation() > 0);
+
+		const Common::SlabAllocatorStats &bigStats = allocator.getStats(Common::SlabAllocator::kNumSizeClasses);
+		TS_ASSERT_EQUALS(bigStats.bytesInUse, 10000U);
+		TS_ASSERT_EQUALS(bigStats.getFragmentation(), 0U);
+
+		allocator.deallocate(a, 20);
+		TS_ASSERT_EQUALS(stats.bytesInUse, 30U);
+		TS_ASSERT_EQUALS(stats.peakBytesInUse, 50U);
+
+		// Freed chunks are reused first
+		TS_ASSERT_EQUALS(allocator.allocate(17), a);
+		allocator.deallocate(a, 17);
+
+		TS_ASSERT_EQUALS(allocator.getTotalStats().bytesInUse, 10030U);
+		allocator.deallocate(b, 30);
+		allocator.deallocate(big, 10000);
+		TS_ASSERT_EQUALS(allocator.getTotalStats().bytesInUse, 0U);
+		TS_ASSERT_EQUALS(allocator.getTotalStats().chunksInUse, 0U);
+
+		allocator.freeUnusedPages();
+		TS_ASSERT_EQUALS(allocator.getTotalStats().bytesReserved, 0U);
+	}
+
+	void test_blocks_do_not_overlap() {
+		Common::SlabAllocator allocator;
+		byte *blocks[300];
+		for (uint i = 0; i < ARRAYSIZE(blocks); ++i) {
+			blocks[i] = (byte *)allocator.allocate(i * 10 + 1);
+			memset(blocks[i], (byte)i, i * 10 + 1);
+		}
+		for (uint i = 0; i < ARRAYSIZE(blocks); ++i) {
+			TS_ASSERT_EQUALS(blocks[i][0], (byte)i);
+			TS_ASSERT_EQUALS(blocks[i][i * 10], (byte)i);
+			allocator.deallocate(blocks[i], i * 10 + 1);
+		}
+	}
+
+	void test_cache() {
+		Common::SlabAllocator allocator;
+		{
+			Common::SlabCache cache(allocator);
+			void *blocks[100];
+			for (uint i = 0; i < ARRAYSIZE(blocks); ++i)
+				blocks[i] = cache.allocate(24);
+
+			// The allocator hands out whole batches
+			TS_ASSERT_EQUALS(cache.getStats(1).chunksInUse, 100U);
+			TS_ASSERT_EQUALS(allocator.getStats(1).chunksInUse, 128U);
+
+			for (uint i = 0; i < ARRAYSIZE(blocks); ++i)
+				cache.deallocate(blocks[i], 24);
+			TS_ASSERT_EQUALS(cache.getStats(1).bytesInUse, 0U);
+			TS_ASSERT_EQUALS(cache.getStats(1).peakBytesInUse, 2400U);
+			TS_ASSERT(allocator.getStats(1).chunksInUse <= 2U * Common::SlabCache::kBatchSize);
+
+			void *big = cache.allocate(5000);
+			TS_ASSERT_EQUALS(allocator.getStats(Common::SlabAllocator::kNumSizeClasses).bytesInUse, 5000U);
+			cache.deallocate(big, 5000);
+		}
+		TS_ASSERT_EQUALS(allocator.getTotalStats().chunksInUse, 0U);
+		TS_ASSERT_EQUALS(allocator.getTotalStats().bytesInUse, 0U);
+	}
+
+	void test_delete_object() {
+		Common::SlabAllocator allocator;
+		Common::String *str = new (allocator.allocate(sizeof(Common::String))) Common::String("A string too long for the internal storage");
+		TS_ASSERT_EQUALS(*str, "A string too long for the internal storage");
+		allocator.deleteObject(str);
+		TS_ASSERT_EQUALS(allocator.getTotalStats().chunksInUse, 0U);
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		MallocAllocator mallocAllocator;
+		Common::SlabAllocator allocator;
+		Common::SlabAllocator sharedAllocator(true);
+		Common::SlabCache cache(sharedAllocator);
+
+		// Warm up, so the pages of the pools are allocated
+		churn(allocator);
+		churn(cache);
+
+		const uint64 mallocTime = churn(mallocAllocator);
+		const uint64 slabTime = churn(allocator);
+		const uint64 cacheTime = churn(cache);
+		Benchmark::report("%u allocations with %u live blocks: malloc %u us, SlabAllocator %u us, SlabCache %u us",
+		                  (uint)kNumOps, (uint)kNumLive, (uint)mallocTime, (uint)slabTime, (uint)cacheTime);
+
+		const Common::SlabAllocatorStats total = allocator.getTotalStats();
+		Benchmark::report("SlabAllocator: %u allocations, %u KB peak, %u KB reserved",
+		                  total.numAllocs, (uint)(total.peakBytesInUse / 1024), (uint)(total.bytesReserved / 1024));
+#endif // TEST_BENCHMARKS
+	}
+};
@@ -0,0 +1,259 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+/**
+ * Build zip archives in memory. Members are either stored or deflated,
+ * using the raw deflate data of a gzip stream.
+ */
+class ZipBuilder {
+public:
+	ZipBuilder() : _data(DisposeAfterUse::NO), _central(DisposeAfterUse::YES), _numMembers(0) {}
+
+	void addMember(const char *name, const byte *data, uint32 size, bool deflate, bool corruptCrc = false) {
+		const byte *compressed = data;
+		uint32 compressedSize = size;
+		byte *gzipData = nullptr;
+
+#ifdef USE_ZLIB
+		if (deflate) {
+			// Strip the 10 byte gzip header and the 8 byte trailer
+			Common::MemoryWriteStreamDynamic *gzip = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+			Common::WriteStream *stream = Common::wrapCompressedWriteStream(gzip);
+			stream->write(data, size);
+			stream->finalize();
+			gzipData = gzip->getData();
+			compressed = gzipData + 10;
+			compressedSize = gzip->size() - 18;
+			delete stream;
+		}
+#endif
+
+		const uint32 crc = crc32(data, size) ^ (corruptCrc ? 1 : 0);
+		const uint32 offset = _data.pos();
+		const uint16 nameLen = strlen(name);
+
+		_data.writeUint32LE(0x04034b50);
+		_data.writeUint16LE(20);					// version needed
+		_data.writeUint16LE(0);						// flags
+		_data.writeUint16LE(deflate ? 8 : 0);		// compression method
+		_data.writeUint32LE(0);						// date/time
+		_data.writeUint32LE(crc);
+		_data.writeUint32LE(compressedSize);
+		_data.writeUint32LE(size);
+		_data.writeUint16LE(nameLen);
+		_data.writeUint16LE(0);						// extra field length
+		_data.write(name, nameLen);
+		_data.write(compressed, compressedSize);
+
+		_central.writeUint32LE(0x02014b50);
+		_central.writeUint16LE(20);					// version made by
+		_central.writeUint16LE(20);					// version needed
+		_central.writeUint16LE(0);					// flags
+		_central.writeUint16LE(deflate ? 8 : 0);	// compression method
+		_central.writeUint32LE(0);					// date/time
+		_central.writeUint32LE(crc);
+		_central.writeUint32LE(compressedSize);
+		_central.writeUint32LE(size);
+		_central.writeUint16LE(nameLen);
+		_central.writeUint16LE(0);					// extra field length
+		_central.writeUint16LE(0);					// comment length
+		_central.writeUint16LE(0);					// disk number
+		_central.writeUint16LE(0);					// internal attributes
+		_central.writeUint32LE(0);					// external attributes
+		_central.writeUint32LE(offset);
+		_central.write(name, nameLen);
+
+		++_numMembers;
+		free(gzipData);
+	}
+
+	Common::Archive *makeArchive() {
+		const uint32 centralOffset = _data.pos();
+		_data.write(_central.getData(), _central.size());
+
+		_data.writeUint32LE(0x06054b50);
+		_data.writeUint16LE(0);						// disk number
+		_data.writeUint16LE(0);						// disk with central directory
+		_data.writeUint16LE(_numMembers);
+		_data.writeUint16LE(_numMembers);
+		_data.writeUint32LE(_central.size());
+		_data.writeUint32LE(centralOffset);
+		_data.writeUint16LE(0);						// comment length
+
+		return Common::makeZipArchive(new Common::MemoryReadStream(_data.getData(), _data.size(), DisposeAfterUse::YES));
+	}
+
+private:
+	static uint32 crc32(const byte *data, uint32 size) {
+		uint32 crc = 0xFFFFFFFF;
+		for (uint32 i = 0; i < size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+		return ~crc;
+	}
+
+	Common::MemoryWriteStreamDynamic _data;
+	Common::MemoryWriteStreamDynamic _central;
+	uint16 _numMembers;
+};
+
+class UnzipTestSuite : public CxxTest::TestSuite
+{
+	// Big enough for the deflated member to get several checkpoints
+	enum { kDataSize = 1100 * 1024 };
+
+	byte *_content;
+
+	void checkRead(Common::SeekableReadStream *stream, uint32 pos, uint32 size) {
+		byte buffer[1000];
+		TS_ASSERT(stream->seek(pos));
+		TS_ASSERT_EQUALS((uint32)stream->pos(), pos);
+		TS_ASSERT_EQUALS(stream->read(buffer, size), size);
+		TS_ASSERT_EQUALS(memcmp(buffer, _content + pos, size), 0);
+		TS_ASSERT(!stream->err());
+	}
+
+	void checkMember(Common::Archive *archive, const char *name) {
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember(name);
+		Common::SeekableReadStream *other = archive->createReadStreamForMember(name);
+		TS_ASSERT(stream && other);
+		if (!stream || !other)
+			return;
+		TS_ASSERT_EQUALS(stream->size(), (int32)kDataSize);
+
+		// Backward and forward seeks, across checkpoints, with interleaved
+		// reads of another stream of the same member
+		const uint32 positions[] = { 0, 700000, 300000, 299999, 1000000, 5, kDataSize - 1000, 262144, 524287 };
+		for (uint i = 0; i < ARRAYSIZE(positions); ++i) {
+			checkRead(stream, positions[i], 1000);
+			checkRead(other, (positions[i] * 7) % (kDataSize - 1000), 1000);
+		}
+
+		// Reading beyond the end sets eos
+		byte buffer[16];
+		TS_ASSERT(stream->seek(-4, SEEK_END));
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), 4U);
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+
+		delete stream;
+		delete other;
+	}
+
+public:
+	void setUp() {
+		// Compressible, but not trivially
+		_content = new byte[kDataSize];
+		uint32 seed = 1;
+		for (uint32 i = 0; i < kDataSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_content[i] = (byte)((seed >> 16) % 16 + (i / 1000));
+		}
+	}
+
+	void tearDown() {
+		delete[] _content;
+	}
+
+	void test_stored_member() {
+		ZipBuilder builder;
+		builder.addMember("stored.bin", _content, kDataSize, false);
+		Common::Archive *archive = builder.makeArchive();
+		TS_ASSERT(archive);
+		checkMember(archive, "stored.bin");
+		delete archive;
+	}
+
+	void test_deflated_member() {
+#ifdef USE_ZLIB
+		ZipBuilder builder;
+		builder.addMember("deflated.bin", _content, kDataSize, true);
+		Common::Archive *archive = builder.makeArchive();
+		TS_ASSERT(archive);
+		checkMember(archive, "deflated.bin");
+		delete archive;
+#endif
+	}
+
+	void test_members_read_alternately() {
+		// Two members with different content, read in turns, so that each
+		// read follows a read of the other member from the same archive stream
+		const uint32 memberSize = 300000;
+		const uint32 otherOffset = 500000;
+		ZipBuilder builder;
+		builder.addMember("first.bin", _content, memberSize, false);
+#ifdef USE_ZLIB
+		builder.addMember("second.bin", _content + otherOffset, memberSize, true);
+#else
+		builder.addMember("second.bin", _content + otherOffset, memberSize, false);
+#endif
+		Common::Archive *archive = builder.makeArchive();
+		Common::SeekableReadStream *first = archive->createReadStreamForMember("first.bin");
+		Common::SeekableReadStream *second = archive->createReadStreamForMember("second.bin");
+		TS_ASSERT(first && second);
+		if (!first || !second) {
+			delete first;
+			delete second;
+			delete archive;
+			return;
+		}
+
+		byte buffer[777];
+		for (uint32 pos = 0; pos < memberSize; pos += sizeof(buffer)) {
+			const uint32 size = MIN<uint32>(sizeof(buffer), memberSize - pos);
+			TS_ASSERT_EQUALS(first->read(buffer, size), size);
+			TS_ASSERT_EQUALS(memcmp(buffer, _content + pos, size), 0);
+			TS_ASSERT_EQUALS(second->read(buffer, size), size);
+			TS_ASSERT_EQUALS(memcmp(buffer, _content + otherOffset + pos, size), 0);
+		}
+		TS_ASSERT(!first->err() && !second->err());
+
+		delete first;
+		delete second;
+		delete archive;
+	}
+
+	void test_stream_outlives_archive() {
+		ZipBuilder builder;
+		builder.addMember("stored.bin", _content, 1000, false);
+#ifdef USE_ZLIB
+		builder.addMember("deflated.bin", _content, 1000, true);
+#endif
+		Common::Archive *archive = builder.makeArchive();
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.bin");
+#ifdef USE_ZLIB
+		Common::SeekableReadStream *deflated = archive->createReadStreamForMember("deflated.bin");
+#endif
+		delete archive;
+
+		checkRead(stored, 0, 1000);
+		delete stored;
+#ifdef USE_ZLIB
+		checkRead(deflated, 0, 1000);
+		delete deflated;
+#endif
+	}
+
+	void test_crc_mismatch() {
+#ifdef USE_ZLIB
+		ZipBuilder builder;
+		builder.addMember("corrupt.bin", _content, 1000, true, true);
+		Common::Archive *archive = builder.makeArchive();
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("corrupt.bin");
+
+		byte buffer[1000];
+		stream->read(buffer, sizeof(buffer));
+		TS_ASSERT(stream->err());
+
+		delete stream;
+		delete archive;
+#endif
+	}
+};
@@ -0,0 +1,259 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/blit_kernels.h"
+#include "graphics/managed_surface.h"
+#include "graphics/transparent_surface.h"
+
+#include "test/benchmark.h"
+
+class BlitTestSuite : public CxxTest::TestSuite
+{
+	typedef Graphics::BlitKernels Kernels;
+
+	uint32 _seed;
+
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Fill a surface with random pixels. For 32 bit surfaces, a quarter of
+	 * the alpha values is 0 and another quarter is 255.
+	 */
+	template<typename TSurface>
+	void fillRandom(TSurface &surface) {
+		for (int y = 0; y < surface.h; y++) {
+			for (int x = 0; x < surface.w; x++) {
+				const uint32 value = getRandom();
+				switch (surface.format.bytesPerPixel) {
+				case 1:
+					// Make the color key common
+					*(byte *)surface.getBasePtr(x, y) = (value & 3) ? value >> 8 : 0;
+					break;
+				case 2:
+					*(uint16 *)surface.getBasePtr(x, y) = (value & 3) ? value >> 8 : 0;
+					break;
+				default: {
+					// The alpha channel is in the lowest byte
+					uint32 pixel = (value & 3) ? getRandom() : 0;
+					const byte alpha = (value >> 2) & 3;
+					if (alpha < 2)
+						pixel = (pixel & 0xFFFFFF00) | (alpha ? 0xFF : 0);
+					*(uint32 *)surface.getBasePtr(x, y) = pixel;
+					break;
+				}
+				}
+			}
+		}
+	}
+
+	void checkTransparentBlit(const Kernels *kernels, Graphics::AlphaType alphaMode, Graphics::TSpriteBlendMode blendMode, uint color, int flipping) {
+		Graphics::TransparentSurface sprite;
+		sprite.create(37, 23, Graphics::TransparentSurface::getSupportedPixelFormat());
+		sprite.setAlphaMode(alphaMode);
+		_seed = 1;
+		fillRandom(sprite);
+
+		Graphics::Surface target[2];
+		for (int i = 0; i < 2; i++) {
+			target[i].create(64, 48, Graphics::TransparentSurface::getSupportedPixelFormat());
+			_seed = 2;
+			fillRandom(target[i]);
+
+			Graphics::setBlitKernels(i ? kernels : 0);
+			sprite.blit(target[i], 5, -3, flipping, nullptr, color, -1, -1, blendMode);
+			sprite.blit(target[i], 40, 30, flipping, nullptr, color, -1, -1, blendMode);
+		}
+
+		TS_ASSERT_EQUALS(memcmp(target[0].getPixels(), target[1].getPixels(), target[0].pitch * target[0].h), 0);
+		target[0].free();
+		target[1].free();
+		sprite.free();
+	}
+
+	void checkKeyBlit(const Kernels *kernels, const Graphics::PixelFormat &format) {
+		Graphics::ManagedSurface sprite;
+		sprite.create(45, 20, format);
+		_seed = 1;
+		fillRandom(sprite);
+
+		Graphics::ManagedSurface target[2];
+		for (int i = 0; i < 2; i++) {
+			target[i].create(64, 48, format);
+			_seed = 2;
+			fillRandom(target[i]);
+
+			Graphics::setBlitKernels(i ? kernels : 0);
+			target[i].transBlitFrom(sprite, Common::Rect(1, 2, 44, 20), Common::Point(-7, 3), 0);
+			target[i].transBlitFrom(sprite, Common::Rect(0, 0, 45, 20), Common::Point(30, 35), 0);
+		}
+
+		TS_ASSERT_EQUALS(memcmp(target[0].getPixels(), target[1].getPixels(), target[0].pitch * target[0].h), 0);
+	}
+
+	void checkTransform(const Kernels *kernels, int srcW, int srcH, int newW, int newH, int angle) {
+		Graphics::TransparentSurface sprite;
+		sprite.create(srcW, srcH, Graphics::TransparentSurface::getSupportedPixelFormat());
+		_seed = 3;
+		fillRandom(sprite);
+
+		Graphics::TransparentSurface *result[2];
+		for (int i = 0; i < 2; i++) {
+			Graphics::setBlitKernels(i ? kernels : 0);
+			if (angle)
+				result[i] = sprite.rotoscaleT<Graphics::FILTER_BILINEAR>(Graphics::TransformStruct(newW * 100 / srcW, newH * 100 / srcH, angle, srcW / 3, srcH / 2));
+			else
+				result[i] = sprite.scaleT<Graphics::FILTER_BILINEAR>(newW, newH);
+		}
+
+		TS_ASSERT_EQUALS(result[0]->w, result[1]->w);
+		TS_ASSERT_EQUALS(result[0]->h, result[1]->h);
+		TS_ASSERT_EQUALS(memcmp(result[0]->getPixels(), result[1]->getPixels(), result[0]->pitch * result[0]->h), 0);
+		for (int i = 0; i < 2; i++) {
+			result[i]->free();
+			delete result[i];
+		}
+		sprite.free();
+	}
+
+	void checkKernels(const Kernels *kernels) {
+		static const uint colors[] = { 0xFFFFFFFF, 0x80FF40C0, 0xFFFFFF00, 0x00FFFFFF };
+		const Kernels *oldKernels = Graphics::getBlitKernels();
+
+		for (int flipping = 0; flipping < 4; flipping++) {
+			// The opaque blitter does not support horizontal flipping
+			if (!(flipping & Graphics::FLIP_H))
+				checkTransparentBlit(kernels, Graphics::ALPHA_OPAQUE, Graphics::BLEND_NORMAL, 0xFFFFFFFF, flipping);
+			checkTransparentBlit(kernels, Graphics::ALPHA_BINARY, Graphics::BLEND_NORMAL, 0xFFFFFFFF, flipping);
+
+			for (int i = 0; i < ARRAYSIZE(colors); i++) {
+				checkTransparentBlit(kernels, Graphics::ALPHA_FULL, Graphics::BLEND_NORMAL, colors[i], flipping);
+				checkTransparentBlit(kernels, Graphics::ALPHA_FULL, Graphics::BLEND_ADDITIVE, colors[i], flipping);
+				checkTransparentBlit(kernels, Graphics::ALPHA_FULL, Graphics::BLEND_MULTIPLY, colors[i], flipping);
+			}
+		}
+
+		checkKeyBlit(kernels, Graphics::PixelFormat::createFormatCLUT8());
+		checkKeyBlit(kernels, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		checkKeyBlit(kernels, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+		checkTransform(kernels, 37, 23, 80, 51, 0);
+		checkTransform(kernels, 37, 23, 15, 9, 0);
+		checkTransform(kernels, 37, 23, 37, 23, 30);
+		checkTransform(kernels, 37, 23, 61, 40, 200);
+		checkTransform(kernels, 37, 23, 19, 11, 315);
+
+		Graphics::setBlitKernels(oldKernels);
+	}
+
+	void benchmarkTransparent(const char *name, const char *kernelName, const Kernels *kernels,
+			Graphics::AlphaType alphaMode, Graphics::TSpriteBlendMode blendMode, uint color) {
+		enum { kIterations = 200 };
+
+		Graphics::TransparentSurface sprite;
+		sprite.create(256, 256, Graphics::TransparentSurface::getSupportedPixelFormat());
+		sprite.setAlphaMode(alphaMode);
+		Graphics::Surface target;
+		target.create(640, 480, Graphics::TransparentSurface::getSupportedPixelFormat());
+		_seed = 1;
+		fillRandom(sprite);
+		fillRandom(target);
+
+		const Kernels *oldKernels = Graphics::getBlitKernels();
+		Graphics::setBlitKernels(kernels);
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < kIterations; i++)
+			sprite.blit(target, (i * 37) % 384, (i * 23) % 224, Graphics::FLIP_NONE, nullptr, color, -1, -1, blendMode);
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		Graphics::setBlitKernels(oldKernels);
+
+		Benchmark::report("Blit %-18s %-6s: %8u kpixels/sec\n", name, kernelName,
+			(uint)(kIterations * 256ULL * 256 * 1000 / time));
+		target.free();
+		sprite.free();
+	}
+
+	void benchmarkKeyBlit(const char *name, const char *kernelName, const Kernels *kernels, const Graphics::PixelFormat &format) {
+		enum { kIterations = 200 };
+
+		Graphics::ManagedSurface sprite, target;
+		sprite.create(256, 256, format);
+		target.create(640, 480, format);
+		_seed = 1;
+		fillRandom(sprite);
+		fillRandom(target);
+
+		const Kernels *oldKernels = Graphics::getBlitKernels();
+		Graphics::setBlitKernels(kernels);
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < kIterations; i++)
+			target.transBlitFrom(sprite, Common::Point((i * 37) % 384, (i * 23) % 224), 0);
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		Graphics::setBlitKernels(oldKernels);
+
+		Benchmark::report("Blit %-18s %-6s: %8u kpixels/sec\n", name, kernelName,
+			(uint)(kIterations * 256ULL * 256 * 1000 / time));
+	}
+
+	void benchmarkTransform(const char *name, const char *kernelName, const Kernels *kernels, int angle) {
+		enum { kIterations = 50 };
+
+		Graphics::TransparentSurface sprite;
+		sprite.create(256, 256, Graphics::TransparentSurface::getSupportedPixelFormat());
+		_seed = 1;
+		fillRandom(sprite);
+
+		const Kernels *oldKernels = Graphics::getBlitKernels();
+		Graphics::setBlitKernels(kernels);
+		uint64 pixels = 0;
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < kIterations; i++) {
+			Graphics::TransparentSurface *result;
+			if (angle)
+				result = sprite.rotoscaleT<Graphics::FILTER_BILINEAR>(Graphics::TransformStruct(150, 150, angle, 128, 128));
+			else
+				result = sprite.scaleT<Graphics::FILTER_BILINEAR>(384, 384);
+			pixels += result->w * result->h;
+			result->free();
+			delete result;
+		}
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		Graphics::setBlitKernels(oldKernels);
+
+		Benchmark::report("Blit %-18s %-6s: %8u kpixels/sec\n", name, kernelName, (uint)(pixels * 1000 / time));
+		sprite.free();
+	}
+
+	void benchmark(const char *kernelName, const Kernels *kernels) {
+		benchmarkTransparent("opaque", kernelName, kernels, Graphics::ALPHA_OPAQUE, Graphics::BLEND_NORMAL, 0xFFFFFFFF);
+		benchmarkTransparent("binary", kernelName, kernels, Graphics::ALPHA_BINARY, Graphics::BLEND_NORMAL, 0xFFFFFFFF);
+		benchmarkTransparent("alpha", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_NORMAL, 0xFFFFFFFF);
+		benchmarkTransparent("alpha, tinted", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_NORMAL, 0xC0FF8040);
+		benchmarkTransparent("additive", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_ADDITIVE, 0xFFFFFFFF);
+		benchmarkTransparent("additive, tinted", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_ADDITIVE, 0xC0FF8040);
+		benchmarkTransparent("multiply", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_MULTIPLY, 0xFFFFFFFF);
+		benchmarkTransparent("multiply, tinted", kernelName, kernels, Graphics::ALPHA_FULL, Graphics::BLEND_MULTIPLY, 0xC0FF8040);
+		benchmarkKeyBlit("color key, 8 bpp", kernelName, kernels, Graphics::PixelFormat::createFormatCLUT8());
+		benchmarkKeyBlit("color key, 16 bpp", kernelName, kernels, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		benchmarkKeyBlit("color key, 32 bpp", kernelName, kernels, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		benchmarkTransform("bilinear scale", kernelName, kernels, 0);
+		benchmarkTransform("bilinear rotate", kernelName, kernels, 30);
+	}
+
+public:
+	void test_sse2_kernels() {
+#ifdef SCUMMVM_SSE2
+		checkKernels(&Graphics::getSSE2BlitKernels());
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		benchmark("plain", 0);
+#ifdef SCUMMVM_SSE2
+		benchmark("SSE2", &Graphics::getSSE2BlitKernels());
+#endif
+#endif // TEST_BENCHMARKS
+	}
+};
@@ -0,0 +1,120 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyregion.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_contained_rects() {
+		Graphics::DirtyRegion region;
+		region.addRect(Common::Rect(10, 10, 100, 100));
+		region.addRect(Common::Rect(20, 20, 30, 30));
+		region.addRect(Common::Rect(0, 0, 200, 200));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1U);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 200, 200));
+		TS_ASSERT_EQUALS(region.getStats().rectsSubmitted, 3U);
+		TS_ASSERT_EQUALS(region.getStats().rectsMerged, 2U);
+	}
+
+	void test_adjacent_rects() {
+		Graphics::DirtyRegion region;
+		region.addRect(Common::Rect(0, 0, 50, 20));
+		region.addRect(Common::Rect(50, 0, 100, 20));
+		region.addRect(Common::Rect(0, 20, 100, 40));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1U);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 40));
+	}
+
+	void test_distant_rects() {
+		// Merging these would cost much more than the per-rect overhead
+		Graphics::DirtyRegion region;
+		region.addRect(Common::Rect(0, 0, 20, 20));
+		region.addRect(Common::Rect(300, 180, 320, 200));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 2U);
+		TS_ASSERT_EQUALS(region.getArea(), 800U);
+	}
+
+	void test_cascading_merge() {
+		// The last rect bridges the first two, whose union then covers everything
+		Graphics::DirtyRegion region;
+		region.addRect(Common::Rect(0, 0, 40, 40));
+		region.addRect(Common::Rect(60, 0, 100, 40));
+		region.addRect(Common::Rect(40, 0, 60, 40));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 1U);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 40));
+	}
+
+	void test_no_rect_cost() {
+		// Without an overhead per rect, as used by the GUI, rects are only
+		// merged when their union covers no more pixels than they do
+		Graphics::DirtyRegion region(Graphics::DirtyRegion::kDefaultMaxRects, 0);
+		region.addRect(Common::Rect(0, 0, 100, 20));
+		region.addRect(Common::Rect(0, 10, 100, 30));
+		TS_ASSERT_EQUALS(region.getRects().size(), 1U);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 30));
+
+		// An L shape would cover more pixels as a single rect
+		region.clear();
+		region.addRect(Common::Rect(0, 0, 100, 20));
+		region.addRect(Common::Rect(0, 10, 20, 100));
+		TS_ASSERT_EQUALS(region.getRects().size(), 2U);
+		TS_ASSERT_EQUALS(region.getArea(), 2000U + 1800U);
+
+		// Like rects which just touch without being aligned
+		region.clear();
+		region.addRect(Common::Rect(0, 0, 20, 20));
+		region.addRect(Common::Rect(20, 10, 40, 30));
+		TS_ASSERT_EQUALS(region.getRects().size(), 2U);
+
+		// A rect inside another one is dropped
+		region.addRect(Common::Rect(5, 5, 10, 10));
+		TS_ASSERT_EQUALS(region.getRects().size(), 2U);
+		TS_ASSERT_EQUALS(region.getArea(), 800U);
+	}
+
+	void test_max_rects() {
+		Graphics::DirtyRegion region(4, 0);
+		for (int i = 0; i < 10; ++i)
+			region.addRect(Common::Rect(i * 30, i * 20, i * 30 + 10, i * 20 + 10));
+
+		TS_ASSERT_EQUALS(region.getRects().size(), 4U);
+
+		// Everything submitted is still covered
+		for (int i = 0; i < 10; ++i) {
+			bool covered = false;
+			for (uint j = 0; j < region.getRects().size(); ++j)
+				covered |= region.getRects()[j].contains(Common::Rect(i * 30, i * 20, i * 30 + 10, i * 20 + 10));
+			TS_ASSERT(covered);
+		}
+	}
+
+	void test_frame_stats() {
+		Graphics::DirtyRegion::resetTotalStats();
+
+		Graphics::DirtyRegion region;
+		region.addRect(Common::Rect(0, 0, 10, 10));
+		region.addRect(Common::Rect(5, 5, 15, 15));
+		region.flush();
+		region.endFrame();
+
+		const Graphics::DirtyRegionStats &last = Graphics::DirtyRegion::getLastFrameStats();
+		TS_ASSERT_EQUALS(last.rectsSubmitted, 2U);
+		TS_ASSERT_EQUALS(last.rectsMerged, 1U);
+		TS_ASSERT_EQUALS(last.rectsUpdated, 1U);
+		TS_ASSERT_EQUALS(last.pixelsUpdated, 225U);
+		TS_ASSERT(region.empty());
+
+		region.setRect(Common::Rect(320, 200));
+		region.flush();
+		region.endFrame();
+
+		const Graphics::DirtyRegionStats &total = Graphics::DirtyRegion::getTotalStats();
+		TS_ASSERT_EQUALS(total.frames, 2U);
+		TS_ASSERT_EQUALS(total.rectsSubmitted, 2U);
+		TS_ASSERT_EQUALS(total.pixelsUpdated, 225U + 320U * 200U);
+	}
+};
@@ -0,0 +1,121 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transform_cache.h"
+
+class TransformCacheTestSuite : public CxxTest::TestSuite
+{
+	Graphics::Surface _sprite;
+
+	void createSprite() {
+		_sprite.create(40, 30, Graphics::TransparentSurface::getSupportedPixelFormat());
+		for (int y = 0; y < _sprite.h; y++) {
+			for (int x = 0; x < _sprite.w; x++)
+				*(uint32 *)_sprite.getBasePtr(x, y) = (x * 0x01020304) ^ (y * 0x40302010);
+		}
+	}
+
+public:
+	void test_hits_and_misses() {
+		createSprite();
+		Graphics::TransformCache cache;
+		const Common::Rect rect(5, 5, 25, 20);
+
+		Graphics::TransformCache::SurfacePtr a = cache.scale(&_sprite, _sprite, rect, 40, 30, Graphics::FILTER_BILINEAR);
+		Graphics::TransformCache::SurfacePtr b = cache.scale(&_sprite, _sprite, rect, 40, 30, Graphics::FILTER_BILINEAR);
+		TS_ASSERT_EQUALS(a.get(), b.get());
+		TS_ASSERT_EQUALS(cache.getStats().hits, 1u);
+		TS_ASSERT_EQUALS(cache.getStats().misses, 1u);
+
+		// Any other part, size, filter or transform is another copy
+		TS_ASSERT_DIFFERS(cache.scale(&_sprite, _sprite, Common::Rect(5, 5, 25, 21), 40, 30, Graphics::FILTER_BILINEAR).get(), a.get());
+		TS_ASSERT_DIFFERS(cache.scale(&_sprite, _sprite, rect, 40, 31, Graphics::FILTER_BILINEAR).get(), a.get());
+		TS_ASSERT_DIFFERS(cache.scale(&_sprite, _sprite, rect, 40, 30, Graphics::FILTER_NEAREST).get(), a.get());
+		Graphics::TransformCache::SurfacePtr c = cache.rotoscale(&_sprite, _sprite, rect, Graphics::TransformStruct(100, 100, 45), Graphics::FILTER_BILINEAR);
+		TS_ASSERT_EQUALS(cache.rotoscale(&_sprite, _sprite, rect, Graphics::TransformStruct(100, 100, 45), Graphics::FILTER_BILINEAR).get(), c.get());
+		TS_ASSERT_DIFFERS(cache.rotoscale(&_sprite, _sprite, rect, Graphics::TransformStruct(100, 100, 46), Graphics::FILTER_BILINEAR).get(), c.get());
+		TS_ASSERT_EQUALS(cache.getStats().hits, 2u);
+		TS_ASSERT_EQUALS(cache.getStats().misses, 6u);
+		TS_ASSERT_EQUALS(cache.size(), 6u);
+
+		_sprite.free();
+	}
+
+	void test_same_pixels() {
+		createSprite();
+		Graphics::TransformCache cache;
+		const Common::Rect rect(3, 2, 33, 29);
+
+		Graphics::TransparentSurface part(_sprite.getSubArea(rect), true);
+		Graphics::TransparentSurface *scaled = part.scaleT<Graphics::FILTER_BILINEAR>(50, 17);
+		Graphics::TransformCache::SurfacePtr cached = cache.scale(&_sprite, _sprite, rect, 50, 17, Graphics::FILTER_BILINEAR);
+		TS_ASSERT_EQUALS(cached->w, 50);
+		TS_ASSERT_EQUALS(cached->h, 17);
+		TS_ASSERT_EQUALS(memcmp(cached->getPixels(), scaled->getPixels(), scaled->pitch * scaled->h), 0);
+
+		scaled->free();
+		delete scaled;
+		part.free();
+		_sprite.free();
+	}
+
+	void test_memory_budget() {
+		createSprite();
+		// Room for three 20x20 copies
+		Graphics::TransformCache cache(3 * 20 * 20 * 4);
+
+		Graphics::TransformCache::SurfacePtr first = cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 11, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 12, 10), 20, 20, Graphics::FILTER_NEAREST);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 3u * 20 * 20 * 4);
+
+		// Using the first copy makes the second one the least recently used
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 13, 10), 20, 20, Graphics::FILTER_NEAREST);
+		TS_ASSERT_EQUALS(cache.getStats().evictions, 1u);
+		TS_ASSERT_EQUALS(cache.size(), 3u);
+		cache.resetStats();
+		TS_ASSERT_EQUALS(cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST).get(), first.get());
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 11, 10), 20, 20, Graphics::FILTER_NEAREST);
+		TS_ASSERT_EQUALS(cache.getStats().hits, 1u);
+		TS_ASSERT_EQUALS(cache.getStats().misses, 1u);
+
+		// Copies larger than the budget are not kept
+		Graphics::TransformCache::SurfacePtr large = cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 40, 40, Graphics::FILTER_NEAREST);
+		TS_ASSERT(large);
+		TS_ASSERT_EQUALS(cache.size(), 3u);
+
+		// Shrinking the budget drops copies, which stay valid while in use
+		cache.setMemoryBudget(20 * 20 * 4);
+		TS_ASSERT_EQUALS(cache.size(), 1u);
+		TS_ASSERT_EQUALS(first->w, 20);
+
+		_sprite.free();
+	}
+
+	void test_invalidate() {
+		createSprite();
+		Graphics::TransformCache cache;
+		int otherOwner;
+
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 20, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&otherOwner, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		TS_ASSERT_EQUALS(cache.size(), 3u);
+
+		cache.invalidate(&_sprite);
+		TS_ASSERT_EQUALS(cache.size(), 1u);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 20u * 20 * 4);
+
+		cache.resetStats();
+		cache.scale(&otherOwner, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		cache.scale(&_sprite, _sprite, Common::Rect(0, 0, 10, 10), 20, 20, Graphics::FILTER_NEAREST);
+		TS_ASSERT_EQUALS(cache.getStats().hits, 1u);
+		TS_ASSERT_EQUALS(cache.getStats().misses, 1u);
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.size(), 0u);
+		TS_ASSERT_EQUALS(cache.getMemoryUsage(), 0u);
+
+		_sprite.free();
+	}
+};
@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_kernels.h"
+
+#include "test/benchmark.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+	typedef Graphics::YUVToRGBManager Manager;
+	typedef Graphics::YUVToRGBKernels Kernels;
+
+	enum Subsampling {
+		k444,
+		k420,
+		k410
+	};
+
+	uint32 _seed;
+
+	byte getRandomByte() {
+		_seed = _seed * 1103515245 + 12345;
+		return (byte)(_seed >> 16);
+	}
+
+	static Graphics::PixelFormat getFormat(uint index) {
+		switch (index) {
+		case 0:
+			return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		case 1:
+			return Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);
+		case 2:
+			return Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0);
+		case 3:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		case 4:
+			return Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		default:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24);
+		}
+	}
+
+	static void convert(Graphics::Surface *dst, Subsampling subsampling, Manager::LuminanceScale scale, const byte *y, const byte *u, const byte *v, int width, int height, int yPitch, int uvPitch) {
+		switch (subsampling) {
+		case k444:
+			YUVToRGBMan.convert444(dst, scale, y, u, v, width, height, yPitch, uvPitch);
+			break;
+		case k420:
+			YUVToRGBMan.convert420(dst, scale, y, u, v, width, height, yPitch, uvPitch);
+			break;
+		case k410:
+			YUVToRGBMan.convert410(dst, scale, y, u, v, width, height, yPitch, uvPitch);
+			break;
+		}
+	}
+
+	/**
+	 * Convert an image with the kernels and with the lookup tables, and
+	 * check that both give the same pixels. The destination and source
+	 * pitches are larger than the width, which is not a multiple of 16.
+	 */
+	void checkKernels(const Kernels *kernels, Subsampling subsampling, int width, int height) {
+		const int yPitch = width + 7;
+		const int uvPitch = width + 5;
+		byte *y = new byte[yPitch * height];
+		byte *u = new byte[uvPitch * (height + 1)];
+		byte *v = new byte[uvPitch * (height + 1)];
+
+		_seed = 1;
+		for (int i = 0; i < yPitch * height; i++)
+			y[i] = getRandomByte();
+		for (int i = 0; i < uvPitch * (height + 1); i++) {
+			// Cover every pair of chroma values in the first columns
+			u[i] = (i % uvPitch < 256) ? i % uvPitch : getRandomByte();
+			v[i] = (i % uvPitch < 256) ? i / uvPitch : getRandomByte();
+		}
+
+		const Kernels *oldKernels = YUVToRGBMan.getKernels();
+		for (uint format = 0; format < 6; format++) {
+			for (int scale = 0; scale < 2; scale++) {
+				Graphics::Surface dst[2];
+				for (int i = 0; i < 2; i++) {
+					dst[i].create(width + 3, height, getFormat(format));
+					memset(dst[i].getPixels(), 0x55, dst[i].pitch * height);
+					YUVToRGBMan.setKernels(i ? kernels : 0);
+					convert(&dst[i], subsampling, (Manager::LuminanceScale)scale, y, u, v, width, height, yPitch, uvPitch);
+				}
+
+				TS_ASSERT_EQUALS(memcmp(dst[0].getPixels(), dst[1].getPixels(), dst[0].pitch * height), 0);
+				dst[0].free();
+				dst[1].free();
+			}
+		}
+		YUVToRGBMan.setKernels(oldKernels);
+
+		delete[] y;
+		delete[] u;
+		delete[] v;
+	}
+
+	void checkKernels(const Kernels *kernels) {
+		checkKernels(kernels, k444, 260, 256);
+		checkKernels(kernels, k420, 276, 256);
+		checkKernels(kernels, k410, 268, 64);
+	}
+
+	void benchmark(const char *name, const Kernels *kernels, Subsampling subsampling, int bytesPerPixel, int width, int height) {
+		static const char *const subsamplingNames[] = { "444", "420", "410" };
+
+		// Keep the number of converted pixels about the same for all sizes
+		const uint frames = MAX(4000000 / (width * height), 1);
+		byte *y = new byte[width * height];
+		byte *u = new byte[width * (height + 1)];
+		byte *v = new byte[width * (height + 1)];
+		_seed = 1;
+		for (int i = 0; i < width * height; i++)
+			y[i] = getRandomByte();
+		for (int i = 0; i < width * (height + 1); i++) {
+			u[i] = getRandomByte();
+			v[i] = getRandomByte();
+		}
+
+		Graphics::Surface dst;
+		dst.create(width, height, getFormat(bytesPerPixel == 2 ? 0 : 3));
+		const Kernels *oldKernels = YUVToRGBMan.getKernels();
+		YUVToRGBMan.setKernels(kernels);
+
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < frames; i++)
+			convert(&dst, subsampling, Manager::kScaleFull, y, u, v, width, height, width, width);
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		Benchmark::report("YUV%s to %2d bpp, %4dx%-4d %-6s: %8u frames/sec\n", subsamplingNames[subsampling],
+			bytesPerPixel * 8, width, height, name, (uint)(frames * 1000000ULL / time));
+
+		YUVToRGBMan.setKernels(oldKernels);
+		dst.free();
+		delete[] y;
+		delete[] u;
+		delete[] v;
+	}
+
+	void benchmark(const char *name, const Kernels *kernels) {
+		static const int sizes[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 } };
+
+		for (int i = 0; i < ARRAYSIZE(sizes); i++) {
+			benchmark(name, kernels, k420, 2, sizes[i][0], sizes[i][1]);
+			benchmark(name, kernels, k420, 4, sizes[i][0], sizes[i][1]);
+			benchmark(name, kernels, k444, 4, sizes[i][0], sizes[i][1]);
+			benchmark(name, kernels, k410, 4, sizes[i][0], sizes[i][1]);
+		}
+	}
+
+public:
+	void test_lookup_gray() {
+		// Gray pixels without chroma keep their luminance
+		byte y[16 * 2], uv[16 * 2];
+		for (int i = 0; i < 32; i++) {
+			y[i] = i * 8;
+			uv[i] = 128;
+		}
+
+		const Kernels *oldKernels = YUVToRGBMan.getKernels();
+		YUVToRGBMan.setKernels(0);
+		Graphics::Surface dst;
+		dst.create(16, 2, getFormat(3));
+		YUVToRGBMan.convert444(&dst, Manager::kScaleFull, y, uv, uv, 16, 2, 16, 16);
+		for (int i = 0; i < 32; i++) {
+			byte a, r, g, b;
+			dst.format.colorToARGB(((const uint32 *)dst.getPixels())[i], a, r, g, b);
+			TS_ASSERT_EQUALS(a, 255);
+			TS_ASSERT_EQUALS(r, i * 8);
+			TS_ASSERT_EQUALS(g, i * 8);
+			TS_ASSERT_EQUALS(b, i * 8);
+		}
+		dst.free();
+		YUVToRGBMan.setKernels(oldKernels);
+	}
+
+	void test_sse2_kernels() {
+#ifdef SCUMMVM_SSE2
+		checkKernels(&Graphics::getSSE2YUVToRGBKernels());
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		benchmark("lookup", 0);
+#ifdef SCUMMVM_SSE2
+		benchmark("SSE2", &Graphics::getSSE2YUVToRGBKernels());
+#endif
+#endif // TEST_BENCHMARKS
+	}
+};
@@ -5,8 +5,8 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := test/benchmark.o test/threadedsystem.o video/libvideo.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
@@ -24,6 +24,18 @@ TEST_CFLAGS  := $(CFLAGS) -I$(srcdir)/test/cxxtest
 TEST_LDFLAGS := $(LDFLAGS) $(LIBS)
 TEST_CXXFLAGS := $(filter-out -Wglobal-constructors,$(CXXFLAGS))
 
+# The timing loops of the benchmark tests only run when the runner is built
+# with "make clean-test test TEST_BENCHMARKS=1". Otherwise these tests do
+# nothing.
+ifdef TEST_BENCHMARKS
+TEST_CXXFLAGS += -DTEST_BENCHMARKS
+endif
+
+# ThreadedTestSystem runs the background jobs on a POSIX thread
+ifdef POSIX
+TEST_LDFLAGS += -lpthread
+endif
+
 ifdef N64
 TEST_LDFLAGS := $(filter-out -mno-crt0,$(TEST_LDFLAGS))
 endif
@@ -49,6 +61,6 @@ test/runner.cpp: $(TESTS)
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner
+	-$(RM) test/runner.cpp test/runner test/benchmark.o test/threadedsystem.o
 
 .PHONY: test clean-test
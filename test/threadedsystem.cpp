@@ -0,0 +1,216 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/threadedsystem.h"
+
+#ifdef POSIX
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+class PosixThreadedTestSystem : public ThreadedTestSystem {
+public:
+	PosixThreadedTestSystem() : _threadStarted(false), _quit(false), _running(false), _lastId(0), _doneId(0) {
+		pthread_mutex_init(&_jobMutex, nullptr);
+		pthread_cond_init(&_jobCond, nullptr);
+		pthread_cond_init(&_idleCond, nullptr);
+	}
+
+	~PosixThreadedTestSystem() {
+		if (_threadStarted) {
+			pthread_mutex_lock(&_jobMutex);
+			_quit = true;
+			pthread_cond_signal(&_jobCond);
+			pthread_mutex_unlock(&_jobMutex);
+			pthread_join(_thread, nullptr);
+		}
+
+		pthread_cond_destroy(&_idleCond);
+		pthread_cond_destroy(&_jobCond);
+		pthread_mutex_destroy(&_jobMutex);
+	}
+
+	void waitForBackgroundJobs() override {
+		pthread_mutex_lock(&_jobMutex);
+		while (!_jobs.empty() || _running)
+			pthread_cond_wait(&_idleCond, &_jobMutex);
+		pthread_mutex_unlock(&_jobMutex);
+	}
+
+	bool isBackgroundThread() override {
+		return _threadStarted && pthread_equal(pthread_self(), _thread);
+	}
+
+	uint32 startBackgroundJob(BackgroundJobProc job, void *param) override {
+		pthread_mutex_lock(&_jobMutex);
+		if (!_threadStarted) {
+			if (pthread_create(&_thread, nullptr, &threadMain, this) != 0) {
+				pthread_mutex_unlock(&_jobMutex);
+				return 0;
+			}
+			_threadStarted = true;
+		}
+
+		if (++_lastId == 0)
+			++_lastId;
+
+		Job entry;
+		entry.job = job;
+		entry.param = param;
+		entry.id = _lastId;
+		_jobs.push_back(entry);
+		pthread_cond_signal(&_jobCond);
+		pthread_mutex_unlock(&_jobMutex);
+		return entry.id;
+	}
+
+	void waitForBackgroundJob(uint32 id) override {
+		if (!id)
+			return;
+
+		pthread_mutex_lock(&_jobMutex);
+		while ((int32)(_doneId - id) < 0)
+			pthread_cond_wait(&_idleCond, &_jobMutex);
+		pthread_mutex_unlock(&_jobMutex);
+	}
+
+	bool canRunBackgroundJobs() override { return true; }
+
+	MutexRef createMutex() override {
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_t *mutex = new pthread_mutex_t;
+		pthread_mutex_init(mutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+		return (MutexRef)mutex;
+	}
+
+	void lockMutex(MutexRef mutex) override { pthread_mutex_lock((pthread_mutex_t *)mutex); }
+	void unlockMutex(MutexRef mutex) override { pthread_mutex_unlock((pthread_mutex_t *)mutex); }
+
+	void deleteMutex(MutexRef mutex) override {
+		pthread_mutex_destroy((pthread_mutex_t *)mutex);
+		delete (pthread_mutex_t *)mutex;
+	}
+
+	uint32 getMillis(bool skipRecord = false) override {
+		struct timeval tv;
+		gettimeofday(&tv, nullptr);
+		return (uint32)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+	}
+
+	void delayMillis(uint msecs) override { usleep(msecs * 1000); }
+	void getTimeAndDate(TimeDate &t) const override { memset(&t, 0, sizeof(t)); }
+
+#ifdef USE_RGB_COLOR
+	Graphics::PixelFormat getScreenFormat() const override { return Graphics::PixelFormat::createFormatCLUT8(); }
+	Common::List<Graphics::PixelFormat> getSupportedFormats() const override { return Common::List<Graphics::PixelFormat>(); }
+#endif
+	void initSize(uint width, uint height, const Graphics::PixelFormat *format = nullptr) override {}
+	int16 getHeight() override { return 0; }
+	int16 getWidth() override { return 0; }
+	PaletteManager *getPaletteManager() override { return nullptr; }
+	void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) override {}
+	Graphics::Surface *lockScreen() override { return nullptr; }
+	void unlockScreen() override {}
+	void fillScreen(uint32 col) override {}
+	void updateScreen() override {}
+	void setShakePos(int shakeXOffset, int shakeYOffset) override {}
+	void showOverlay() override {}
+	void hideOverlay() override {}
+	Graphics::PixelFormat getOverlayFormat() const override { return Graphics::PixelFormat::createFormatCLUT8(); }
+	void clearOverlay() override {}
+	void grabOverlay(void *buf, int pitch) override {}
+	void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) override {}
+	int16 getOverlayHeight() override { return 0; }
+	int16 getOverlayWidth() override { return 0; }
+	bool showMouse(bool visible) override { return false; }
+	void warpMouse(int x, int y) override {}
+	void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = nullptr) override {}
+	Audio::Mixer *getMixer() override { return nullptr; }
+	void quit() override {}
+	void displayMessageOnOSD(const char *msg) override {}
+	void displayActivityIconOnOSD(const Graphics::Surface *icon) override {}
+	void logMessage(LogMessageType::Type type, const char *message) override {}
+
+private:
+	struct Job {
+		BackgroundJobProc job;
+		void *param;
+		uint32 id;
+	};
+
+	static void *threadMain(void *arg) {
+		PosixThreadedTestSystem *system = (PosixThreadedTestSystem *)arg;
+
+		pthread_mutex_lock(&system->_jobMutex);
+		while (true) {
+			while (system->_jobs.empty() && !system->_quit)
+				pthread_cond_wait(&system->_jobCond, &system->_jobMutex);
+			// The queued jobs still run when quitting, like on the SDL backend
+			if (system->_jobs.empty())
+				break;
+
+			const Job job = system->_jobs.front();
+			system->_jobs.pop_front();
+			system->_running = true;
+			pthread_mutex_unlock(&system->_jobMutex);
+
+			job.job(job.param);
+
+			pthread_mutex_lock(&system->_jobMutex);
+			system->_running = false;
+			system->_doneId = job.id;
+			pthread_cond_broadcast(&system->_idleCond);
+		}
+		pthread_mutex_unlock(&system->_jobMutex);
+
+		return nullptr;
+	}
+
+	pthread_t _thread;
+	bool _threadStarted;
+	pthread_mutex_t _jobMutex;
+	pthread_cond_t _jobCond;   ///< Signaled when a job is queued or the thread has to quit
+	pthread_cond_t _idleCond;  ///< Signaled when a job is done
+	Common::List<Job> _jobs;
+	bool _quit;
+	bool _running;
+	uint32 _lastId;
+	uint32 _doneId;            ///< Id of the last job which is done
+
+};
+
+} // End of anonymous namespace
+
+ThreadedTestSystem *ThreadedTestSystem::create() {
+	return new PosixThreadedTestSystem();
+}
+
+#endif
@@ -0,0 +1,51 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TEST_THREADEDSYSTEM_H
+#define TEST_THREADEDSYSTEM_H
+
+#include "common/system.h"
+
+#ifdef POSIX
+
+/**
+ * An OSystem for tests of code which uses several threads, like the
+ * background jobs. It provides recursive mutexes, the time, and a thread
+ * running the background jobs, but no graphics, sound or events. The
+ * threads need system headers, which are forbidden in regular code, so the
+ * implementation lives in its own translation unit.
+ */
+class ThreadedTestSystem : public OSystem {
+public:
+	/** Create the system. It has to be set as g_system by the caller. */
+	static ThreadedTestSystem *create();
+
+	/** Wait until all background jobs started so far are done. */
+	virtual void waitForBackgroundJobs() = 0;
+
+	/** Return whether this is called from a background job. */
+	virtual bool isBackgroundThread() = 0;
+};
+
+#endif
+
+#endif
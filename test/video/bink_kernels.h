@@ -0,0 +1,133 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_kernels.h"
+
+#include "test/benchmark.h"
+
+#ifdef USE_BINK
+
+class BinkKernelsTestSuite : public CxxTest::TestSuite
+{
+	typedef Video::BinkKernels Kernels;
+
+	enum {
+		kPitch = 13,
+		kNumBlocks = 200
+	};
+
+	uint32 _seed;
+
+	int32 getRandom(int32 range) {
+		_seed = _seed * 1103515245 + 12345;
+		return (int32)((_seed >> 8) % (2 * range + 1)) - range;
+	}
+
+	/**
+	 * Fill a block with coefficients like the ones the decoder reads: a
+	 * large DC value and mostly small or zero AC values, with some blocks
+	 * containing only the DC value.
+	 */
+	void fillCoeffs(int32 *block, uint index) {
+		memset(block, 0, 64 * sizeof(int32));
+		block[0] = getRandom(1 << 15);
+		if (index % 4 == 0)
+			return;
+		for (int i = 1; i < 64; i++) {
+			if (getRandom(3) == 0)
+				block[i] = (index % 4 == 1) ? getRandom(8192) : getRandom(256);
+		}
+	}
+
+	void fillBytes(byte *dest, uint size) {
+		for (uint i = 0; i < size; i++)
+			dest[i] = getRandom(128) + 128;
+	}
+
+	void checkKernels(const Kernels &kernels) {
+		const Kernels &scalar = Video::getScalarBinkKernels();
+		_seed = 1;
+
+		for (uint n = 0; n < kNumBlocks; n++) {
+			int32 coeffs[64], block[2][64];
+			byte dest[2][8 * kPitch];
+
+			fillCoeffs(coeffs, n);
+			memcpy(block[0], coeffs, sizeof(coeffs));
+			memcpy(block[1], coeffs, sizeof(coeffs));
+			kernels.idct(block[0]);
+			scalar.idct(block[1]);
+			TS_ASSERT_EQUALS(memcmp(block[0], block[1], sizeof(block[0])), 0);
+
+			// The bytes between the rows must not be touched
+			fillBytes(dest[0], sizeof(dest[0]));
+			memcpy(dest[1], dest[0], sizeof(dest[0]));
+			kernels.idctPut(dest[0], kPitch, coeffs);
+			scalar.idctPut(dest[1], kPitch, coeffs);
+			TS_ASSERT_EQUALS(memcmp(dest[0], dest[1], sizeof(dest[0])), 0);
+
+			fillBytes(dest[0], sizeof(dest[0]));
+			memcpy(dest[1], dest[0], sizeof(dest[0]));
+			kernels.idctAdd(dest[0], kPitch, coeffs);
+			scalar.idctAdd(dest[1], kPitch, coeffs);
+			TS_ASSERT_EQUALS(memcmp(dest[0], dest[1], sizeof(dest[0])), 0);
+
+			int16 residue[64];
+			for (int i = 0; i < 64; i++)
+				residue[i] = getRandom((n & 1) ? 32767 : 64);
+			fillBytes(dest[0], sizeof(dest[0]));
+			memcpy(dest[1], dest[0], sizeof(dest[0]));
+			kernels.addResidue(dest[0], kPitch, residue);
+			scalar.addResidue(dest[1], kPitch, residue);
+			TS_ASSERT_EQUALS(memcmp(dest[0], dest[1], sizeof(dest[0])), 0);
+		}
+	}
+
+	void benchmark(const char *name, const Kernels &kernels) {
+		enum { kIterations = 20000 };
+
+		int32 coeffs[16][64];
+		byte dest[8 * kPitch];
+		_seed = 1;
+		for (uint i = 0; i < 16; i++)
+			fillCoeffs(coeffs[i], i);
+		fillBytes(dest, sizeof(dest));
+
+		const uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < kIterations; i++) {
+			kernels.idctPut(dest, kPitch, coeffs[i & 15]);
+			kernels.idctAdd(dest, kPitch, coeffs[(i + 1) & 15]);
+		}
+		const uint64 time = MAX<uint64>(Benchmark::getMicros() - start, 1);
+		Benchmark::report("Bink IDCT %-6s: %10u blocks/sec\n", name,
+			(uint)(kIterations * 2 * 1000000ULL / time));
+	}
+
+public:
+	void test_scalar_dc_only() {
+		// A lone DC coefficient gives a flat block
+		int32 coeffs[64];
+		memset(coeffs, 0, sizeof(coeffs));
+		coeffs[0] = 100 << 8;
+		byte dest[8 * 8];
+		Video::getScalarBinkKernels().idctPut(dest, 8, coeffs);
+		for (int i = 0; i < 64; i++)
+			TS_ASSERT_EQUALS(dest[i], 100);
+	}
+
+	void test_sse2_kernels() {
+#ifdef SCUMMVM_SSE2
+		checkKernels(Video::getSSE2BinkKernels());
+#endif
+	}
+
+	void test_benchmark() {
+#ifdef TEST_BENCHMARKS
+		benchmark("scalar", Video::getScalarBinkKernels());
+#ifdef SCUMMVM_SSE2
+		benchmark("SSE2", Video::getSSE2BinkKernels());
+#endif
+#endif // TEST_BENCHMARKS
+	}
+};
+
+#endif // USE_BINK
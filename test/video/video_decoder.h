@@ -0,0 +1,207 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef POSIX
+
+#include "common/endian.h"
+#include "graphics/surface.h"
+#include "video/video_decoder.h"
+
+#include "test/threadedsystem.h"
+
+/**
+ * A decoder of a video whose frames contain their frame number. It notes
+ * whether frames were decoded by a background job.
+ */
+class DecodeAheadTestDecoder : public Video::VideoDecoder {
+public:
+	enum {
+		kFrameCount = 30
+	};
+
+	DecodeAheadTestDecoder() : _track(nullptr) {}
+	~DecodeAheadTestDecoder() { close(); }
+
+	bool loadStream(Common::SeekableReadStream *stream) override {
+		close();
+		_track = new CountingVideoTrack();
+		addTrack(_track);
+		return true;
+	}
+
+	void close() override {
+		VideoDecoder::close();
+		_track = nullptr;
+	}
+
+	/** Whether the track decoded a frame in a background job. */
+	bool decodedInBackground() const { return _track->_decodedInBackground; }
+
+private:
+	class CountingVideoTrack : public FixedRateVideoTrack {
+	public:
+		CountingVideoTrack() : _curFrame(-1), _decodedInBackground(false) {
+			_surface.create(4, 1, Graphics::PixelFormat::createFormatCLUT8());
+		}
+
+		~CountingVideoTrack() { _surface.free(); }
+
+		uint16 getWidth() const override { return _surface.w; }
+		uint16 getHeight() const override { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const override { return _surface.format; }
+		int getCurFrame() const override { return _curFrame; }
+		int getFrameCount() const override { return kFrameCount; }
+		bool isSeekable() const override { return true; }
+
+		bool seek(const Audio::Timestamp &time) override {
+			_curFrame = (int)getFrameAtTime(time) - 1;
+			return true;
+		}
+
+		const Graphics::Surface *decodeNextFrame() override {
+			if (((ThreadedTestSystem *)g_system)->isBackgroundThread())
+				_decodedInBackground = true;
+
+			_curFrame++;
+			WRITE_UINT32(_surface.getPixels(), _curFrame);
+			return &_surface;
+		}
+
+		int _curFrame;
+		bool _decodedInBackground;
+		Graphics::Surface _surface;
+
+	protected:
+		Common::Rational getFrameRate() const override { return 10; }
+	};
+
+	CountingVideoTrack *_track;
+};
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite {
+	enum {
+		kDepth = 4
+	};
+
+	OSystem *_savedSystem;
+	ThreadedTestSystem *_system;
+	DecodeAheadTestDecoder *_decoder;
+
+	int nextFrame() {
+		const Graphics::Surface *surface = _decoder->decodeNextFrame();
+		TS_ASSERT(surface);
+		return surface ? (int)READ_UINT32(surface->getPixels()) : -1;
+	}
+
+	uint queuedFrames() {
+		return _decoder->getDecodeAheadStats().queuedFrames;
+	}
+
+public:
+	void setUp() {
+		_savedSystem = g_system;
+		_system = ThreadedTestSystem::create();
+		g_system = _system;
+
+		_decoder = new DecodeAheadTestDecoder();
+		_decoder->loadStream(nullptr);
+	}
+
+	void tearDown() {
+		delete _decoder;
+		delete _system;
+		g_system = _savedSystem;
+	}
+
+	void test_decodes_ahead_in_background() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+
+		for (int i = 0; i < DecodeAheadTestDecoder::kFrameCount; i++) {
+			TS_ASSERT_EQUALS(nextFrame(), i);
+			TS_ASSERT_EQUALS(_decoder->getCurFrame(), i);
+
+			_system->waitForBackgroundJobs();
+			TS_ASSERT_EQUALS(queuedFrames(), (uint)MIN<int>(kDepth, DecodeAheadTestDecoder::kFrameCount - 1 - i));
+		}
+
+		TS_ASSERT(_decoder->endOfVideo());
+		TS_ASSERT(_decoder->decodedInBackground());
+
+		const Video::VideoDecoder::DecodeAheadStats stats = _decoder->getDecodeAheadStats();
+		TS_ASSERT_EQUALS(stats.frames, (uint32)DecodeAheadTestDecoder::kFrameCount);
+		TS_ASSERT_EQUALS(stats.maxQueuedFrames, (uint)kDepth);
+		TS_ASSERT_EQUALS(stats.lateFrames, 0U);
+	}
+
+	void test_seek_discards_frames() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+		_system->waitForBackgroundJobs();
+		TS_ASSERT_EQUALS(queuedFrames(), (uint)kDepth);
+
+		TS_ASSERT(_decoder->seekToFrame(20));
+		TS_ASSERT_EQUALS(_decoder->getCurFrame(), 19);
+		_system->waitForBackgroundJobs();
+		TS_ASSERT_EQUALS(queuedFrames(), (uint)kDepth);
+
+		TS_ASSERT_EQUALS(nextFrame(), 20);
+		TS_ASSERT_EQUALS(nextFrame(), 21);
+		TS_ASSERT_EQUALS(_decoder->getCurFrame(), 21);
+	}
+
+	void test_rewind_discards_frames() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+		TS_ASSERT_EQUALS(nextFrame(), 1);
+		_system->waitForBackgroundJobs();
+
+		TS_ASSERT(_decoder->rewind());
+		TS_ASSERT_EQUALS(_decoder->getCurFrame(), -1);
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+		TS_ASSERT_EQUALS(nextFrame(), 1);
+	}
+
+	void test_nothing_decoded_while_paused() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+		_decoder->pauseVideo(true);
+
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+		_system->waitForBackgroundJobs();
+		TS_ASSERT_EQUALS(queuedFrames(), 0U);
+
+		// Seeking while paused discards the queue without refilling it
+		TS_ASSERT(_decoder->seekToFrame(5));
+		_system->waitForBackgroundJobs();
+		TS_ASSERT_EQUALS(queuedFrames(), 0U);
+
+		_decoder->pauseVideo(false);
+		_system->waitForBackgroundJobs();
+		TS_ASSERT_EQUALS(queuedFrames(), (uint)kDepth);
+		TS_ASSERT_EQUALS(nextFrame(), 5);
+		TS_ASSERT_EQUALS(nextFrame(), 6);
+	}
+
+	void test_disabling_returns_queued_frames() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+		_system->waitForBackgroundJobs();
+
+		TS_ASSERT(_decoder->setDecodeAhead(0));
+		for (int i = 1; i < 10; i++)
+			TS_ASSERT_EQUALS(nextFrame(), i);
+		TS_ASSERT_EQUALS(queuedFrames(), 0U);
+	}
+
+	void test_close_while_decoding() {
+		TS_ASSERT(_decoder->setDecodeAhead(kDepth));
+		TS_ASSERT_EQUALS(nextFrame(), 0);
+
+		// The background job may still be queued or running
+		delete _decoder;
+		_decoder = nullptr;
+		_system->waitForBackgroundJobs();
+	}
+};
+
+#endif
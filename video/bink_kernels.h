@@ -0,0 +1,70 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef VIDEO_BINK_KERNELS_H
+#define VIDEO_BINK_KERNELS_H
+
+#include "common/scummsys.h"
+
+#ifdef USE_BINK
+
+namespace Video {
+
+/**
+ * The per block transforms of the Bink video decoder. Blocks are 8x8,
+ * stored row by row. Like the original decoder, pixel values are not
+ * clamped but wrap around. All implementations produce bit-identical
+ * output.
+ */
+struct BinkKernels {
+	/** Transform a block of DCT coefficients in place. */
+	void (*idct)(int32 *block);
+
+	/** Transform a block of DCT coefficients and store it at dest. */
+	void (*idctPut)(byte *dest, uint32 pitch, const int32 *block);
+
+	/** Transform a block of DCT coefficients and add it to dest. */
+	void (*idctAdd)(byte *dest, uint32 pitch, const int32 *block);
+
+	/** Add a block of residues to dest. */
+	void (*addResidue)(byte *dest, uint32 pitch, const int16 *block);
+};
+
+/** Plain C++ kernels, available on all platforms. */
+const BinkKernels &getScalarBinkKernels();
+
+#ifdef SCUMMVM_SSE2
+/** Kernels using SSE2. Only use them if OSystem::kFeatureCpuSSE2 is set. */
+const BinkKernels &getSSE2BinkKernels();
+#endif
+
+/**
+ * Return the fastest kernels supported by the CPU. The choice is made
+ * once, on the first call.
+ */
+const BinkKernels &getBinkKernels();
+
+} // End of namespace Video
+
+#endif // USE_BINK
+
+#endif
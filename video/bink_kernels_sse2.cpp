@@ -0,0 +1,198 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "video/bink_kernels.h"
+
+#if defined(USE_BINK) && defined(SCUMMVM_SSE2)
+
+#include <emmintrin.h>
+
+namespace Video {
+
+/**
+ * Multiply four 32 bit integers by a constant, keeping the low 32 bits of
+ * the products like the scalar code does. SSE2 has no 32 bit mullo, but
+ * the low halves of unsigned products are the same as the signed ones.
+ */
+static FORCEINLINE __m128i mulConst(__m128i x, __m128i k) {
+	const __m128i even = _mm_mul_epu32(x, k);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), k);
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * Run the 1D transform on eight vectors of four independent lanes, in
+ * place. The row pass also rounds and scales down the results.
+ */
+static FORCEINLINE void transform(__m128i &s0, __m128i &s1, __m128i &s2, __m128i &s3,
+                                  __m128i &s4, __m128i &s5, __m128i &s6, __m128i &s7, bool munge) {
+	const __m128i a1c = _mm_set1_epi32(2896);
+	const __m128i a2c = _mm_set1_epi32(2217);
+	const __m128i a3c = _mm_set1_epi32(3784);
+	const __m128i a4c = _mm_set1_epi32(-5352);
+
+	const __m128i a0 = _mm_add_epi32(s0, s4);
+	const __m128i a1 = _mm_sub_epi32(s0, s4);
+	const __m128i a2 = _mm_add_epi32(s2, s6);
+	const __m128i a3 = _mm_srai_epi32(mulConst(_mm_sub_epi32(s2, s6), a1c), 11);
+	const __m128i a4 = _mm_add_epi32(s5, s3);
+	const __m128i a5 = _mm_sub_epi32(s5, s3);
+	const __m128i a6 = _mm_add_epi32(s1, s7);
+	const __m128i a7 = _mm_sub_epi32(s1, s7);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(mulConst(_mm_add_epi32(a5, a7), a3c), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(mulConst(a5, a4c), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(mulConst(_mm_sub_epi32(a6, a4), a1c), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(mulConst(a7, a2c), 11), b3), b1);
+
+	// The rounding term of the row pass is folded into the common sums
+	const __m128i round = _mm_set1_epi32(munge ? 0x7F : 0);
+	const __m128i e0 = _mm_add_epi32(_mm_add_epi32(a0, a2), round);
+	const __m128i e1 = _mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(a1, a3), a2), round);
+	const __m128i e2 = _mm_add_epi32(_mm_add_epi32(_mm_sub_epi32(a1, a3), a2), round);
+	const __m128i e3 = _mm_add_epi32(_mm_sub_epi32(a0, a2), round);
+	s0 = _mm_add_epi32(e0, b0);
+	s1 = _mm_add_epi32(e1, b2);
+	s2 = _mm_add_epi32(e2, b3);
+	s3 = _mm_sub_epi32(e3, b4);
+	s4 = _mm_add_epi32(e3, b4);
+	s5 = _mm_sub_epi32(e2, b3);
+	s6 = _mm_sub_epi32(e1, b2);
+	s7 = _mm_sub_epi32(e0, b0);
+	if (munge) {
+		s0 = _mm_srai_epi32(s0, 8);
+		s1 = _mm_srai_epi32(s1, 8);
+		s2 = _mm_srai_epi32(s2, 8);
+		s3 = _mm_srai_epi32(s3, 8);
+		s4 = _mm_srai_epi32(s4, 8);
+		s5 = _mm_srai_epi32(s5, 8);
+		s6 = _mm_srai_epi32(s6, 8);
+		s7 = _mm_srai_epi32(s7, 8);
+	}
+}
+
+static FORCEINLINE void transpose4(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3) {
+	const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+	r0 = _mm_unpacklo_epi64(t0, t1);
+	r1 = _mm_unpackhi_epi64(t0, t1);
+	r2 = _mm_unpacklo_epi64(t2, t3);
+	r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+ * Transpose an 8x8 matrix stored as v[row * 2 + half]. Each 4x4 quarter is
+ * transposed in place, so afterwards the columns 0-3 are in v[0], v[2],
+ * v[4] and v[6] (rows 0-3) and v[8], v[10], v[12] and v[14] (rows 4-7),
+ * the columns 4-7 in the odd elements. Doing it twice restores the rows.
+ */
+static FORCEINLINE void transposeQuarters(__m128i *v) {
+	transpose4(v[0], v[2], v[4], v[6]);
+	transpose4(v[1], v[3], v[5], v[7]);
+	transpose4(v[8], v[10], v[12], v[14]);
+	transpose4(v[9], v[11], v[13], v[15]);
+}
+
+/**
+ * Run the column and the row pass of the IDCT, leaving the result row by
+ * row in v[row * 2 + half].
+ */
+static FORCEINLINE void idct2D(__m128i *v, const int32 *block) {
+	for (int i = 0; i < 16; i++)
+		v[i] = _mm_loadu_si128((const __m128i *)(block + 4 * i));
+
+	// Columns: the eight rows are the inputs of four columns at a time
+	transform(v[0], v[2], v[4], v[6], v[8], v[10], v[12], v[14], false);
+	transform(v[1], v[3], v[5], v[7], v[9], v[11], v[13], v[15], false);
+
+	// Rows: after transposing the quarters, v[0] to v[7] hold the columns
+	// of the rows 0-3, and v[8] to v[15] the ones of the rows 4-7
+	transposeQuarters(v);
+	transform(v[0], v[2], v[4], v[6], v[1], v[3], v[5], v[7], true);
+	transform(v[8], v[10], v[12], v[14], v[9], v[11], v[13], v[15], true);
+	transposeQuarters(v);
+}
+
+/** Truncate two rows of eight 32 bit values to bytes. */
+static FORCEINLINE __m128i packRows(const __m128i *row) {
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	const __m128i lo = _mm_packs_epi32(_mm_and_si128(row[0], mask), _mm_and_si128(row[1], mask));
+	const __m128i hi = _mm_packs_epi32(_mm_and_si128(row[2], mask), _mm_and_si128(row[3], mask));
+	return _mm_packus_epi16(lo, hi);
+}
+
+static inline __m128i loadRows(const byte *src, uint32 pitch) {
+	return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)src),
+	                          _mm_loadl_epi64((const __m128i *)(src + pitch)));
+}
+
+static inline void storeRows(byte *dest, uint32 pitch, __m128i v) {
+	_mm_storel_epi64((__m128i *)dest, v);
+	_mm_storel_epi64((__m128i *)(dest + pitch), _mm_srli_si128(v, 8));
+}
+
+static void idctSSE2(int32 *block) {
+	__m128i v[16];
+	idct2D(v, block);
+	for (int i = 0; i < 16; i++)
+		_mm_storeu_si128((__m128i *)(block + 4 * i), v[i]);
+}
+
+static void idctPutSSE2(byte *dest, uint32 pitch, const int32 *block) {
+	__m128i v[16];
+	idct2D(v, block);
+	for (int i = 0; i < 8; i += 2, dest += 2 * pitch)
+		storeRows(dest, pitch, packRows(&v[i * 2]));
+}
+
+static void idctAddSSE2(byte *dest, uint32 pitch, const int32 *block) {
+	__m128i v[16];
+	idct2D(v, block);
+	for (int i = 0; i < 8; i += 2, dest += 2 * pitch)
+		storeRows(dest, pitch, _mm_add_epi8(loadRows(dest, pitch), packRows(&v[i * 2])));
+}
+
+static void addResidueSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	const __m128i mask = _mm_set1_epi16(0xFF);
+	for (int i = 0; i < 8; i += 2, dest += 2 * pitch, block += 16) {
+		const __m128i r0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)block), mask);
+		const __m128i r1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(block + 8)), mask);
+		storeRows(dest, pitch, _mm_add_epi8(loadRows(dest, pitch), _mm_packus_epi16(r0, r1)));
+	}
+}
+
+const BinkKernels &getSSE2BinkKernels() {
+	static const BinkKernels kernels = {
+		idctSSE2,
+		idctPutSSE2,
+		idctAddSSE2,
+		addResidueSSE2
+	};
+	return kernels;
+}
+
+} // End of namespace Video
+
+#endif
@@ -13,7 +13,15 @@ MODULE_OBJS := \
 
 ifdef USE_BINK
 MODULE_OBJS += \
-	bink_decoder.o
+	bink_decoder.o \
+	bink_kernels.o
+
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	bink_kernels_sse2.o
+
+$(MODULE)/bink_kernels_sse2.o: CXXFLAGS += -msse2
+endif
 endif
 
 ifdef USE_THEORADEC
@@ -26,13 +26,26 @@
 #include "audio/mixer.h" // for kMaxChannelVolume
 
 #include "common/rational.h"
+#include "common/rect.h"
 #include "common/file.h"
 #include "common/system.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+struct VideoDecoder::AheadFrame {
+	Graphics::Surface surface;
+	bool hasSurface;
+	bool dirtyPalette;
+	byte palette[256 * 3];
+	AheadTrackState state;
+
+	AheadFrame() : hasSurface(false), dirtyPalette(false) {}
+	~AheadFrame() { surface.free(); }
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -50,6 +63,14 @@ VideoDecoder::VideoDecoder() {
 	_mainAudioTrack = 0;
 	_canSetDither = true;
 
+	_aheadDepth = 0;
+	_aheadTrack = 0;
+	_aheadOutput = 0;
+	_aheadStarted = false;
+	_aheadJobQueued = false;
+	_aheadJob = 0;
+	memset(&_aheadStats, 0, sizeof(_aheadStats));
+
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
 
@@ -57,10 +78,17 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	freeDecodeAhead();
+	waitForDecodeAheadJob();
+}
+
 void VideoDecoder::close() {
 	if (isPlaying())
 		stop();
 
+	freeDecodeAhead();
+
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		delete *it;
 
@@ -98,29 +126,38 @@ bool VideoDecoder::needsUpdate() const {
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
-	if (pause) {
-		_pauseLevel++;
+	{
+		// Keep frames from being decoded ahead while pausing
+		Common::StackLock decodeLock(_aheadDecodeMutex);
 
-	// We can't go negative
-	} else if (_pauseLevel) {
-		_pauseLevel--;
+		if (pause) {
+			_pauseLevel++;
 
-	// Do nothing
-	} else {
-		return;
-	}
+		// We can't go negative
+		} else if (_pauseLevel) {
+			_pauseLevel--;
+
+		// Do nothing
+		} else {
+			return;
+		}
 
-	if (_pauseLevel == 1 && pause) {
-		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
+		if (_pauseLevel == 1 && pause) {
+			_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
-		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
-			(*it)->pause(true);
-	} else if (_pauseLevel == 0) {
-		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
-			(*it)->pause(false);
+			for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
+				(*it)->pause(true);
+		} else if (_pauseLevel == 0) {
+			for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
+				(*it)->pause(false);
 
-		_startTime += (g_system->getMillis() - _pauseStartTime);
+			_startTime += (g_system->getMillis() - _pauseStartTime);
+		}
 	}
+
+	// Nothing was decoded ahead while paused
+	if (!isPaused())
+		startDecodeAheadJob();
 }
 
 void VideoDecoder::resetPauseStartTime() {
@@ -185,6 +222,20 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	if (_aheadTrack) {
+		if (_aheadDepth || !_aheadQueue.empty())
+			return returnAheadFrame();
+
+		// All the frames decoded ahead have been returned after disabling
+		// decoding ahead, so the track is back in sync
+		{
+			Common::StackLock decodeLock(_aheadDecodeMutex);
+			_aheadTrack = 0;
+			_aheadStarted = false;
+		}
+		findNextVideoTrack();
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -210,6 +261,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// Frames decoded ahead are of no use backwards
+	if (reverse && _aheadTrack && !cancelDecodeAhead())
+		return false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -234,7 +289,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+			frame += getTrackCurFrame((const VideoTrack *)*it) + 1;
 
 	return frame;
 }
@@ -275,7 +330,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getTrackNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -296,8 +351,8 @@ bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		const Track *track = *it;
 
-		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && ((const VideoTrack *)track)->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && getTrackNextFrameStartTime((const VideoTrack *)track) >= (uint)_endTime.msecs();
+		bool endReached = isTrackEndOfTrack(track) || (isPlaying() && videoEndTimeReached);
 		if (!endReached)
 			return false;
 	}
@@ -320,13 +375,21 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	// Keep frames from being decoded ahead while rewinding
+	Common::StackLock decodeLock(_aheadDecodeMutex);
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
 
-	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->rewind())
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if (!(*it)->rewind()) {
+			discardDecodedAhead();
 			return false;
+		}
+	}
+
+	discardDecodedAhead();
 
 	// Now that we've rewound, start all tracks again
 	if (isPlaying())
@@ -336,6 +399,7 @@ bool VideoDecoder::rewind() {
 	_startTime = g_system->getMillis();
 	resetPauseStartTime();
 	findNextVideoTrack();
+	startDecodeAheadJob();
 	return true;
 }
 
@@ -354,12 +418,17 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	// Keep frames from being decoded ahead while seeking
+	Common::StackLock decodeLock(_aheadDecodeMutex);
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
 
 	// Do the actual seeking
-	if (!seekIntern(time))
+	bool result = seekIntern(time);
+	discardDecodedAhead();
+	if (!result)
 		return false;
 
 	// Seek any external track too
@@ -379,6 +448,7 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	resetPauseStartTime();
 	findNextVideoTrack();
 	_needsUpdate = true;
+	startDecodeAheadJob();
 	return true;
 }
 
@@ -435,12 +505,15 @@ void VideoDecoder::stop() {
 	_dirtyPalette = false;
 	_needsUpdate = false;
 
-	// Also reset the pause state.
-	_pauseLevel = 0;
+	// Also reset the pause state, and the one of the tracks too
+	{
+		Common::StackLock decodeLock(_aheadDecodeMutex);
+		_pauseLevel = 0;
 
-	// Reset the pause state of the tracks too
-	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		(*it)->pause(false);
+		for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
+			(*it)->pause(false);
+	}
+	startDecodeAheadJob();
 }
 
 void VideoDecoder::setRate(const Common::Rational &rate) {
@@ -805,8 +878,14 @@ void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
 		stopAudio();
 	}
 
-	_endTime = endTime;
-	_endTimeSet = true;
+	{
+		Common::StackLock decodeLock(_aheadDecodeMutex);
+		_endTime = endTime;
+		_endTimeSet = true;
+	}
+
+	// Decoding ahead may have stopped at the previous end time
+	startDecodeAheadJob();
 
 	if (startTime > endTime)
 		return;
@@ -861,7 +940,7 @@ const VideoDecoder::Track *VideoDecoder::getTrack(uint track) const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack())
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackEndOfTrack(*it))
 			return false;
 
 	return true;
@@ -872,9 +951,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	uint32 bestTime = 0xFFFFFFFF;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack()) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackEndOfTrack(*it)) {
 			VideoTrack *track = (VideoTrack *)*it;
-			uint32 time = track->getNextFrameStartTime();
+			uint32 time = getTrackNextFrameStartTime(track);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -921,8 +1000,8 @@ bool VideoDecoder::hasFramesLeft() const {
 
 		const VideoTrack *track = (const VideoTrack *)*it;
 
-		bool videoEndTimeReached = _endTimeSet && track->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool videoEndTimeReached = _endTimeSet && getTrackNextFrameStartTime(track) >= (uint)_endTime.msecs();
+		bool endReached = isTrackEndOfTrack(track) || (isPlaying() && videoEndTimeReached);
 		if (!endReached)
 			return true;
 	}
@@ -955,4 +1034,315 @@ void VideoDecoder::eraseTrack(Track *track) {
 	}
 }
 
+bool VideoDecoder::setDecodeAhead(uint depth) {
+	if (depth == 0) {
+		// The frames already decoded ahead are still returned by
+		// decodeNextFrame(), since the track cannot go back to them
+		Common::StackLock decodeLock(_aheadDecodeMutex);
+		_aheadDepth = 0;
+		return true;
+	}
+
+	if (!g_system->canRunBackgroundJobs())
+		return false;
+
+	VideoTrack *track = 0;
+
+	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			// We only allow decoding ahead when one video track is present
+			if (track)
+				return false;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	if (!track || track->isReversed())
+		return false;
+
+	{
+		Common::StackLock decodeLock(_aheadDecodeMutex);
+
+		if (!_aheadTrack) {
+			_aheadTrack = track;
+			_aheadState.curFrame = track->getCurFrame();
+			_aheadState.nextFrameStartTime = track->getNextFrameStartTime();
+			_aheadState.endOfTrack = track->endOfTrack();
+		}
+
+		_aheadDepth = depth;
+	}
+
+	// The background job only starts once the first frame is decoded, so
+	// the dithering palette can still be set until then
+	startDecodeAheadJob();
+	return true;
+}
+
+VideoDecoder::DecodeAheadStats VideoDecoder::getDecodeAheadStats() const {
+	Common::StackLock queueLock(_aheadQueueMutex);
+	DecodeAheadStats stats = _aheadStats;
+	stats.queuedFrames = _aheadQueue.size();
+	return stats;
+}
+
+void VideoDecoder::resetDecodeAheadStats() {
+	Common::StackLock queueLock(_aheadQueueMutex);
+	memset(&_aheadStats, 0, sizeof(_aheadStats));
+	_aheadStats.maxQueuedFrames = _aheadQueue.size();
+}
+
+int VideoDecoder::getTrackCurFrame(const VideoTrack *track) const {
+	return (track == _aheadTrack) ? _aheadState.curFrame : track->getCurFrame();
+}
+
+uint32 VideoDecoder::getTrackNextFrameStartTime(const VideoTrack *track) const {
+	return (track == _aheadTrack) ? _aheadState.nextFrameStartTime : track->getNextFrameStartTime();
+}
+
+bool VideoDecoder::isTrackEndOfTrack(const Track *track) const {
+	return (track == _aheadTrack) ? _aheadState.endOfTrack : track->endOfTrack();
+}
+
+VideoDecoder::AheadFrame *VideoDecoder::takeAheadFrame() {
+	Common::StackLock queueLock(_aheadQueueMutex);
+
+	if (_aheadFree.empty())
+		return new AheadFrame();
+
+	AheadFrame *frame = _aheadFree.front();
+	_aheadFree.pop_front();
+	return frame;
+}
+
+void VideoDecoder::decodeAheadFrame(AheadFrame *frame) {
+	// Must be called with _aheadDecodeMutex locked, unless the background
+	// job was not started yet
+	readNextPacket();
+
+	const Graphics::Surface *surface = _aheadTrack->decodeNextFrame();
+
+	frame->hasSurface = surface != 0;
+	if (surface) {
+		if (frame->surface.w != surface->w || frame->surface.h != surface->h || frame->surface.format != surface->format) {
+			frame->surface.free();
+			frame->surface.create(surface->w, surface->h, surface->format);
+		}
+
+		frame->surface.copyRectToSurface(*surface, 0, 0, Common::Rect(surface->w, surface->h));
+	}
+
+	frame->dirtyPalette = _aheadTrack->hasDirtyPalette();
+	if (frame->dirtyPalette)
+		memcpy(frame->palette, _aheadTrack->getPalette(), sizeof(frame->palette));
+
+	frame->state.curFrame = _aheadTrack->getCurFrame();
+	frame->state.nextFrameStartTime = _aheadTrack->getNextFrameStartTime();
+	frame->state.endOfTrack = _aheadTrack->endOfTrack();
+}
+
+const Graphics::Surface *VideoDecoder::returnAheadFrame() {
+	AheadFrame *frame = 0;
+	bool late = false;
+
+	{
+		Common::StackLock queueLock(_aheadQueueMutex);
+		if (!_aheadQueue.empty()) {
+			frame = _aheadQueue.front();
+			_aheadQueue.pop_front();
+		}
+	}
+
+	if (!frame) {
+		// Nothing was decoded ahead yet, wait for the background job to
+		// finish the frame it may be decoding, or decode it now
+		Common::StackLock decodeLock(_aheadDecodeMutex);
+
+		{
+			Common::StackLock queueLock(_aheadQueueMutex);
+			if (!_aheadQueue.empty()) {
+				frame = _aheadQueue.front();
+				_aheadQueue.pop_front();
+			}
+		}
+
+		if (!frame) {
+			frame = takeAheadFrame();
+			decodeAheadFrame(frame);
+			late = _aheadStarted;
+		}
+	}
+
+	{
+		Common::StackLock queueLock(_aheadQueueMutex);
+
+		// The previous frame is not in use anymore
+		if (_aheadOutput)
+			_aheadFree.push_back(_aheadOutput);
+		_aheadOutput = frame;
+
+		_aheadStats.frames++;
+		if (late)
+			_aheadStats.lateFrames++;
+	}
+
+	_aheadState = frame->state;
+
+	if (frame->dirtyPalette) {
+		memcpy(_aheadPalette, frame->palette, sizeof(_aheadPalette));
+		_palette = _aheadPalette;
+		_dirtyPalette = true;
+	}
+
+	findNextVideoTrack();
+
+	// Decode the frame taken from the queue again
+	if (_aheadDepth) {
+		_aheadStarted = true;
+		startDecodeAheadJob();
+	}
+
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+void VideoDecoder::discardDecodedAhead() {
+	// Must be called with _aheadDecodeMutex locked
+	if (!_aheadTrack)
+		return;
+
+	{
+		Common::StackLock queueLock(_aheadQueueMutex);
+		while (!_aheadQueue.empty()) {
+			_aheadFree.push_back(_aheadQueue.front());
+			_aheadQueue.pop_front();
+		}
+	}
+
+	_aheadState.curFrame = _aheadTrack->getCurFrame();
+	_aheadState.nextFrameStartTime = _aheadTrack->getNextFrameStartTime();
+	_aheadState.endOfTrack = _aheadTrack->endOfTrack();
+}
+
+bool VideoDecoder::cancelDecodeAhead() {
+	// Keep frames from being decoded ahead while putting the track back
+	Common::StackLock decodeLock(_aheadDecodeMutex);
+
+	// Put the track back to the last returned frame
+	bool queueEmpty;
+	{
+		Common::StackLock queueLock(_aheadQueueMutex);
+		queueEmpty = _aheadQueue.empty();
+	}
+
+	if (!queueEmpty) {
+		Audio::Timestamp time = _aheadTrack->getFrameTime(_aheadState.curFrame + 1);
+
+		if (!isSeekable() || time < 0 || !seekIntern(time))
+			return false;
+	}
+
+	discardDecodedAhead();
+	_aheadTrack = 0;
+	_aheadDepth = 0;
+	_aheadStarted = false;
+	findNextVideoTrack();
+	return true;
+}
+
+void VideoDecoder::freeDecodeAhead() {
+	// The background job does not hold any frames while this is locked,
+	// and it stops once it sees that there is no track to decode
+	Common::StackLock decodeLock(_aheadDecodeMutex);
+	Common::StackLock queueLock(_aheadQueueMutex);
+	Common::List<AheadFrame *>::iterator it;
+
+	for (it = _aheadQueue.begin(); it != _aheadQueue.end(); it++)
+		delete *it;
+
+	for (it = _aheadFree.begin(); it != _aheadFree.end(); it++)
+		delete *it;
+
+	delete _aheadOutput;
+
+	_aheadQueue.clear();
+	_aheadFree.clear();
+	_aheadOutput = 0;
+	_aheadTrack = 0;
+	_aheadDepth = 0;
+	_aheadStarted = false;
+	memset(&_aheadStats, 0, sizeof(_aheadStats));
+}
+
+void VideoDecoder::startDecodeAheadJob() {
+	if (!_aheadStarted || !_aheadDepth)
+		return;
+
+	{
+		// A queued or running job checks the state again before it stops
+		Common::StackLock queueLock(_aheadQueueMutex);
+		if (_aheadJobQueued)
+			return;
+		_aheadJobQueued = true;
+	}
+
+	const uint32 job = g_system->startBackgroundJob(&decodeAheadProc, this);
+
+	Common::StackLock queueLock(_aheadQueueMutex);
+	if (job)
+		_aheadJob = job;
+	else
+		_aheadJobQueued = false;
+}
+
+void VideoDecoder::waitForDecodeAheadJob() {
+	// Only this thread starts the job, so _aheadJob is the one which may
+	// still be queued or running. It stops at its next frame, as decoding
+	// ahead is disabled when this is called. This waits even if the job
+	// cleared _aheadJobQueued already, as it still unlocks the mutexes
+	// afterwards.
+	uint32 job;
+	{
+		Common::StackLock queueLock(_aheadQueueMutex);
+		job = _aheadJob;
+	}
+
+	g_system->waitForBackgroundJob(job);
+}
+
+bool VideoDecoder::decodeAhead() {
+	Common::StackLock decodeLock(_aheadDecodeMutex);
+
+	{
+		// The job is done once it is checked here that there is nothing to
+		// decode, with both mutexes locked. The main thread changes the
+		// state with _aheadDecodeMutex locked, and queues the job again
+		// unless it sees _aheadJobQueued set here, so that no change is
+		// missed. This is the last access to the decoder, as it may be
+		// deleted as soon as _aheadJobQueued is cleared.
+		Common::StackLock queueLock(_aheadQueueMutex);
+		if (!_aheadTrack || !_aheadDepth || isPaused() || _aheadQueue.size() >= _aheadDepth ||
+			_aheadTrack->endOfTrack() || (_endTimeSet && _aheadTrack->getNextFrameStartTime() >= (uint)_endTime.msecs())) {
+			_aheadJobQueued = false;
+			return false;
+		}
+	}
+
+	AheadFrame *frame = takeAheadFrame();
+	decodeAheadFrame(frame);
+
+	Common::StackLock queueLock(_aheadQueueMutex);
+	_aheadQueue.push_back(frame);
+	_aheadStats.maxQueuedFrames = MAX<uint>(_aheadStats.maxQueuedFrames, _aheadQueue.size());
+	return true;
+}
+
+void VideoDecoder::decodeAheadProc(void *param) {
+	// Fill the queue, one frame at a time, so that the main thread only
+	// has to wait for one frame when it seeks or pauses
+	VideoDecoder *decoder = (VideoDecoder *)param;
+	while (decoder->decodeAhead())
+		;
+}
+
 } // End of namespace Video
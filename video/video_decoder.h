@@ -26,6 +26,8 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/list.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
@@ -52,7 +54,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -396,6 +398,64 @@ public:
 	 */
 	bool setDitheringPalette(const byte *palette);
 
+	/////////////////////////////////////////
+	// Decode-Ahead
+	/////////////////////////////////////////
+
+	/**
+	 * Counters of the frames decoded ahead.
+	 */
+	struct DecodeAheadStats {
+		uint queuedFrames;    ///< Number of frames currently decoded ahead
+		uint maxQueuedFrames; ///< Highest number of frames decoded ahead at once
+		uint32 frames;        ///< Number of frames returned by decodeNextFrame()
+		uint32 lateFrames;    ///< Number of frames which were not decoded ahead in time
+	};
+
+	/**
+	 * Decode frames ahead in the background.
+	 *
+	 * Once playback has started, the next frames of the video are decoded
+	 * by a job started with OSystem::startBackgroundJob(), and
+	 * decodeNextFrame() only has to return the next one. This avoids hitches
+	 * when some frames take much longer to decode than others. Seeking and
+	 * rewinding discard the frames decoded ahead. Nothing is decoded ahead
+	 * while the video is paused.
+	 *
+	 * The state reported by the VideoDecoder, e.g. getCurFrame(), is the
+	 * one of the frame last returned by decodeNextFrame(). The tracks
+	 * themselves are ahead of that, so a subclass must not rely on their
+	 * state while decoding ahead, and must not access the data its tracks
+	 * decode from outside of readNextPacket() and the tracks.
+	 *
+	 * This must be set after calling loadStream(). It is only supported for
+	 * videos with a single video track, played forward, on backends which
+	 * can run background jobs. close() disables it. A subclass has to call
+	 * close() in its destructor when using this, so that the background job
+	 * stops using it.
+	 *
+	 * @param depth The maximum number of frames to decode ahead, 0 to stop
+	 *              decoding ahead
+	 * @return true on success, false if the video cannot be decoded ahead
+	 */
+	bool setDecodeAhead(uint depth);
+
+	/**
+	 * Get the maximum number of frames to decode ahead, 0 if disabled.
+	 */
+	uint getDecodeAhead() const { return _aheadDepth; }
+
+	/**
+	 * Get the counters of the frames decoded ahead.
+	 */
+	DecodeAheadStats getDecodeAheadStats() const;
+
+	/**
+	 * Reset the counters of the frames decoded ahead, except for the number
+	 * of frames currently decoded ahead.
+	 */
+	void resetDecodeAheadStats();
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -964,6 +1024,48 @@ private:
 	Audio::Mixer::SoundType _soundType;
 
 	AudioTrack *_mainAudioTrack;
+
+	// Decode-ahead
+	struct AheadFrame;
+
+	/** The state of the video track after decoding a frame. */
+	struct AheadTrackState {
+		int curFrame;
+		uint32 nextFrameStartTime;
+		bool endOfTrack;
+	};
+
+	// The background job only runs while holding _aheadDecodeMutex, so the
+	// main thread locks it to change what the job reads: the tracks,
+	// _aheadDepth, _aheadTrack, _pauseLevel and the end time.
+	uint _aheadDepth;
+	VideoTrack *_aheadTrack;           ///< The track decoded ahead, 0 if not decoding ahead
+	AheadTrackState _aheadState;       ///< State of _aheadTrack as of the last returned frame
+	AheadFrame *_aheadOutput;          ///< The frame last returned by decodeNextFrame()
+	byte _aheadPalette[256 * 3];
+	Common::List<AheadFrame *> _aheadQueue;
+	Common::List<AheadFrame *> _aheadFree;
+	DecodeAheadStats _aheadStats;
+	bool _aheadStarted;                ///< Frames are decoded in the background since the first one was returned
+	bool _aheadJobQueued;              ///< The background job is queued or running
+	uint32 _aheadJob;                  ///< Id of the last background job started
+	Common::Mutex _aheadDecodeMutex;   ///< Held while decoding ahead
+	Common::Mutex _aheadQueueMutex;    ///< Guards _aheadQueue, _aheadFree, _aheadStats, _aheadJobQueued and _aheadJob
+
+	int getTrackCurFrame(const VideoTrack *track) const;
+	uint32 getTrackNextFrameStartTime(const VideoTrack *track) const;
+	bool isTrackEndOfTrack(const Track *track) const;
+
+	AheadFrame *takeAheadFrame();
+	void decodeAheadFrame(AheadFrame *frame);
+	const Graphics::Surface *returnAheadFrame();
+	void discardDecodedAhead();
+	bool cancelDecodeAhead();
+	void freeDecodeAhead();
+	void startDecodeAheadJob();
+	void waitForDecodeAheadJob();
+	bool decodeAhead();
+	static void decodeAheadProc(void *param);
 };
 
 } // End of namespace Video